@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TDENGINE_TSCPARSECACHE_H
+#define TDENGINE_TSCPARSECACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "tsclient.h"
+
+typedef struct SParseCacheEntry {
+  struct SParseCacheEntry *prev;
+  struct SParseCacheEntry *next;
+  char                    *key;         // current db and the normalized sql string
+  int32_t                  keyLen;
+  SQueryInfo              *pQueryInfo;  // validated query info, the table meta is kept to check the schema version
+  int16_t                  numOfCols;
+} SParseCacheEntry;
+
+typedef struct SSqlParseCache {
+  pthread_mutex_t   lock;
+  SHashObj         *pEntries;  // key -> SParseCacheEntry*
+  SParseCacheEntry *pHead;     // the most recently used entry
+  SParseCacheEntry *pTail;     // the least recently used entry, evicted first
+  int32_t           capacity;
+} SSqlParseCache;
+
+SSqlParseCache *tscCreateParseCache(int32_t capacity);
+void            tscDestroyParseCache(SSqlParseCache *pCache);
+
+/**
+ * restore the validated query info of the sql statement of pSql from the parse cache of the connection
+ * @param pSql
+ * @return true if the sql statement has been restored, false if it needs to be parsed
+ */
+bool tscRestoreFromParseCache(SSqlObj *pSql);
+
+/**
+ * keep the validated query info of pSql in the parse cache of the connection if it is allowed to be reused
+ * @param pSql
+ */
+void tscAddIntoParseCache(SSqlObj *pSql);
+
+/**
+ * keep a copy of the validated query info of pSql in pSql->cmd.pValidated if it is requested by the prepared statement
+ * and it is allowed to be reused
+ * @param pSql
+ */
+void tscKeepValidatedQueryInfo(SSqlObj *pSql);
+
+/**
+ * install a copy of the validated query info into pSql, with the table meta and vgroup list refreshed from the local
+ * meta buffer
+ * @param pSql
+ * @param pSrc       validated query info
+ * @param numOfCols
+ * @return TSDB_CODE_TDB_INVALID_TABLE_ID if the schema of the queried table has changed since pSrc is validated
+ */
+int32_t tscRestoreQueryInfo(SSqlObj *pSql, const SQueryInfo *pSrc, int16_t numOfCols);
+
+SQueryInfo *tscCloneValidatedQueryInfo(const SQueryInfo *pSrc);
+void        tscDestroyValidatedQueryInfo(SQueryInfo *pQueryInfo);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TDENGINE_TSCPARSECACHE_H
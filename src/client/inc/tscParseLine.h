@@ -81,6 +81,9 @@ int32_t convertSmlTimeStamp(TAOS_SML_KV *pVal, char *value,
 
 void destroySmlDataPoint(TAOS_SML_DATA_POINT* point);
 
+struct SSmlSchemaCache;
+void tscDestroySmlSchemaCache(struct SSmlSchemaCache* pCache);
+
 int taos_insert_lines(TAOS* taos, char* lines[], int numLines, SMLProtocolType protocol,
                       SMLTimeStampType tsType, int* affectedRows);
 int taos_insert_telnet_lines(TAOS* taos, char* lines[], int numLines, SMLProtocolType protocol,
@@ -30,6 +30,11 @@ int  tscBuildQueryStreamDesc(void *pMsg, STscObj *pObj);
 void tscKillQuery(STscObj *pObj, uint32_t killId);
 void tscKillStream(STscObj *pObj, uint32_t killId);
 void tscKillConnection(STscObj *pObj);
+void tscUpdateParseStatis(STscObj *pObj, int64_t useconds, bool cached);
+void tscPrintParseStatis(STscObj *pObj);
+void tscUpdateStmtPrepareStatis(STscObj *pObj, int64_t useconds);
+void tscUpdateStmtExecuteStatis(STscObj *pObj, int64_t useconds, bool bound);
+void tscPrintStmtStatis(STscObj *pObj);
 
 #ifdef __cplusplus
 }
@@ -288,6 +288,7 @@ SQueryInfo *tscGetQueryInfo(SSqlCmd* pCmd);
 SQueryInfo *tscGetQueryInfoS(SSqlCmd *pCmd);
 
 void tscClearTableMetaInfo(STableMetaInfo* pTableMetaInfo);
+int32_t tscQueryInfoCopy(SQueryInfo* pQueryInfo, const SQueryInfo* pSrc);
 
 STableMetaInfo* tscAddTableMetaInfo(SQueryInfo* pQueryInfo, SName* name, STableMeta* pTableMeta,
                                     SVgroupsInfo* vgroupList, SArray* pTagCols, SArray* pVgroupTables);
@@ -302,6 +303,14 @@ void tscVgroupTableCopy(SVgroupTableInfo* info, SVgroupTableInfo* pInfo);
 int  tscGetSTableVgroupInfo(SSqlObj* pSql, SQueryInfo* pQueryInfo);
 int  tscGetTableMeta(SSqlObj* pSql, STableMetaInfo* pTableMetaInfo);
 int  tscGetTableMetaEx(SSqlObj *pSql, STableMetaInfo *pTableMetaInfo, bool createIfNotExists, bool onlyLocal);
+
+/**
+ * same as tscGetTableMetaEx without onlyLocal, but the table meta request, if it is sent to mnode, calls fp with param
+ * pSql->self instead of going on with the statement of pSql
+ * @return TSDB_CODE_TSC_ACTION_IN_PROGRESS if the request has been sent
+ */
+int32_t tscGetTableMetaWithCallBack(SSqlObj *pSql, STableMetaInfo *pTableMetaInfo, bool autocreate,
+                                    __async_cb_func_t fp);
 int32_t tscGetUdfFromNode(SSqlObj *pSql, SQueryInfo* pQueryInfo);
 
 void tscResetForNextRetrieve(SSqlRes* pRes);
@@ -292,6 +292,9 @@ typedef struct {
   SQueryInfo  *active;         // current active query info
   int32_t      batchSize;      // for parameter ('?') binding and batch processing
   int32_t      resColumnId;
+
+  bool         keepValidated;  // keep a copy of the validated query info for the prepared statement
+  SQueryInfo  *pValidated;
 } SSqlCmd;
 
 typedef struct {
@@ -315,6 +318,7 @@ typedef struct {
   bool           dataConverted;
   int32_t*       length;  // length for each field for current row
   char **        buffer;  // Buffer used to put multibytes encoded using unicode (wchar_t)
+  uint8_t **     nullBitmap;  // null bitmap of each column of current retrieval, built by taos_fetch_column_block
   SColumnIndex*  pColumnIndex;
 
   TAOS_FIELD*    final;
@@ -349,6 +353,18 @@ typedef struct STscObj {
   int32_t            numOfObj; // number of sqlObj from this tscObj
       
   SReqOrigin         from;
+
+  struct SSqlParseCache *pParseCache;  // validated select statements, created on demand
+  int64_t            numOfParsed;      // number of select statements parsed by this tscObj
+  int64_t            numOfParseCacheHits;
+  int64_t            parseTime;        // total time of parsing select statements, in microseconds
+  int64_t            numOfStmtPrepared;  // number of select statements prepared by this tscObj
+  int64_t            stmtPrepareTime;    // total time of preparing select statements, in microseconds
+  int64_t            numOfStmtExecuted;
+  int64_t            numOfStmtBound;     // executions that bind the parameters without parsing the sql statement
+  int64_t            stmtExecuteTime;    // total time of executing prepared select statements, in microseconds
+
+  struct SSmlSchemaCache *pSmlCache;  // super table schemas of schemaless insertion, created on demand
 } STscObj;
 
 typedef struct SSubqueryState {
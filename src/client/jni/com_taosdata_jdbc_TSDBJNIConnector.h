@@ -153,6 +153,14 @@ JNIEXPORT jint JNICALL Java_com_taosdata_jdbc_TSDBJNIConnector_fetchRowImp
 JNIEXPORT jint JNICALL Java_com_taosdata_jdbc_TSDBJNIConnector_fetchBlockImp
   (JNIEnv *, jobject, jlong, jlong, jobject);
 
+/*
+ * Class:     com_taosdata_jdbc_TSDBJNIConnector
+ * Method:    fetchColumnBlockImp
+ * Signature: (JJLcom/taosdata/jdbc/TSDBResultSetBlockData;)I
+ */
+JNIEXPORT jint JNICALL Java_com_taosdata_jdbc_TSDBJNIConnector_fetchColumnBlockImp
+  (JNIEnv *, jobject, jlong, jlong, jobject);
+
 /*
  * Class:     com_taosdata_jdbc_TSDBJNIConnector
  * Method:    closeConnectionImp
@@ -53,6 +53,7 @@ jmethodID g_rowdataSetByteArrayFp;
 jmethodID g_blockdataSetByteArrayFp;
 jmethodID g_blockdataSetNumOfRowsFp;
 jmethodID g_blockdataSetNumOfColsFp;
+jmethodID g_blockdataSetByteBufferFp;
 
 void jniGetGlobalMethod(JNIEnv *env) {
   // make sure init function executed once
@@ -107,6 +108,8 @@ void jniGetGlobalMethod(JNIEnv *env) {
   g_blockdataSetByteArrayFp = (*env)->GetMethodID(env, g_blockdataClass, "setByteArray", "(II[B)V");
   g_blockdataSetNumOfRowsFp = (*env)->GetMethodID(env, g_blockdataClass, "setNumOfRows", "(I)V");
   g_blockdataSetNumOfColsFp = (*env)->GetMethodID(env, g_blockdataClass, "setNumOfCols", "(I)V");
+  g_blockdataSetByteBufferFp = (*env)->GetMethodID(env, g_blockdataClass, "setByteBuffer",
+                                                   "(ILjava/nio/ByteBuffer;Ljava/nio/ByteBuffer;)V");
   (*env)->DeleteLocalRef(env, blockdataClass);
 
   atomic_store_32(&__init, 2);
@@ -604,6 +607,59 @@ JNIEXPORT jint JNICALL Java_com_taosdata_jdbc_TSDBJNIConnector_fetchBlockImp(JNI
   return JNI_SUCCESS;
 }
 
+JNIEXPORT jint JNICALL Java_com_taosdata_jdbc_TSDBJNIConnector_fetchColumnBlockImp(JNIEnv *env, jobject jobj,
+                                                                                   jlong con, jlong res,
+                                                                                   jobject rowobj) {
+  TAOS   *tscon = (TAOS *)con;
+  int32_t code = check_for_params(jobj, con, res);
+  if (code != JNI_SUCCESS) {
+    return code;
+  }
+
+  TAOS_RES *tres = (TAOS_RES *)res;
+
+  int32_t numOfFields = taos_num_fields(tres);
+  assert(numOfFields > 0);
+
+  TAOS_COLUMN_BLOCK *columns = calloc(numOfFields, sizeof(TAOS_COLUMN_BLOCK));
+  if (columns == NULL) {
+    jniError("jobj:%p, conn:%p, resultset:%p, out of memory", jobj, tscon, (void *)res);
+    return JNI_OUT_OF_MEMORY;
+  }
+
+  int32_t numOfRows = taos_fetch_column_block(tres, columns);
+  if (numOfRows == 0) {
+    free(columns);
+
+    code = taos_errno(tres);
+    if (code == JNI_SUCCESS) {
+      jniDebug("jobj:%p, conn:%p, resultset:%p, numOfFields:%d, no data to retrieve", jobj, tscon, (void *)res,
+               numOfFields);
+      return JNI_FETCH_END;
+    } else {
+      jniDebug("jobj:%p, conn:%p, query interrupted", jobj, tscon);
+      return JNI_RESULT_SET_NULL;
+    }
+  }
+
+  (*env)->CallVoidMethod(env, rowobj, g_blockdataSetNumOfRowsFp, (jint)numOfRows);
+  (*env)->CallVoidMethod(env, rowobj, g_blockdataSetNumOfColsFp, (jint)numOfFields);
+
+  // the direct buffers wrap the received result without copy, they are valid until the next fetch
+  for (int i = 0; i < numOfFields; i++) {
+    jobject data = (*env)->NewDirectByteBuffer(env, columns[i].data, (jlong)columns[i].bytes * numOfRows);
+    jobject bitmap = (*env)->NewDirectByteBuffer(env, columns[i].is_null, (numOfRows + 7) >> 3);
+
+    (*env)->CallVoidMethod(env, rowobj, g_blockdataSetByteBufferFp, i, data, bitmap);
+
+    (*env)->DeleteLocalRef(env, data);
+    (*env)->DeleteLocalRef(env, bitmap);
+  }
+
+  free(columns);
+  return JNI_SUCCESS;
+}
+
 JNIEXPORT jint JNICALL Java_com_taosdata_jdbc_TSDBJNIConnector_closeConnectionImp(JNIEnv *env, jobject jobj,
                                                                                   jlong con) {
   TAOS *tscon = (TAOS *)con;
@@ -0,0 +1,523 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "os.h"
+#include "hash.h"
+#include "tcache.h"
+#include "tglobal.h"
+#include "ttoken.h"
+#include "ttokendef.h"
+#include "tscLog.h"
+#include "tscUtil.h"
+#include "tscParseCache.h"
+
+/*
+ * The parse cache of a connection keeps the query info of select statements that have passed the validation, keyed by
+ * the current database and the sql string with the blanks and comments removed. A statement that hits the cache skips
+ * the parse and validation, only the table meta and the vgroup list are refreshed from the local meta buffer. The
+ * cached query info is dropped if the schema of the queried table has changed since it is validated.
+ *
+ * Only the statement on one table without subquery, union, join or udf is kept, and the statement referring to
+ * "now" is never kept since the time window is calculated during the validation.
+ *
+ * The prepared select statement keeps the validated query info of its first execution in the same way, and binds the
+ * parameters of the following executions into a copy of it, see tscPrepare.c.
+ */
+
+static void destroyParseCacheEntry(SParseCacheEntry *pEntry) {
+  if (pEntry == NULL) {
+    return;
+  }
+
+  tscDestroyValidatedQueryInfo(pEntry->pQueryInfo);
+  tfree(pEntry->key);
+  free(pEntry);
+}
+
+static void unlinkParseCacheEntry(SSqlParseCache *pCache, SParseCacheEntry *pEntry) {
+  if (pEntry->prev != NULL) {
+    pEntry->prev->next = pEntry->next;
+  } else {
+    pCache->pHead = pEntry->next;
+  }
+
+  if (pEntry->next != NULL) {
+    pEntry->next->prev = pEntry->prev;
+  } else {
+    pCache->pTail = pEntry->prev;
+  }
+
+  pEntry->prev = NULL;
+  pEntry->next = NULL;
+}
+
+static void pushFrontParseCacheEntry(SSqlParseCache *pCache, SParseCacheEntry *pEntry) {
+  pEntry->prev = NULL;
+  pEntry->next = pCache->pHead;
+
+  if (pCache->pHead != NULL) {
+    pCache->pHead->prev = pEntry;
+  } else {
+    pCache->pTail = pEntry;
+  }
+
+  pCache->pHead = pEntry;
+}
+
+static void removeParseCacheEntry(SSqlParseCache *pCache, SParseCacheEntry *pEntry) {
+  unlinkParseCacheEntry(pCache, pEntry);
+  taosHashRemove(pCache->pEntries, pEntry->key, pEntry->keyLen);
+  destroyParseCacheEntry(pEntry);
+}
+
+SSqlParseCache *tscCreateParseCache(int32_t capacity) {
+  SSqlParseCache *pCache = calloc(1, sizeof(SSqlParseCache));
+  if (pCache == NULL) {
+    return NULL;
+  }
+
+  pCache->pEntries = taosHashInit(capacity, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), false, HASH_NO_LOCK);
+  if (pCache->pEntries == NULL) {
+    free(pCache);
+    return NULL;
+  }
+
+  pCache->capacity = capacity;
+  pthread_mutex_init(&pCache->lock, NULL);
+  return pCache;
+}
+
+void tscDestroyParseCache(SSqlParseCache *pCache) {
+  if (pCache == NULL) {
+    return;
+  }
+
+  while (pCache->pHead != NULL) {
+    removeParseCacheEntry(pCache, pCache->pHead);
+  }
+
+  taosHashCleanup(pCache->pEntries);
+  pthread_mutex_destroy(&pCache->lock);
+  free(pCache);
+}
+
+/*
+ * the key is the current database followed by the tokens of the sql string separated by one blank, NULL is returned
+ * if the statement should not be cached
+ */
+static char *buildParseCacheKey(SSqlObj *pSql, int32_t *keyLen) {
+  STscObj *pObj = pSql->pTscObj;
+  char     db[TSDB_ACCT_ID_LEN + TSDB_DB_NAME_LEN] = {0};
+
+  pthread_mutex_lock(&pObj->mutex);
+  tstrncpy(db, pObj->db, tListLen(db));
+  pthread_mutex_unlock(&pObj->mutex);
+
+  int32_t dbLen = (int32_t)strlen(db);
+  size_t  sqlLen = strlen(pSql->sqlstr);
+
+  char *key = malloc(dbLen + sqlLen * 2 + 2);
+  if (key == NULL) {
+    return NULL;
+  }
+
+  memcpy(key, db, dbLen);
+  int32_t len = dbLen;
+  key[len++] = '\n';
+
+  char    *sql = pSql->sqlstr;
+  uint32_t i = 0;
+  while (sql[i] != 0) {
+    uint32_t type = 0;
+    uint32_t n = tGetToken(&sql[i], &type);
+
+    if (type == TK_SPACE || type == TK_COMMENT) {
+      i += n;
+      continue;
+    }
+
+    if (type == TK_SEMI) {
+      break;
+    }
+
+    if (n == 0 || type == TK_NOW || type == TK_QUESTION || type == TK_ILLEGAL) {
+      free(key);
+      return NULL;
+    }
+
+    if (len > dbLen + 1) {
+      key[len++] = ' ';
+    }
+
+    memcpy(&key[len], &sql[i], n);
+    len += n;
+    i += n;
+  }
+
+  *keyLen = len;
+  return key;
+}
+
+static bool isParseCacheEnabled(SSqlObj *pSql) {
+  return pSql->pStream == NULL && pSql->pSubscription == NULL && pSql->rootObj == pSql && pSql->sqlstr != NULL;
+}
+
+static bool isCacheableQueryInfo(SSqlCmd *pCmd) {
+  SQueryInfo *pQueryInfo = pCmd->pQueryInfo;
+  if (pCmd->command != TSDB_SQL_SELECT || pQueryInfo == NULL) {
+    return false;
+  }
+
+  if (pQueryInfo->sibling != NULL || pQueryInfo->pDownstream != NULL ||
+      (pQueryInfo->pUpstream != NULL && taosArrayGetSize(pQueryInfo->pUpstream) > 0) || pQueryInfo->numOfTables != 1 ||
+      pQueryInfo->tsBuf != NULL || pQueryInfo->pQInfo != NULL || pQueryInfo->pUdfInfo != NULL ||
+      pQueryInfo->tagCond.joinInfo.hasJoin) {
+    return false;
+  }
+
+  STableMetaInfo *pTableMetaInfo = tscGetMetaInfo(pQueryInfo, 0);
+  STableMeta     *pTableMeta = pTableMetaInfo->pTableMeta;
+  if (pTableMeta == NULL || pTableMeta->id.uid == 0 || pTableMetaInfo->pVgroupTables != NULL) {
+    return false;
+  }
+
+  return pTableMeta->tableType == TSDB_SUPER_TABLE || pTableMeta->tableType == TSDB_CHILD_TABLE ||
+         pTableMeta->tableType == TSDB_NORMAL_TABLE;
+}
+
+// tscQueryInfoCopy does not copy the attributes that are derived during the validation
+static int32_t copyValidatedQueryInfo(SQueryInfo *pDst, const SQueryInfo *pSrc) {
+  int32_t code = tscQueryInfoCopy(pDst, pSrc);
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  if (pDst->numOfTables != pSrc->numOfTables) {
+    return TSDB_CODE_TSC_OUT_OF_MEMORY;
+  }
+
+  pDst->udColumnId        = pSrc->udColumnId;
+  pDst->distinct          = pSrc->distinct;
+  pDst->onlyHasTagCond    = pSrc->onlyHasTagCond;
+  pDst->round             = pSrc->round;
+  pDst->havingFieldNum    = pSrc->havingFieldNum;
+  pDst->stableQuery       = pSrc->stableQuery;
+  pDst->groupbyColumn     = pSrc->groupbyColumn;
+  pDst->groupbyTag        = pSrc->groupbyTag;
+  pDst->simpleAgg         = pSrc->simpleAgg;
+  pDst->projectionQuery   = pSrc->projectionQuery;
+  pDst->hasFilter         = pSrc->hasFilter;
+  pDst->onlyTagQuery      = pSrc->onlyTagQuery;
+  pDst->globalMerge       = pSrc->globalMerge;
+
+  for (int32_t i = 0; i < pSrc->numOfTables; ++i) {
+    STableMetaInfo *pDstInfo = tscGetMetaInfo(pDst, i);
+    STableMetaInfo *pSrcInfo = tscGetMetaInfo((SQueryInfo *)pSrc, i);
+
+    pDstInfo->vgroupIndex = pSrcInfo->vgroupIndex;
+    pDstInfo->joinTagNum  = pSrcInfo->joinTagNum;
+    tstrncpy(pDstInfo->aliasName, pSrcInfo->aliasName, tListLen(pDstInfo->aliasName));
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+SQueryInfo *tscCloneValidatedQueryInfo(const SQueryInfo *pSrc) {
+  SQueryInfo *pQueryInfo = calloc(1, sizeof(SQueryInfo));
+  if (pQueryInfo == NULL) {
+    return NULL;
+  }
+
+  tscInitQueryInfo(pQueryInfo);
+  if (copyValidatedQueryInfo(pQueryInfo, pSrc) != TSDB_CODE_SUCCESS) {
+    tscDestroyValidatedQueryInfo(pQueryInfo);
+    return NULL;
+  }
+
+  return pQueryInfo;
+}
+
+void tscDestroyValidatedQueryInfo(SQueryInfo *pQueryInfo) {
+  if (pQueryInfo == NULL) {
+    return;
+  }
+
+  SSqlCmd cmd = {0};
+  cmd.pQueryInfo = pQueryInfo;
+  tscFreeQueryInfo(&cmd, false, 0);
+}
+
+// acquire the table meta from the local meta buffer in the same way as the validation does
+static STableMeta *acquireLocalTableMeta(SSqlObj *pSql, STableMetaInfo *pTableMetaInfo) {
+  char name[TSDB_TABLE_FNAME_LEN] = {0};
+  tNameExtractFullName(&pTableMetaInfo->name, name);
+  size_t len = strnlen(name, TSDB_TABLE_FNAME_LEN);
+
+  STableMeta *pTableMeta = NULL;
+  size_t      capacity = 0;
+  if (taosHashGetCloneExt(UTIL_GET_TABLEMETA(pSql), name, len, NULL, (void **)&pTableMeta, &capacity) == NULL) {
+    tfree(pTableMeta);
+    return NULL;
+  }
+
+  if (pTableMeta->id.uid == 0) {
+    tfree(pTableMeta);
+    return NULL;
+  }
+
+  if (pTableMeta->tableType == TSDB_CHILD_TABLE) {
+    STableMeta *pSTableMeta = NULL;
+    int32_t     code = tscCreateTableMetaFromSTableMeta(pSql, &pTableMeta, name, &capacity, &pSTableMeta);
+    tfree(pSTableMeta);
+
+    if (code != TSDB_CODE_SUCCESS) {
+      tfree(pTableMeta);
+      return NULL;
+    }
+  }
+
+  return pTableMeta;
+}
+
+// build the vgroup list of super table from the local buffer, NULL is returned if any of them is not available
+static SVgroupsInfo *acquireLocalVgroupList(SSqlObj *pSql, STableMetaInfo *pTableMetaInfo) {
+  char name[TSDB_TABLE_FNAME_LEN] = {0};
+  tNameExtractFullName(&pTableMetaInfo->name, name);
+
+  void *pv = taosCacheAcquireByKey(UTIL_GET_VGROUPLIST(pSql), name, strnlen(name, TSDB_TABLE_FNAME_LEN));
+  if (pv == NULL) {
+    return NULL;
+  }
+
+  tFilePage    *pdata = (tFilePage *)pv;
+  SVgroupsInfo *pVgroupList = calloc(1, sizeof(SVgroupsInfo) + sizeof(SVgroupMsg) * pdata->num);
+  if (pVgroupList == NULL) {
+    taosCacheRelease(UTIL_GET_VGROUPLIST(pSql), &pv, false);
+    return NULL;
+  }
+
+  pVgroupList->numOfVgroups = (int32_t)pdata->num;
+  for (int32_t i = 0; i < pdata->num; ++i) {
+    int32_t       *id = (int32_t *)pdata->data + i;
+    SNewVgroupInfo existVgroupInfo = {.inUse = -1};
+    taosHashGetClone(UTIL_GET_VGROUPMAP(pSql), id, sizeof(*id), NULL, &existVgroupInfo);
+
+    if (existVgroupInfo.inUse < 0) {
+      tfree(pVgroupList);
+      break;
+    }
+
+    SVgroupMsg *pVgroup = &pVgroupList->vgroups[i];
+    pVgroup->numOfEps = existVgroupInfo.numOfEps;
+    pVgroup->vgId = existVgroupInfo.vgId;
+    memcpy(&pVgroup->epAddr, &existVgroupInfo.ep, sizeof(pVgroup->epAddr));
+  }
+
+  taosCacheRelease(UTIL_GET_VGROUPLIST(pSql), &pv, false);
+  return pVgroupList;
+}
+
+static bool isSameTableVersion(STableMeta *p1, STableMeta *p2) {
+  return p1->id.uid == p2->id.uid && p1->tableType == p2->tableType && p1->suid == p2->suid &&
+         p1->sversion == p2->sversion && p1->tversion == p2->tversion;
+}
+
+static int32_t refreshTableMetaInfo(SSqlObj *pSql, SQueryInfo *pQueryInfo) {
+  STableMetaInfo *pTableMetaInfo = tscGetMetaInfo(pQueryInfo, 0);
+
+  STableMeta *pTableMeta = acquireLocalTableMeta(pSql, pTableMetaInfo);
+  if (pTableMeta == NULL) {
+    return TSDB_CODE_TSC_INVALID_TABLE_NAME;
+  }
+
+  if (!isSameTableVersion(pTableMeta, pTableMetaInfo->pTableMeta)) {
+    tfree(pTableMeta);
+    return TSDB_CODE_TDB_INVALID_TABLE_ID;
+  }
+
+  tfree(pTableMetaInfo->pTableMeta);
+  pTableMetaInfo->pTableMeta = pTableMeta;
+  pTableMetaInfo->tableMetaSize = tscGetTableMetaSize(pTableMeta);
+  pTableMetaInfo->tableMetaCapacity = pTableMetaInfo->tableMetaSize;
+
+  pTableMetaInfo->vgroupList = tscVgroupInfoClear(pTableMetaInfo->vgroupList);
+  if (UTIL_TABLE_IS_SUPER_TABLE(pTableMetaInfo)) {
+    pTableMetaInfo->vgroupList = acquireLocalVgroupList(pSql, pTableMetaInfo);
+    if (pTableMetaInfo->vgroupList == NULL) {
+      return TSDB_CODE_TSC_INVALID_TABLE_NAME;
+    }
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+int32_t tscRestoreQueryInfo(SSqlObj *pSql, const SQueryInfo *pSrc, int16_t numOfCols) {
+  SSqlCmd *pCmd = &pSql->cmd;
+
+  int32_t code = tscAddQueryInfo(pCmd);
+  if (code == TSDB_CODE_SUCCESS) {
+    code = copyValidatedQueryInfo(pCmd->pQueryInfo, pSrc);
+  }
+
+  if (code == TSDB_CODE_SUCCESS) {
+    code = refreshTableMetaInfo(pSql, pCmd->pQueryInfo);
+  }
+
+  if (code != TSDB_CODE_SUCCESS) {
+    tscFreeQueryInfo(pCmd, false, pSql->self);
+    return code;
+  }
+
+  SQueryInfo *pQueryInfo = pCmd->pQueryInfo;
+  pCmd->active = pQueryInfo;
+  pCmd->command = pQueryInfo->command;
+  pCmd->numOfCols = numOfCols;
+
+  STableMetaInfo *pTableMetaInfo = tscGetMetaInfo(pQueryInfo, 0);
+  pSql->res.precision = tscGetTableInfo(pTableMetaInfo->pTableMeta).precision;
+  return TSDB_CODE_SUCCESS;
+}
+
+bool tscRestoreFromParseCache(SSqlObj *pSql) {
+  SSqlCmd        *pCmd = &pSql->cmd;
+  SSqlParseCache *pCache = atomic_load_ptr(&pSql->pTscObj->pParseCache);
+
+  // the table meta of this statement has been loaded, continue the validation
+  if (pCache == NULL || pCmd->pQueryInfo != NULL || pCmd->pTableMetaMap != NULL || !isParseCacheEnabled(pSql)) {
+    return false;
+  }
+
+  int32_t keyLen = 0;
+  char   *key = buildParseCacheKey(pSql, &keyLen);
+  if (key == NULL) {
+    return false;
+  }
+
+  pthread_mutex_lock(&pCache->lock);
+
+  SParseCacheEntry **p = taosHashGet(pCache->pEntries, key, keyLen);
+  if (p == NULL) {
+    pthread_mutex_unlock(&pCache->lock);
+    free(key);
+    return false;
+  }
+
+  SParseCacheEntry *pEntry = *p;
+  unlinkParseCacheEntry(pCache, pEntry);
+  pushFrontParseCacheEntry(pCache, pEntry);
+
+  int32_t code = tscRestoreQueryInfo(pSql, pEntry->pQueryInfo, pEntry->numOfCols);
+  if (code == TSDB_CODE_TDB_INVALID_TABLE_ID) {
+    tscDebug("0x%" PRIx64 " table schema changed, remove sql from parse cache", pSql->self);
+    removeParseCacheEntry(pCache, pEntry);
+  }
+
+  pthread_mutex_unlock(&pCache->lock);
+  free(key);
+
+  if (code != TSDB_CODE_SUCCESS) {
+    return false;
+  }
+
+  tscDebug("0x%" PRIx64 " sql restored from parse cache", pSql->self);
+  return true;
+}
+
+static SSqlParseCache *getOrCreateParseCache(STscObj *pObj) {
+  SSqlParseCache *pCache = atomic_load_ptr(&pObj->pParseCache);
+  if (pCache != NULL) {
+    return pCache;
+  }
+
+  pthread_mutex_lock(&pObj->mutex);
+  if (pObj->pParseCache == NULL) {
+    atomic_store_ptr(&pObj->pParseCache, tscCreateParseCache(tsParseCacheSize));
+  }
+
+  pCache = pObj->pParseCache;
+  pthread_mutex_unlock(&pObj->mutex);
+
+  return pCache;
+}
+
+void tscAddIntoParseCache(SSqlObj *pSql) {
+  SSqlCmd *pCmd = &pSql->cmd;
+  if (tsParseCacheSize <= 0 || !isParseCacheEnabled(pSql) || !isCacheableQueryInfo(pCmd)) {
+    return;
+  }
+
+  int32_t keyLen = 0;
+  char   *key = buildParseCacheKey(pSql, &keyLen);
+  if (key == NULL) {
+    return;
+  }
+
+  SParseCacheEntry *pEntry = calloc(1, sizeof(SParseCacheEntry));
+  if (pEntry == NULL) {
+    free(key);
+    return;
+  }
+
+  pEntry->key = key;
+  pEntry->keyLen = keyLen;
+  pEntry->pQueryInfo = tscCloneValidatedQueryInfo(pCmd->pQueryInfo);
+  if (pEntry->pQueryInfo == NULL) {
+    destroyParseCacheEntry(pEntry);
+    return;
+  }
+
+  pEntry->numOfCols = pCmd->numOfCols;
+
+  SSqlParseCache *pCache = getOrCreateParseCache(pSql->pTscObj);
+  if (pCache == NULL) {
+    destroyParseCacheEntry(pEntry);
+    return;
+  }
+
+  pthread_mutex_lock(&pCache->lock);
+
+  SParseCacheEntry **p = taosHashGet(pCache->pEntries, pEntry->key, pEntry->keyLen);
+  if (p != NULL) {
+    removeParseCacheEntry(pCache, *p);
+  }
+
+  if (taosHashPut(pCache->pEntries, pEntry->key, pEntry->keyLen, &pEntry, POINTER_BYTES) != 0) {
+    pthread_mutex_unlock(&pCache->lock);
+    destroyParseCacheEntry(pEntry);
+    return;
+  }
+
+  pushFrontParseCacheEntry(pCache, pEntry);
+  while (taosHashGetSize(pCache->pEntries) > pCache->capacity) {
+    removeParseCacheEntry(pCache, pCache->pTail);
+  }
+
+  pthread_mutex_unlock(&pCache->lock);
+  tscDebug("0x%" PRIx64 " sql added into parse cache", pSql->self);
+}
+
+void tscKeepValidatedQueryInfo(SSqlObj *pSql) {
+  SSqlCmd *pCmd = &pSql->cmd;
+  if (!pCmd->keepValidated) {
+    return;
+  }
+
+  tscDestroyValidatedQueryInfo(pCmd->pValidated);
+  pCmd->pValidated = NULL;
+
+  if (isParseCacheEnabled(pSql) && isCacheableQueryInfo(pCmd)) {
+    pCmd->pValidated = tscCloneValidatedQueryInfo(pCmd->pQueryInfo);
+  }
+}
@@ -29,6 +29,8 @@
 #include "taosdef.h"
 
 #include "tscLog.h"
+#include "tscParseCache.h"
+#include "tscProfile.h"
 #include "ttoken.h"
 
 #include "tdataformat.h"
@@ -1642,6 +1644,13 @@ int tsParseSql(SSqlObj *pSql, bool initial) {
       strncpy(pCmd->payload, pCmd->insertParam.msg, TSDB_DEFAULT_PAYLOAD_SIZE);
     }
   } else {
+    int64_t st = taosGetTimestampUs();
+    if (tscRestoreFromParseCache(pSql)) {
+      tscUpdateParseStatis(pSql->pTscObj, taosGetTimestampUs() - st, true);
+      tscKeepValidatedQueryInfo(pSql);
+      return TSDB_CODE_SUCCESS;
+    }
+
     SSqlInfo sqlInfo = qSqlParse(pSql->sqlstr);
     ret = tscValidateSqlInfo(pSql, &sqlInfo);
     if (ret == TSDB_CODE_TSC_INVALID_OPERATION && pSql->parseRetry < 1 && sqlInfo.type == TSDB_SQL_SELECT) {
@@ -1654,6 +1663,12 @@ int tsParseSql(SSqlObj *pSql, bool initial) {
     }
 
     SqlInfoDestroy(&sqlInfo);
+
+    if (ret == TSDB_CODE_SUCCESS && pCmd->command == TSDB_SQL_SELECT) {
+      tscAddIntoParseCache(pSql);
+      tscKeepValidatedQueryInfo(pSql);
+      tscUpdateParseStatis(pSql->pTscObj, taosGetTimestampUs() - st, false);
+    }
   }
 
   /*
@@ -1687,46 +1702,143 @@ static int doPackSendDataBlock(SSqlObj* pSql, SInsertStatementParam *pInsertPara
 }
 
 typedef struct SImportFileSupport {
-  SSqlObj *pSql;
-  FILE    *fp;
+  SSqlObj        *pSql;          // the insert ... file statement
+  FILE           *fp;
+  pthread_mutex_t lock;          // serializes the reading of chunks from fp
+  int32_t         numOfWorkers;  // number of workers that have not finished yet
+  int32_t         code;          // the first error reported by any worker
+  int64_t         numOfRows;     // number of rows written into vnode
+  int64_t         numOfBytes;    // number of bytes read from the file
+  int64_t         startTime;
 } SImportFileSupport;
 
-static void parseFileSendDataBlock(void *param, TAOS_RES *tres, int32_t numOfRows) {
-  assert(param != NULL && tres != NULL);
+// Each worker reads the next chunk of lines from the file, parses it into a submit block and sends it with its own
+// sql object, so that several chunks are parsed by the tsc threads and several submit requests are in flight.
+typedef struct SImportFileWorker {
+  SImportFileSupport *pSupporter;
+  SSqlObj            *pSql;
+  char               *chunk;       // lines of the current chunk separated by '\0', kept until the chunk is written
+  size_t              chunkLen;
+  size_t              chunkCap;
+  int32_t             numOfLines;
+  int32_t             curLine;     // the lines of the chunk before it are written
+  size_t              curPos;      // offset of curLine in the chunk
+  int32_t             nextLine;    // the line after the ones in the submit block being sent
+  size_t              nextPos;
+  char               *line;        // line buffer of tgetline
+  size_t              lineCap;
+  char               *tokenBuf;
+} SImportFileWorker;
+
+static void parseFileSendDataBlock(void *param, TAOS_RES *tres, int32_t numOfRows);
+
+static void doFinishImportFileWorker(SImportFileWorker *pWorker) {
+  SImportFileSupport *pSupporter = pWorker->pSupporter;
+
+  taos_free_result(pWorker->pSql);
+  tfree(pWorker->chunk);
+  tfree(pWorker->line);
+  tfree(pWorker->tokenBuf);
+  tfree(pWorker);
+
+  if (atomic_sub_fetch_32(&pSupporter->numOfWorkers, 1) > 0) {
+    return;
+  }
+
+  // the last finished worker reports the result of the whole file
+  SSqlObj *pParentSql = pSupporter->pSql;
+  int32_t  code = pSupporter->code;
+  int64_t  numOfRows = pSupporter->numOfRows;
+
+  double elapsed = (taosGetTimestampUs() - pSupporter->startTime) / 1000000.0;
+  if (elapsed <= 0) {
+    elapsed = 1e-6;
+  }
+
+  tscDebug("0x%"PRIx64" import %"PRId64" rows, %"PRId64" bytes from file in %.3f sec, %.2f rows/s, %.2f bytes/s, code:%s",
+           pParentSql->self, numOfRows, pSupporter->numOfBytes, elapsed, numOfRows / elapsed,
+           pSupporter->numOfBytes / elapsed, tstrerror(code));
+
+  fclose(pSupporter->fp);
+  pthread_mutex_destroy(&pSupporter->lock);
+  tfree(pSupporter);
 
-  char *  tokenBuf = NULL;
-  size_t  n = 0;
+  pParentSql->res.code = code;
+  if (code != TSDB_CODE_SUCCESS) {
+    tscAsyncResultOnError(pParentSql);
+    return;
+  }
+
+  pParentSql->res.numOfRows = numOfRows;
+  pParentSql->fp = pParentSql->fetchFp;
+
+  // all data has been sent to vnode, call user function
+  (*pParentSql->fp)(pParentSql->param, pParentSql, (int32_t)numOfRows);
+}
+
+static int32_t readImportFileChunk(SImportFileWorker *pWorker, int32_t maxRows) {
+  SImportFileSupport *pSupporter = pWorker->pSupporter;
+
+  int32_t code = TSDB_CODE_SUCCESS;
+  int64_t numOfBytes = 0;
   ssize_t readLen = 0;
-  char *  line = NULL;
-  int32_t count = 0;
-  int32_t maxRows = 0;
-  FILE *  fp   = NULL;
 
-  SSqlObj *pSql = tres;
-  SSqlCmd *pCmd = &pSql->cmd;
+  pWorker->chunkLen = 0;
+  pWorker->numOfLines = 0;
+  pWorker->curLine = 0;
+  pWorker->curPos = 0;
 
-  SImportFileSupport *pSupporter = (SImportFileSupport *)param;
+  pthread_mutex_lock(&pSupporter->lock);
+  while (pWorker->numOfLines < maxRows && (readLen = tgetline(&pWorker->line, &pWorker->lineCap, pSupporter->fp)) != -1) {
+    numOfBytes += readLen;
 
-  SSqlObj *pParentSql = pSupporter->pSql;
-  fp = pSupporter->fp;
+    if (('\r' == pWorker->line[readLen - 1]) || ('\n' == pWorker->line[readLen - 1])) {
+      pWorker->line[--readLen] = 0;
+    }
 
-  int32_t code = pSql->res.code;
+    if (readLen == 0) {
+      continue;
+    }
 
-  // retry parse data from file and import data from the begining again
-  if (code == TSDB_CODE_TDB_TABLE_RECONFIGURE) {
-    assert(pSql->res.numOfRows == 0);
-    int32_t ret = fseek(fp, 0, SEEK_SET);
-    if (ret < 0) {
-      tscError("0x%"PRIx64" failed to seek SEEK_SET since:%s", pSql->self, tstrerror(errno));
-      code = TAOS_SYSTEM_ERROR(errno);
-      goto _error;
+    if (pWorker->chunkLen + readLen + 1 > pWorker->chunkCap) {
+      size_t cap = MAX(pWorker->chunkCap * 2, pWorker->chunkLen + readLen + 1);
+      char  *tmp = realloc(pWorker->chunk, cap);
+      if (tmp == NULL) {
+        code = TSDB_CODE_TSC_OUT_OF_MEMORY;
+        break;
+      }
+
+      pWorker->chunk = tmp;
+      pWorker->chunkCap = cap;
     }
-  } else if (code != TSDB_CODE_SUCCESS) {
-    goto _error;
+
+    char *dst = pWorker->chunk + pWorker->chunkLen;
+    strtolower(dst, pWorker->line);
+
+    pWorker->chunkLen += readLen + 1;
+    pWorker->numOfLines += 1;
   }
+  pthread_mutex_unlock(&pSupporter->lock);
+
+  atomic_add_fetch_64(&pSupporter->numOfBytes, numOfBytes);
+  return code;
+}
 
-  // accumulate the total submit records
-  pParentSql->res.numOfRows += pSql->res.numOfRows;
+static void doImportFileChunk(SSchedMsg *pMsg) {
+  SImportFileWorker  *pWorker = (SImportFileWorker *)pMsg->ahandle;
+  SImportFileSupport *pSupporter = pWorker->pSupporter;
+
+  int32_t maxRows = 0;
+  int32_t count = 0;
+
+  SSqlObj *pSql = pWorker->pSql;
+  SSqlCmd *pCmd = &pSql->cmd;
+
+  // stop importing the remain chunks once any worker fails
+  int32_t code = atomic_load_32(&pSupporter->code);
+  if (code != TSDB_CODE_SUCCESS) {
+    goto _end;
+  }
 
   STableMetaInfo *pTableMetaInfo = tscGetTableMetaInfoFromCmd(pCmd, 0);
   STableMeta *    pTableMeta = pTableMetaInfo->pTableMeta;
@@ -1735,96 +1847,118 @@ static void parseFileSendDataBlock(void *param, TAOS_RES *tres, int32_t numOfRow
   SInsertStatementParam *pInsertParam = &pCmd->insertParam;
   destroyTableNameList(pInsertParam);
 
-  pInsertParam->pDataBlocks = tscDestroyBlockArrayList(pParentSql, pInsertParam->pDataBlocks);
+  pInsertParam->pDataBlocks = tscDestroyBlockArrayList(pSql, pInsertParam->pDataBlocks);
 
   if (pInsertParam->pTableBlockHashList == NULL) {
     pInsertParam->pTableBlockHashList = taosHashInit(16, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BIGINT), true, false);
     if (pInsertParam->pTableBlockHashList == NULL) {
       code = TSDB_CODE_TSC_OUT_OF_MEMORY;
-      goto _error;
+      goto _end;
     }
   }
 
   STableDataBlocks *pTableDataBlock = NULL;
-  int32_t ret = tscGetDataBlockFromList(pInsertParam->pTableBlockHashList, pTableMeta->id.uid, TSDB_PAYLOAD_SIZE,
-                                        sizeof(SSubmitBlk), tinfo.rowSize, &pTableMetaInfo->name, pTableMeta,
-                                        &pTableDataBlock, NULL);
-  if (ret != TSDB_CODE_SUCCESS) {
-    pParentSql->res.code = TSDB_CODE_TSC_OUT_OF_MEMORY;
-    goto _error;
+  code = tscGetDataBlockFromList(pInsertParam->pTableBlockHashList, pTableMeta->id.uid, TSDB_PAYLOAD_SIZE,
+                                 sizeof(SSubmitBlk), tinfo.rowSize, &pTableMetaInfo->name, pTableMeta,
+                                 &pTableDataBlock, NULL);
+  if (code != TSDB_CODE_SUCCESS) {
+    code = TSDB_CODE_TSC_OUT_OF_MEMORY;
+    goto _end;
   }
 
   tscAllocateMemIfNeed(pTableDataBlock, getExtendedRowSize(pTableDataBlock), &maxRows);
-  tokenBuf = calloc(1, TSDB_MAX_BYTES_PER_ROW);
-  if (tokenBuf == NULL) {
+  if (pWorker->tokenBuf == NULL && (pWorker->tokenBuf = calloc(1, TSDB_MAX_BYTES_PER_ROW)) == NULL) {
     code = TSDB_CODE_TSC_OUT_OF_MEMORY;
-    goto _error;
+    goto _end;
   }
 
-  while ((readLen = tgetline(&line, &n, fp)) != -1) {
-    if (('\r' == line[readLen - 1]) || ('\n' == line[readLen - 1])) {
-      line[--readLen] = 0;
-    }
-
-    if (readLen == 0) {
-      continue;
-    }
+  // the lines of a chunk that are not written yet are parsed again, e.g., with the table schema attached, or when
+  // they do not fit into the submit block of a single request
+  if (pWorker->numOfLines == 0 && (code = readImportFileChunk(pWorker, maxRows)) != TSDB_CODE_SUCCESS) {
+    goto _end;
+  }
 
+  char   *line = pWorker->chunk + pWorker->curPos;
+  int32_t i = pWorker->curLine;
+  for (; i < pWorker->numOfLines && count < maxRows; ++i) {
+    char *row = line;
     char *lineptr = line;
-    strtolower(line, line);
+    line += strlen(line) + 1;
 
     int32_t len = 0;
-    code = tsParseOneRow(&lineptr, pTableDataBlock, tinfo.precision, &len, tokenBuf, pInsertParam);
-    if (code != TSDB_CODE_SUCCESS || pTableDataBlock->numOfParams > 0) {
+    code = tsParseOneRow(&lineptr, pTableDataBlock, tinfo.precision, &len, pWorker->tokenBuf, pInsertParam);
+    if (code == TSDB_CODE_SUCCESS && pTableDataBlock->numOfParams > 0) {
+      // a parameter placeholder is not a value, the import fails as it does for any other invalid line
+      tscError("0x%"PRIx64" parameter placeholder is not allowed in the data file: %s", pSql->self, row);
+      code = TSDB_CODE_TSC_INVALID_OPERATION;
+    }
+    if (code != TSDB_CODE_SUCCESS) {
       pSql->res.code = code;
       break;
     }
 
     pTableDataBlock->size += len;
+    count += 1;
+  }
 
-    if (++count >= maxRows) {
-      break;
-    }
+  if (code != TSDB_CODE_SUCCESS || count == 0) {
+    goto _end;
   }
 
-  tfree(tokenBuf);
-  tfree(line);
+  pWorker->nextLine = i;
+  pWorker->nextPos = line - pWorker->chunk;
 
-  pParentSql->res.code = code;
-  if (code == TSDB_CODE_SUCCESS) {
-    if (count > 0) {
-      pSql->res.numOfRows = 0;
-      code = doPackSendDataBlock(pSql, pInsertParam, pTableMeta, count, pTableDataBlock);
-      if (code != TSDB_CODE_SUCCESS) {
-        pParentSql->res.code = code;
-        goto _error;
-      }
+  pSql->res.numOfRows = 0;
+  code = doPackSendDataBlock(pSql, pInsertParam, pTableMeta, count, pTableDataBlock);
+  if (code != TSDB_CODE_SUCCESS) {
+    goto _end;
+  }
 
-      tscBuildAndSendRequest(pSql, NULL);
-      return;
-    } else {
-      taos_free_result(pSql);
-      tfree(pSupporter);
-      fclose(fp);
+  tscBuildAndSendRequest(pSql, NULL);
+  return;
 
-      pParentSql->fp = pParentSql->fetchFp;
+_end:
+  if (code != TSDB_CODE_SUCCESS) {
+    atomic_val_compare_exchange_32(&pSupporter->code, TSDB_CODE_SUCCESS, code);
+  }
+
+  doFinishImportFileWorker(pWorker);
+}
+
+static void scheduleImportFileChunk(SImportFileWorker *pWorker) {
+  SSchedMsg schedMsg = {0};
+  schedMsg.fp = doImportFileChunk;
+  schedMsg.ahandle = pWorker;
+  taosScheduleTask(tscQhandle, &schedMsg);
+}
+
+static void parseFileSendDataBlock(void *param, TAOS_RES *tres, int32_t numOfRows) {
+  assert(param != NULL && tres != NULL);
 
-      // all data has been sent to vnode, call user function
-      int32_t v = (int32_t)pParentSql->res.numOfRows;
-      (*pParentSql->fp)(pParentSql->param, pParentSql, v);
-      return;
+  SImportFileWorker  *pWorker = (SImportFileWorker *)param;
+  SImportFileSupport *pSupporter = pWorker->pSupporter;
+
+  SSqlObj *pSql = tres;
+  int32_t  code = pSql->res.code;
+
+  // parse the current chunk again and resend it with the table schema attached
+  if (code == TSDB_CODE_TDB_TABLE_RECONFIGURE) {
+    assert(pSql->res.numOfRows == 0);
+  } else if (code != TSDB_CODE_SUCCESS) {
+    atomic_val_compare_exchange_32(&pSupporter->code, TSDB_CODE_SUCCESS, code);
+    doFinishImportFileWorker(pWorker);
+    return;
+  } else {
+    // accumulate the total submit records
+    atomic_add_fetch_64(&pSupporter->numOfRows, pSql->res.numOfRows);
+    pWorker->curLine = pWorker->nextLine;
+    pWorker->curPos = pWorker->nextPos;
+    if (pWorker->curLine >= pWorker->numOfLines) {
+      pWorker->numOfLines = 0;
     }
   }
 
-_error:
-  pParentSql->res.code = code;
-  tfree(tokenBuf);
-  tfree(line);
-  taos_free_result(pSql);
-  tfree(pSupporter);
-  fclose(fp);
-
-  tscAsyncResultOnError(pParentSql);
+  scheduleImportFileChunk(pWorker);
 }
 
 void tscImportDataFromFile(SSqlObj *pSql) {
@@ -1837,22 +1971,63 @@ void tscImportDataFromFile(SSqlObj *pSql) {
   assert(TSDB_QUERY_HAS_TYPE(pInsertParam->insertType, TSDB_QUERY_TYPE_FILE_INSERT) && strlen(pCmd->payload) != 0);
   pCmd->active = pCmd->pQueryInfo;
 
-  SImportFileSupport *pSupporter = calloc(1, sizeof(SImportFileSupport));
-  SSqlObj *pNew = createSubqueryObj(pSql, 0, parseFileSendDataBlock, pSupporter, TSDB_SQL_INSERT, NULL);
-
   FILE *fp = fopen(pCmd->payload, "rb");
   if (fp == NULL) {
     pSql->res.code = TAOS_SYSTEM_ERROR(errno);
     tscError("0x%"PRIx64" failed to open file %s to load data from file, code:%s", pSql->self, pCmd->payload, tstrerror(pSql->res.code));
 
-    tfree(pSupporter);
-    taos_free_result(pNew);
     tscAsyncResultOnError(pSql);
     return;
   }
 
+  int32_t             numOfWorkers = MAX(tsImportParallelism, 1);
+  SImportFileSupport *pSupporter = calloc(1, sizeof(SImportFileSupport));
+  SImportFileWorker **pWorkers = calloc(numOfWorkers, POINTER_BYTES);
+  if (pSupporter == NULL || pWorkers == NULL) {
+    goto _error;
+  }
+
+  for (int32_t i = 0; i < numOfWorkers; ++i) {
+    pWorkers[i] = calloc(1, sizeof(SImportFileWorker));
+    if (pWorkers[i] == NULL) {
+      goto _error;
+    }
+
+    pWorkers[i]->pSupporter = pSupporter;
+    pWorkers[i]->pSql = createSubqueryObj(pSql, 0, parseFileSendDataBlock, pWorkers[i], TSDB_SQL_INSERT, NULL);
+    if (pWorkers[i]->pSql == NULL) {
+      goto _error;
+    }
+  }
+
   pSupporter->pSql = pSql;
   pSupporter->fp   = fp;
+  pSupporter->numOfWorkers = numOfWorkers;
+  pSupporter->startTime = taosGetTimestampUs();
+  pthread_mutex_init(&pSupporter->lock, NULL);
+
+  tscDebug("0x%"PRIx64" start to import data from file %s by %d workers", pSql->self, pCmd->payload, numOfWorkers);
+
+  for (int32_t i = 0; i < numOfWorkers; ++i) {
+    scheduleImportFileChunk(pWorkers[i]);
+  }
+
+  tfree(pWorkers);
+  return;
+
+_error:
+  for (int32_t i = 0; pWorkers != NULL && i < numOfWorkers; ++i) {
+    if (pWorkers[i] != NULL && pWorkers[i]->pSql != NULL) {
+      taos_free_result(pWorkers[i]->pSql);
+    }
+
+    tfree(pWorkers[i]);
+  }
+
+  tfree(pWorkers);
+  tfree(pSupporter);
+  fclose(fp);
 
-  parseFileSendDataBlock(pSupporter, pNew, TSDB_CODE_SUCCESS);
+  pSql->res.code = TSDB_CODE_TSC_OUT_OF_MEMORY;
+  tscAsyncResultOnError(pSql);
 }
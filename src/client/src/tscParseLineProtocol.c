@@ -18,6 +18,9 @@
 
 #include "taos.h"
 #include "tscParseLine.h"
+#include "tscSubquery.h"
+
+int32_t tsCheckTimestamp(STableDataBlocks *pDataBlocks, const char *start);
 
 typedef struct  {
   char sTableName[TSDB_TABLE_NAME_LEN + TS_ESCAPE_CHAR_SIZE];
@@ -26,8 +29,15 @@ typedef struct  {
   SArray* tags; //SArray<SSchema>
   SArray* fields; //SArray<SSchema>
   uint8_t precision;
+  STableMeta* tableMeta; // meta of the super table, used to build the submit blocks directly
+  bool cached; // tableMeta is taken from the schema cache, it may be out of date
 } SSmlSTableSchema;
 
+typedef struct SSmlSchemaCache {
+  pthread_mutex_t lock;
+  SHashObj*       pSTables;  // "<db>.<super table name>" -> SSmlSTableSchema* loaded from db
+} SSmlSchemaCache;
+
 //=================================================================================================
 
 static uint64_t linesSmlHandleId = 0;
@@ -214,7 +224,7 @@ static int32_t buildDataPointSchemas(TAOS_SML_DATA_POINT* points, int numPoint,
       pStableSchema= taosArrayGet(stableSchemas, *pStableIdx);
       stableIdx = *pStableIdx;
     } else {
-      SSmlSTableSchema schema;
+      SSmlSTableSchema schema = {0};
       strncpy(schema.sTableName, point->stableName, stableNameLen);
       schema.sTableName[stableNameLen] = '\0';
       schema.fields = taosArrayInit(64, sizeof(SSchema));
@@ -517,6 +527,7 @@ static int32_t destroySmlSTableSchema(SSmlSTableSchema* schema) {
   taosHashCleanup(schema->fieldHash);
   taosArrayDestroy(schema->tags);
   taosArrayDestroy(schema->fields);
+  tfree(schema->tableMeta);
   return 0;
 }
 
@@ -634,18 +645,208 @@ static int32_t loadTableSchemaFromDB(TAOS* taos, char* tableName, SSmlSTableSche
   if (code == TSDB_CODE_SUCCESS) {
     assert(tableMeta != NULL);
     fillDbSchema(tableMeta, tableName, schema, info);
-    free(tableMeta);
-    tableMeta = NULL;
+    schema->tableMeta = tableMeta;
   }
 
   return code;
 }
 
+static void destroySmlSchemaCacheEntry(SSmlSTableSchema* schema) {
+  destroySmlSTableSchema(schema);
+  free(schema);
+}
+
+static SSmlSchemaCache* createSmlSchemaCache() {
+  SSmlSchemaCache* pCache = calloc(1, sizeof(SSmlSchemaCache));
+  if (pCache == NULL) {
+    return NULL;
+  }
+
+  pCache->pSTables = taosHashInit(32, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), true, HASH_NO_LOCK);
+  if (pCache->pSTables == NULL) {
+    free(pCache);
+    return NULL;
+  }
+
+  pthread_mutex_init(&pCache->lock, NULL);
+  return pCache;
+}
+
+void tscDestroySmlSchemaCache(SSmlSchemaCache* pCache) {
+  if (pCache == NULL) {
+    return;
+  }
+
+  SSmlSTableSchema** ppSchema = taosHashIterate(pCache->pSTables, NULL);
+  while (ppSchema != NULL) {
+    destroySmlSchemaCacheEntry(*ppSchema);
+    ppSchema = taosHashIterate(pCache->pSTables, ppSchema);
+  }
+
+  taosHashCleanup(pCache->pSTables);
+  pthread_mutex_destroy(&pCache->lock);
+  free(pCache);
+}
+
+static SSmlSchemaCache* getOrCreateSmlSchemaCache(STscObj* pObj) {
+  SSmlSchemaCache* pCache = atomic_load_ptr(&pObj->pSmlCache);
+  if (pCache != NULL) {
+    return pCache;
+  }
+
+  pthread_mutex_lock(&pObj->mutex);
+  if (pObj->pSmlCache == NULL) {
+    atomic_store_ptr(&pObj->pSmlCache, createSmlSchemaCache());
+  }
+
+  pCache = pObj->pSmlCache;
+  pthread_mutex_unlock(&pObj->mutex);
+
+  return pCache;
+}
+
+/*
+ * the super tables are cached by the current database of the connection and the super table name
+ */
+static int32_t buildSmlSchemaCacheKey(STscObj* pObj, const char* sTableName, char* key) {
+  char db[TSDB_ACCT_ID_LEN + TSDB_DB_NAME_LEN] = {0};
+  pthread_mutex_lock(&pObj->mutex);
+  tstrncpy(db, pObj->db, tListLen(db));
+  pthread_mutex_unlock(&pObj->mutex);
+
+  return sprintf(key, "%s.%s", db, sTableName);
+}
+
+/*
+ * the cached super table covers the point schema if every tag and column of the points exists with the same type,
+ * and the binary/nchar values fit in the existing length
+ */
+static bool smlSchemaCovered(SSmlSTableSchema* pointSchema, SSmlSTableSchema* dbSchema) {
+  size_t numTags = taosArrayGetSize(pointSchema->tags);
+  for (int32_t i = 0; i < numTags; ++i) {
+    SSchema* pointTag = taosArrayGet(pointSchema->tags, i);
+    size_t*  pDbIndex = taosHashGet(dbSchema->tagHash, pointTag->name, strlen(pointTag->name));
+    if (pDbIndex == NULL) {
+      return false;
+    }
+
+    SSchema* dbTag = taosArrayGet(dbSchema->tags, *pDbIndex);
+    if (dbTag->type != pointTag->type || (IS_VAR_DATA_TYPE(pointTag->type) && pointTag->bytes > dbTag->bytes)) {
+      return false;
+    }
+  }
+
+  size_t numFields = taosArrayGetSize(pointSchema->fields);
+  for (int32_t i = 1; i < numFields; ++i) {
+    SSchema* pointCol = taosArrayGet(pointSchema->fields, i);
+    size_t*  pDbIndex = taosHashGet(dbSchema->fieldHash, pointCol->name, strlen(pointCol->name));
+    if (pDbIndex == NULL) {
+      return false;
+    }
+
+    SSchema* dbCol = taosArrayGet(dbSchema->fields, *pDbIndex);
+    if (dbCol->type != pointCol->type || (IS_VAR_DATA_TYPE(pointCol->type) && pointCol->bytes > dbCol->bytes)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/*
+ * fill the precision, the timestamp column name and the super table meta of the point schema from the schema cache
+ * @return true if the super table needs no change, so that it is not loaded from db
+ */
+static bool getSchemaFromSmlCache(TAOS* taos, SSmlSTableSchema* pointSchema, SSmlLinesInfo* info) {
+  SSmlSchemaCache* pCache = atomic_load_ptr(&((STscObj*)taos)->pSmlCache);
+  if (pCache == NULL) {
+    return false;
+  }
+
+  char key[TSDB_ACCT_ID_LEN + TSDB_DB_NAME_LEN + TSDB_TABLE_NAME_LEN + TS_ESCAPE_CHAR_SIZE + 2] = {0};
+  int32_t keyLen = buildSmlSchemaCacheKey(taos, pointSchema->sTableName, key);
+
+  bool covered = false;
+  pthread_mutex_lock(&pCache->lock);
+  SSmlSTableSchema** ppSchema = taosHashGet(pCache->pSTables, key, keyLen);
+  if (ppSchema != NULL && smlSchemaCovered(pointSchema, *ppSchema)) {
+    SSmlSTableSchema* dbSchema = *ppSchema;
+    pointSchema->tableMeta = tscTableMetaDup(dbSchema->tableMeta);
+    if (pointSchema->tableMeta != NULL) {
+      SSchema* pointColTs = taosArrayGet(pointSchema->fields, 0);
+      SSchema* dbColTs = taosArrayGet(dbSchema->fields, 0);
+      memcpy(pointColTs->name, dbColTs->name, TSDB_COL_NAME_LEN + TS_ESCAPE_CHAR_SIZE);
+      pointSchema->precision = dbSchema->precision;
+      covered = true;
+    }
+  }
+  pthread_mutex_unlock(&pCache->lock);
+
+  if (covered) {
+    tscDebug("SML:0x%"PRIx64" super table %s is found in schema cache", info->id, pointSchema->sTableName);
+  }
+  return covered;
+}
+
+/*
+ * keep the super table schema loaded from db in the schema cache, the cache takes over the schema
+ */
+static void putSchemaIntoSmlCache(TAOS* taos, SSmlSTableSchema* dbSchema) {
+  SSmlSchemaCache* pCache = getOrCreateSmlSchemaCache(taos);
+  SSmlSTableSchema* pSchema = (pCache != NULL)? malloc(sizeof(SSmlSTableSchema)) : NULL;
+  if (pSchema == NULL) {
+    destroySmlSTableSchema(dbSchema);
+    return;
+  }
+
+  *pSchema = *dbSchema;
+
+  char key[TSDB_ACCT_ID_LEN + TSDB_DB_NAME_LEN + TSDB_TABLE_NAME_LEN + TS_ESCAPE_CHAR_SIZE + 2] = {0};
+  int32_t keyLen = buildSmlSchemaCacheKey(taos, pSchema->sTableName, key);
+
+  pthread_mutex_lock(&pCache->lock);
+  SSmlSTableSchema** ppSchema = taosHashGet(pCache->pSTables, key, keyLen);
+  if (ppSchema != NULL) {
+    destroySmlSchemaCacheEntry(*ppSchema);
+    taosHashRemove(pCache->pSTables, key, keyLen);
+  }
+
+  if (taosHashPut(pCache->pSTables, key, keyLen, &pSchema, POINTER_BYTES) != 0) {
+    destroySmlSchemaCacheEntry(pSchema);
+  }
+  pthread_mutex_unlock(&pCache->lock);
+}
+
+static void removeSchemaFromSmlCache(TAOS* taos, const char* sTableName) {
+  SSmlSchemaCache* pCache = atomic_load_ptr(&((STscObj*)taos)->pSmlCache);
+  if (pCache == NULL) {
+    return;
+  }
+
+  char key[TSDB_ACCT_ID_LEN + TSDB_DB_NAME_LEN + TSDB_TABLE_NAME_LEN + TS_ESCAPE_CHAR_SIZE + 2] = {0};
+  int32_t keyLen = buildSmlSchemaCacheKey(taos, sTableName, key);
+
+  pthread_mutex_lock(&pCache->lock);
+  SSmlSTableSchema** ppSchema = taosHashGet(pCache->pSTables, key, keyLen);
+  if (ppSchema != NULL) {
+    destroySmlSchemaCacheEntry(*ppSchema);
+    taosHashRemove(pCache->pSTables, key, keyLen);
+  }
+  pthread_mutex_unlock(&pCache->lock);
+}
+
 static int32_t modifyDBSchemas(TAOS* taos, SArray* stableSchemas, SSmlLinesInfo* info) {
   int32_t code = 0;
   size_t numStable = taosArrayGetSize(stableSchemas);
   for (int i = 0; i < numStable; ++i) {
     SSmlSTableSchema* pointSchema = taosArrayGet(stableSchemas, i);
+    tfree(pointSchema->tableMeta);
+    pointSchema->cached = false;
+    if (tsSmlDirectSubmit && getSchemaFromSmlCache(taos, pointSchema, info)) {
+      pointSchema->cached = true;
+      continue;
+    }
+
     SSmlSTableSchema  dbSchema;
     memset(&dbSchema, 0, sizeof(SSmlSTableSchema));
 
@@ -672,6 +873,7 @@ static int32_t modifyDBSchemas(TAOS* taos, SArray* stableSchemas, SSmlLinesInfo*
 
       SHashObj* dbTagHash = dbSchema.tagHash;
       SHashObj* dbFieldHash = dbSchema.fieldHash;
+      bool      schemaChanged = false;
 
       for (int j = 0; j < pointTagSize; ++j) {
         SSchema* pointTag = taosArrayGet(pointSchema->tags, j);
@@ -685,6 +887,7 @@ static int32_t modifyDBSchemas(TAOS* taos, SArray* stableSchemas, SSmlLinesInfo*
             destroySmlSTableSchema(&dbSchema);
             return code;
           }
+          schemaChanged = true;
         }
       }
 
@@ -704,12 +907,34 @@ static int32_t modifyDBSchemas(TAOS* taos, SArray* stableSchemas, SSmlLinesInfo*
             destroySmlSTableSchema(&dbSchema);
             return code;
           }
+          schemaChanged = true;
         }
       }
 
       pointSchema->precision = dbSchema.precision;
 
-      destroySmlSTableSchema(&dbSchema);
+      if (!tsSmlDirectSubmit) {
+        destroySmlSTableSchema(&dbSchema);
+        continue;
+      }
+
+      // the submit blocks are built with the super table meta, so load it again once the super table is changed
+      if (schemaChanged) {
+        destroySmlSTableSchema(&dbSchema);
+        memset(&dbSchema, 0, sizeof(SSmlSTableSchema));
+        code = loadTableSchemaFromDB(taos, pointSchema->sTableName, &dbSchema, info);
+        if (code != 0) {
+          tscError("SML:0x%"PRIx64" reload table meta error: %s", info->id, tstrerror(code));
+          return code;
+        }
+      }
+
+      pointSchema->tableMeta = tscTableMetaDup(dbSchema.tableMeta);
+      if (pointSchema->tableMeta == NULL) {
+        destroySmlSTableSchema(&dbSchema);
+        return TSDB_CODE_TSC_OUT_OF_MEMORY;
+      }
+      putSchemaIntoSmlCache(taos, &dbSchema);
     } else {
       tscError("SML:0x%"PRIx64" load table meta error: %s", info->id, tstrerror(code));
       return code;
@@ -1062,13 +1287,587 @@ static int32_t applyChildTableFields(TAOS* taos, SSmlSTableSchema* sTableSchema,
   return code;
 }
 
+//=================================================================================================
+// build the submit blocks of the points directly with the super table meta, instead of binding them to statements
+
+typedef struct {
+  int16_t* colIndex;   // column index in the super table of each field of the point schema
+  int32_t* colOffset;  // offset of each column of the super table in the row
+} SSmlColumnMap;
+
+static bool smlColumnNameMatches(const char* escapedName, const char* name) {
+  size_t len = strlen(name);
+  return strlen(escapedName) == len + TS_ESCAPE_CHAR_SIZE && strncmp(escapedName + 1, name, len) == 0;
+}
+
+static int32_t setSmlTableName(SSqlObj* pSql, const char* tableName, SName* pName) {
+  char   tableNameBuf[TSDB_TABLE_NAME_LEN + TS_ESCAPE_CHAR_SIZE] = {0};
+  size_t len = strlen(tableName);
+  if (len >= tListLen(tableNameBuf)) {
+    return TSDB_CODE_TSC_INVALID_TABLE_ID_LENGTH;
+  }
+
+  memcpy(tableNameBuf, tableName, len);
+  SStrToken tableToken = {.z = tableNameBuf, .n = (uint32_t)len, .type = TK_ID};
+  tGetToken(tableNameBuf, &tableToken.type);
+  bool dbIncluded = false;
+  if (tscValidateName(&tableToken, true, &dbIncluded) != TSDB_CODE_SUCCESS) {
+    return TSDB_CODE_TSC_INVALID_TABLE_ID_LENGTH;
+  }
+
+  return tscSetTableFullName(pName, &tableToken, pSql, dbIncluded);
+}
+
+/*
+ * write the value of the kv in the format of the column, TSDB_CODE_TDB_IVD_TB_SCHEMA_VERSION is returned if the
+ * value does not fit the column any more
+ */
+static int32_t smlKvToColumnValue(TAOS_SML_KV* kv, SSchema* pSchema, char* val) {
+  if (kv->type != pSchema->type) {
+    return TSDB_CODE_TSC_INVALID_VALUE;
+  }
+
+  if (kv->type == TSDB_DATA_TYPE_BINARY) {
+    if (kv->length + VARSTR_HEADER_SIZE > pSchema->bytes) {
+      return TSDB_CODE_TDB_IVD_TB_SCHEMA_VERSION;
+    }
+    STR_WITH_SIZE_TO_VARSTR(val, kv->value, kv->length);
+  } else if (kv->type == TSDB_DATA_TYPE_NCHAR) {
+    int32_t output = 0;
+    if (!taosMbsToUcs4(kv->value, kv->length, varDataVal(val), pSchema->bytes - VARSTR_HEADER_SIZE, &output)) {
+      return TSDB_CODE_TDB_IVD_TB_SCHEMA_VERSION;
+    }
+    varDataSetLen(val, output);
+  } else {
+    memcpy(val, kv->value, pSchema->bytes);
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+static int32_t buildSmlColumnMap(SSmlSTableSchema* sTableSchema, SSmlColumnMap* pMap, SSmlLinesInfo* info) {
+  STableMeta* pSTableMeta = sTableSchema->tableMeta;
+  SSchema*    pSchema = tscGetTableSchema(pSTableMeta);
+  int32_t     numOfCols = tscGetNumOfColumns(pSTableMeta);
+  size_t      numOfFields = taosArrayGetSize(sTableSchema->fields);
+
+  pMap->colIndex = calloc(numOfFields, sizeof(int16_t));
+  pMap->colOffset = calloc(numOfCols, sizeof(int32_t));
+  if (pMap->colIndex == NULL || pMap->colOffset == NULL) {
+    return TSDB_CODE_TSC_OUT_OF_MEMORY;
+  }
+
+  for (int32_t i = 1; i < numOfCols; ++i) {
+    pMap->colOffset[i] = pMap->colOffset[i - 1] + pSchema[i - 1].bytes;
+  }
+
+  // the first field is always the timestamp column
+  for (int32_t i = 1; i < numOfFields; ++i) {
+    SSchema* pField = taosArrayGet(sTableSchema->fields, i);
+
+    int16_t j = 1;
+    while (j < numOfCols && !smlColumnNameMatches(pField->name, pSchema[j].name)) {
+      ++j;
+    }
+
+    if (j == numOfCols) {
+      tscDebug("SML:0x%"PRIx64" column %s is not found in super table %s", info->id, pField->name, sTableSchema->sTableName);
+      return TSDB_CODE_TDB_IVD_TB_SCHEMA_VERSION;
+    }
+
+    if (pField->type != pSchema[j].type) {
+      tscError("SML:0x%"PRIx64" point type and db type mismatch. key: %s. point type: %d, db type: %d", info->id,
+               pField->name, pField->type, pSchema[j].type);
+      return TSDB_CODE_TSC_INVALID_VALUE;
+    }
+    pMap->colIndex[i] = j;
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+static void destroySmlColumnMaps(SSmlColumnMap* maps, size_t numOfMaps) {
+  for (int32_t i = 0; i < numOfMaps; ++i) {
+    tfree(maps[i].colIndex);
+    tfree(maps[i].colOffset);
+  }
+  free(maps);
+}
+
+/*
+ * the tag values of the child table to create, the tags that the points do not carry are null
+ */
+static int32_t buildSmlTagData(SSqlObj* pSql, SSmlSTableSchema* sTableSchema, SArray* cTablePoints, SSmlLinesInfo* info) {
+  STableMeta* pSTableMeta = sTableSchema->tableMeta;
+  SSchema*    pTagSchema = tscGetTableTagSchema(pSTableMeta);
+  int32_t     numOfTags = tscGetNumOfTags(pSTableMeta);
+  size_t      numOfPointTags = taosArrayGetSize(sTableSchema->tags);
+
+  int32_t      numOfKVs = 0;
+  TAOS_SML_KV* tagKVs[TSDB_MAX_TAGS] = {0};
+  size_t rows = taosArrayGetSize(cTablePoints);
+  for (int32_t i = 0; i < rows; ++i) {
+    TAOS_SML_DATA_POINT* pDataPoint = taosArrayGetP(cTablePoints, i);
+    for (int32_t j = 0; j < pDataPoint->tagNum; ++j) {
+      TAOS_SML_KV* kv = pDataPoint->tags + j;
+      numOfKVs += (tagKVs[kv->fieldSchemaIdx] == NULL)? 1 : 0;
+      tagKVs[kv->fieldSchemaIdx] = kv;
+    }
+  }
+
+  SKVRowBuilder kvRowBuilder = {0};
+  if (tdInitKVRowBuilder(&kvRowBuilder) < 0) {
+    return TSDB_CODE_TSC_OUT_OF_MEMORY;
+  }
+
+  int32_t code = TSDB_CODE_SUCCESS;
+  char    tagVal[TSDB_MAX_TAGS_LEN];
+  for (int32_t i = 0; i < numOfTags && code == TSDB_CODE_SUCCESS; ++i) {
+    SSchema*     pSchema = &pTagSchema[i];
+    TAOS_SML_KV* kv = NULL;
+    for (int32_t j = 0; j < numOfPointTags; ++j) {
+      SSchema* pointTag = taosArrayGet(sTableSchema->tags, j);
+      if (smlColumnNameMatches(pointTag->name, pSchema->name)) {
+        kv = tagKVs[j];
+        break;
+      }
+    }
+
+    if (kv == NULL) {
+      tdAddColToKVRow(&kvRowBuilder, pSchema->colId, pSchema->type, (void*)getNullValue(pSchema->type));
+    } else if ((code = smlKvToColumnValue(kv, pSchema, tagVal)) == TSDB_CODE_SUCCESS) {
+      tdAddColToKVRow(&kvRowBuilder, pSchema->colId, pSchema->type, tagVal);
+      numOfKVs -= 1;
+    }
+  }
+
+  // some tags of the points do not exist in the super table any more
+  if (code == TSDB_CODE_SUCCESS && numOfKVs > 0) {
+    code = TSDB_CODE_TDB_IVD_TB_SCHEMA_VERSION;
+  }
+
+  if (code != TSDB_CODE_SUCCESS) {
+    tdDestroyKVRowBuilder(&kvRowBuilder);
+    return code;
+  }
+
+  SKVRow row = tdGetKVRowFromBuilder(&kvRowBuilder);
+  tdDestroyKVRowBuilder(&kvRowBuilder);
+  if (row == NULL) {
+    return TSDB_CODE_TSC_OUT_OF_MEMORY;
+  }
+  tdSortKVRowByColIdx(row);
+
+  STagData* pTagData = &pSql->cmd.insertParam.tagData;
+  char*     pTag = realloc(pTagData->data, kvRowLen(row));
+  if (pTag == NULL) {
+    free(row);
+    return TSDB_CODE_TSC_OUT_OF_MEMORY;
+  }
+
+  kvRowCpy(pTag, row);
+  pTagData->data = pTag;
+  pTagData->dataLen = kvRowLen(row);
+  free(row);
+
+  SName sname = {0};
+  code = setSmlTableName(pSql, sTableSchema->sTableName, &sname);
+  if (code == TSDB_CODE_SUCCESS) {
+    code = tNameExtractFullName(&sname, pTagData->name);
+  }
+  return code;
+}
+
+static void smlTableMetaCallback(void* param, TAOS_RES* res, int code) {
+  SSqlObj* pSql = (SSqlObj*)taosAcquireRef(tscObjRef, (int64_t)param);
+  if (pSql == NULL) {
+    return;
+  }
+  taosReleaseRef(tscObjRef, pSql->self);
+
+  pSql->res.code = code;
+  tsem_post(&pSql->rspSem);
+}
+
+/*
+ * acquire the meta of the child table from the local meta buffer, the child table is created with the tags of the
+ * points by the table meta request if it does not exist
+ */
+static int32_t getSmlChildTableMeta(SSqlObj* pSql, STableMetaInfo* pTableMetaInfo, SSmlSTableSchema* sTableSchema,
+                                    SArray* cTablePoints, SSmlLinesInfo* info) {
+  TAOS_SML_DATA_POINT* point = taosArrayGetP(cTablePoints, 0);
+
+  int32_t code = setSmlTableName(pSql, point->childTableName, &pTableMetaInfo->name);
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  char fname[TSDB_TABLE_FNAME_LEN] = {0};
+  code = tNameExtractFullName(&pTableMetaInfo->name, fname);
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  // the tag data is only built for a child table which is not known locally, it may not exist yet
+  bool autocreate = (taosHashGet(UTIL_GET_TABLEMETA(pSql), fname, strlen(fname)) == NULL);
+  if (autocreate && sTableSchema->cached) {
+    // the tags of a cached schema may have been dropped or changed, and a child table created with them would keep
+    // null tags, so the super table is loaded from db first
+    tscDebug("SML:0x%"PRIx64" child table %s may be created, verify the cached super table %s", info->id,
+             point->childTableName, sTableSchema->sTableName);
+    return TSDB_CODE_TDB_IVD_TB_SCHEMA_VERSION;
+  }
+
+  if (autocreate) {
+    tscDebug("SML:0x%"PRIx64" get meta of child table %s from mnode", info->id, point->childTableName);
+    code = buildSmlTagData(pSql, sTableSchema, cTablePoints, info);
+  }
+
+  // the meta is in the local buffer once the request to mnode returns, so the second call is done locally
+  for (int32_t i = 0; i < 2 && code == TSDB_CODE_SUCCESS; ++i) {
+    code = tscGetTableMetaWithCallBack(pSql, pTableMetaInfo, autocreate, smlTableMetaCallback);
+    if (code != TSDB_CODE_TSC_ACTION_IN_PROGRESS) {
+      break;
+    }
+
+    tsem_wait(&pSql->rspSem);
+    code = pSql->res.code;
+    if (code == TSDB_CODE_SUCCESS && i == 1) {
+      code = TSDB_CODE_TSC_NO_META_CACHED;
+    }
+  }
+
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  STableMeta* pTableMeta = pTableMetaInfo->pTableMeta;
+  STableMeta* pSTableMeta = sTableSchema->tableMeta;
+  if (pTableMeta->tableType != TSDB_CHILD_TABLE) {
+    tscError("SML:0x%"PRIx64" table %s is not a child table", info->id, point->childTableName);
+    return TSDB_CODE_TDB_INVALID_TABLE_TYPE;
+  }
+
+  if (pTableMeta->suid != pSTableMeta->id.uid || pTableMeta->sversion != pSTableMeta->sversion ||
+      pTableMeta->tversion != pSTableMeta->tversion) {
+    tscDebug("SML:0x%"PRIx64" super table %s of child table %s has been changed", info->id, sTableSchema->sTableName,
+             point->childTableName);
+    return TSDB_CODE_TDB_IVD_TB_SCHEMA_VERSION;
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+static int32_t appendSmlRow(STableDataBlocks* pBlock, STableMeta* pSTableMeta, SSmlColumnMap* pMap,
+                            TAOS_SML_DATA_POINT* point, int32_t rowIdx, SSmlLinesInfo* info) {
+  if (pBlock->size + pBlock->rowSize > pBlock->nAllocSize) {
+    const double factor = 1.5;
+
+    uint32_t allocSize = (uint32_t)((pBlock->size + pBlock->rowSize) * factor);
+    char*    tmp = realloc(pBlock->pData, allocSize);
+    if (tmp == NULL) {
+      return TSDB_CODE_TSC_OUT_OF_MEMORY;
+    }
+
+    pBlock->pData = tmp;
+    pBlock->nAllocSize = allocSize;
+  }
+
+  SSchema* pSchema = tscGetTableSchema(pSTableMeta);
+  int32_t  numOfCols = tscGetNumOfColumns(pSTableMeta);
+  char*    row = pBlock->pData + pBlock->size;
+  for (int32_t i = 0; i < numOfCols; ++i) {
+    setNull(row + pMap->colOffset[i], pSchema[i].type, pSchema[i].bytes);
+  }
+
+  for (int32_t i = 0; i < point->fieldNum; ++i) {
+    TAOS_SML_KV* kv = point->fields + i;
+    int16_t      colIndex = pMap->colIndex[kv->fieldSchemaIdx];
+    int32_t      code = smlKvToColumnValue(kv, &pSchema[colIndex], row + pMap->colOffset[colIndex]);
+    if (code != TSDB_CODE_SUCCESS) {
+      return code;
+    }
+  }
+
+  if (tsCheckTimestamp(pBlock, row) != TSDB_CODE_SUCCESS) {
+    tscError("SML:0x%"PRIx64" invalid timestamp %"PRId64" of point %d of child table %s, client and server time can not "
+             "be mixed", info->id, *(TSKEY*)(row + pMap->colOffset[0]), rowIdx, point->childTableName);
+    return TSDB_CODE_TSC_INVALID_VALUE;
+  }
+
+  pBlock->size += pBlock->rowSize;
+  return tsSetBlockInfo((SSubmitBlk*)pBlock->pData, pBlock->pTableMeta, 1);
+}
+
+/*
+ * append the rows of the child tables from position (tIdx, rIdx) into the data blocks, until all points are appended
+ * or the submit message is about to exceed the limit of wal
+ */
+static int32_t buildSmlDataBlocks(SSqlObj* pSql, SArray* cTables, SArray* stableSchemas, SSmlColumnMap* maps,
+                                  int32_t* tIdx, int32_t* rIdx, SSmlLinesInfo* info) {
+  SSqlCmd*        pCmd = &pSql->cmd;
+  STableMetaInfo* pTableMetaInfo = tscGetTableMetaInfoFromCmd(pCmd, 0);
+  size_t          maxSize = TSDB_MAX_WAL_SIZE * 4 / 5;
+  size_t          size = 0;
+
+  size_t numOfTables = taosArrayGetSize(cTables);
+  for (; *tIdx < numOfTables; ++(*tIdx), *rIdx = 0) {
+    SArray*              cTablePoints = taosArrayGetP(cTables, *tIdx);
+    TAOS_SML_DATA_POINT* point = taosArrayGetP(cTablePoints, 0);
+    SSmlSTableSchema*    sTableSchema = taosArrayGet(stableSchemas, point->schemaIdx);
+    SSmlColumnMap*       pMap = &maps[point->schemaIdx];
+    STableMeta*          pSTableMeta = sTableSchema->tableMeta;
+    int32_t              rowSize = pSTableMeta->tableInfo.rowSize;
+
+    if (size > 0 && size + rowSize > maxSize) {
+      break;
+    }
+
+    int32_t code = TSDB_CODE_SUCCESS;
+    if (pMap->colIndex == NULL && (code = buildSmlColumnMap(sTableSchema, pMap, info)) != TSDB_CODE_SUCCESS) {
+      return code;
+    }
+
+    code = getSmlChildTableMeta(pSql, pTableMetaInfo, sTableSchema, cTablePoints, info);
+    if (code != TSDB_CODE_SUCCESS) {
+      tscError("SML:0x%"PRIx64" get meta of child table %s failed. error %s", info->id, point->childTableName,
+               tstrerror(code));
+      return code;
+    }
+
+    STableMeta*       pTableMeta = pTableMetaInfo->pTableMeta;
+    STableDataBlocks* pBlock = NULL;
+    code = tscGetDataBlockFromList(pCmd->insertParam.pTableBlockHashList, pTableMeta->id.uid, TSDB_PAYLOAD_SIZE,
+                                   sizeof(SSubmitBlk), rowSize, &pTableMetaInfo->name, pTableMeta, &pBlock, NULL);
+    if (code != TSDB_CODE_SUCCESS) {
+      return code;
+    }
+
+    size_t rows = taosArrayGetSize(cTablePoints);
+    for (; *rIdx < rows; ++(*rIdx)) {
+      if ((size > 0 && size + rowSize > maxSize) || ((SSubmitBlk*)pBlock->pData)->numOfRows >= INT16_MAX - 1) {
+        return TSDB_CODE_SUCCESS;
+      }
+
+      code = appendSmlRow(pBlock, pSTableMeta, pMap, taosArrayGetP(cTablePoints, *rIdx), *rIdx, info);
+      if (code != TSDB_CODE_SUCCESS) {
+        tscError("SML:0x%"PRIx64" append row to child table %s failed. error %s", info->id, point->childTableName,
+                 tstrerror(code));
+        return code;
+      }
+      size += rowSize;
+    }
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+static void cleanSmlDataBlocks(SSqlObj* pSql) {
+  SInsertStatementParam* pInsertParam = &pSql->cmd.insertParam;
+
+  for (int32_t i = 0; i < pInsertParam->numOfTables; ++i) {
+    tfree(pInsertParam->pTableNameList[i]);
+  }
+  tfree(pInsertParam->pTableNameList);
+  pInsertParam->numOfTables = 0;
+
+  pInsertParam->pDataBlocks = tscDestroyBlockArrayList(pSql, pInsertParam->pDataBlocks);
+  tscDestroyBlockHashTable(pSql, pInsertParam->pTableBlockHashList, false);
+  pInsertParam->pTableBlockHashList = taosHashInit(128, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BIGINT), true, false);
+
+  tscFreeSqlResult(pSql);
+  tscFreeSubobj(pSql);
+  tfree(pSql->pSubs);
+  pSql->subState.numOfSub = 0;
+}
+
+static int32_t submitSmlDataBlocks(SSqlObj* pSql, SSmlLinesInfo* info) {
+  SInsertStatementParam* pInsertParam = &pSql->cmd.insertParam;
+  if (taosHashGetSize(pInsertParam->pTableBlockHashList) == 0) {
+    return TSDB_CODE_SUCCESS;
+  }
+
+  int32_t code = tscMergeTableDataBlocks(pSql, pInsertParam, false);
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  pSql->res.code = TSDB_CODE_SUCCESS;
+  pSql->res.numOfRows = 0;
+  code = tscHandleMultivnodeInsert(pSql);
+  if (code == TSDB_CODE_SUCCESS) {
+    // wait for the callback function to post the semaphore
+    tsem_wait(&pSql->rspSem);
+    code = pSql->res.code;
+    info->affectedRows += pSql->res.numOfRows;
+  }
+
+  tscDebug("SML:0x%"PRIx64" submit %d child tables, inserted %d rows, code:%s", info->id, pInsertParam->numOfTables,
+           pSql->res.numOfRows, tstrerror(code));
+
+  // the table meta is acquired again before the retry
+  if (code == TSDB_CODE_TDB_INVALID_TABLE_ID || code == TSDB_CODE_VND_INVALID_VGROUP_ID) {
+    for (int32_t i = 0; i < pInsertParam->numOfTables; ++i) {
+      char name[TSDB_TABLE_FNAME_LEN] = {0};
+      tNameExtractFullName(pInsertParam->pTableNameList[i], name);
+      taosHashRemove(UTIL_GET_TABLEMETA(pSql), name, strnlen(name, TSDB_TABLE_FNAME_LEN));
+    }
+  }
+
+  return code;
+}
+
+static SSqlObj* createSmlSubmitObj(TAOS* taos) {
+  SSqlObj* pSql = calloc(1, sizeof(SSqlObj));
+  if (pSql == NULL) {
+    return NULL;
+  }
+
+  if (TSDB_CODE_SUCCESS != tscAllocPayload(&pSql->cmd, TSDB_DEFAULT_PAYLOAD_SIZE)) {
+    free(pSql);
+    return NULL;
+  }
+
+  tsem_init(&pSql->rspSem, 0, 0);
+  pSql->signature = pSql;
+  pSql->pTscObj   = taos;
+  pSql->rootObj   = pSql;
+  pSql->maxRetry  = TSDB_MAX_REPLICA;
+  pSql->retry     = pSql->maxRetry + 1;  // the failed batch is built and submitted again by the caller
+  pSql->fp        = waitForQueryRsp;
+  pSql->fetchFp   = waitForQueryRsp;
+  pSql->param     = pSql;
+  registerSqlObj(pSql);
+
+  SSqlCmd* pCmd = &pSql->cmd;
+  pCmd->command = TSDB_SQL_INSERT;
+  pCmd->insertParam.payloadType = PAYLOAD_TYPE_RAW;
+  pCmd->insertParam.objectId = pSql->self;
+  pCmd->insertParam.pTableBlockHashList = taosHashInit(128, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BIGINT), true, false);
+
+  if (pCmd->insertParam.pTableBlockHashList == NULL || tscAddQueryInfo(pCmd) != TSDB_CODE_SUCCESS ||
+      tscAddEmptyMetaInfo(tscGetQueryInfo(pCmd)) == NULL) {
+    taos_free_result(pSql);
+    return NULL;
+  }
+
+  return pSql;
+}
+
+/*
+ * insert the points of the child tables from position (tIdx, rIdx) by submit messages, the position is moved forward
+ * once a submit message succeeds
+ */
+static int32_t insertSmlChildTables(TAOS* taos, SArray* cTables, SArray* stableSchemas, int32_t* tIdx, int32_t* rIdx,
+                                    SSmlLinesInfo* info) {
+  SSqlObj* pSql = createSmlSubmitObj(taos);
+  if (pSql == NULL) {
+    return TSDB_CODE_TSC_OUT_OF_MEMORY;
+  }
+
+  size_t         numOfSTables = taosArrayGetSize(stableSchemas);
+  SSmlColumnMap* maps = calloc(numOfSTables, sizeof(SSmlColumnMap));
+  if (maps == NULL) {
+    taos_free_result(pSql);
+    return TSDB_CODE_TSC_OUT_OF_MEMORY;
+  }
+
+  int32_t code = TSDB_CODE_SUCCESS;
+  int32_t try = 0;
+  size_t  numOfTables = taosArrayGetSize(cTables);
+  while (*tIdx < numOfTables) {
+    int32_t endTIdx = *tIdx;
+    int32_t endRIdx = *rIdx;
+    code = buildSmlDataBlocks(pSql, cTables, stableSchemas, maps, &endTIdx, &endRIdx, info);
+    if (code == TSDB_CODE_SUCCESS) {
+      code = submitSmlDataBlocks(pSql, info);
+    }
+    cleanSmlDataBlocks(pSql);
+
+    if (code == TSDB_CODE_SUCCESS) {
+      *tIdx = endTIdx;
+      *rIdx = endRIdx;
+      try = 0;
+      continue;
+    }
+
+    if ((code != TSDB_CODE_TDB_INVALID_TABLE_ID && code != TSDB_CODE_VND_INVALID_VGROUP_ID &&
+         code != TSDB_CODE_TDB_TABLE_RECONFIGURE && code != TSDB_CODE_APP_NOT_READY &&
+         code != TSDB_CODE_RPC_NETWORK_UNAVAIL) || try++ >= TSDB_MAX_REPLICA) {
+      break;
+    }
+
+    tscError("SML:0x%"PRIx64" submit child tables failed. error %s, try:%d", info->id, tstrerror(code), try);
+    if (code != TSDB_CODE_TDB_TABLE_RECONFIGURE) {
+      taosMsleep(100 * (1 << try));
+    }
+  }
+
+  // the super table meta in the local meta buffer is out of date as well
+  if (code == TSDB_CODE_TDB_IVD_TB_SCHEMA_VERSION || code == TSDB_CODE_MND_INVALID_TABLE_NAME) {
+    for (int32_t i = 0; i < numOfSTables; ++i) {
+      SSmlSTableSchema* sTableSchema = taosArrayGet(stableSchemas, i);
+      SName             sname = {0};
+      char              name[TSDB_TABLE_FNAME_LEN] = {0};
+      if (setSmlTableName(pSql, sTableSchema->sTableName, &sname) == TSDB_CODE_SUCCESS &&
+          tNameExtractFullName(&sname, name) == TSDB_CODE_SUCCESS) {
+        taosHashRemove(UTIL_GET_TABLEMETA(pSql), name, strnlen(name, TSDB_TABLE_FNAME_LEN));
+      }
+    }
+  }
+
+  destroySmlColumnMaps(maps, numOfSTables);
+  taos_free_result(pSql);
+  return code;
+}
+
+static int32_t applyDataPointsDirectly(TAOS* taos, SHashObj* cname2points, SArray* stableSchemas, SSmlLinesInfo* info) {
+  SArray* cTables = taosArrayInit(taosHashGetSize(cname2points), POINTER_BYTES);
+  if (cTables == NULL) {
+    return TSDB_CODE_TSC_OUT_OF_MEMORY;
+  }
+
+  SArray** pCTablePoints = taosHashIterate(cname2points, NULL);
+  while (pCTablePoints) {
+    taosArrayPush(cTables, pCTablePoints);
+    pCTablePoints = taosHashIterate(cname2points, pCTablePoints);
+  }
+
+  int32_t tIdx = 0;
+  int32_t rIdx = 0;
+  int32_t code = insertSmlChildTables(taos, cTables, stableSchemas, &tIdx, &rIdx, info);
+
+  // the cached super tables have been changed or dropped, reconcile them with db and go on from the failed batch
+  if (code == TSDB_CODE_TDB_IVD_TB_SCHEMA_VERSION || code == TSDB_CODE_MND_INVALID_TABLE_NAME) {
+    tscDebug("SML:0x%"PRIx64" super tables are out of date. error %s, reload them", info->id, tstrerror(code));
+    for (int32_t i = 0; i < taosArrayGetSize(stableSchemas); ++i) {
+      SSmlSTableSchema* sTableSchema = taosArrayGet(stableSchemas, i);
+      removeSchemaFromSmlCache(taos, sTableSchema->sTableName);
+    }
+
+    code = modifyDBSchemas(taos, stableSchemas, info);
+    if (code == TSDB_CODE_SUCCESS) {
+      code = insertSmlChildTables(taos, cTables, stableSchemas, &tIdx, &rIdx, info);
+    }
+  }
+
+  taosArrayDestroy(cTables);
+  return code;
+}
+
 static int32_t applyDataPoints(TAOS* taos, TAOS_SML_DATA_POINT* points, int32_t numPoints, SArray* stableSchemas, SSmlLinesInfo* info) {
   int32_t code = TSDB_CODE_SUCCESS;
 
   SHashObj* cname2points = taosHashInit(128, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), true, false);
   arrangePointsByChildTableName(points, numPoints, cname2points, stableSchemas, info);
 
-  SArray** pCTablePoints = taosHashIterate(cname2points, NULL);
+  SArray** pCTablePoints = NULL;
+  if (tsSmlDirectSubmit) {
+    code = applyDataPointsDirectly(taos, cname2points, stableSchemas, info);
+    goto cleanup;
+  }
+
+  pCTablePoints = taosHashIterate(cname2points, NULL);
   while (pCTablePoints) {
     SArray* cTablePoints = *pCTablePoints;
 
@@ -1145,6 +1944,7 @@ clean_up:
     SSmlSTableSchema* schema = taosArrayGet(stableSchemas, i);
     taosArrayDestroy(schema->fields);
     taosArrayDestroy(schema->tags);
+    tfree(schema->tableMeta);
   }
   taosArrayDestroy(stableSchemas);
   return code;
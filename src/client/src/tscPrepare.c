@@ -22,6 +22,9 @@
 #include "tstrbuild.h"
 #include "tscLog.h"
 #include "tscSubquery.h"
+#include "tscParseCache.h"
+#include "tscProfile.h"
+#include "texpr.h"
 
 int tsParseInsertSql(SSqlObj *pSql);
 int32_t tsCheckTimestamp(STableDataBlocks *pDataBlocks, const char *start);
@@ -35,6 +38,21 @@ typedef struct SNormalStmtPart {
   char* str;
 } SNormalStmtPart;
 
+typedef enum {
+  STMT_PARAM_UNKNOWN = 0,
+  STMT_PARAM_TS,           // operand of a condition on the primary timestamp column, decides the query time window
+  STMT_PARAM_TAG,          // operand of a condition on a tag or tbname of the super table
+} STMT_PARAM_TYPE;
+
+// the condition "colName optr ?" that a parameter of the select statement belongs to
+typedef struct SNormalStmtParam {
+  int8_t     type;
+  int16_t    optr;         // TK_EQ, TK_GT, TK_GE, TK_LT or TK_LE
+  char       colName[TSDB_COL_NAME_LEN];
+  SSchema    schema;       // schema of the tag or tbname, for STMT_PARAM_TAG
+  tExprNode* pValue;       // value node of the condition in the tag query condition, for STMT_PARAM_TAG
+} SNormalStmtParam;
+
 typedef struct SNormalStmt {
   uint16_t         sizeParts;
   uint16_t         numParts;
@@ -42,6 +60,18 @@ typedef struct SNormalStmt {
   char* sql;
   SNormalStmtPart* parts;
   tVariant*        params;
+
+  /*
+   * The select statement is validated only at the first execution if all its parameters are the operand of the time
+   * window or tag conditions, the following executions bind the parameters into a copy of the validated query info
+   * without parsing the sql statement.
+   */
+  bool              bindable;
+  SNormalStmtParam* paramInfo;
+  SArray*           literalCols;   // columns compared with a literal, char[TSDB_COL_NAME_LEN]
+  SQueryInfo*       pQueryInfo;    // validated query info of the first execution
+  int16_t           numOfCols;
+  tExprNode*        pTagCond;      // tag query condition of pQueryInfo, in which the value of parameters are replaced
 } SNormalStmt;
 
 typedef struct SMultiTbStmt {
@@ -208,50 +238,173 @@ static int normalStmtBindParam(STscStmt* stmt, TAOS_BIND* bind) {
 }
 
 
+static bool isStmtRelationalOptr(uint32_t type) {
+  return type == TK_EQ || type == TK_GT || type == TK_GE || type == TK_LT || type == TK_LE;
+}
+
+// the tokens around a condition "colName optr ?", so that neither side of it is part of an expression
+static bool isStmtCondStart(uint32_t type) {
+  return type == TK_WHERE || type == TK_AND || type == TK_LP;
+}
+
+static bool isStmtCondEnd(uint32_t type) {
+  return type == TK_AND || type == TK_RP || type == TK_GROUP || type == TK_ORDER || type == TK_LIMIT ||
+         type == TK_SLIMIT || type == TK_INTERVAL || type == TK_SESSION || type == TK_STATE_WINDOW ||
+         type == TK_EVERY || type == TK_FILL || type == TK_SLIDING || type == TK_SEMI;
+}
+
+static int normalStmtAddLiteralCol(SNormalStmt* normal, SStrToken* pToken) {
+  if (pToken->type != TK_ID && pToken->type != TK_TBNAME) {
+    return TSDB_CODE_SUCCESS;
+  }
+
+  char name[TSDB_COL_NAME_LEN] = {0};
+  strntolower(name, pToken->z, MIN(pToken->n, TSDB_COL_NAME_LEN - 1));
+  return (taosArrayPush(normal->literalCols, name) == NULL) ? TSDB_CODE_TSC_OUT_OF_MEMORY : TSDB_CODE_SUCCESS;
+}
+
+/*
+ * find the condition "colName optr ?" of each parameter from the tokens of the select statement, the parameters can
+ * not be bound without parsing if any of them is not in this form, or the conditions are combined by "or". The
+ * parameter must end the condition, since the parser folds an expression like "? + 1000" into one literal.
+ */
+static int normalStmtParseParams(SNormalStmt* normal, SArray* pTokens) {
+  normal->bindable = true;
+
+  if (normal->numParams > 0) {
+    normal->paramInfo = calloc(normal->numParams, sizeof(SNormalStmtParam));
+    if (normal->paramInfo == NULL) {
+      return TSDB_CODE_TSC_OUT_OF_MEMORY;
+    }
+  }
+
+  normal->literalCols = taosArrayInit(4, TSDB_COL_NAME_LEN);
+  if (normal->literalCols == NULL) {
+    return TSDB_CODE_TSC_OUT_OF_MEMORY;
+  }
+
+  size_t  numOfTokens = taosArrayGetSize(pTokens);
+  int32_t idxParam = 0;
+
+  for (int32_t i = 0; i < numOfTokens; ++i) {
+    SStrToken* pToken = taosArrayGet(pTokens, i);
+
+    if (pToken->type == TK_OR || pToken->type == TK_BETWEEN || pToken->type == TK_IN || pToken->type == TK_NOW) {
+      normal->bindable = false;
+      continue;
+    }
+
+    if (pToken->type == TK_QUESTION) {
+      SStrToken* pOptr  = (i > 0) ? taosArrayGet(pTokens, i - 1) : NULL;
+      SStrToken* pCol   = (i > 1) ? taosArrayGet(pTokens, i - 2) : NULL;
+      SStrToken* pStart = (i > 2) ? taosArrayGet(pTokens, i - 3) : NULL;
+      SStrToken* pEnd   = (i < numOfTokens - 1) ? taosArrayGet(pTokens, i + 1) : NULL;
+
+      if (pStart != NULL && isStmtCondStart(pStart->type) && isStmtRelationalOptr(pOptr->type) &&
+          (pCol->type == TK_ID || pCol->type == TK_TBNAME) && (pEnd == NULL || isStmtCondEnd(pEnd->type))) {
+        SNormalStmtParam* pInfo = &normal->paramInfo[idxParam];
+        pInfo->optr = (int16_t)pOptr->type;
+        strntolower(pInfo->colName, pCol->z, MIN(pCol->n, TSDB_COL_NAME_LEN - 1));
+      } else {
+        normal->bindable = false;
+      }
+
+      idxParam += 1;
+      continue;
+    }
+
+    if (!isStmtRelationalOptr(pToken->type) || i == 0 || i == numOfTokens - 1) {
+      continue;
+    }
+
+    // the condition on literal, like "ts > 1626624000000" or "1 < ts"
+    SStrToken* pLeft = taosArrayGet(pTokens, i - 1);
+    SStrToken* pRight = taosArrayGet(pTokens, i + 1);
+    if (pRight->type == TK_QUESTION) {
+      continue;
+    }
+
+    int code = normalStmtAddLiteralCol(normal, pLeft);
+    if (code == TSDB_CODE_SUCCESS) {
+      code = normalStmtAddLiteralCol(normal, pRight);
+    }
+
+    if (code != TSDB_CODE_SUCCESS) {
+      return code;
+    }
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
 static int normalStmtPrepare(STscStmt* stmt) {
   SNormalStmt* normal = &stmt->normal;
-  char* sql = stmt->pSql->sqlstr;
   uint32_t i = 0, start = 0;
+  int code = TSDB_CODE_SUCCESS;
+
+  // the parts refer to the sql string, which outlives the sql object that is replaced by each execution
+  normal->sql = strdup(stmt->pSql->sqlstr);
+  if (normal->sql == NULL) {
+    return TSDB_CODE_TSC_OUT_OF_MEMORY;
+  }
+
+  char* sql = normal->sql;
+  SArray* pTokens = taosArrayInit(32, sizeof(SStrToken));
+  if (pTokens == NULL) {
+    return TSDB_CODE_TSC_OUT_OF_MEMORY;
+  }
 
   while (sql[i] != 0) {
     SStrToken token = {0};
     token.n = tGetToken(sql + i, &token.type);
+    token.z = sql + i;
 
     if (token.type == TK_QUESTION) {
       sql[i] = 0;
       if (i > start) {
-        int code = normalStmtAddPart(normal, false, sql + start, i - start);
+        code = normalStmtAddPart(normal, false, sql + start, i - start);
         if (code != TSDB_CODE_SUCCESS) {
-          return code;
+          goto _end;
         }
       }
-      int code = normalStmtAddPart(normal, true, NULL, 0);
+      code = normalStmtAddPart(normal, true, NULL, 0);
       if (code != TSDB_CODE_SUCCESS) {
-        return code;
+        goto _end;
       }
       start = i + token.n;
     } else if (token.type == TK_ILLEGAL) {
-      return invalidOperationMsg(tscGetErrorMsgPayload(&stmt->pSql->cmd), "invalid sql");
+      code = invalidOperationMsg(tscGetErrorMsgPayload(&stmt->pSql->cmd), "invalid sql");
+      goto _end;
+    }
+
+    if (token.type != TK_SPACE && token.type != TK_COMMENT && taosArrayPush(pTokens, &token) == NULL) {
+      code = TSDB_CODE_TSC_OUT_OF_MEMORY;
+      goto _end;
     }
 
     i += token.n;
   }
 
   if (i > start) {
-    int code = normalStmtAddPart(normal, false, sql + start, i - start);
+    code = normalStmtAddPart(normal, false, sql + start, i - start);
     if (code != TSDB_CODE_SUCCESS) {
-      return code;
+      goto _end;
     }
   }
 
   if (normal->numParams > 0) {
     normal->params = calloc(normal->numParams, sizeof(tVariant));
     if (normal->params == NULL) {
-      return TSDB_CODE_TSC_OUT_OF_MEMORY;
+      code = TSDB_CODE_TSC_OUT_OF_MEMORY;
+      goto _end;
     }
   }
 
-  return TSDB_CODE_SUCCESS;
+  code = normalStmtParseParams(normal, pTokens);
+
+_end:
+  taosArrayDestroy(pTokens);
+  return code;
 }
 
 static char* normalStmtBuildSql(STscStmt* stmt) {
@@ -327,6 +480,437 @@ static char* normalStmtBuildSql(STscStmt* stmt) {
   return taosStringBuilderGetResult(&sb, NULL);
 }
 
+static void normalStmtResetQueryInfo(SNormalStmt* normal) {
+  tscDestroyValidatedQueryInfo(normal->pQueryInfo);
+  normal->pQueryInfo = NULL;
+
+  tExprTreeDestroy(normal->pTagCond, NULL);
+  normal->pTagCond = NULL;
+
+  for (uint16_t i = 0; i < normal->numParams && normal->paramInfo != NULL; ++i) {
+    normal->paramInfo[i].type = STMT_PARAM_UNKNOWN;
+    normal->paramInfo[i].pValue = NULL;
+  }
+}
+
+static uint8_t getStmtRelationalOptr(int16_t optr) {
+  switch (optr) {
+    case TK_EQ:
+      return TSDB_RELATION_EQUAL;
+    case TK_GT:
+      return TSDB_RELATION_GREATER;
+    case TK_GE:
+      return TSDB_RELATION_GREATER_EQUAL;
+    case TK_LT:
+      return TSDB_RELATION_LESS;
+    case TK_LE:
+      return TSDB_RELATION_LESS_EQUAL;
+    default:
+      return 0;
+  }
+}
+
+// find the value node of condition "colName optr value" in the tag query condition, return the number of matches
+static int32_t findTagCondValue(tExprNode* pNode, const char* colName, uint8_t optr, tExprNode** pValue) {
+  if (pNode == NULL || pNode->nodeType != TSQL_NODE_EXPR) {
+    return 0;
+  }
+
+  tExprNode* pLeft = pNode->_node.pLeft;
+  tExprNode* pRight = pNode->_node.pRight;
+
+  if (pLeft->nodeType == TSQL_NODE_COL && pRight->nodeType == TSQL_NODE_VALUE) {
+    if (pNode->_node.optr == optr && strcasecmp(pLeft->pSchema->name, colName) == 0) {
+      *pValue = pRight;
+      return 1;
+    }
+
+    return 0;
+  }
+
+  return findTagCondValue(pLeft, colName, optr, pValue) + findTagCondValue(pRight, colName, optr, pValue);
+}
+
+static bool normalStmtSetTagParams(SNormalStmt* normal, STableMetaInfo* pTableMetaInfo) {
+  SCond* pCond = tsGetSTableQueryCond(&normal->pQueryInfo->tagCond, pTableMetaInfo->pTableMeta->id.uid);
+  if (pCond == NULL || pCond->cond == NULL) {
+    return false;
+  }
+
+  TRY(TSDB_MAX_TAG_CONDITIONS) {
+    normal->pTagCond = exprTreeFromBinary(pCond->cond, pCond->len);
+  } CATCH(code) {
+    CLEANUP_EXECUTE();
+    UNUSED(code);
+    normal->pTagCond = NULL;
+  } END_TRY
+
+  if (normal->pTagCond == NULL) {
+    return false;
+  }
+
+  for (uint16_t i = 0; i < normal->numParams; ++i) {
+    SNormalStmtParam* pInfo = &normal->paramInfo[i];
+    if (pInfo->type != STMT_PARAM_TAG) {
+      continue;
+    }
+
+    // one value node should not be shared by two parameters
+    for (uint16_t j = 0; j < i; ++j) {
+      SNormalStmtParam* pPrev = &normal->paramInfo[j];
+      if (pPrev->type == STMT_PARAM_TAG && pPrev->optr == pInfo->optr && strcmp(pPrev->colName, pInfo->colName) == 0) {
+        return false;
+      }
+    }
+
+    if (findTagCondValue(normal->pTagCond, pInfo->colName, getStmtRelationalOptr(pInfo->optr), &pInfo->pValue) != 1) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/*
+ * keep the validated query info of the first execution if the parameters can be bound into it, the time window is
+ * recalculated and the tag query condition is rebuilt from the bound values in the following executions.
+ */
+static void normalStmtKeepQueryInfo(SNormalStmt* normal, SSqlObj* pSql) {
+  SSqlCmd* pCmd = &pSql->cmd;
+
+  if (pCmd->pValidated == NULL) {
+    // the statement is valid but can not be reused, or the time window of this execution is empty
+    if (pSql->res.code == TSDB_CODE_SUCCESS && pCmd->command == TSDB_SQL_SELECT) {
+      normal->bindable = false;
+    }
+    return;
+  }
+
+  normal->pQueryInfo = pCmd->pValidated;
+  normal->numOfCols = pCmd->numOfCols;
+  pCmd->pValidated = NULL;
+
+  SQueryInfo*     pQueryInfo = normal->pQueryInfo;
+  STableMetaInfo* pTableMetaInfo = tscGetMetaInfo(pQueryInfo, 0);
+  SSchema*        pSchema = tscGetTableSchema(pTableMetaInfo->pTableMeta);
+
+  // the validation of fill and interp depends on the time window
+  bool bindable = pQueryInfo->command == TSDB_SQL_SELECT && pQueryInfo->fillType == TSDB_FILL_NONE;
+
+  for (int32_t i = 0; bindable && i < tscNumOfExprs(pQueryInfo); ++i) {
+    bindable = (tscExprGet(pQueryInfo, i)->base.functionId != TSDB_FUNC_INTERP);
+  }
+
+  // the time window is calculated from the parameters only
+  for (int32_t i = 0; bindable && i < taosArrayGetSize(normal->literalCols); ++i) {
+    bindable = (strcasecmp(taosArrayGet(normal->literalCols, i), pSchema[0].name) != 0);
+  }
+
+  bool hasTagParam = false;
+  for (uint16_t i = 0; bindable && i < normal->numParams; ++i) {
+    SNormalStmtParam* pInfo = &normal->paramInfo[i];
+
+    if (strcasecmp(pInfo->colName, pSchema[0].name) == 0) {
+      pInfo->type = STMT_PARAM_TS;
+      continue;
+    }
+
+    pInfo->type = STMT_PARAM_UNKNOWN;
+    if (UTIL_TABLE_IS_SUPER_TABLE(pTableMetaInfo)) {
+      SSchema* pTagSchema = tscGetTableTagSchema(pTableMetaInfo->pTableMeta);
+      int32_t  numOfTags = tscGetNumOfTags(pTableMetaInfo->pTableMeta);
+
+      // "tbname = ?" is a node of the tag query condition on the tbname column, not a separate table name filter
+      if (strcasecmp(pInfo->colName, TSQL_TBNAME_L) == 0) {
+        pInfo->type = STMT_PARAM_TAG;
+        pInfo->schema = *tGetTbnameColumnSchema();
+      }
+
+      for (int32_t j = 0; j < numOfTags && pInfo->type == STMT_PARAM_UNKNOWN; ++j) {
+        if (strcasecmp(pInfo->colName, pTagSchema[j].name) == 0) {
+          pInfo->type = STMT_PARAM_TAG;
+          pInfo->schema = pTagSchema[j];
+        }
+      }
+    }
+
+    hasTagParam |= (pInfo->type == STMT_PARAM_TAG);
+    bindable = (pInfo->type != STMT_PARAM_UNKNOWN);
+  }
+
+  if (bindable && hasTagParam) {
+    bindable = normalStmtSetTagParams(normal, pTableMetaInfo);
+  }
+
+  if (!bindable) {
+    normalStmtResetQueryInfo(normal);
+    normal->bindable = false;
+    return;
+  }
+
+  tscDebug("0x%"PRIx64" validated query info is kept for the prepared statement", pSql->self);
+}
+
+static bool getBoundTimestamp(tVariant* pVar, int64_t* val) {
+  if (IS_SIGNED_NUMERIC_TYPE(pVar->nType) || pVar->nType == TSDB_DATA_TYPE_TIMESTAMP) {
+    *val = pVar->i64;
+    return true;
+  }
+
+  if (IS_UNSIGNED_NUMERIC_TYPE(pVar->nType) && pVar->u64 <= INT64_MAX) {
+    *val = (int64_t)pVar->u64;
+    return true;
+  }
+
+  return false;
+}
+
+static bool mergeBoundTimeWindow(STimeWindow* win, int16_t optr, int64_t val) {
+  int64_t skey = INT64_MIN, ekey = INT64_MAX;
+
+  switch (optr) {
+    case TK_LE:
+      ekey = val;
+      break;
+    case TK_LT:
+      if (val == INT64_MIN) {
+        return false;
+      }
+      ekey = val - 1;
+      break;
+    case TK_GT:
+      if (val == INT64_MAX) {
+        return false;
+      }
+      skey = val + 1;
+      break;
+    case TK_GE:
+      skey = val;
+      break;
+    case TK_EQ:
+      skey = val;
+      ekey = val;
+      break;
+    default:
+      return false;
+  }
+
+  win->skey = MAX(win->skey, skey);
+  win->ekey = MIN(win->ekey, ekey);
+  return true;
+}
+
+/*
+ * convert the bound value into the literal that the parser generates for the text of the value, then check it in
+ * the same way as the validation does.
+ */
+static bool convertBoundTagValue(tVariant* pDst, tVariant* pSrc, SSchema* pSchema) {
+  memset(pDst, 0, sizeof(tVariant));
+
+  if (IS_SIGNED_NUMERIC_TYPE(pSrc->nType) || pSrc->nType == TSDB_DATA_TYPE_BOOL ||
+      pSrc->nType == TSDB_DATA_TYPE_TIMESTAMP) {
+    pDst->nType = TSDB_DATA_TYPE_BIGINT;
+    pDst->i64 = pSrc->i64;
+  } else if (IS_UNSIGNED_NUMERIC_TYPE(pSrc->nType) && pSrc->u64 <= INT64_MAX) {
+    pDst->nType = TSDB_DATA_TYPE_BIGINT;
+    pDst->i64 = (int64_t)pSrc->u64;
+  } else if (pSrc->nType == TSDB_DATA_TYPE_FLOAT || pSrc->nType == TSDB_DATA_TYPE_DOUBLE) {
+    pDst->nType = TSDB_DATA_TYPE_DOUBLE;
+    pDst->dKey = pSrc->dKey;
+  } else if ((pSrc->nType == TSDB_DATA_TYPE_BINARY || pSrc->nType == TSDB_DATA_TYPE_NCHAR) &&
+             pSchema->type != TSDB_DATA_TYPE_TIMESTAMP) {
+    pDst->nType = TSDB_DATA_TYPE_BINARY;
+    pDst->pz = strndup(pSrc->pz, pSrc->nLen);
+    pDst->nLen = pSrc->nLen;
+    if (pDst->pz == NULL) {
+      return false;
+    }
+  } else {
+    return false;
+  }
+
+  int32_t type = pSchema->type;
+  if (type >= TSDB_DATA_TYPE_TINYINT && type <= TSDB_DATA_TYPE_BIGINT) {
+    type = TSDB_DATA_TYPE_BIGINT;
+  } else if (type == TSDB_DATA_TYPE_FLOAT || type == TSDB_DATA_TYPE_DOUBLE) {
+    type = TSDB_DATA_TYPE_DOUBLE;
+  }
+
+  int32_t code = TSDB_CODE_SUCCESS;
+  if (type == TSDB_DATA_TYPE_BINARY || type == TSDB_DATA_TYPE_NCHAR) {
+    int32_t bufLen = IS_NUMERIC_TYPE(pDst->nType) ? 60 : pDst->nLen + 1;
+    char*   tmp = calloc(1, bufLen * TSDB_NCHAR_SIZE);
+    code = (tmp == NULL) ? TSDB_CODE_TSC_OUT_OF_MEMORY : tVariantDump(pDst, tmp, type, false);
+    free(tmp);
+  } else {
+    double tmp;
+    code = tVariantDump(pDst, (char*)&tmp, type, false);
+  }
+
+  if (code != TSDB_CODE_SUCCESS) {
+    tVariantDestroy(pDst);
+    return false;
+  }
+
+  return true;
+}
+
+static int32_t normalStmtBuildTagCond(SNormalStmt* normal, SQueryInfo* pQueryInfo) {
+  STableMetaInfo* pTableMetaInfo = tscGetMetaInfo(pQueryInfo, 0);
+
+  SCond* pCond = tsGetSTableQueryCond(&pQueryInfo->tagCond, pTableMetaInfo->pTableMeta->id.uid);
+  if (pCond == NULL) {
+    return TSDB_CODE_TSC_APP_ERROR;
+  }
+
+  SBufferWriter bw = tbufInitWriter(NULL, false);
+  int32_t       ret = TSDB_CODE_SUCCESS;
+
+  TRY(0) {
+    exprTreeToBinary(&bw, normal->pTagCond);
+  } CATCH(code) {
+    tbufCloseWriter(&bw);
+    ret = code;
+  } END_TRY
+
+  if (ret != TSDB_CODE_SUCCESS) {
+    return ret;
+  }
+
+  tfree(pCond->cond);
+  pCond->len = (int32_t)tbufTell(&bw);
+  pCond->cond = tbufGetData(&bw, true);
+  return TSDB_CODE_SUCCESS;
+}
+
+// bind the parameters into the validated query info, false is returned if the sql statement needs to be parsed
+static bool normalStmtBindQueryInfo(SNormalStmt* normal, SSqlObj* pSql) {
+  SSqlCmd*    pCmd = &pSql->cmd;
+  SQueryInfo* pQueryInfo = tscGetQueryInfo(pCmd);
+
+  STimeWindow win = TSWINDOW_INITIALIZER;
+  bool        hasTagParam = false;
+
+  for (uint16_t i = 0; i < normal->numParams; ++i) {
+    SNormalStmtParam* pInfo = &normal->paramInfo[i];
+    tVariant*         pVar = &normal->params[i];
+
+    if (pInfo->type == STMT_PARAM_TS) {
+      int64_t val = 0;
+      if (!getBoundTimestamp(pVar, &val) || !mergeBoundTimeWindow(&win, pInfo->optr, val)) {
+        return false;
+      }
+
+      continue;
+    }
+
+    tVariant val = {0};
+    if (!convertBoundTagValue(&val, pVar, &pInfo->schema)) {
+      return false;
+    }
+
+    tVariantDestroy(pInfo->pValue->pVal);
+    *pInfo->pValue->pVal = val;
+    hasTagParam = true;
+  }
+
+  if (hasTagParam && normalStmtBuildTagCond(normal, pQueryInfo) != TSDB_CODE_SUCCESS) {
+    return false;
+  }
+
+  pQueryInfo->window = win;
+  if (win.skey > win.ekey) {
+    pQueryInfo->command = TSDB_SQL_RETRIEVE_EMPTY_RESULT;
+  }
+
+  pCmd->command = pQueryInfo->command;
+  return true;
+}
+
+/*
+ * execute the select statement with the parameters bound into the validated query info of the first execution, the
+ * sql string with the parameters substituted is kept only for the retry and the log. NULL is returned if the sql
+ * statement needs to be parsed.
+ */
+static SSqlObj* normalStmtExecuteBound(STscStmt* pStmt, const char* sql) {
+  SNormalStmt* normal = &pStmt->normal;
+  STscObj*     pObj = pStmt->taos;
+  size_t       sqlLen = strlen(sql);
+
+  SSqlObj* pSql = calloc(1, sizeof(SSqlObj));
+  if (pSql == NULL) {
+    return NULL;
+  }
+
+  tsem_init(&pSql->rspSem, 0, 0);
+  pSql->signature = pSql;
+  pSql->param     = pObj;
+  pSql->pTscObj   = pObj;
+  pSql->maxRetry  = TSDB_MAX_REPLICA;
+  pSql->fp        = waitForQueryRsp;
+  pSql->fetchFp   = waitForQueryRsp;
+  pSql->rootObj   = pSql;
+  pSql->cmd.resColumnId = TSDB_RES_COL_ID;
+  registerSqlObj(pSql);
+
+  pSql->sqlstr = calloc(1, sqlLen + 1);
+  if (pSql->sqlstr == NULL) {
+    taos_free_result(pSql);
+    return NULL;
+  }
+
+  strntolower(pSql->sqlstr, sql, (int32_t)sqlLen);
+
+  int32_t code = tscRestoreQueryInfo(pSql, normal->pQueryInfo, normal->numOfCols);
+  if (code == TSDB_CODE_TDB_INVALID_TABLE_ID) {
+    tscDebug("0x%"PRIx64" table schema changed, validate the prepared statement again", pSql->self);
+    normalStmtResetQueryInfo(normal);
+  }
+
+  if (code != TSDB_CODE_SUCCESS || !normalStmtBindQueryInfo(normal, pSql)) {
+    taos_free_result(pSql);
+    return NULL;
+  }
+
+  tscDebugL("0x%"PRIx64" SQL: %s, parameters bound without parsing", pSql->self, pSql->sqlstr);
+
+  taosAcquireRef(tscObjRef, pSql->self);
+  executeQuery(pSql, tscGetQueryInfo(&pSql->cmd));
+  taosReleaseRef(tscObjRef, pSql->self);
+
+  tsem_wait(&pSql->rspSem);
+  return pSql;
+}
+
+// execute the select statement by parsing the sql string, and keep the validated query info if it is requested
+static SSqlObj* normalStmtExecuteSql(STscStmt* pStmt, const char* sql) {
+  SNormalStmt* normal = &pStmt->normal;
+  if (!normal->bindable || normal->pQueryInfo != NULL) {
+    return taos_query((TAOS*)pStmt->taos, sql);
+  }
+
+  size_t sqlLen = strlen(sql);
+  if (sqlLen > (size_t)tsMaxSQLStringLen) {
+    tscError("sql string exceeds max length:%d", tsMaxSQLStringLen);
+    terrno = TSDB_CODE_TSC_EXCEED_SQL_LIMIT;
+    return NULL;
+  }
+
+  SSqlObj* pSql = calloc(1, sizeof(SSqlObj));
+  if (pSql == NULL) {
+    terrno = TSDB_CODE_TSC_OUT_OF_MEMORY;
+    return NULL;
+  }
+
+  tsem_init(&pSql->rspSem, 0, 0);
+  pSql->cmd.keepValidated = true;
+  doAsyncQuery(pStmt->taos, pSql, waitForQueryRsp, pStmt->taos, sql, sqlLen);
+  tsem_wait(&pSql->rspSem);
+
+  normalStmtKeepQueryInfo(normal, pSql);
+  return pSql;
+}
+
 static int fillColumnsNull(STableDataBlocks* pBlock, int32_t rowNum) {
   SParsedDataColInfo* spd = &pBlock->boundColumnInfo;
   int32_t offset = 0;
@@ -1536,6 +2120,26 @@ int stmtGenInsertStatement(SSqlObj* pSql, STscStmt* pStmt, const char* name, TAO
 ////////////////////////////////////////////////////////////////////////////////
 // interface functions
 
+static SSqlObj* createStmtSqlObj(STscObj* pObj) {
+  SSqlObj* pSql = calloc(1, sizeof(SSqlObj));
+  if (pSql == NULL) {
+    return NULL;
+  }
+
+  if (TSDB_CODE_SUCCESS != tscAllocPayload(&pSql->cmd, TSDB_DEFAULT_PAYLOAD_SIZE)) {
+    free(pSql);
+    return NULL;
+  }
+
+  tsem_init(&pSql->rspSem, 0, 0);
+  pSql->signature   = pSql;
+  pSql->pTscObj     = pObj;
+  pSql->maxRetry    = TSDB_MAX_REPLICA;
+  registerSqlObj(pSql);
+
+  return pSql;
+}
+
 TAOS_STMT* taos_stmt_init(TAOS* taos) {
   STscObj* pObj = (STscObj*)taos;
   STscStmt* pStmt = NULL;
@@ -1554,8 +2158,7 @@ TAOS_STMT* taos_stmt_init(TAOS* taos) {
   }
   pStmt->taos = pObj;
 
-  SSqlObj* pSql = calloc(1, sizeof(SSqlObj));
-
+  SSqlObj* pSql = createStmtSqlObj(pObj);
   if (pSql == NULL) {
     free(pStmt);
     terrno = TSDB_CODE_TSC_OUT_OF_MEMORY;
@@ -1563,22 +2166,9 @@ TAOS_STMT* taos_stmt_init(TAOS* taos) {
     return NULL;
   }
 
-  if (TSDB_CODE_SUCCESS != tscAllocPayload(&pSql->cmd, TSDB_DEFAULT_PAYLOAD_SIZE)) {
-    free(pSql);
-    free(pStmt);
-    terrno = TSDB_CODE_TSC_OUT_OF_MEMORY;
-    tscError("failed to malloc payload buffer");
-    return NULL;
-  }
-
-  tsem_init(&pSql->rspSem, 0, 0);
-  pSql->signature   = pSql;
-  pSql->pTscObj     = pObj;
-  pSql->maxRetry    = TSDB_MAX_REPLICA;
   pStmt->pSql       = pSql;
   pStmt->last       = STMT_INIT;
   pStmt->numOfRows  = 0;
-  registerSqlObj(pSql);
 
   return pStmt;
 }
@@ -1654,7 +2244,12 @@ int taos_stmt_prepare(TAOS_STMT* stmt, const char* sql, unsigned long length) {
   }
 
   pStmt->isInsert = false;
-  STMT_RET(normalStmtPrepare(pStmt));
+
+  int64_t st = taosGetTimestampUs();
+  int32_t code = normalStmtPrepare(pStmt);
+  tscUpdateStmtPrepareStatis(pStmt->taos, taosGetTimestampUs() - st);
+
+  STMT_RET(code);
 }
 
 int taos_stmt_set_tbname_tags(TAOS_STMT* stmt, const char* name, TAOS_BIND* tags) {
@@ -1870,6 +2465,9 @@ int taos_stmt_close(TAOS_STMT* stmt) {
     }
     free(normal->parts);
     free(normal->sql);
+    normalStmtResetQueryInfo(normal);
+    free(normal->paramInfo);
+    taosArrayDestroy(normal->literalCols);
   } else {
     if (pStmt->multiTbInsert) {
       taosHashCleanup(pStmt->mtb.pTableHash);
@@ -2030,15 +2628,30 @@ int taos_stmt_execute(TAOS_STMT* stmt) {
       ret = insertStmtExecute(pStmt);
     }
   } else { // normal stmt query
+    int64_t st = taosGetTimestampUs();
+
     char* sql = normalStmtBuildSql(pStmt);
     if (sql == NULL) {
       ret = TSDB_CODE_TSC_OUT_OF_MEMORY;
     } else {
       taosReleaseRef(tscObjRef, pStmt->pSql->self);
-      pStmt->pSql = taos_query((TAOS*)pStmt->taos, sql);
+
+      SSqlObj* pSql = NULL;
+      if (pStmt->normal.pQueryInfo != NULL) {
+        pSql = normalStmtExecuteBound(pStmt, sql);
+      }
+
+      bool bound = (pSql != NULL);
+      if (!bound) {
+        pSql = normalStmtExecuteSql(pStmt, sql);
+      }
+
+      pStmt->pSql = pSql;
       pStmt->numOfRows += taos_affected_rows(pStmt->pSql);
       ret = taos_errno(pStmt->pSql);
       free(sql);
+
+      tscUpdateStmtExecuteStatis(pStmt->taos, taosGetTimestampUs() - st, bound);
     }
   }
 
@@ -2063,12 +2676,18 @@ TAOS_RES *taos_stmt_use_result(TAOS_STMT* stmt) {
   }
 
   STscStmt* pStmt = (STscStmt*)stmt;
-  if (pStmt->pSql == NULL) {
+  if (pStmt->pSql == NULL || (!pStmt->isInsert && pStmt->pSql->sqlstr == NULL)) {
     tscError("result has been used already.");
     return NULL;
   }
   TAOS_RES* result = pStmt->pSql;
   pStmt->pSql = NULL;
+
+  // the prepared select statement can be executed again with other parameters
+  if (!pStmt->isInsert && pStmt->last != STMT_INIT) {
+    pStmt->pSql = createStmtSqlObj(pStmt->taos);
+  }
+
   return result;
 }
 
@@ -123,6 +123,55 @@ void tscSaveSlowQuery(SSqlObj *pSql) {
   taosTmrStart(tscSaveSlowQueryFp, 200, sql, tscTmr);
 }
 
+void tscUpdateParseStatis(STscObj *pObj, int64_t useconds, bool cached) {
+  atomic_add_fetch_64(&pObj->numOfParsed, 1);
+  atomic_add_fetch_64(&pObj->parseTime, useconds);
+
+  if (cached) {
+    atomic_add_fetch_64(&pObj->numOfParseCacheHits, 1);
+  }
+}
+
+void tscPrintParseStatis(STscObj *pObj) {
+  int64_t numOfParsed = atomic_load_64(&pObj->numOfParsed);
+  if (numOfParsed == 0) {
+    return;
+  }
+
+  int64_t hits = atomic_load_64(&pObj->numOfParseCacheHits);
+  tscDebug("taos:%p, %" PRId64 " select statements parsed, avg elapsed time:%" PRId64 " us, parse cache hit:%" PRId64
+           ", ratio:%.2f%%", pObj, numOfParsed, atomic_load_64(&pObj->parseTime) / numOfParsed, hits,
+           hits * 100.0 / numOfParsed);
+}
+
+void tscUpdateStmtPrepareStatis(STscObj *pObj, int64_t useconds) {
+  atomic_add_fetch_64(&pObj->numOfStmtPrepared, 1);
+  atomic_add_fetch_64(&pObj->stmtPrepareTime, useconds);
+}
+
+void tscUpdateStmtExecuteStatis(STscObj *pObj, int64_t useconds, bool bound) {
+  atomic_add_fetch_64(&pObj->numOfStmtExecuted, 1);
+  atomic_add_fetch_64(&pObj->stmtExecuteTime, useconds);
+
+  if (bound) {
+    atomic_add_fetch_64(&pObj->numOfStmtBound, 1);
+  }
+}
+
+void tscPrintStmtStatis(STscObj *pObj) {
+  int64_t numOfPrepared = atomic_load_64(&pObj->numOfStmtPrepared);
+  if (numOfPrepared == 0) {
+    return;
+  }
+
+  int64_t numOfExecuted = atomic_load_64(&pObj->numOfStmtExecuted);
+  tscDebug("taos:%p, %" PRId64 " select statements prepared, avg elapsed time:%" PRId64 " us, %" PRId64
+           " executions, avg elapsed time:%" PRId64 " us, bound without parsing:%" PRId64,
+           pObj, numOfPrepared, atomic_load_64(&pObj->stmtPrepareTime) / numOfPrepared, numOfExecuted,
+           (numOfExecuted > 0) ? atomic_load_64(&pObj->stmtExecuteTime) / numOfExecuted : 0,
+           atomic_load_64(&pObj->numOfStmtBound));
+}
+
 void tscRemoveFromSqlList(SSqlObj *pSql) {
   STscObj *pObj = pSql->pTscObj;
   if (pSql->listed == 0) return;
@@ -2799,7 +2799,7 @@ int tscProcessRetrieveRspFromNode(SSqlObj *pSql) {
 
 void tscTableMetaCallBack(void *param, TAOS_RES *res, int code);
 
-static int32_t getTableMetaFromMnode(SSqlObj *pSql, STableMetaInfo *pTableMetaInfo, bool autocreate) {
+static int32_t getTableMetaFromMnode(SSqlObj *pSql, STableMetaInfo *pTableMetaInfo, bool autocreate, __async_cb_func_t fp) {
   SSqlObj *pNew = calloc(1, sizeof(SSqlObj));
   if (NULL == pNew) {
     tscError("0x%"PRIx64" malloc failed for new sqlobj to get table meta", pSql->self);
@@ -2813,7 +2813,8 @@ static int32_t getTableMetaFromMnode(SSqlObj *pSql, STableMetaInfo *pTableMetaIn
   tscAddQueryInfo(&pNew->cmd);
 
   SQueryInfo *pNewQueryInfo = tscGetQueryInfoS(&pNew->cmd);
-  if (TSDB_CODE_SUCCESS != tscAllocPayload(&pNew->cmd, TSDB_DEFAULT_PAYLOAD_SIZE + pSql->cmd.payloadLen)) {
+  int32_t size = TSDB_DEFAULT_PAYLOAD_SIZE + pSql->cmd.payloadLen + (autocreate ? pSql->cmd.insertParam.tagData.dataLen : 0);
+  if (TSDB_CODE_SUCCESS != tscAllocPayload(&pNew->cmd, size)) {
     tscError("0x%"PRIx64" malloc failed for payload to get table meta", pSql->self);
 
     tscFreeSqlObj(pNew);
@@ -2827,7 +2828,7 @@ static int32_t getTableMetaFromMnode(SSqlObj *pSql, STableMetaInfo *pTableMetaIn
 
   registerSqlObj(pNew);
 
-  pNew->fp    = tscTableMetaCallBack;
+  pNew->fp    = fp;
   pNew->param = (void *)pSql->self;
 
   tscDebug("0x%"PRIx64" new pSqlObj:0x%"PRIx64" to get tableMeta, auto create:%d, metaRid from %"PRId64" to %"PRId64,
@@ -2945,7 +2946,8 @@ int32_t getMultiTableMetaFromMnode(SSqlObj *pSql, SArray* pNameList, SArray* pVg
   return code;
 }
 
-int32_t tscGetTableMetaImpl(SSqlObj* pSql, STableMetaInfo *pTableMetaInfo, bool autocreate, bool onlyLocal) {
+static int32_t doGetTableMeta(SSqlObj* pSql, STableMetaInfo *pTableMetaInfo, bool autocreate, bool onlyLocal,
+                              __async_cb_func_t fp) {
   if (!tIsValidName(&pTableMetaInfo->name)) {
     return TSDB_CODE_TSC_APP_ERROR;
   }
@@ -2975,7 +2977,7 @@ int32_t tscGetTableMetaImpl(SSqlObj* pSql, STableMetaInfo *pTableMetaInfo, bool
       pSql->pBuf   = (void *)(pSTMeta);
       pMeta   = pTableMetaInfo->pTableMeta;
       if (code != TSDB_CODE_SUCCESS) {
-        return getTableMetaFromMnode(pSql, pTableMetaInfo, autocreate);
+        return getTableMetaFromMnode(pSql, pTableMetaInfo, autocreate, fp);
       }
     }
 
@@ -2987,7 +2989,16 @@ int32_t tscGetTableMetaImpl(SSqlObj* pSql, STableMetaInfo *pTableMetaInfo, bool
     return TSDB_CODE_TSC_NO_META_CACHED;
   }
   
-  return getTableMetaFromMnode(pSql, pTableMetaInfo, autocreate);
+  return getTableMetaFromMnode(pSql, pTableMetaInfo, autocreate, fp);
+}
+
+int32_t tscGetTableMetaImpl(SSqlObj* pSql, STableMetaInfo *pTableMetaInfo, bool autocreate, bool onlyLocal) {
+  return doGetTableMeta(pSql, pTableMetaInfo, autocreate, onlyLocal, tscTableMetaCallBack);
+}
+
+int32_t tscGetTableMetaWithCallBack(SSqlObj *pSql, STableMetaInfo *pTableMetaInfo, bool autocreate,
+                                    __async_cb_func_t fp) {
+  return doGetTableMeta(pSql, pTableMetaInfo, autocreate, false, fp);
 }
 
 int32_t tscGetTableMeta(SSqlObj *pSql, STableMetaInfo *pTableMetaInfo) {
@@ -547,6 +547,77 @@ int taos_fetch_block(TAOS_RES *res, TAOS_ROW *rows) {
   return pRes->numOfRows;
 }
 
+static uint8_t* buildColumnNullBitmap(SSqlRes *pRes, int32_t index, int32_t type, int32_t bytes) {
+  if (pRes->nullBitmap == NULL) {
+    pRes->nullBitmap = calloc(pRes->numOfCols, POINTER_BYTES);
+    if (pRes->nullBitmap == NULL) {
+      return NULL;
+    }
+  }
+
+  int32_t size = (pRes->numOfRows + 7) >> 3;
+
+  uint8_t* p = realloc(pRes->nullBitmap[index], size);
+  if (p == NULL) {
+    return NULL;
+  }
+
+  pRes->nullBitmap[index] = p;
+  memset(p, 0, size);
+
+  char* data = pRes->urow[index];
+  for (int32_t k = 0; k < pRes->numOfRows; ++k, data += bytes) {
+    if (isNull(data, type)) {
+      p[k >> 3] |= (1u << (k & 7u));
+    }
+  }
+
+  return p;
+}
+
+int taos_fetch_column_block(TAOS_RES *res, TAOS_COLUMN_BLOCK *columns) {
+  SSqlObj *pSql = (SSqlObj *)res;
+  if (pSql == NULL || pSql->signature != pSql) {
+    terrno = TSDB_CODE_TSC_DISCONNECTED;
+    return 0;
+  }
+
+  SSqlRes *pRes = &pSql->res;
+
+  TAOS_ROW rows = NULL;
+  int32_t  numOfRows = taos_fetch_block(res, &rows);
+  if (numOfRows <= 0) {
+    return 0;
+  }
+
+  SQueryInfo *pQueryInfo = tscGetQueryInfo(&pSql->cmd);
+
+  // the column data is handed out in place, only the null bitmap is built for each column
+  int32_t j = 0;
+  size_t  numOfCols = tscNumOfFields(pQueryInfo);
+  for (int32_t i = 0; i < numOfCols; ++i) {
+    SInternalField* pInfo = (SInternalField*)TARRAY_GET_ELEM(pQueryInfo->fieldsInfo.internalField, i);
+    if (!pInfo->visible) {
+      continue;
+    }
+
+    uint8_t* pBitmap = buildColumnNullBitmap(pRes, i, pInfo->field.type, pInfo->field.bytes);
+    if (pBitmap == NULL) {
+      terrno = TSDB_CODE_TSC_OUT_OF_MEMORY;
+      pRes->code = terrno;
+      return 0;
+    }
+
+    columns[j].type    = pInfo->field.type;
+    columns[j].bytes   = pInfo->field.bytes;
+    columns[j].data    = rows[i];
+    columns[j].is_null = pBitmap;
+    j += 1;
+  }
+
+  return numOfRows;
+}
+
 int taos_select_db(TAOS *taos, const char *db) {
   char sql[256] = {0};
 
@@ -22,6 +22,8 @@
 #include "tmd5.h"
 #include "tscGlobalmerge.h"
 #include "tscLog.h"
+#include "tscParseCache.h"
+#include "tscParseLine.h"
 #include "tscProfile.h"
 #include "tscSubquery.h"
 #include "tsched.h"
@@ -910,7 +912,8 @@ static void doSetupSDataBlock(SSqlRes* pRes, SSDataBlock* pBlock, void* pFilterI
 
     bool gotNchar = false;
     filterConverNcharColumns(pFilterInfo, pBlock->info.rows, &gotNchar);
-    int8_t* p = NULL;
+    int8_t* pFilterRes = filterGetResultBuf(pFilterInfo, pBlock->info.rows);
+    int8_t* p = pFilterRes;
     //bool all = doFilterDataBlock(pFilterInfo, numOfFilterCols, pBlock->info.rows, p);
     bool all = filterExecute(pFilterInfo, pBlock->info.rows, &p, NULL, 0);
     if (gotNchar) {
@@ -925,7 +928,9 @@ static void doSetupSDataBlock(SSqlRes* pRes, SSDataBlock* pBlock, void* pFilterI
       }
     }
 
-    tfree(p);
+    if (p != pFilterRes) {
+      tfree(p);
+    }
   }
 
   // todo refactor: extract method
@@ -1427,6 +1432,12 @@ void handleDownstreamOperator(SSqlObj** pSqlObjList, int32_t numOfUpstream, SQue
 }
 
 static void tscDestroyResPointerInfo(SSqlRes* pRes) {
+  if (pRes->nullBitmap != NULL) {
+    for (int i = 0; i < pRes->numOfCols; i++) {
+      tfree(pRes->nullBitmap[i]);
+    }
+  }
+
   if (pRes->buffer != NULL) { // free all buffers containing the multibyte string
     for (int i = 0; i < pRes->numOfCols; i++) {
       tfree(pRes->buffer[i]);
@@ -1440,6 +1451,7 @@ static void tscDestroyResPointerInfo(SSqlRes* pRes) {
   tfree(pRes->tsrow);
   tfree(pRes->length);
   tfree(pRes->buffer);
+  tfree(pRes->nullBitmap);
   tfree(pRes->urow);
 
   tfree(pRes->pColumnIndex);
@@ -1648,6 +1660,8 @@ void tscFreeSqlObj(SSqlObj* pSql) {
 
   tscFreeSqlResult(pSql);
   tscResetSqlCmd(pCmd, false, pSql->self);
+  tscDestroyValidatedQueryInfo(pCmd->pValidated);
+  pCmd->pValidated = NULL;
 
   tfree(pCmd->payload);
   pCmd->allocSize = 0;
@@ -2180,6 +2194,11 @@ void tscCloseTscObj(void *param) {
   pObj->signature = NULL;
   taosTmrStopA(&(pObj->pTimer));
 
+  tscPrintParseStatis(pObj);
+  tscPrintStmtStatis(pObj);
+  tscDestroyParseCache(pObj->pParseCache);
+  tscDestroySmlSchemaCache(pObj->pSmlCache);
+
   tfree(pObj->tscCorMgmtEpSet);
   tscReleaseRpc(pObj->pRpcObj);
   pthread_mutex_destroy(&pObj->mutex);
@@ -3824,6 +3843,8 @@ SSqlObj* createSubqueryObj(SSqlObj* pSql, int16_t tableIndex, __async_cb_func_t
   pnCmd->pTableMetaMap = NULL;
 
   pnCmd->pQueryInfo  = NULL;
+  pnCmd->keepValidated = false;
+  pnCmd->pValidated  = NULL;
   pnCmd->insertParam.pDataBlocks = NULL;
 
   pnCmd->insertParam.numOfTables = 0;
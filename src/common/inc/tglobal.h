@@ -47,6 +47,7 @@ extern int64_t  tsDnodeStartTime;
 extern int      tsRpcTimer;
 extern int      tsRpcMaxTime;
 extern int      tsRpcForceTcp;  // all commands go to tcp protocol if this is enabled
+extern int32_t  tsRpcMultiplex; // requests to a peer share one tcp connection if this is enabled
 extern int32_t  tsMaxConnections;
 extern int32_t  tsMaxShellConns;
 extern int32_t  tsShellActivityTimer;
@@ -69,6 +70,9 @@ extern int32_t tsQueryBufferSize;  // maximum allowed usage buffer size in MB fo
 extern int64_t
     tsQueryBufferSizeBytes;  // maximum allowed usage buffer size in byte for each data node during query processing
 extern int32_t tsRetrieveBlockingModel;  // retrieve threads will be blocked
+extern int32_t tsQueryParallelism;       // max number of parts of the file sets scanned in parallel for one aggregate query
+extern int32_t tsTagIndexMinTables;      // min number of child tables of a super table to build tag indexes on demand
+extern int32_t tsSortBufferSize;         // in-memory sort buffer size in MB of the outer query order by clause
 
 extern int8_t tsKeepOriginalColumnName;
 
@@ -76,6 +80,8 @@ extern int8_t tsKeepOriginalColumnName;
 extern int32_t tsMaxSQLStringLen;
 extern int32_t tsMaxWildCardsLen;
 extern int32_t tsMaxRegexStringLen;
+extern int32_t tsParseCacheSize;
+extern int32_t tsImportParallelism;
 extern int8_t  tsTscEnableRecordSql;
 extern int32_t tsMaxNumOfOrderedResults;
 extern int32_t tsMinSlidingTime;
@@ -113,6 +119,13 @@ extern int8_t  tsCacheLastRow;
 extern bool    tsdbForceKeepFile;
 extern bool    tsdbForceCompactFile;
 extern int32_t tsdbWalFlushSize;
+extern int32_t tsWalGroupCommit;
+extern int32_t tsdbBlkCacheSize;
+extern int32_t tsdbReadAheadBlocks;
+extern int8_t  tsdbColumnCodec;
+extern int8_t  tsdbSecondStageCodec;
+extern int8_t  tsdbSyncDelta;
+extern int8_t  tsdbSyncCompress;
 
 // balance
 extern int8_t  tsEnableBalance;
@@ -120,6 +133,7 @@ extern int8_t  tsAlternativeRole;
 extern int32_t tsBalanceInterval;
 extern int32_t tsOfflineThreshold;
 extern int32_t tsMnodeEqualVnodeNum;
+extern int32_t tsMnodeSnapshotRows;
 extern int8_t  tsEnableFlowCtrl;
 extern int8_t  tsEnableSlaveQuery;
 extern int8_t  tsEnableAdjustMaster;
@@ -238,6 +252,7 @@ extern int8_t tsDeadLockKillQuery;
 extern char tsDefaultJSONStrType[];
 extern char tsSmlChildTableName[];
 extern char tsSmlTagNullName[];
+extern int8_t tsSmlDirectSubmit;
 
 
 typedef struct {
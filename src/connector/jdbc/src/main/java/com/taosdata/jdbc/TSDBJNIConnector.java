@@ -211,6 +211,15 @@ public class TSDBJNIConnector {
 
     private native int fetchBlockImp(long connection, long resultSet, TSDBResultSetBlockData blockData);
 
+    /**
+     * Get one block data column by column, the columns refer to the native result buffer without copy
+     */
+    public int fetchColumnBlock(long resultSet, TSDBResultSetBlockData blockData) {
+        return this.fetchColumnBlockImp(this.taos, resultSet, blockData);
+    }
+
+    private native int fetchColumnBlockImp(long connection, long resultSet, TSDBResultSetBlockData blockData);
+
     /**
      * Get Result Time Precision.
      *
@@ -78,7 +78,9 @@ public class TSDBResultSet extends AbstractResultSet implements ResultSet {
                 return true;
             }
 
-            int code = this.jniConnector.fetchBlock(this.resultSetPointer, this.blockData);
+            // the native result of the current block is released by the fetch
+            this.blockData.release();
+            int code = this.jniConnector.fetchColumnBlock(this.resultSetPointer, this.blockData);
             this.blockData.reset();
 
             if (code == TSDBConstants.JNI_CONNECTION_NULL) {
@@ -113,6 +115,7 @@ public class TSDBResultSet extends AbstractResultSet implements ResultSet {
         if (this.statement == null)
             return;
         if (this.jniConnector != null) {
+            this.blockData.release();
             int code = this.jniConnector.freeResultSet(this.resultSetPointer);
             if (code == TSDBConstants.JNI_CONNECTION_NULL) {
                 throw TSDBError.createSQLException(TSDBErrorNumbers.ERROR_JNI_CONNECTION_NULL);
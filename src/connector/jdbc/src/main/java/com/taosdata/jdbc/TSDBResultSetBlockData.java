@@ -38,14 +38,20 @@ public class TSDBResultSetBlockData {
 
     private List<ColumnMetaData> columnMetaDataList;
     private ArrayList<Object> colData;
+    private ArrayList<ByteBuffer> nullBitmaps;
+    private int[] valueBytes;
 
     public TSDBResultSetBlockData(List<ColumnMetaData> colMeta, int numOfCols) {
         this.columnMetaDataList = colMeta;
         this.colData = new ArrayList<>(numOfCols);
+        this.nullBitmaps = new ArrayList<>(numOfCols);
+        this.valueBytes = new int[numOfCols];
     }
 
     public TSDBResultSetBlockData() {
         this.colData = new ArrayList<>();
+        this.nullBitmaps = new ArrayList<>();
+        this.valueBytes = new int[0];
     }
 
     public void clear() {
@@ -69,6 +75,9 @@ public class TSDBResultSetBlockData {
     public void setNumOfCols(int numOfCols) {
         this.colData = new ArrayList<>(numOfCols);
         this.colData.addAll(Collections.nCopies(numOfCols, null));
+        this.nullBitmaps = new ArrayList<>(numOfCols);
+        this.nullBitmaps.addAll(Collections.nCopies(numOfCols, null));
+        this.valueBytes = new int[numOfCols];
     }
 
     public boolean hasMore() {
@@ -87,72 +96,90 @@ public class TSDBResultSetBlockData {
         this.rowIndex = 0;
     }
 
+    /**
+     * Drop the buffers of the current block, it must be called before the native result that the buffers wrap is
+     * released by the next fetch or by freeing the result set. Reading a value afterwards fails instead of reading
+     * the released memory.
+     */
+    public void release() {
+        this.numOfRows = 0;
+        this.rowIndex = 0;
+        Collections.fill(this.colData, null);
+        Collections.fill(this.nullBitmaps, null);
+    }
+
     public void setBoolean(int col, boolean value) {
         colData.set(col, value);
     }
 
     public void setByteArray(int col, int length, byte[] value) {
+        setColumnBuffer(col, ByteBuffer.wrap(value, 0, length));
+    }
+
+    /**
+     * Set the values and the null bitmap of a column. Both buffers wrap the native result of the current block,
+     * they are dropped by release() before the native result is released.
+     */
+    public void setByteBuffer(int col, ByteBuffer value, ByteBuffer nullBitmap) {
+        if (this.numOfRows > 0) {
+            this.valueBytes[col] = value.capacity() / this.numOfRows;
+        }
+        this.nullBitmaps.set(col, nullBitmap);
+        setColumnBuffer(col, value);
+    }
+
+    private void setColumnBuffer(int col, ByteBuffer buf) {
         switch (this.columnMetaDataList.get(col).getColType()) {
             case TSDBConstants.TSDB_DATA_TYPE_BOOL: {
-                ByteBuffer buf = ByteBuffer.wrap(value, 0, length);
                 buf.order(ByteOrder.LITTLE_ENDIAN).asCharBuffer();
                 this.colData.set(col, buf);
                 break;
             }
             case TSDBConstants.TSDB_DATA_TYPE_UTINYINT:
             case TSDBConstants.TSDB_DATA_TYPE_TINYINT: {
-                ByteBuffer buf = ByteBuffer.wrap(value, 0, length);
                 buf.order(ByteOrder.LITTLE_ENDIAN);
                 this.colData.set(col, buf);
                 break;
             }
             case TSDBConstants.TSDB_DATA_TYPE_USMALLINT:
             case TSDBConstants.TSDB_DATA_TYPE_SMALLINT: {
-                ByteBuffer buf = ByteBuffer.wrap(value, 0, length);
                 ShortBuffer sb = buf.order(ByteOrder.LITTLE_ENDIAN).asShortBuffer();
                 this.colData.set(col, sb);
                 break;
             }
             case TSDBConstants.TSDB_DATA_TYPE_UINT:
             case TSDBConstants.TSDB_DATA_TYPE_INT: {
-                ByteBuffer buf = ByteBuffer.wrap(value, 0, length);
                 IntBuffer ib = buf.order(ByteOrder.LITTLE_ENDIAN).asIntBuffer();
                 this.colData.set(col, ib);
                 break;
             }
             case TSDBConstants.TSDB_DATA_TYPE_UBIGINT:
             case TSDBConstants.TSDB_DATA_TYPE_BIGINT: {
-                ByteBuffer buf = ByteBuffer.wrap(value, 0, length);
                 LongBuffer lb = buf.order(ByteOrder.LITTLE_ENDIAN).asLongBuffer();
                 this.colData.set(col, lb);
                 break;
             }
             case TSDBConstants.TSDB_DATA_TYPE_FLOAT: {
-                ByteBuffer buf = ByteBuffer.wrap(value, 0, length);
                 FloatBuffer fb = buf.order(ByteOrder.LITTLE_ENDIAN).asFloatBuffer();
                 this.colData.set(col, fb);
                 break;
             }
             case TSDBConstants.TSDB_DATA_TYPE_DOUBLE: {
-                ByteBuffer buf = ByteBuffer.wrap(value, 0, length);
                 DoubleBuffer db = buf.order(ByteOrder.LITTLE_ENDIAN).asDoubleBuffer();
                 this.colData.set(col, db);
                 break;
             }
             case TSDBConstants.TSDB_DATA_TYPE_BINARY: {
-                ByteBuffer buf = ByteBuffer.wrap(value, 0, length);
                 buf.order(ByteOrder.LITTLE_ENDIAN);
                 this.colData.set(col, buf);
                 break;
             }
             case TSDBConstants.TSDB_DATA_TYPE_TIMESTAMP: {
-                ByteBuffer buf = ByteBuffer.wrap(value, 0, length);
                 LongBuffer lb = buf.order(ByteOrder.LITTLE_ENDIAN).asLongBuffer();
                 this.colData.set(col, lb);
                 break;
             }
             case TSDBConstants.TSDB_DATA_TYPE_NCHAR: {
-                ByteBuffer buf = ByteBuffer.wrap(value, 0, length);
                 buf.order(ByteOrder.LITTLE_ENDIAN);
                 this.colData.set(col, buf);
                 break;
@@ -174,7 +201,7 @@ public class TSDBResultSetBlockData {
         return obj.toString();
     }
 
-    public int getInt(int col) {
+    public int getInt(int col) throws SQLException {
         Object obj = get(col);
         if (obj == null) {
             return 0;
@@ -283,7 +310,7 @@ public class TSDBResultSetBlockData {
         return new Timestamp(getLong(col));
     }
 
-    public double getDouble(int col) {
+    public double getDouble(int col) throws SQLException {
         Object obj = get(col);
         if (obj == null) {
             return 0;
@@ -316,8 +343,22 @@ public class TSDBResultSetBlockData {
         return 0;
     }
 
-    public Object get(int col) {
+    private boolean isNull(int col) {
+        ByteBuffer bitmap = this.nullBitmaps.get(col);
+        return bitmap != null && (bitmap.get(this.rowIndex >> 3) & (1 << (this.rowIndex & 7))) != 0;
+    }
+
+    public Object get(int col) throws SQLException {
+        if (this.rowIndex >= this.numOfRows || this.colData.get(col) == null) {
+            throw TSDBError.createSQLException(TSDBErrorNumbers.ERROR_JNI_FETCH_END);
+        }
+
+        if (isNull(col)) {
+            return null;
+        }
+
         int fieldSize = this.columnMetaDataList.get(col).getColSize();
+        int valueBytes = this.valueBytes[col] > 0 ? this.valueBytes[col] : fieldSize + BINARY_LENGTH_OFFSET;
 
         switch (this.columnMetaDataList.get(col).getColType()) {
             case TSDBConstants.TSDB_DATA_TYPE_BOOL: {
@@ -395,7 +436,7 @@ public class TSDBResultSetBlockData {
 
             case TSDBConstants.TSDB_DATA_TYPE_BINARY: {
                 ByteBuffer bb = (ByteBuffer) this.colData.get(col);
-                bb.position((fieldSize + BINARY_LENGTH_OFFSET) * this.rowIndex);
+                bb.position(valueBytes * this.rowIndex);
                 int length = bb.getShort();
                 byte[] dest = new byte[length];
                 bb.get(dest, 0, length);
@@ -408,7 +449,7 @@ public class TSDBResultSetBlockData {
 
             case TSDBConstants.TSDB_DATA_TYPE_NCHAR: {
                 ByteBuffer bb = (ByteBuffer) this.colData.get(col);
-                bb.position((fieldSize + BINARY_LENGTH_OFFSET) * this.rowIndex);
+                bb.position(valueBytes * this.rowIndex);
                 int length = bb.getShort();
                 byte[] dest = new byte[length];
                 bb.get(dest, 0, length);
@@ -0,0 +1,91 @@
+package com.taosdata.jdbc.cases;
+
+import org.junit.*;
+
+import java.sql.*;
+
+public class BatchFetchColumnBlockJNITest {
+
+    private static final String host = "127.0.0.1";
+    private static final String dbName = "test_batch_fetch_block";
+    private static final long startTs = 1626624000000L;
+    private static final int numOfRows = 20000;
+    private static Connection conn;
+
+    @Test
+    public void readAcrossBlocks() throws SQLException {
+        try (Statement stmt = conn.createStatement()) {
+            ResultSet rs = stmt.executeQuery("select * from weather");
+            int rows = 0;
+            while (rs.next()) {
+                Assert.assertEquals(startTs + rows, rs.getTimestamp(1).getTime());
+                if (rows % 7 == 0) {
+                    Assert.assertNull(rs.getObject(2));
+                    Assert.assertNull(rs.getObject(4));
+                    Assert.assertNull(rs.getObject(5));
+                } else {
+                    Assert.assertEquals(rows, rs.getInt(2));
+                    Assert.assertEquals("b" + rows, rs.getString(4));
+                    Assert.assertEquals("n" + rows, rs.getString(5));
+                }
+                Assert.assertEquals(rows * 0.5, rs.getDouble(3), 0);
+                rows++;
+            }
+            Assert.assertEquals(numOfRows, rows);
+        }
+    }
+
+    @Test(expected = SQLException.class)
+    public void readAfterFetchEnd() throws SQLException {
+        try (Statement stmt = conn.createStatement()) {
+            ResultSet rs = stmt.executeQuery("select * from weather");
+            while (rs.next()) {
+            }
+            rs.getInt(2);
+        }
+    }
+
+    @Test(expected = SQLException.class)
+    public void readAfterClose() throws SQLException {
+        try (Statement stmt = conn.createStatement()) {
+            ResultSet rs = stmt.executeQuery("select * from weather");
+            Assert.assertTrue(rs.next());
+            rs.close();
+            rs.getInt(2);
+        }
+    }
+
+    @BeforeClass
+    public static void beforeClass() throws SQLException {
+        final String url = "jdbc:TAOS://" + host + ":6030/?user=root&password=taosdata&batchfetch=true";
+        conn = DriverManager.getConnection(url);
+        try (Statement stmt = conn.createStatement()) {
+            stmt.execute("drop database if exists " + dbName);
+            stmt.execute("create database if not exists " + dbName);
+            stmt.execute("use " + dbName);
+            stmt.execute("create table weather(ts timestamp, f1 int, f2 double, f3 binary(16), f4 nchar(16))");
+            for (int i = 0; i < numOfRows; i += 1000) {
+                StringBuilder sb = new StringBuilder("insert into weather values");
+                for (int j = i; j < i + 1000; j++) {
+                    if (j % 7 == 0) {
+                        sb.append("(").append(startTs + j).append(", null, ").append(j * 0.5).append(", null, null)");
+                    } else {
+                        sb.append("(").append(startTs + j).append(", ").append(j).append(", ").append(j * 0.5)
+                                .append(", 'b").append(j).append("', 'n").append(j).append("')");
+                    }
+                }
+                stmt.execute(sb.toString());
+            }
+        }
+    }
+
+    @AfterClass
+    public static void afterClass() throws SQLException {
+        if (conn != null) {
+            try (Statement stmt = conn.createStatement()) {
+                stmt.execute("drop database if exists " + dbName);
+            }
+            conn.close();
+        }
+    }
+}
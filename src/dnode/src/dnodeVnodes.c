@@ -16,6 +16,7 @@
 #define _DEFAULT_SOURCE
 #include "os.h"
 #include "ttimer.h"
+#include "twal.h"
 #include "dnodeEps.h"
 #include "dnodeCfg.h"
 #include "dnodeMInfos.h"
@@ -28,6 +29,7 @@ typedef struct {
   int32_t   opened;
   int32_t   vnodeNum;
   int32_t * vnodeList;
+  int32_t * nextVnode;  // shared by all threads, so a vnode with a long wal does not hold up others
 } SOpenVnodeThread;
 
 extern void *   tsDnodeTmr;
@@ -89,10 +91,11 @@ static void *dnodeOpenVnode(void *param) {
   SOpenVnodeThread *pThread = param;
   char stepDesc[TSDB_STEP_DESC_LEN] = {0};
 
-  dDebug("thread:%d, start to open %d vnodes", pThread->threadIndex, pThread->vnodeNum);
+  dDebug("thread:%d, start to open vnodes", pThread->threadIndex);
   setThreadName("dnodeOpenVnode");
 
-  for (int32_t v = 0; v < pThread->vnodeNum; ++v) {
+  int32_t v = 0;
+  while ((v = atomic_fetch_add_32(pThread->nextVnode, 1)) < pThread->vnodeNum) {
     int32_t vgId = pThread->vnodeList[v];
     snprintf(stepDesc, TSDB_STEP_DESC_LEN, "vgId:%d, start to restore, %d of %d have been opened", vgId, tsOpenVnodes, tsTotalVnodes);
     dnodeReportStep("open-vnodes", stepDesc, 0);
@@ -108,8 +111,7 @@ static void *dnodeOpenVnode(void *param) {
     atomic_add_fetch_32(&tsOpenVnodes, 1);
   }
 
-  dDebug("thread:%d, total vnodes:%d, opened:%d failed:%d", pThread->threadIndex, pThread->vnodeNum, pThread->opened,
-         pThread->failed);
+  dDebug("thread:%d, opened:%d failed:%d", pThread->threadIndex, pThread->opened, pThread->failed);
   return NULL;
 }
 
@@ -124,8 +126,10 @@ int32_t dnodeInitVnodes() {
     return status;
   }
 
-  int32_t threadNum = tsNumOfCores;
-  int32_t vnodesPerThread = numOfVnodes / threadNum + 1;
+  int32_t threadNum = MIN(tsNumOfCores, numOfVnodes);
+  if (threadNum < 1) threadNum = 1;
+  int32_t nextVnode = 0;
+  int64_t startMs = taosGetTimestampMs();
   SOpenVnodeThread *threads = calloc(threadNum, sizeof(SOpenVnodeThread));
 
   if (threads == NULL) {
@@ -134,19 +138,9 @@ int32_t dnodeInitVnodes() {
 
   for (int32_t t = 0; t < threadNum; ++t) {
     threads[t].threadIndex = t;
-    threads[t].vnodeList = calloc(vnodesPerThread, sizeof(int32_t));
-
-    if (threads[t].vnodeList == NULL) {
-      dError("vnodeList allocation failed");
-      status = TSDB_CODE_DND_OUT_OF_MEMORY;
-      goto DNODE_INIT_VNODES_OUT;
-    }
-  }
-
-  for (int32_t v = 0; v < numOfVnodes; ++v) {
-    int32_t t = v % threadNum;
-    SOpenVnodeThread *pThread = &threads[t];
-    pThread->vnodeList[pThread->vnodeNum++] = vnodeList[v];
+    threads[t].vnodeNum = numOfVnodes;
+    threads[t].vnodeList = vnodeList;
+    threads[t].nextVnode = &nextVnode;
   }
 
   dInfo("start %d threads to open %d vnodes", threadNum, numOfVnodes);
@@ -176,19 +170,18 @@ int32_t dnodeInitVnodes() {
     failedVnodes += pThread->failed;
   }
 
-  dInfo("there are total vnodes:%d, opened:%d", numOfVnodes, openVnodes);
+  SWalRestoreStat walStat = {0};
+  walGetRestoreStat(&walStat);
+  dInfo("there are total vnodes:%d, opened:%d in %" PRId64 "ms, wal files:%" PRId64 " records:%" PRId64
+        " bytes:%" PRId64 " are restored, restore time of all files:%" PRId64 "ms",
+        numOfVnodes, openVnodes, taosGetTimestampMs() - startMs, walStat.files, walStat.records, walStat.bytes,
+        walStat.elapsedUs / 1000);
 
   if (failedVnodes != 0) {
     dError("there are total vnodes:%d, failed:%d", numOfVnodes, failedVnodes);
     status = TSDB_CODE_DND_VNODE_OPEN_FAILED;
   }
 
-DNODE_INIT_VNODES_OUT:
-
-  for (int32_t t = 0; t < threadNum; ++t) {
-    SOpenVnodeThread *pThread = &threads[t];
-    free(pThread->vnodeList);
-  }
   free(threads);
 
   return status;
@@ -179,6 +179,17 @@ DLL_EXPORT bool taos_is_update_query(TAOS_RES *res);
 DLL_EXPORT int taos_fetch_block(TAOS_RES *res, TAOS_ROW *rows);
 DLL_EXPORT int* taos_fetch_lengths(TAOS_RES *res);
 
+typedef struct TAOS_COLUMN_BLOCK {
+  int            type;
+  int            bytes;     // length of each value in data, including the 2-byte length prefix of binary/nchar values
+  char          *data;      // values of all rows in the block, one after another
+  unsigned char *is_null;   // bit (row & 7) of byte (row >> 3) is set if the value of the row is null
+} TAOS_COLUMN_BLOCK;
+
+// fetch the next block of results column by column, columns must hold taos_num_fields(res) elements.
+// The returned buffers refer to the received result and are valid until the next fetch or taos_free_result.
+DLL_EXPORT int taos_fetch_column_block(TAOS_RES *res, TAOS_COLUMN_BLOCK *columns);
+
 DLL_EXPORT int taos_validate_sql(TAOS *taos, const char *sql);
 DLL_EXPORT void taos_reset_current_db(TAOS *taos);
 
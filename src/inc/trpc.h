@@ -78,6 +78,14 @@ typedef struct SRpcInit {
   int  (*afp)(char *tableId, char *spi, char *encrypt, char *secret, char *ckey);
 } SRpcInit;
 
+typedef struct {
+  int64_t allocs;  // message buffers allocated
+  int64_t hits;    // allocations served by the buffer pools
+  int64_t frees;
+  int64_t copied;  // bytes copied between buffers while receiving, decompressing or growing messages
+  int64_t direct;  // bytes received into the message buffers directly
+} SRpcBufStat;
+
 int32_t rpcInit();
 void  rpcCleanup();
 void *rpcOpen(const SRpcInit *pRpc);
@@ -92,6 +100,7 @@ int   rpcGetConnInfo(void *thandle, SRpcConnInfo *pInfo);
 void  rpcSendRecv(void *shandle, SRpcEpSet *pEpSet, SRpcMsg *pReq, SRpcMsg *pRsp);
 int   rpcReportProgress(void *pConn, char *pCont, int contLen);
 void  rpcCancelRequest(int64_t rid);
+void  rpcGetBufStat(SRpcBufStat *pStat);
 
 #ifdef __cplusplus
 }
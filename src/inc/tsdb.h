@@ -169,6 +169,9 @@ typedef void *TsdbQueryHandleT;  // Use void to hide implementation details
 #define BLOCK_LOAD_TABLE_SEQ_ORDER    2
 #define BLOCK_LOAD_TABLE_RR_ORDER     3
 
+// check the pre-calculated statistics of a file data block, return false if no row in the block can be qualified
+typedef bool (*__block_filter_fn_t)(void *param, SDataStatis *pStatis, int32_t numOfCols, int32_t numOfRows);
+
 // query condition to build multi-table data block iterator
 typedef struct STsdbQueryCond {
   STimeWindow  twindow;
@@ -177,6 +180,8 @@ typedef struct STsdbQueryCond {
   SColumnInfo *colList;
   bool         loadExternalRows;  // load external rows or not
   int32_t      type;              // data block load type:
+  __block_filter_fn_t blockFilterFp;     // optional, prune the file data blocks before loading them
+  void               *blockFilterParam;
 } STsdbQueryCond;
 
 typedef struct STableData STableData;
@@ -385,12 +390,31 @@ int32_t tsdbGetTableGroupFromIdList(STsdbRepo *tsdb, SArray *pTableIdList, STabl
  */
 void tsdbCleanupQueryHandle(TsdbQueryHandleT queryHandle);
 
+/**
+ * get the number of file data blocks and file sets that are pruned by the block filter of the query condition
+ * @param queryHandle
+ * @param blocks
+ * @param fileSets
+ */
+void tsdbGetPrunedBlocks(TsdbQueryHandleT queryHandle, int64_t *blocks, int64_t *fileSets);
+
 void tsdbResetQueryHandle(TsdbQueryHandleT queryHandle, STsdbQueryCond *pCond);
 
 void tsdbResetQueryHandleForNewTable(TsdbQueryHandleT queryHandle, STsdbQueryCond *pCond, STableGroupInfo* groupList);
 
 int32_t tsdbGetFileBlocksDistInfo(TsdbQueryHandleT* queryHandle, STableBlockDist* pTableBlockInfo);
 
+/**
+ * split the ascending query time window into at most maxParts consecutive windows at the boundaries of the data
+ * file sets, so that each of them can be scanned by an individual query handle
+ * @param tsdb
+ * @param pWin     query time window
+ * @param pParts   output windows, at least maxParts elements
+ * @param maxParts
+ * @return the number of windows, 1 if the query time window is not split
+ */
+int32_t tsdbSplitQueryWindow(STsdbRepo *tsdb, STimeWindow *pWin, STimeWindow *pParts, int32_t maxParts);
+
 /**
  * get the statistics of repo usage
  * @param repo. point to the tsdbrepo
@@ -400,6 +424,22 @@ int32_t tsdbGetFileBlocksDistInfo(TsdbQueryHandleT* queryHandle, STableBlockDist
  */
 void tsdbReportStat(void *repo, int64_t *totalPoints, int64_t *totalStorage, int64_t *compStorage);
 
+// --------- TSDB BLOCK CACHE
+typedef struct {
+  int64_t capacity;      // bytes allowed by blockCacheSize
+  int64_t used;          // bytes taken by cached column chunks
+  int64_t numOfEntries;
+  int64_t hits;
+  int64_t misses;
+  int64_t evicts;
+  int64_t numOfHeadIdx;  // decoded head file indexes shared by the readers of file sets
+  int64_t headIdxUsed;   // bytes taken by the decoded head file indexes
+} STsdbBlkCacheStat;
+
+int  tsdbInitBlkCache();
+void tsdbDestroyBlkCache();
+void tsdbGetBlkCacheStat(STsdbBlkCacheStat *pStat);
+
 int  tsdbInitCommitQueue();
 void tsdbDestroyCommitQueue();
 int  tsdbSyncCommit(STsdbRepo *repo);
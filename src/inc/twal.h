@@ -48,6 +48,24 @@ typedef struct {
   EWalKeep keep;         // keep the wal file when closed
 } SWalCfg;
 
+#define WAL_STAT_BUCKETS 20
+
+typedef struct {
+  int64_t cycles;                      // flush cycles which wrote or fsynced anything
+  int64_t records;
+  int64_t bytes;
+  int64_t fsyncs;
+  int64_t latency[WAL_STAT_BUCKETS];  // cycles by duration, bucket i counts [2^i, 2^(i+1)) us
+  int64_t groups[WAL_STAT_BUCKETS];   // cycles by records written, bucket i counts [2^i, 2^(i+1))
+} SWalGroupStat;
+
+typedef struct {
+  int64_t files;
+  int64_t records;
+  int64_t bytes;
+  int64_t elapsedUs;  // sum of the restore time of all files
+} SWalRestoreStat;
+
 typedef void *  twalh;  // WAL HANDLE
 typedef int32_t FWalWrite(void *ahandle, void *pHead, int32_t qtype, void *pMsg);
 
@@ -61,8 +79,13 @@ int32_t  walRenew(twalh);
 void     walRemoveOneOldFile(twalh);
 void     walRemoveAllOldFiles(twalh);
 int32_t  walWrite(twalh, SWalHead *);
-void     walFsync(twalh, bool forceFsync);
+int32_t  walFsync(twalh, bool forceFsync);
+int32_t  walCommit(twalh, bool forceFsync);
+void     walGetGroupStat(SWalGroupStat *pStat);
 int32_t  walRestore(twalh, void *pVnode, FWalWrite writeFp);
+int32_t  walRestoreFrom(twalh, void *pVnode, FWalWrite writeFp, int64_t fileId, int64_t offset);
+bool     walCheckPos(twalh, int64_t fileId, int64_t offset, uint64_t version);
+void     walGetRestoreStat(SWalRestoreStat *pStat);
 int32_t  walGetWalFile(twalh, char *fileName, int64_t *fileId);
 uint64_t walGetVersion(twalh);
 void     walResetVersion(twalh, uint64_t newVer);
@@ -60,6 +60,7 @@ typedef struct SSdbRow {
   SMnodeMsg *pMsg;
   int32_t  (*fpReq)(SMnodeMsg *pMsg);
   int32_t  (*fpRsp)(SMnodeMsg *pMsg, int32_t code);
+  void *     pSnapDeltas;     // rows deleted locally along with the row, kept for the snapshot with its wal record
   char       reserveForSync[24];
   SWalHead   pHead;
 } SSdbRow;
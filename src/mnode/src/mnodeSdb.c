@@ -18,6 +18,7 @@
 #include "taoserror.h"
 #include "hash.h"
 #include "tutil.h"
+#include "tchecksum.h"
 #include "tref.h"
 #include "tbn.h"
 #include "tfs.h"
@@ -38,6 +39,12 @@
 #define SDB_TABLE_LEN 12
 #define MAX_QUEUED_MSG_NUM 100000
 
+#define SDB_SNAP_FILE       "snapshot"
+#define SDB_SNAP_TMP_SUFFIX ".tmp"
+#define SDB_SNAP_MAGIC      0x53444253
+#define SDB_SNAP_KEY_LEN    (TSDB_TABLE_FNAME_LEN + 8)
+#define SDB_SNAP_RETRY_MS   10000
+
 typedef enum {
   SDB_ACTION_INSERT = 0,
   SDB_ACTION_DELETE = 1,
@@ -90,6 +97,81 @@ typedef struct {
   pthread_mutex_t mutex;
 } SSdbMgmt;
 
+typedef struct {
+  uint32_t magic;
+  int32_t  reserved;
+  uint64_t version;    // sdb version of the last record in the snapshot
+  int64_t  walFileId;  // wal position after that record
+  int64_t  walOffset;
+  int64_t  rows;
+  int64_t  size;       // bytes of the rows
+  uint32_t reserved2;
+  TSCKSUM  cksum;      // of the head
+} SSdbSnapHead;
+
+typedef struct {
+  int32_t tableId;
+  int32_t len;
+} SSdbSnapRow;
+
+typedef struct {
+  uint64_t version;
+  int64_t  walFileId;
+  int64_t  walOffset;
+} SSdbSnapPos;
+
+typedef struct {
+  FILE *  fp;
+  int64_t rows;
+  int64_t size;
+  TSCKSUM cksum;
+} SSdbSnapWriter;
+
+typedef struct {
+  FILE *       fp;
+  SSdbSnapHead head;
+  SSdbSnapRow  row;     // the row read last
+  char *       buffer;  // content of the row
+  int32_t      bufLen;
+  int64_t      rows;
+  TSCKSUM      cksum;
+} SSdbSnapReader;
+
+typedef struct SSdbSnapDelta {
+  struct SSdbSnapDelta *next;
+  char                  data[];  // SWalHead and the row
+} SSdbSnapDelta;
+
+typedef enum {
+  SDB_SNAP_KEY_PRESENT = 0,
+  SDB_SNAP_KEY_ABSENT = 1,
+  SDB_SNAP_KEY_UPDATED = 2  // updated only, present if the last snapshot has it
+} ESdbSnapKey;
+
+typedef struct {
+  SSdbSnapDelta *pDelta;  // the record with the row of the key
+  int8_t         state;
+  int8_t         written;
+} SSdbSnapKey;
+
+typedef struct {
+  pthread_t       thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t  cond;
+  int8_t          stop;
+  int8_t          capture;      // records are kept for the next snapshot
+  int8_t          dump;         // dump the tables to a new snapshot after restore
+  int8_t          hasSnapshot;
+  uint64_t        version;      // of the last snapshot
+  int64_t         retryTime;
+  int32_t         numOfDeltas;  // records after the last snapshot
+  SSdbSnapDelta * deltaHead;
+  SSdbSnapDelta * deltaTail;
+  int32_t         numOfJobDeltas;  // records being merged by the snapshot thread
+  SSdbSnapDelta * jobHead;
+  SSdbSnapPos     jobPos;
+} SSdbSnapshot;
+
 typedef struct {
   pthread_t thread;
   int32_t   workerId;
@@ -108,6 +190,10 @@ static taos_qset  tsSdbWQset;
 static taos_qall  tsSdbWQall;
 static taos_queue tsSdbWQueue;
 static SSdbWorkerPool tsSdbPool;
+static SSdbSnapshot   tsSdbSnap;
+
+// the rows deleted locally while a row is deleted globally in this thread, they have no wal record of their own
+static threadlocal SSdbSnapDelta **tsSdbSnapCascade = NULL;
 
 static int32_t sdbProcessWrite(void *pRow, void *pHead, int32_t qtype, void *unused);
 static int32_t sdbWriteFwdToQueue(int32_t vgId, void *pHead, int32_t qtype, void *rparam);
@@ -122,6 +208,15 @@ static int32_t sdbInsertHash(SSdbTable *pTable, SSdbRow *pRow);
 static int32_t sdbUpdateHash(SSdbTable *pTable, SSdbRow *pRow);
 static int32_t sdbDeleteHash(SSdbTable *pTable, SSdbRow *pRow);
 static void    sdbCloseTableObj(void *handle);
+static int32_t sdbInitSnapshot();
+static int32_t sdbStartSnapshot();
+static void    sdbCleanupSnapshot();
+static int32_t sdbLoadSnapshot(SSdbSnapPos *pPos);
+static void    sdbKeepSnapDelta(SWalHead *pHead);
+static void    sdbKeepSnapDeltas(SSdbSnapDelta *pDeltas);
+static void    sdbFreeSnapDeltas(SSdbSnapDelta *pDelta);
+static SSdbSnapDelta *sdbNewSnapDeleteDelta(SSdbTable *pTable, void *pObj);
+static void    sdbTriggerSnapshot();
 
 int32_t sdbGetId(void *pTable) {
   return ((SSdbTable *)pTable)->autoIndex;
@@ -184,8 +279,13 @@ static int32_t sdbInitWal() {
     return -1;
   }
 
-  sdbInfo("vgId:1, open sdb wal for restore");
-  int32_t code = walRestore(tsSdbMgmt.wal, NULL, sdbProcessWrite);
+  SSdbSnapPos pos = {.walFileId = -1};
+  if (tsMnodeSnapshotRows > 0 && sdbLoadSnapshot(&pos) != TSDB_CODE_SUCCESS) {
+    return -1;
+  }
+
+  sdbInfo("vgId:1, open sdb wal for restore, mver:%" PRIu64, tsSdbMgmt.version);
+  int32_t code = walRestoreFrom(tsSdbMgmt.wal, NULL, sdbProcessWrite, pos.walFileId, pos.walOffset);
   if (code != TSDB_CODE_SUCCESS) {
     sdbError("vgId:1, failed to open wal for restore since %s", tstrerror(code));
     return -1;
@@ -441,10 +541,13 @@ int32_t sdbInit() {
     return -1;
   }
 
+  sdbInitSnapshot();
+
   if (sdbInitWal() != 0) {
     return -1;
   }
 
+  sdbStartSnapshot();
   sdbRestoreTables();
 
   if (mnodeGetMnodesNum() == 1) {
@@ -467,6 +570,7 @@ void sdbCleanUp() {
   tsSdbMgmt.status = SDB_STATUS_CLOSING;
 
   sdbCleanupWorker();
+  sdbCleanupSnapshot();
   sdbDebug("vgId:1, sdb will be closed, mver:%" PRIu64, tsSdbMgmt.version);
 
   if (tsSdbMgmt.sync) {
@@ -693,6 +797,11 @@ static int32_t sdbProcessWrite(void *wparam, void *hparam, int32_t qtype, void *
     return code;
   }
 
+  sdbKeepSnapDelta(pHead);
+  if (pRow != NULL && pRow->pSnapDeltas != NULL) {
+    sdbKeepSnapDeltas(pRow->pSnapDeltas);
+    pRow->pSnapDeltas = NULL;
+  }
   pthread_mutex_unlock(&tsSdbMgmt.mutex);
 
   // from app, row is created
@@ -800,21 +909,49 @@ int32_t sdbDeleteRow(SSdbRow *pRow) {
     return TSDB_CODE_MND_SDB_OBJ_NOT_THERE;
   }
 
+  /*
+   * A local delete has no wal record, but it is the side effect of deleting another row, e.g. the child tables of a
+   * dropped db. It is kept for the snapshot right after the wal record of that row, or right away if the record is
+   * being restored or forwarded in this thread, so the snapshot drops the row the same as replaying the wal.
+   */
+  SSdbSnapDelta * pDelta = NULL;
+  SSdbSnapDelta * pCascade = NULL;
+  SSdbSnapDelta **pOuter = tsSdbSnapCascade;
+  if (pRow->type != SDB_OPER_GLOBAL) {
+    pDelta = sdbNewSnapDeleteDelta(pTable, pObj);
+  } else if (pRow->fpReq == NULL && tsSdbSnap.capture && tsSdbSnapCascade == NULL) {
+    tsSdbSnapCascade = &pCascade;
+  }
+
   int32_t code = sdbDeleteHash(pTable, pRow);
+  tsSdbSnapCascade = pOuter;
+
   if (code != TSDB_CODE_SUCCESS) {
     sdbError("vgId:1, sdb:%s, failed to delete from hash", pTable->name);
+    sdbFreeSnapDeltas(pDelta);
+    sdbFreeSnapDeltas(pCascade);
     return code;
   }
 
   // just delete data from memory
   if (pRow->type != SDB_OPER_GLOBAL) {
+    if (pDelta != NULL && tsSdbSnapCascade != NULL) {
+      pDelta->next = *tsSdbSnapCascade;
+      *tsSdbSnapCascade = pDelta;
+    } else if (pDelta != NULL) {
+      sdbKeepSnapDeltas(pDelta);
+    }
     return TSDB_CODE_SUCCESS;
   }
 
   if (pRow->fpReq) {
     return (*pRow->fpReq)(pRow->pMsg);
   } else {
-    return sdbWriteRowToQueue(pRow, SDB_ACTION_DELETE);
+    pRow->pSnapDeltas = pCascade;
+    code = sdbWriteRowToQueue(pRow, SDB_ACTION_DELETE);
+    if (code != TSDB_CODE_MND_ACTION_IN_PROGRESS) sdbFreeSnapDeltas(pCascade);
+    pRow->pSnapDeltas = NULL;
+    return code;
   }
 }
 
@@ -1060,6 +1197,7 @@ static void sdbFreeFromQueue(SSdbRow *pRow) {
   int32_t queued = atomic_sub_fetch_32(&tsSdbMgmt.queuedMsg, 1);
   sdbTrace("vgId:1, msg:%p free from sdb queue, queued:%d", pRow->pMsg, queued);
 
+  sdbFreeSnapDeltas(pRow->pSnapDeltas);
   sdbDecRef(pRow->pTable, pRow->pObj);
   taosFreeQitem(pRow);
 }
@@ -1135,6 +1273,7 @@ static void *sdbWorkerFp(void *pWorker) {
     }
 
     walFsync(tsSdbMgmt.wal, true);
+    sdbTriggerSnapshot();
 
     // browse all items, and process them one by one
     taosResetQitems(tsSdbWQall);
@@ -1158,6 +1297,643 @@ static void *sdbWorkerFp(void *pWorker) {
   return NULL;
 }
 
+/*
+ * Snapshot of the sdb tables, so that the startup loads the rows of all tables and replays only the wal records after
+ * the snapshot instead of the whole wal. The records written since the last snapshot are kept in memory, and after
+ * tsMnodeSnapshotRows of them, a background thread merges them into the last snapshot to write a new one. The first
+ * snapshot is dumped from the tables at startup, when the tables are the same as the wal. The snapshot is kept in
+ * tsMnodeDir with the wal it is taken from, so it goes away with the wal when the wal is compacted or the mnode is
+ * dropped.
+ *
+ * file: head | row 1 | ... | row n | checksum of the rows
+ * row:  SSdbSnapRow | the row encoded by fpEncode, the same as the content of its wal record
+ *
+ * The rows are ordered by the table id, which is the order the tables depend on each other.
+ */
+static void sdbSnapFileName(char *name, const char *suffix) {
+  snprintf(name, TSDB_FILENAME_LEN, "%s/%s%s", tsMnodeDir, SDB_SNAP_FILE, suffix);
+}
+
+static int32_t sdbGetRowKeyLen(SSdbTable *pTable, char *cont, int32_t len) {
+  if (pTable->keyType == SDB_KEY_STRING || pTable->keyType == SDB_KEY_VAR_STRING) {
+    return (int32_t)strnlen(cont, len);
+  }
+  return sizeof(int32_t);
+}
+
+static int32_t sdbSnapWrite(SSdbSnapWriter *pWriter, int32_t tableId, void *cont, int32_t len) {
+  SSdbSnapRow row = {.tableId = tableId, .len = len};
+  if (fwrite(&row, sizeof(row), 1, pWriter->fp) != 1 || fwrite(cont, len, 1, pWriter->fp) != 1) {
+    return TAOS_SYSTEM_ERROR(errno);
+  }
+
+  pWriter->cksum = taosCalcChecksum(pWriter->cksum, (uint8_t *)&row, sizeof(row));
+  pWriter->cksum = taosCalcChecksum(pWriter->cksum, cont, len);
+  pWriter->rows++;
+  pWriter->size += sizeof(row) + len;
+  return TSDB_CODE_SUCCESS;
+}
+
+static int32_t sdbSnapWriterOpen(SSdbSnapWriter *pWriter) {
+  char name[TSDB_FILENAME_LEN];
+  sdbSnapFileName(name, SDB_SNAP_TMP_SUFFIX);
+
+  memset(pWriter, 0, sizeof(SSdbSnapWriter));
+  pWriter->fp = fopen(name, "wb");
+  if (pWriter->fp == NULL) {
+    sdbError("vgId:1, failed to open %s for snapshot since %s", name, strerror(errno));
+    return TAOS_SYSTEM_ERROR(errno);
+  }
+
+  // the head is written again when the snapshot is finished
+  SSdbSnapHead head = {0};
+  if (fwrite(&head, sizeof(head), 1, pWriter->fp) != 1) {
+    fclose(pWriter->fp);
+    pWriter->fp = NULL;
+    return TAOS_SYSTEM_ERROR(errno);
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+static int32_t sdbSnapWriterClose(SSdbSnapWriter *pWriter, SSdbSnapPos *pPos, bool commit) {
+  char    tmpName[TSDB_FILENAME_LEN];
+  char    name[TSDB_FILENAME_LEN];
+  int32_t code = TSDB_CODE_SUCCESS;
+
+  sdbSnapFileName(tmpName, SDB_SNAP_TMP_SUFFIX);
+  sdbSnapFileName(name, "");
+
+  if (commit) {
+    SSdbSnapHead head = {.magic = SDB_SNAP_MAGIC,
+                         .version = pPos->version,
+                         .walFileId = pPos->walFileId,
+                         .walOffset = pPos->walOffset,
+                         .rows = pWriter->rows,
+                         .size = pWriter->size};
+    taosCalcChecksumAppend(0, (uint8_t *)&head, sizeof(head));
+
+    if (fwrite(&pWriter->cksum, sizeof(TSCKSUM), 1, pWriter->fp) != 1 || fseek(pWriter->fp, 0, SEEK_SET) != 0 ||
+        fwrite(&head, sizeof(head), 1, pWriter->fp) != 1 || fflush(pWriter->fp) != 0 || taosFsync(fileno(pWriter->fp)) != 0) {
+      code = TAOS_SYSTEM_ERROR(errno);
+    }
+  }
+
+  if (fclose(pWriter->fp) != 0 && code == TSDB_CODE_SUCCESS) code = TAOS_SYSTEM_ERROR(errno);
+  pWriter->fp = NULL;
+
+  if (commit && code == TSDB_CODE_SUCCESS && taosRename(tmpName, name) != 0) {
+    code = TAOS_SYSTEM_ERROR(errno);
+  }
+
+  if (!commit || code != TSDB_CODE_SUCCESS) remove(tmpName);
+  return code;
+}
+
+// the rows of a snapshot are read one by one into pReader->buffer, and checked against the checksum at the end
+static int32_t sdbSnapReaderOpen(SSdbSnapReader *pReader) {
+  char name[TSDB_FILENAME_LEN];
+  sdbSnapFileName(name, "");
+
+  memset(pReader, 0, sizeof(SSdbSnapReader));
+  pReader->fp = fopen(name, "rb");
+  if (pReader->fp == NULL) return TAOS_SYSTEM_ERROR(errno);
+
+  if (fread(&pReader->head, sizeof(SSdbSnapHead), 1, pReader->fp) != 1 ||
+      !taosCheckChecksumWhole((uint8_t *)&pReader->head, sizeof(SSdbSnapHead)) ||
+      pReader->head.magic != SDB_SNAP_MAGIC) {
+    sdbError("vgId:1, snapshot %s has an invalid head", name);
+    fclose(pReader->fp);
+    pReader->fp = NULL;
+    return TSDB_CODE_MND_SDB_ERROR;
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+static int32_t sdbSnapReaderRewind(SSdbSnapReader *pReader) {
+  pReader->rows = 0;
+  pReader->cksum = 0;
+  if (fseek(pReader->fp, sizeof(SSdbSnapHead), SEEK_SET) != 0) return TAOS_SYSTEM_ERROR(errno);
+  return TSDB_CODE_SUCCESS;
+}
+
+// returns 1 if a row is read, 0 at the end of the rows, and an error code if the snapshot is broken
+static int32_t sdbSnapRead(SSdbSnapReader *pReader) {
+  if (pReader->rows >= pReader->head.rows) {
+    TSCKSUM cksum = 0;
+    if (fread(&cksum, sizeof(cksum), 1, pReader->fp) != 1 || cksum != pReader->cksum) {
+      sdbError("vgId:1, snapshot rows are messed up, rows:%" PRId64, pReader->rows);
+      return TSDB_CODE_MND_SDB_ERROR;
+    }
+    return 0;
+  }
+
+  SSdbSnapRow *pRow = &pReader->row;
+  if (fread(pRow, sizeof(SSdbSnapRow), 1, pReader->fp) != 1 || pRow->tableId < 0 || pRow->tableId >= SDB_TABLE_MAX ||
+      pRow->len <= 0 || pRow->len > TSDB_MAX_WAL_SIZE) {
+    sdbError("vgId:1, snapshot row:%" PRId64 " is messed up", pReader->rows);
+    return TSDB_CODE_MND_SDB_ERROR;
+  }
+
+  if (pRow->len > pReader->bufLen) {
+    char *buffer = realloc(pReader->buffer, pRow->len);
+    if (buffer == NULL) return TSDB_CODE_MND_OUT_OF_MEMORY;
+    pReader->buffer = buffer;
+    pReader->bufLen = pRow->len;
+  }
+
+  if (fread(pReader->buffer, pRow->len, 1, pReader->fp) != 1) {
+    sdbError("vgId:1, snapshot row:%" PRId64 " is truncated", pReader->rows);
+    return TSDB_CODE_MND_SDB_ERROR;
+  }
+
+  pReader->cksum = taosCalcChecksum(pReader->cksum, (uint8_t *)pRow, sizeof(SSdbSnapRow));
+  pReader->cksum = taosCalcChecksum(pReader->cksum, (uint8_t *)pReader->buffer, pRow->len);
+  pReader->rows++;
+  return 1;
+}
+
+static void sdbSnapReaderClose(SSdbSnapReader *pReader) {
+  if (pReader->fp != NULL) fclose(pReader->fp);
+  pReader->fp = NULL;
+  tfree(pReader->buffer);
+}
+
+static void sdbFreeSnapDeltas(SSdbSnapDelta *pDelta) {
+  while (pDelta != NULL) {
+    SSdbSnapDelta *pNext = pDelta->next;
+    free(pDelta);
+    pDelta = pNext;
+  }
+}
+
+// keep the records for the next snapshot, in the order they are written to the wal
+static void sdbKeepSnapDeltas(SSdbSnapDelta *pDeltas) {
+  if (pDeltas == NULL) return;
+
+  pthread_mutex_lock(&tsSdbSnap.mutex);
+
+  if (!tsSdbSnap.capture) {
+    pthread_mutex_unlock(&tsSdbSnap.mutex);
+    sdbFreeSnapDeltas(pDeltas);
+    return;
+  }
+
+  // too many records are restored from wal, a new snapshot is dumped from the tables after the restore
+  if (!sdbIsServing() && tsSdbSnap.numOfDeltas >= tsMnodeSnapshotRows) {
+    sdbFreeSnapDeltas(tsSdbSnap.deltaHead);
+    tsSdbSnap.deltaHead = NULL;
+    tsSdbSnap.deltaTail = NULL;
+    tsSdbSnap.numOfDeltas = 0;
+    tsSdbSnap.capture = 0;
+    tsSdbSnap.dump = 1;
+    pthread_mutex_unlock(&tsSdbSnap.mutex);
+    sdbFreeSnapDeltas(pDeltas);
+    return;
+  }
+
+  if (tsSdbSnap.deltaTail) {
+    tsSdbSnap.deltaTail->next = pDeltas;
+  } else {
+    tsSdbSnap.deltaHead = pDeltas;
+  }
+
+  for (SSdbSnapDelta *pDelta = pDeltas; pDelta != NULL; pDelta = pDelta->next) {
+    tsSdbSnap.deltaTail = pDelta;
+    tsSdbSnap.numOfDeltas++;
+  }
+
+  pthread_mutex_unlock(&tsSdbSnap.mutex);
+}
+
+static void sdbStopSnapCapture() {
+  pthread_mutex_lock(&tsSdbSnap.mutex);
+  sdbFreeSnapDeltas(tsSdbSnap.deltaHead);
+  tsSdbSnap.deltaHead = NULL;
+  tsSdbSnap.deltaTail = NULL;
+  tsSdbSnap.numOfDeltas = 0;
+  tsSdbSnap.capture = 0;
+  tsSdbSnap.dump = !sdbIsServing();
+  pthread_mutex_unlock(&tsSdbSnap.mutex);
+
+  sdbError("vgId:1, failed to keep record for snapshot, no more snapshot till restart");
+}
+
+// keep the record for the next snapshot, it is called with tsSdbMgmt.mutex locked
+static void sdbKeepSnapDelta(SWalHead *pHead) {
+  if (!tsSdbSnap.capture) return;
+
+  int32_t        len = sizeof(SWalHead) + pHead->len;
+  SSdbSnapDelta *pDelta = malloc(sizeof(SSdbSnapDelta) + len);
+  if (pDelta == NULL) {
+    sdbStopSnapCapture();
+    return;
+  }
+
+  pDelta->next = NULL;
+  memcpy(pDelta->data, pHead, len);
+  sdbKeepSnapDeltas(pDelta);
+}
+
+// a delete record with the key of the row only, it must be built before the row is removed from the hash
+static SSdbSnapDelta *sdbNewSnapDeleteDelta(SSdbTable *pTable, void *pObj) {
+  if (!tsSdbSnap.capture) return NULL;
+
+  void *  key = sdbGetObjKey(pTable, pObj);
+  int32_t keyLen = sizeof(int32_t);
+  if (pTable->keyType == SDB_KEY_STRING || pTable->keyType == SDB_KEY_VAR_STRING) {
+    keyLen = (int32_t)strlen((char *)key) + 1;
+  }
+
+  SSdbSnapDelta *pDelta = calloc(1, sizeof(SSdbSnapDelta) + sizeof(SWalHead) + keyLen);
+  if (pDelta == NULL) {
+    sdbStopSnapCapture();
+    return NULL;
+  }
+
+  SWalHead *pHead = (SWalHead *)pDelta->data;
+  pHead->msgType = pTable->id * 10 + SDB_ACTION_DELETE;
+  pHead->len = keyLen;
+  memcpy(pHead->cont, key, keyLen);
+  return pDelta;
+}
+
+/*
+ * The net effect of the records on each key, which is looked up by the rows of the last snapshot. A key updated but
+ * not inserted by the records keeps the update only if the last snapshot has it, the same as replaying the records.
+ */
+static int32_t sdbBuildSnapKeys(SSdbSnapDelta *pDelta, SHashObj *pKeys) {
+  char key[SDB_SNAP_KEY_LEN];
+
+  for (; pDelta != NULL; pDelta = pDelta->next) {
+    SWalHead * pHead = (SWalHead *)pDelta->data;
+    int32_t    tableId = pHead->msgType / 10;
+    int32_t    action = pHead->msgType % 10;
+    SSdbTable *pTable = sdbGetTableFromId(tableId);
+    int32_t    keyLen = sdbGetRowKeyLen(pTable, pHead->cont, pHead->len);
+    if (keyLen + sizeof(int32_t) > SDB_SNAP_KEY_LEN) return TSDB_CODE_MND_INVALID_MSG_LEN;
+
+    *(int32_t *)key = tableId;
+    memcpy(key + sizeof(int32_t), pHead->cont, keyLen);
+    keyLen += sizeof(int32_t);
+
+    SSdbSnapKey  snapKey = {.pDelta = pDelta, .state = SDB_SNAP_KEY_UPDATED};
+    SSdbSnapKey *pKey = taosHashGet(pKeys, key, keyLen);
+
+    if (action == SDB_ACTION_INSERT) {
+      snapKey.state = SDB_SNAP_KEY_PRESENT;
+    } else if (action == SDB_ACTION_DELETE) {
+      snapKey.state = SDB_SNAP_KEY_ABSENT;
+    } else if (pKey != NULL && pKey->state != SDB_SNAP_KEY_UPDATED) {
+      snapKey.state = pKey->state;
+      if (pKey->state == SDB_SNAP_KEY_ABSENT) snapKey.pDelta = pKey->pDelta;
+    }
+
+    if (taosHashPut(pKeys, key, keyLen, &snapKey, sizeof(SSdbSnapKey)) != 0) return TSDB_CODE_MND_OUT_OF_MEMORY;
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+// write the rows inserted by the records into tables before the table tableId
+static int32_t sdbWriteSnapInserts(SSdbSnapWriter *pWriter, SSdbSnapDelta *pDeltas, SHashObj *pKeys, int32_t *pNext,
+                                   int32_t tableId) {
+  char key[SDB_SNAP_KEY_LEN];
+
+  for (; *pNext < tableId; ++(*pNext)) {
+    for (SSdbSnapDelta *pDelta = pDeltas; pDelta != NULL; pDelta = pDelta->next) {
+      SWalHead *pHead = (SWalHead *)pDelta->data;
+      if (pHead->msgType / 10 != *pNext) continue;
+
+      int32_t keyLen = sdbGetRowKeyLen(sdbGetTableFromId(*pNext), pHead->cont, pHead->len);
+      *(int32_t *)key = *pNext;
+      memcpy(key + sizeof(int32_t), pHead->cont, keyLen);
+
+      SSdbSnapKey *pKey = taosHashGet(pKeys, key, keyLen + sizeof(int32_t));
+      if (pKey == NULL || pKey->pDelta != pDelta || pKey->state != SDB_SNAP_KEY_PRESENT || pKey->written) continue;
+
+      int32_t code = sdbSnapWrite(pWriter, *pNext, pHead->cont, pHead->len);
+      if (code != TSDB_CODE_SUCCESS) return code;
+      pKey->written = 1;
+    }
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+// merge the records into the last snapshot, the rows of the last snapshot are replaced or removed by the records
+static int32_t sdbMergeSnapshot(SSdbSnapDelta *pDeltas, int32_t numOfDeltas, SSdbSnapPos *pPos, bool hasSnapshot) {
+  SSdbSnapReader reader = {0};
+  SSdbSnapWriter writer = {0};
+  int32_t        next = 0;
+  char           key[SDB_SNAP_KEY_LEN];
+
+  SHashObj *pKeys = taosHashInit(numOfDeltas, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), true, HASH_NO_LOCK);
+  if (pKeys == NULL) return TSDB_CODE_MND_OUT_OF_MEMORY;
+
+  int32_t code = sdbBuildSnapKeys(pDeltas, pKeys);
+  if (code != TSDB_CODE_SUCCESS) goto _end;
+
+  if (hasSnapshot) {
+    code = sdbSnapReaderOpen(&reader);
+    if (code != TSDB_CODE_SUCCESS) goto _end;
+  }
+
+  code = sdbSnapWriterOpen(&writer);
+  if (code != TSDB_CODE_SUCCESS) goto _end;
+
+  while (hasSnapshot) {
+    code = sdbSnapRead(&reader);
+    if (code <= 0) break;
+
+    int32_t tableId = reader.row.tableId;
+    code = sdbWriteSnapInserts(&writer, pDeltas, pKeys, &next, tableId);
+    if (code != TSDB_CODE_SUCCESS) break;
+
+    SSdbTable *pTable = sdbGetTableFromId(tableId);
+    int32_t    keyLen = (pTable == NULL) ? SDB_SNAP_KEY_LEN : sdbGetRowKeyLen(pTable, reader.buffer, reader.row.len);
+    if (keyLen + sizeof(int32_t) > SDB_SNAP_KEY_LEN) {
+      code = TSDB_CODE_MND_SDB_ERROR;
+      break;
+    }
+
+    *(int32_t *)key = tableId;
+    memcpy(key + sizeof(int32_t), reader.buffer, keyLen);
+
+    SSdbSnapKey *pKey = taosHashGet(pKeys, key, keyLen + sizeof(int32_t));
+    if (pKey == NULL) {
+      code = sdbSnapWrite(&writer, tableId, reader.buffer, reader.row.len);
+    } else if (pKey->state != SDB_SNAP_KEY_ABSENT && !pKey->written) {
+      SWalHead *pHead = (SWalHead *)pKey->pDelta->data;
+      code = sdbSnapWrite(&writer, tableId, pHead->cont, pHead->len);
+      pKey->written = 1;
+    }
+    if (code != TSDB_CODE_SUCCESS) break;
+  }
+
+  if (code == TSDB_CODE_SUCCESS) {
+    code = sdbWriteSnapInserts(&writer, pDeltas, pKeys, &next, SDB_TABLE_MAX);
+  }
+
+  int32_t ret = sdbSnapWriterClose(&writer, pPos, code == TSDB_CODE_SUCCESS);
+  if (code == TSDB_CODE_SUCCESS) code = ret;
+
+  if (code == TSDB_CODE_SUCCESS) {
+    sdbInfo("vgId:1, snapshot is written, mver:%" PRIu64 " rows:%" PRId64 " size:%" PRId64 ", %d records are merged",
+            pPos->version, writer.rows, writer.size, numOfDeltas);
+  }
+
+_end:
+  sdbSnapReaderClose(&reader);
+  taosHashCleanup(pKeys);
+  return code;
+}
+
+// the tables are the same as the wal at startup, so the first snapshot is dumped from them directly
+static int32_t sdbDumpSnapshot() {
+  SSdbSnapWriter writer = {0};
+  SSdbSnapPos    pos = {.version = tsSdbMgmt.version, .walFileId = 0, .walOffset = walGetFSize(tsSdbMgmt.wal)};
+  int64_t        start = taosGetTimestampMs();
+
+  int32_t code = sdbSnapWriterOpen(&writer);
+  if (code != TSDB_CODE_SUCCESS) return code;
+
+  for (int32_t tableId = 0; tableId < SDB_TABLE_MAX && code == TSDB_CODE_SUCCESS; ++tableId) {
+    SSdbTable *pTable = sdbGetTableFromId(tableId);
+    if (pTable == NULL) continue;
+
+    char *buffer = malloc(pTable->maxRowSize);
+    if (buffer == NULL) {
+      code = TSDB_CODE_MND_OUT_OF_MEMORY;
+      break;
+    }
+
+    void *pIter = taosHashIterate(pTable->iHandle, NULL);
+    while (pIter) {
+      SSdbRow row = {.pTable = pTable, .pObj = *(void **)pIter, .rowData = buffer};
+      code = (*pTable->fpEncode)(&row);
+      if (code == TSDB_CODE_SUCCESS) code = sdbSnapWrite(&writer, tableId, buffer, row.rowSize);
+      if (code != TSDB_CODE_SUCCESS) {
+        taosHashCancelIterate(pTable->iHandle, pIter);
+        break;
+      }
+      pIter = taosHashIterate(pTable->iHandle, pIter);
+    }
+
+    free(buffer);
+  }
+
+  int32_t ret = sdbSnapWriterClose(&writer, &pos, code == TSDB_CODE_SUCCESS);
+  if (code == TSDB_CODE_SUCCESS) code = ret;
+
+  if (code != TSDB_CODE_SUCCESS) {
+    sdbError("vgId:1, failed to dump snapshot since %s", tstrerror(code));
+    return code;
+  }
+
+  sdbInfo("vgId:1, snapshot is dumped, mver:%" PRIu64 " rows:%" PRId64 " size:%" PRId64 " in %" PRId64 "ms",
+          pos.version, writer.rows, writer.size, taosGetTimestampMs() - start);
+  tsSdbSnap.version = pos.version;
+  tsSdbSnap.hasSnapshot = 1;
+  return TSDB_CODE_SUCCESS;
+}
+
+/*
+ * Load the rows of the snapshot into the tables, the same as inserting them from the wal, and set the wal position to
+ * restore from. The whole snapshot is checked before any row is loaded, so a broken or stale snapshot is removed and
+ * the whole wal is replayed instead. An error is returned only if the tables are partly loaded.
+ */
+static int32_t sdbLoadSnapshot(SSdbSnapPos *pPos) {
+  SSdbSnapReader reader = {0};
+  char           name[TSDB_FILENAME_LEN];
+  int64_t        start = taosGetTimestampMs();
+
+  sdbSnapFileName(name, "");
+  if (access(name, F_OK) != 0) return TSDB_CODE_SUCCESS;
+
+  int32_t code = sdbSnapReaderOpen(&reader);
+  while (code == TSDB_CODE_SUCCESS) {
+    code = sdbSnapRead(&reader);
+    if (code <= 0) break;
+    code = (sdbGetTableFromId(reader.row.tableId) == NULL) ? TSDB_CODE_MND_SDB_INVALID_TABLE_TYPE : TSDB_CODE_SUCCESS;
+  }
+
+  if (code == TSDB_CODE_SUCCESS && !walCheckPos(tsSdbMgmt.wal, reader.head.walFileId, reader.head.walOffset,
+                                                reader.head.version)) {
+    code = TSDB_CODE_MND_SDB_ERROR;
+  }
+
+  if (code != TSDB_CODE_SUCCESS) {
+    sdbWarn("vgId:1, snapshot %s can not be used since %s, remove it and restore from wal", name, tstrerror(code));
+    sdbSnapReaderClose(&reader);
+    remove(name);
+    return TSDB_CODE_SUCCESS;
+  }
+
+  sdbInfo("vgId:1, load snapshot, mver:%" PRIu64 " rows:%" PRId64 " wal fileId:%" PRId64 " offset:%" PRId64,
+          reader.head.version, reader.head.rows, reader.head.walFileId, reader.head.walOffset);
+
+  code = sdbSnapReaderRewind(&reader);
+  while (code == TSDB_CODE_SUCCESS) {
+    code = sdbSnapRead(&reader);
+    if (code <= 0) break;
+
+    SSdbTable *pTable = sdbGetTableFromId(reader.row.tableId);
+    SSdbRow    row = {.rowSize = reader.row.len, .rowData = reader.buffer, .pTable = pTable};
+
+    code = (*pTable->fpDecode)(&row);
+    if (code == TSDB_CODE_SUCCESS) code = sdbInsertHash(pTable, &row);
+
+    if (reader.rows % 100000 == 0) {
+      char stepDesc[TSDB_STEP_DESC_LEN] = {0};
+      snprintf(stepDesc, TSDB_STEP_DESC_LEN, "%" PRId64 " rows have been loaded from snapshot", reader.rows);
+      dnodeReportStep("mnode-sdb", stepDesc, 0);
+    }
+  }
+
+  sdbSnapReaderClose(&reader);
+
+  if (code != TSDB_CODE_SUCCESS) {
+    sdbError("vgId:1, failed to load snapshot since %s, remove %s to restore from wal", tstrerror(code), name);
+    return code;
+  }
+
+  pPos->version = reader.head.version;
+  pPos->walFileId = reader.head.walFileId;
+  pPos->walOffset = reader.head.walOffset;
+
+  tsSdbMgmt.version = reader.head.version;
+  walResetVersion(tsSdbMgmt.wal, reader.head.version);
+  tsSdbSnap.version = reader.head.version;
+  tsSdbSnap.hasSnapshot = 1;
+
+  sdbInfo("vgId:1, snapshot is loaded, mver:%" PRIu64 " rows:%" PRId64 " in %" PRId64 "ms", tsSdbMgmt.version,
+          reader.rows, taosGetTimestampMs() - start);
+  return TSDB_CODE_SUCCESS;
+}
+
+static void *sdbSnapshotFp(void *param) {
+  setThreadName("sdbSnapshot");
+
+  while (1) {
+    pthread_mutex_lock(&tsSdbSnap.mutex);
+    while (!tsSdbSnap.stop && tsSdbSnap.jobHead == NULL) {
+      pthread_cond_wait(&tsSdbSnap.cond, &tsSdbSnap.mutex);
+    }
+
+    SSdbSnapDelta *pDeltas = tsSdbSnap.jobHead;
+    int32_t        numOfDeltas = tsSdbSnap.numOfJobDeltas;
+    SSdbSnapPos    pos = tsSdbSnap.jobPos;
+    bool           hasSnapshot = tsSdbSnap.hasSnapshot;
+    pthread_mutex_unlock(&tsSdbSnap.mutex);
+
+    if (pDeltas == NULL) break;
+
+    int32_t code = sdbMergeSnapshot(pDeltas, numOfDeltas, &pos, hasSnapshot);
+
+    pthread_mutex_lock(&tsSdbSnap.mutex);
+    if (code == TSDB_CODE_SUCCESS) {
+      sdbFreeSnapDeltas(pDeltas);
+      tsSdbSnap.version = pos.version;
+      tsSdbSnap.hasSnapshot = 1;
+    } else if (code == TSDB_CODE_MND_SDB_ERROR) {
+      // the last snapshot is broken, the records before the ones kept can not be merged again
+      sdbError("vgId:1, failed to merge snapshot since %s, no more snapshot till restart", tstrerror(code));
+      sdbFreeSnapDeltas(pDeltas);
+      sdbFreeSnapDeltas(tsSdbSnap.deltaHead);
+      tsSdbSnap.deltaHead = NULL;
+      tsSdbSnap.deltaTail = NULL;
+      tsSdbSnap.numOfDeltas = 0;
+      tsSdbSnap.capture = 0;
+    } else {
+      // the records are kept for the next try
+      sdbError("vgId:1, failed to write snapshot since %s, retry later", tstrerror(code));
+      SSdbSnapDelta *pTail = pDeltas;
+      while (pTail->next != NULL) pTail = pTail->next;
+      pTail->next = tsSdbSnap.deltaHead;
+      tsSdbSnap.deltaHead = pDeltas;
+      if (tsSdbSnap.deltaTail == NULL) tsSdbSnap.deltaTail = pTail;
+      tsSdbSnap.numOfDeltas += numOfDeltas;
+      tsSdbSnap.retryTime = taosGetTimestampMs() + SDB_SNAP_RETRY_MS;
+    }
+    tsSdbSnap.jobHead = NULL;
+    tsSdbSnap.numOfJobDeltas = 0;
+    pthread_mutex_unlock(&tsSdbSnap.mutex);
+  }
+
+  return NULL;
+}
+
+// called by the sdb worker after the records are fsynced, so the wal has exactly the records till tsSdbMgmt.version
+static void sdbTriggerSnapshot() {
+  if (!tsSdbSnap.capture || tsSdbSnap.numOfDeltas < tsMnodeSnapshotRows) return;
+
+  pthread_mutex_lock(&tsSdbSnap.mutex);
+  if (tsSdbSnap.capture && tsSdbSnap.jobHead == NULL && tsSdbSnap.numOfDeltas >= tsMnodeSnapshotRows &&
+      taosGetTimestampMs() >= tsSdbSnap.retryTime) {
+    tsSdbSnap.jobHead = tsSdbSnap.deltaHead;
+    tsSdbSnap.numOfJobDeltas = tsSdbSnap.numOfDeltas;
+    tsSdbSnap.jobPos.version = tsSdbMgmt.version;
+    tsSdbSnap.jobPos.walFileId = 0;  // the sdb wal is kept in one file
+    tsSdbSnap.jobPos.walOffset = walGetFSize(tsSdbMgmt.wal);
+    tsSdbSnap.deltaHead = NULL;
+    tsSdbSnap.deltaTail = NULL;
+    tsSdbSnap.numOfDeltas = 0;
+    sdbDebug("vgId:1, start to write snapshot, mver:%" PRIu64 " records:%d", tsSdbMgmt.version,
+             tsSdbSnap.numOfJobDeltas);
+    pthread_cond_signal(&tsSdbSnap.cond);
+  }
+  pthread_mutex_unlock(&tsSdbSnap.mutex);
+}
+
+static int32_t sdbInitSnapshot() {
+  pthread_mutex_init(&tsSdbSnap.mutex, NULL);
+  pthread_cond_init(&tsSdbSnap.cond, NULL);
+  tsSdbSnap.capture = (tsMnodeSnapshotRows > 0 && tsCompactMnodeWal != 1);
+  return 0;
+}
+
+static int32_t sdbStartSnapshot() {
+  if (!tsSdbSnap.capture && !tsSdbSnap.dump) return 0;
+
+  if (tsSdbSnap.dump) {
+    tsSdbSnap.dump = 0;
+    if (sdbDumpSnapshot() != TSDB_CODE_SUCCESS) return 0;
+    tsSdbSnap.capture = 1;
+  }
+
+  pthread_attr_t thAttr;
+  pthread_attr_init(&thAttr);
+  pthread_attr_setdetachstate(&thAttr, PTHREAD_CREATE_JOINABLE);
+  int32_t ret = pthread_create(&tsSdbSnap.thread, &thAttr, sdbSnapshotFp, NULL);
+  if (ret != 0) {
+    sdbError("vgId:1, failed to create snapshot thread since %s", strerror(ret));
+    tsSdbSnap.capture = 0;
+  }
+  pthread_attr_destroy(&thAttr);
+
+  return 0;
+}
+
+static void sdbCleanupSnapshot() {
+  pthread_mutex_lock(&tsSdbSnap.mutex);
+  tsSdbSnap.stop = 1;
+  tsSdbSnap.capture = 0;
+  pthread_cond_signal(&tsSdbSnap.cond);
+  pthread_mutex_unlock(&tsSdbSnap.mutex);
+
+  if (taosCheckPthreadValid(tsSdbSnap.thread)) {
+    pthread_join(tsSdbSnap.thread, NULL);
+  }
+
+  sdbFreeSnapDeltas(tsSdbSnap.deltaHead);
+  sdbFreeSnapDeltas(tsSdbSnap.jobHead);
+  pthread_cond_destroy(&tsSdbSnap.cond);
+  pthread_mutex_destroy(&tsSdbSnap.mutex);
+  memset(&tsSdbSnap, 0, sizeof(SSdbSnapshot));
+}
+
 int32_t sdbGetReplicaNum() {
   return tsSdbMgmt.cfg.replica;
 }
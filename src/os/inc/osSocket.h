@@ -26,12 +26,18 @@ extern "C" {
   #define taosWriteSocket(fd, buf, len) send((SOCKET)fd, buf, len, 0)
   #define taosReadSocket(fd, buf, len) recv((SOCKET)fd, buf, len, 0)
   #define taosCloseSocketNoCheck(fd) closesocket((SOCKET)fd)
+  struct iovec {
+    void * iov_base;
+    size_t iov_len;
+  };
+  int64_t taosWriteSocketV(SOCKET fd, struct iovec *iov, int32_t iovcnt);
   #define taosCloseSocket(fd) closesocket((SOCKET)fd)
 #else
   #define taosSend(sockfd, buf, len, flags) send(sockfd, buf, len, flags)
   #define taosSendto(sockfd, buf, len, flags, dest_addr, addrlen) sendto(sockfd, buf, len, flags, dest_addr, addrlen)
   #define taosReadSocket(fd, buf, len) read(fd, buf, len)
   #define taosWriteSocket(fd, buf, len) write(fd, buf, len)
+  #define taosWriteSocketV(fd, iov, iovcnt) writev(fd, iov, iovcnt)
   #define taosCloseSocketNoCheck(x) close(x)
   #define taosCloseSocket(x) \
     {                        \
@@ -385,11 +385,24 @@ int32_t taosRename(char *oldName, char *newName) {
   return code;
 }
 
+int32_t taosFadviseWillNeed(FileFd fd, int64_t offset, int64_t len) { return 0; }
+
 #else
 
 int32_t taosFtruncate(FileFd fd, int64_t length) { return ftruncate(fd, length); }
 int32_t taosFsync(FileFd fd) { return fsync(fd); }
 
+#if defined(_TD_DARWIN_64)
+int32_t taosFadviseWillNeed(FileFd fd, int64_t offset, int64_t len) {
+  struct radvisory ra = {.ra_offset = (off_t)offset, .ra_count = (int)len};
+  return fcntl(fd, F_RDADVISE, &ra);
+}
+#else
+int32_t taosFadviseWillNeed(FileFd fd, int64_t offset, int64_t len) {
+  return posix_fadvise(fd, (off_t)offset, (off_t)len, POSIX_FADV_WILLNEED);
+}
+#endif
+
 int32_t taosRename(char *oldName, char *newName) {
   int32_t code = rename(oldName, newName);
   if (code < 0) {
@@ -46,6 +46,19 @@ int32_t taosSetNonblocking(SOCKET sock, int32_t on) {
   return 0;
 }
 
+// winsock has no writev, the buffers are sent one by one
+int64_t taosWriteSocketV(SOCKET fd, struct iovec *iov, int32_t iovcnt) {
+  int64_t total = 0;
+  for (int32_t i = 0; i < iovcnt; ++i) {
+    int32_t ret = send(fd, iov[i].iov_base, (int32_t)iov[i].iov_len, 0);
+    if (ret < 0) return (total > 0) ? total : -1;
+    total += ret;
+    if (ret < (int32_t)iov[i].iov_len) break;
+  }
+
+  return total;
+}
+
 void taosIgnSIGPIPE() {}
 void taosBlockSIGPIPE() {}
 void taosSetMaskSIGPIPE() {}
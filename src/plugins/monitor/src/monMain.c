@@ -25,6 +25,9 @@
 #include "tsclient.h"
 #include "dnode.h"
 #include "vnode.h"
+#include "tsdb.h"
+#include "twal.h"
+#include "trpc.h"
 #include "monitor.h"
 #include "taoserror.h"
 
@@ -153,6 +156,9 @@ typedef struct {
 typedef struct {
   SDnodeStatisInfo dInfo;
   SVnodeStatisInfo vInfo;
+  STsdbBlkCacheStat cInfo;
+  SWalGroupStat     wInfo;
+  SRpcBufStat       rInfo;
   float io_read;
   float io_write;
   float io_read_disk;
@@ -511,6 +517,9 @@ static void monGetSysStats() {
 
   tsMonStat.dInfo = dnodeGetStatisInfo();
   tsMonStat.vInfo = vnodeGetStatisInfo();
+  tsdbGetBlkCacheStat(&tsMonStat.cInfo);
+  walGetGroupStat(&tsMonStat.wInfo);
+  rpcGetBufStat(&tsMonStat.rInfo);
 
   tsMonStat.monQueryReqCnt = monFetchQueryReqCnt();
   tsMonStat.monSubmitReqCnt = monFetchSubmitReqCnt();
@@ -1050,6 +1059,15 @@ static void monSaveClusterInfo() {
   }
 }
 
+// print the non-empty buckets of a log2 histogram as "lower bound:count"
+static void monBuildHistogram(int64_t *buckets, char *buf, int32_t size) {
+  int32_t pos = 0;
+  for (int32_t i = 0; i < WAL_STAT_BUCKETS && pos < size; ++i) {
+    if (buckets[i] == 0) continue;
+    pos += snprintf(buf + pos, size - pos, "%s%" PRId64 ":%" PRId64, pos > 0 ? " " : "", (int64_t)1 << i, buckets[i]);
+  }
+}
+
 static void monSaveDnodesInfo() {
   int64_t ts = taosGetTimestampUs();
   char *  sql = tsMonitor.sql;
@@ -1070,6 +1088,33 @@ static void monSaveDnodesInfo() {
 
   monDebug("save dnodes, sql:%s", sql);
 
+  STsdbBlkCacheStat *pCInfo = &tsMonStat.cInfo;
+  if (pCInfo->capacity > 0) {
+    monInfo("block cache, capacity:%" PRId64 " used:%" PRId64 " entries:%" PRId64 " hits:%" PRId64 " misses:%" PRId64
+            " evicts:%" PRId64,
+            pCInfo->capacity, pCInfo->used, pCInfo->numOfEntries, pCInfo->hits, pCInfo->misses, pCInfo->evicts);
+  }
+  if (pCInfo->numOfHeadIdx > 0) {
+    monInfo("head file index, count:%" PRId64 " used:%" PRId64, pCInfo->numOfHeadIdx, pCInfo->headIdxUsed);
+  }
+
+  SWalGroupStat *pWInfo = &tsMonStat.wInfo;
+  if (pWInfo->cycles > 0) {
+    char latency[WAL_STAT_BUCKETS * 24] = {0};
+    char groups[WAL_STAT_BUCKETS * 24] = {0};
+    monBuildHistogram(pWInfo->latency, latency, sizeof(latency));
+    monBuildHistogram(pWInfo->groups, groups, sizeof(groups));
+    monInfo("wal group commit, cycles:%" PRId64 " records:%" PRId64 " bytes:%" PRId64 " fsyncs:%" PRId64
+            " latency(us):[%s] records per group:[%s]",
+            pWInfo->cycles, pWInfo->records, pWInfo->bytes, pWInfo->fsyncs, latency, groups);
+  }
+
+  SRpcBufStat *pRInfo = &tsMonStat.rInfo;
+  if (pRInfo->allocs > 0) {
+    monInfo("rpc buffer, allocs:%" PRId64 " hits:%" PRId64 " frees:%" PRId64 " copied:%" PRId64 " direct:%" PRId64,
+            pRInfo->allocs, pRInfo->hits, pRInfo->frees, pRInfo->copied, pRInfo->direct);
+  }
+
   void *res = taos_query(tsMonitor.conn, tsMonitor.sql);
   int32_t code = taos_errno(res);
   taos_free_result(res);
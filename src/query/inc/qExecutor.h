@@ -28,6 +28,7 @@
 #include "taosdef.h"
 #include "tarray.h"
 #include "tlockfree.h"
+#include "tlosertree.h"
 #include "tsdb.h"
 #include "qUdf.h"
 
@@ -186,6 +187,8 @@ typedef struct SQueryCostInfo {
   uint32_t loadBlocks;
   uint32_t loadBlockStatis;
   uint32_t discardBlocks;
+  int64_t  prunedBlocks;     // file blocks discarded by tsdb with the block statistics before being loaded
+  int64_t  prunedFileSets;
   uint64_t elapsedTime;
   uint64_t firstStageMergeTime;
   uint64_t winInfoSize;
@@ -434,6 +437,29 @@ typedef struct SColumnDataParam{
   SArray* pDataBlock;
 } SColumnDataParam;
 
+// one time range of the parallel table scan, read with its own query handle by the tasks of the shared scan pool
+typedef struct SParScanPart {
+  void           *pQueryHandle;
+  STimeWindow     win;
+  int8_t          state;        // PAR_SCAN_PART_*
+  int32_t         numOfBlocks;
+  struct SParScanInfo *pScan;
+} SParScanPart;
+
+typedef struct SParScanInfo {
+  pthread_mutex_t mutex;
+  pthread_cond_t  cond;
+  uint32_t        loadStatus;   // the block content loaded in advance by the scan tasks, BLK_DATA_*
+  bool            stop;
+  int32_t         code;         // the first error of the scan tasks, raised by the query thread
+  int32_t         numOfParts;
+  int32_t         numOfDone;
+  int32_t         numOfRunning; // scheduled tasks not completed yet
+  int32_t         current;      // the part whose block is consumed by the query thread, -1 if none
+  SParScanPart   *pParts;
+  SQueryCostInfo *pSummary;     // the pruning counters of all parts are added into it when the scan is destroyed
+} SParScanInfo;
+
 typedef struct STableScanInfo {
   void           *pQueryHandle;
   int32_t         numOfBlocks;
@@ -456,6 +482,10 @@ typedef struct STableScanInfo {
 
   int32_t         tableIndex;
   int32_t         prevGroupId;     // previous table group id
+
+  uint8_t         downstreamType;  // operator type of the consumer
+  bool            parScanChecked;
+  SParScanInfo   *pParScan;        // not NULL if the file sets are scanned in parallel
 } STableScanInfo;
 
 typedef struct STagScanInfo {
@@ -605,11 +635,28 @@ typedef struct SMultiwayMergeInfo {
   bool                 multiGroupResults;
 } SMultiwayMergeInfo;
 
-// todo support the disk-based sort
+typedef struct SSortRunCursor {
+  int32_t      runId;      // group id of the pages of this sorted run in the disk-based buffer
+  int32_t      pageIndex;  // index of the current page in the page list of the run
+  int32_t      rowIndex;   // index of the current row in the current page, -1 if the run is exhausted
+  tFilePage   *pPage;
+} SSortRunCursor;
+
 typedef struct SOrderOperatorInfo {
   int32_t      colIndex;
   int32_t      order;
   SSDataBlock *pDataBlock;
+  int32_t      capacity;       // number of rows that the columns of pDataBlock can hold
+  int32_t      rowSize;
+  int64_t      topN;           // only the first topN rows are required by the limit/offset clause, 0 for all rows
+  int32_t     *pHeap;          // top-N row heap of pDataBlock, the last one in the required order is on the top
+  int32_t      maxRowsInMem;   // buffered rows are sorted and spilled to disk as a run beyond this number
+  int32_t      rowsPerPage;
+  int32_t      keyOffset;      // offset of the order column in a page is keyOffset * rowsPerPage
+  SDiskbasedResultBuf *pSortBuf;
+  SArray      *pRuns;          // SSortRunCursor of each sorted run spilled to disk
+  SLoserTreeInfo *pMergeTree;
+  bool         loaded;         // all rows of the upstream have been consumed
 } SOrderOperatorInfo;
 
 void appendUpstream(SOperatorInfo* p, SOperatorInfo* pUpstream);
@@ -640,7 +687,7 @@ SOperatorInfo* createFilterOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperator
                                         int32_t numOfOutput, SColumnInfo* pCols, int32_t numOfFilter);
 
 SOperatorInfo* createJoinOperatorInfo(SOperatorInfo** pUpstream, int32_t numOfUpstream, SSchema* pSchema, int32_t numOfOutput);
-SOperatorInfo* createOrderOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SExprInfo* pExpr, int32_t numOfOutput, SOrderVal* pOrderVal);
+SOperatorInfo* createOrderOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SExprInfo* pExpr, int32_t numOfOutput, SOrderVal* pOrderVal, SLimitVal* pLimit);
 
 SSDataBlock* doGlobalAggregate(void* param, bool* newgroup);
 SSDataBlock* doMultiwayMergeSort(void* param, bool* newgroup);
@@ -104,6 +104,7 @@ typedef struct SFilterRange {
 typedef bool (*rangeCompFunc) (const void *, const void *, const void *, const void *, __compar_fn_t);
 typedef int32_t(*filter_desc_compare_func)(const void *, const void *);
 typedef bool(*filter_exec_func)(void *, int32_t, int8_t**, SDataStatis *, int16_t);
+typedef void(*filter_kernel_func)(const void *, int32_t, const void *, const void *, int8_t *);
 typedef int32_t (*filer_get_col_from_id)(void *, int32_t, void **);
 
 typedef struct SFilterRangeCompare {
@@ -211,8 +212,20 @@ typedef struct SFilterComUnit {
   uint8_t optr;
   int8_t func;
   int8_t rfunc;
+  filter_kernel_func kfunc;  // evaluate the whole column at once, NULL if not available for the type/operator
 } SFilterComUnit;
 
+// a condition on an indexed column that all the rows qualified by one filter group satisfy
+typedef struct SFilterIndexUnit {
+  int16_t colId;
+  uint8_t optr;
+  uint8_t optr2;   // upper bound operator of a range, 0 if no upper bound
+  void   *val;
+  void   *val2;
+} SFilterIndexUnit;
+
+typedef bool (*filter_index_check_func)(void *, int16_t, uint8_t, void *);
+
 typedef struct SFilterPCtx {
   SHashObj *valHash;
   SHashObj *unitHash;
@@ -237,6 +250,10 @@ typedef struct SFilterInfo {
   uint32_t          blkGroupNum;
   uint32_t         *blkUnits;
   int8_t           *blkUnitRes;
+  int8_t           *rowRes;     // row results returned by filterGetResultBuf, reused across blocks
+  int8_t           *tmpRes;     // results of one group and one unit
+  int32_t           rowResSize;
+  int32_t           tmpResSize;
   
   SFilterPCtx       pctx;
 } SFilterInfo;
@@ -323,6 +340,7 @@ typedef struct SFilterInfo {
 
 extern int32_t filterInitFromTree(tExprNode* tree, void **pinfo, uint32_t options);
 extern bool filterExecute(SFilterInfo *info, int32_t numOfRows, int8_t** p, SDataStatis *statis, int16_t numOfCols);
+extern int8_t* filterGetResultBuf(SFilterInfo *info, int32_t numOfRows);
 extern int32_t filterSetColFieldData(SFilterInfo *info, void *param, filer_get_col_from_id fp);
 extern int32_t filterGetTimeRange(SFilterInfo *info, STimeWindow *win);
 extern int32_t filterConverNcharColumns(SFilterInfo* pFilterInfo, int32_t rows, bool *gotNchar);
@@ -331,6 +349,7 @@ extern void filterFreeInfo(SFilterInfo *info);
 extern bool filterRangeExecute(SFilterInfo *info, SDataStatis *pDataStatis, int32_t numOfCols, int32_t numOfRows);
 extern int32_t filterIsIndexedColumnQuery(SFilterInfo* info, int32_t idxId, bool *res);
 extern int32_t filterGetIndexedColumnInfo(SFilterInfo* info, char** val, int32_t *order, int32_t *flag);
+extern bool filterGetIndexUnits(SFilterInfo *info, filter_index_check_func fp, void *param, SArray *res);
 
 #ifdef __cplusplus
 }
@@ -28,6 +28,7 @@
 #include "ttype.h"
 #include "tcompare.h"
 #include "tscompression.h"
+#include "tsched.h"
 #include "qScript.h"
 #include "tscLog.h"
 
@@ -44,6 +45,8 @@
 
 #define MULTI_KEY_DELIM  "-"
 
+#define DEFAULT_ORDER_PAGE_SIZE  (64 * 1024)   // page size of the sorted runs spilled by the order operator
+
 #define TIME_WINDOW_COPY(_dst, _src)  do {\
    (_dst).skey = (_src).skey;\
    (_dst).ekey = (_src).ekey;\
@@ -55,6 +58,13 @@ enum {
   TS_JOIN_TAG_NOT_EQUALS = 2,
 };
 
+enum {
+  PAR_SCAN_PART_LOADING  = 0,
+  PAR_SCAN_PART_READY    = 1,
+  PAR_SCAN_PART_CONSUMED = 2,
+  PAR_SCAN_PART_DONE     = 3,
+};
+
 typedef enum SResultTsInterpType {
   RESULT_ROW_START_INTERP = 1,
   RESULT_ROW_END_INTERP   = 2,
@@ -228,6 +238,7 @@ static void destroyOrderOperatorInfo(void* param, int32_t numOfOutput);
 static void destroySWindowOperatorInfo(void* param, int32_t numOfOutput);
 static void destroyStateWindowOperatorInfo(void* param, int32_t numOfOutput);
 static void destroyAggOperatorInfo(void* param, int32_t numOfOutput);
+static void destroyTableScanOperatorInfo(void* param, int32_t numOfOutput);
 static void destroyOperatorInfo(SOperatorInfo* pOperator);
 
 static void doSetOperatorCompleted(SOperatorInfo* pOperator) {
@@ -2186,7 +2197,7 @@ static int32_t setupQueryRuntimeEnv(SQueryRuntimeEnv *pRuntimeEnv, int32_t numOf
       }
 
       case OP_Order: {
-        pRuntimeEnv->proot = createOrderOperatorInfo(pRuntimeEnv, pRuntimeEnv->proot, pQueryAttr->pExpr1, pQueryAttr->numOfOutput, &pQueryAttr->order);
+        pRuntimeEnv->proot = createOrderOperatorInfo(pRuntimeEnv, pRuntimeEnv->proot, pQueryAttr->pExpr1, pQueryAttr->numOfOutput, &pQueryAttr->order, &pQueryAttr->limit);
         break;
       }
 
@@ -2251,7 +2262,6 @@ static void teardownQueryRuntimeEnv(SQueryRuntimeEnv *pRuntimeEnv) {
   }
   
   destroyResultBuf(pRuntimeEnv->pResultBuf);
-  doFreeQueryHandle(pRuntimeEnv);
 
   destroyTsComp(pRuntimeEnv, pQueryAttr);
 
@@ -2270,7 +2280,9 @@ static void teardownQueryRuntimeEnv(SQueryRuntimeEnv *pRuntimeEnv) {
   taosHashCleanup(pRuntimeEnv->pResultRowListSet);
   pRuntimeEnv->pResultRowListSet = NULL;
 
+  // the table scan operator may hold its own query handles on the memory snapshot
   destroyOperatorInfo(pRuntimeEnv->proot);
+  doFreeQueryHandle(pRuntimeEnv);
 
   pRuntimeEnv->pool = destroyResultRowPool(pRuntimeEnv->pool);
   taosArrayDestroy(pRuntimeEnv->pResultRowArrayList);
@@ -2881,6 +2893,7 @@ void filterColRowsInDataBlock(SQueryRuntimeEnv* pRuntimeEnv, SSDataBlock* pBlock
  int32_t numOfRows = pBlock->info.rows;
 
  int8_t *p = NULL;
+ int8_t *pRes = NULL;
  bool    all = true;
 
  if (pRuntimeEnv->pTsBuf != NULL) {
@@ -2913,6 +2926,9 @@ void filterColRowsInDataBlock(SQueryRuntimeEnv* pRuntimeEnv, SSDataBlock* pBlock
    // save the cursor status
    pRuntimeEnv->current->cur = tsBufGetCursor(pRuntimeEnv->pTsBuf);
  } else {
+   // the result buffer is owned by the filter and reused by the following blocks
+   pRes = filterGetResultBuf(pRuntimeEnv->pQueryAttr->pFilters, numOfRows);
+   p = pRes;
    all = filterExecute(pRuntimeEnv->pQueryAttr->pFilters, numOfRows, &p, pBlock->pBlockStatis, pRuntimeEnv->pQueryAttr->numOfCols);
  }
 
@@ -2925,7 +2941,9 @@ void filterColRowsInDataBlock(SQueryRuntimeEnv* pRuntimeEnv, SSDataBlock* pBlock
    }
  }
 
- tfree(p);
+ if (p != pRes) {
+   tfree(p);
+ }
 }
 
                            
@@ -4386,10 +4404,20 @@ void queryCostStatis(SQInfo *pQInfo) {
 
   calculateOperatorProfResults(pQInfo);
 
+  // the counters of the parallel scan parts are already added
+  if (pRuntimeEnv->pQueryHandle != NULL) {
+    int64_t prunedBlocks = 0, prunedFileSets = 0;
+    tsdbGetPrunedBlocks(pRuntimeEnv->pQueryHandle, &prunedBlocks, &prunedFileSets);
+    pSummary->prunedBlocks += prunedBlocks;
+    pSummary->prunedFileSets += prunedFileSets;
+  }
+
   qDebug("QInfo:0x%"PRIx64" :cost summary: elapsed time:%"PRId64" us, first merge:%"PRId64" us, total blocks:%d, "
-         "load block statis:%d, load data block:%d, total rows:%"PRId64 ", check rows:%"PRId64,
+         "load block statis:%d, load data block:%d, discard blocks:%d, pruned blocks:%"PRId64", pruned file sets:%"PRId64
+         ", total rows:%"PRId64 ", check rows:%"PRId64,
          pQInfo->qId, pSummary->elapsedTime, pSummary->firstStageMergeTime, pSummary->totalBlocks, pSummary->loadBlockStatis,
-         pSummary->loadBlocks, pSummary->totalRows, pSummary->totalCheckedRows);
+         pSummary->loadBlocks, pSummary->discardBlocks, pSummary->prunedBlocks, pSummary->prunedFileSets,
+         pSummary->totalRows, pSummary->totalCheckedRows);
 
   qDebug("QInfo:0x%"PRIx64" :cost summary: winResPool size:%.2f Kb, numOfWin:%"PRId64", tableInfoSize:%.2f Kb, hashTable:%.2f Kb", pQInfo->qId, pSummary->winInfoSize/1024.0,
       pSummary->numOfTimeWindows, pSummary->tableInfoSize/1024.0, pSummary->hashSize/1024.0);
@@ -4840,6 +4868,10 @@ static void doTableQueryInfoTimeWindowCheck(SQueryAttr* pQueryAttr, STableQueryI
   }
 }
 
+static bool doFilterFileBlock(void* param, SDataStatis* pStatis, int32_t numOfCols, int32_t numOfRows) {
+  return filterRangeExecute((SFilterInfo*)param, pStatis, numOfCols, numOfRows);
+}
+
 STsdbQueryCond createTsdbQueryCond(SQueryAttr* pQueryAttr, STimeWindow* win) {
   STsdbQueryCond cond = {
       .colList   = pQueryAttr->tableCols,
@@ -4849,6 +4881,12 @@ STsdbQueryCond createTsdbQueryCond(SQueryAttr* pQueryAttr, STimeWindow* win) {
       .loadExternalRows = false,
   };
 
+  // the file blocks that can not satisfy the filter are discarded by tsdb before being loaded
+  if (pQueryAttr->pFilters != NULL) {
+    cond.blockFilterFp    = doFilterFileBlock;
+    cond.blockFilterParam = pQueryAttr->pFilters;
+  }
+
   TIME_WINDOW_COPY(cond.twindow, *win);
   return cond;
 }
@@ -4906,6 +4944,316 @@ static void notifyTableScan(void* param, int32_t option) {
   return;
 }
 
+static bool isParallelScanAllowed(SQueryRuntimeEnv* pRuntimeEnv, STableScanInfo* pTableScanInfo) {
+  SQueryAttr* pQueryAttr = pRuntimeEnv->pQueryAttr;
+
+  if (tsQueryParallelism <= 1 || pQueryAttr->tsdb == NULL || pTableScanInfo->pQueryHandle == NULL) {
+    return false;
+  }
+
+  if (pTableScanInfo->downstreamType != OP_Aggregate && pTableScanInfo->downstreamType != OP_MultiTableAggregate) {
+    return false;
+  }
+
+  // only one forward scan, in which the data blocks are handled independently
+  if (!QUERY_IS_ASC_QUERY(pQueryAttr) || pTableScanInfo->times != 1 || pTableScanInfo->reverseTimes > 0 ||
+      pRuntimeEnv->pTsBuf != NULL || pRuntimeEnv->enableGroupData || pRuntimeEnv->pUdfInfo != NULL ||
+      QUERY_IS_INTERVAL_QUERY(pQueryAttr) || pQueryAttr->groupbyColumn || pQueryAttr->sw.gap > 0 ||
+      pQueryAttr->stateWindow || pQueryAttr->topBotQuery || pQueryAttr->tsCompQuery || pQueryAttr->diffQuery ||
+      pQueryAttr->pointInterpQuery || pQueryAttr->needTableSeqScan || isTsdbCacheLastRow(pTableScanInfo->pQueryHandle)) {
+    return false;
+  }
+
+  // the result of these functions does not depend on the order of data blocks
+  for (int32_t i = 0; i < pTableScanInfo->numOfOutput; ++i) {
+    int32_t functionId = pTableScanInfo->pCtx[i].functionId;
+    if (functionId != TSDB_FUNC_COUNT && functionId != TSDB_FUNC_SUM && functionId != TSDB_FUNC_AVG &&
+        functionId != TSDB_FUNC_MIN && functionId != TSDB_FUNC_MAX && functionId != TSDB_FUNC_SPREAD &&
+        functionId != TSDB_FUNC_TAG) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static void*          parScanQhandle = NULL;
+static pthread_once_t parScanPoolInit = PTHREAD_ONCE_INIT;
+
+// the scan tasks of all queries share one pool bounded by the number of cores
+static void doInitParScanPool(void) {
+  int32_t numOfThreads = MAX(tsNumOfCores, 1);
+  parScanQhandle = taosInitScheduler(10000, numOfThreads, "parScan");
+  if (parScanQhandle == NULL) {
+    qError("failed to init the parallel scan pool, the table scan is not parallelized");
+  }
+}
+
+static int32_t doLoadParScanBlock(SParScanPart* pPart, bool* hasNext) {
+  terrno = TSDB_CODE_SUCCESS;
+
+  *hasNext = tsdbNextDataBlock(pPart->pQueryHandle);
+  if (!(*hasNext)) {
+    return terrno;
+  }
+
+  // load the content of the block while the query thread is aggregating the blocks of other parts, the query thread
+  // gets the loaded content again from the query handle without decompressing it a second time.
+  uint32_t loadStatus = pPart->pScan->loadStatus;
+  if (loadStatus == BLK_DATA_NO_NEEDED) {
+    return TSDB_CODE_SUCCESS;
+  }
+
+  SDataStatis* pStatis = NULL;
+  int32_t code = tsdbRetrieveDataBlockStatisInfo(pPart->pQueryHandle, &pStatis);
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  if (loadStatus == BLK_DATA_ALL_NEEDED || pStatis == NULL) {
+    if (tsdbRetrieveDataBlock(pPart->pQueryHandle, NULL) == NULL) {
+      return (terrno != TSDB_CODE_SUCCESS) ? terrno : TSDB_CODE_QRY_OUT_OF_MEMORY;
+    }
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+// load the next block of one part, the task does not wait for the block to be consumed
+static void parScanLoadBlockTask(SSchedMsg* pMsg) {
+  SParScanPart* pPart = pMsg->ahandle;
+  SParScanInfo* pScan = pPart->pScan;
+
+  pthread_mutex_lock(&pScan->mutex);
+  bool stop = pScan->stop || pScan->code != TSDB_CODE_SUCCESS;
+  pthread_mutex_unlock(&pScan->mutex);
+
+  bool    hasNext = false;
+  int32_t code = TSDB_CODE_SUCCESS;
+  if (!stop) {
+    code = doLoadParScanBlock(pPart, &hasNext);
+  }
+
+  pthread_mutex_lock(&pScan->mutex);
+  if (hasNext && code == TSDB_CODE_SUCCESS) {
+    pPart->numOfBlocks += 1;
+    pPart->state = PAR_SCAN_PART_READY;
+  } else {
+    pPart->state = PAR_SCAN_PART_DONE;
+    pScan->numOfDone += 1;
+    if (code != TSDB_CODE_SUCCESS && pScan->code == TSDB_CODE_SUCCESS) {
+      pScan->code = code;
+    }
+  }
+
+  pScan->numOfRunning -= 1;
+  pthread_cond_broadcast(&pScan->cond);
+  pthread_mutex_unlock(&pScan->mutex);
+}
+
+// must not be called with the mutex held, since the pool tasks lock it and the scheduler blocks if the queue is full
+static void scheduleParScanPart(SParScanPart* pPart) {
+  SSchedMsg schedMsg = {0};
+  schedMsg.fp      = parScanLoadBlockTask;
+  schedMsg.ahandle = pPart;
+  taosScheduleTask(parScanQhandle, &schedMsg);
+}
+
+static void destroyParallelScan(SParScanInfo* pScan) {
+  if (pScan == NULL) {
+    return;
+  }
+
+  pthread_mutex_lock(&pScan->mutex);
+  pScan->stop = true;
+  while (pScan->numOfRunning > 0) {
+    pthread_cond_wait(&pScan->cond, &pScan->mutex);
+  }
+  pthread_mutex_unlock(&pScan->mutex);
+
+  for (int32_t i = 0; i < pScan->numOfParts; ++i) {
+    SParScanPart* pPart = &pScan->pParts[i];
+
+    int64_t prunedBlocks = 0, prunedFileSets = 0;
+    tsdbGetPrunedBlocks(pPart->pQueryHandle, &prunedBlocks, &prunedFileSets);
+    pScan->pSummary->prunedBlocks += prunedBlocks;
+    pScan->pSummary->prunedFileSets += prunedFileSets;
+
+    tsdbCleanupQueryHandle(pPart->pQueryHandle);
+  }
+
+  pthread_cond_destroy(&pScan->cond);
+  pthread_mutex_destroy(&pScan->mutex);
+
+  tfree(pScan->pParts);
+  tfree(pScan);
+}
+
+/*
+ * The file sets overlapping with the query time window are split into consecutive time ranges, each of which is
+ * scanned with its own query handle by the tasks of the shared scan pool. All query handles share the memory snapshot
+ * of the query, and the blocks of all parts are still aggregated by the query thread, so no aggregate state is ever
+ * accessed concurrently.
+ */
+static SParScanInfo* createParallelScan(SQueryRuntimeEnv* pRuntimeEnv, STableScanInfo* pTableScanInfo) {
+  SQueryAttr* pQueryAttr = pRuntimeEnv->pQueryAttr;
+
+  pthread_once(&parScanPoolInit, doInitParScanPool);
+  if (parScanQhandle == NULL) {
+    return NULL;
+  }
+
+  STimeWindow* pWins = calloc(tsQueryParallelism, sizeof(STimeWindow));
+  if (pWins == NULL) {
+    return NULL;
+  }
+
+  int32_t numOfParts = tsdbSplitQueryWindow(pQueryAttr->tsdb, &pQueryAttr->window, pWins, tsQueryParallelism);
+  if (numOfParts <= 1) {
+    tfree(pWins);
+    return NULL;
+  }
+
+  SParScanInfo* pScan = calloc(1, sizeof(SParScanInfo));
+  if (pScan == NULL || (pScan->pParts = calloc(numOfParts, sizeof(SParScanPart))) == NULL) {
+    tfree(pScan);
+    tfree(pWins);
+    return NULL;
+  }
+
+  pthread_mutex_init(&pScan->mutex, NULL);
+  pthread_cond_init(&pScan->cond, NULL);
+  pScan->current  = -1;
+  pScan->pSummary = &((SQInfo*)pRuntimeEnv->qinfo)->summary;
+
+  // the block content required by all data blocks, since no time window or group by column is involved
+  uint32_t status = BLK_DATA_NO_NEEDED;
+  if (pQueryAttr->pFilters != NULL) {
+    status = BLK_DATA_ALL_NEEDED;
+  } else {
+    for (int32_t i = 0; i < pTableScanInfo->numOfOutput; ++i) {
+      int32_t colId = pTableScanInfo->pExpr[i].base.colInfo.colId;
+      status |= aAggs[pTableScanInfo->pCtx[i].functionId].dataReqFunc(&pTableScanInfo->pCtx[i], &pQueryAttr->window, colId);
+    }
+  }
+
+  pScan->loadStatus = ((status & BLK_DATA_ALL_NEEDED) == BLK_DATA_ALL_NEEDED) ? BLK_DATA_ALL_NEEDED : status;
+
+  for (int32_t i = 0; i < numOfParts; ++i) {
+    SParScanPart* pPart = &pScan->pParts[i];
+    pPart->pScan = pScan;
+    pPart->win = pWins[i];
+
+    STsdbQueryCond cond = createTsdbQueryCond(pQueryAttr, &pPart->win);
+    pPart->pQueryHandle = tsdbQueryTables(pQueryAttr->tsdb, &cond, &pQueryAttr->tableGroupInfo, GET_QID(pRuntimeEnv),
+                                          &pQueryAttr->memRef);
+    if (pPart->pQueryHandle == NULL) {
+      pScan->numOfParts = i;
+      destroyParallelScan(pScan);
+      tfree(pWins);
+      return NULL;
+    }
+  }
+
+  pScan->numOfParts   = numOfParts;
+  pScan->numOfRunning = numOfParts;
+  for (int32_t i = 0; i < numOfParts; ++i) {
+    scheduleParScanPart(&pScan->pParts[i]);
+  }
+
+  qDebug("QInfo:0x%" PRIx64 " scan %d parts in parallel, qrange:%" PRId64 "-%" PRId64, GET_QID(pRuntimeEnv), numOfParts,
+         pQueryAttr->window.skey, pQueryAttr->window.ekey);
+
+  tfree(pWins);
+  return pScan;
+}
+
+// hand back the block consumed by the query thread, and wait for a block loaded by any part
+static bool parallelScanNextBlock(SQueryRuntimeEnv* pRuntimeEnv, SParScanInfo* pScan, void** pQueryHandle) {
+  SParScanPart* pConsumed = NULL;
+
+  pthread_mutex_lock(&pScan->mutex);
+  if (pScan->current >= 0) {
+    pConsumed = &pScan->pParts[pScan->current];
+    pConsumed->state = PAR_SCAN_PART_LOADING;
+    pScan->numOfRunning += 1;
+  }
+  pthread_mutex_unlock(&pScan->mutex);
+
+  if (pConsumed != NULL) {
+    scheduleParScanPart(pConsumed);
+  }
+
+  bool    ret = false;
+  int32_t code = TSDB_CODE_SUCCESS;
+
+  pthread_mutex_lock(&pScan->mutex);
+  while (true) {
+    if (pScan->code != TSDB_CODE_SUCCESS) {
+      code = pScan->code;
+      break;
+    }
+
+    int32_t index = -1;
+    for (int32_t i = 1; i <= pScan->numOfParts; ++i) {
+      int32_t j = (pScan->current + i + pScan->numOfParts) % pScan->numOfParts;
+      if (pScan->pParts[j].state == PAR_SCAN_PART_READY) {
+        index = j;
+        break;
+      }
+    }
+
+    if (index >= 0) {
+      pScan->pParts[index].state = PAR_SCAN_PART_CONSUMED;
+      pScan->current = index;
+      *pQueryHandle = pScan->pParts[index].pQueryHandle;
+      ret = true;
+      break;
+    }
+
+    pScan->current = -1;
+    if (pScan->numOfDone >= pScan->numOfParts) {
+      break;
+    }
+
+    pthread_cond_wait(&pScan->cond, &pScan->mutex);
+  }
+
+  pthread_mutex_unlock(&pScan->mutex);
+
+  // the scan is released along with the table scan operator
+  if (code != TSDB_CODE_SUCCESS) {
+    qError("QInfo:0x%" PRIx64 " failed to scan in parallel, code:%s", GET_QID(pRuntimeEnv), tstrerror(code));
+    longjmp(pRuntimeEnv->env, code);
+  }
+
+  return ret;
+}
+
+static bool tableScanNextBlock(SQueryRuntimeEnv* pRuntimeEnv, STableScanInfo* pTableScanInfo) {
+  if (!pTableScanInfo->parScanChecked) {
+    pTableScanInfo->parScanChecked = true;
+    if (isParallelScanAllowed(pRuntimeEnv, pTableScanInfo)) {
+      pTableScanInfo->pParScan = createParallelScan(pRuntimeEnv, pTableScanInfo);
+    }
+  }
+
+  SParScanInfo* pScan = pTableScanInfo->pParScan;
+  if (pScan == NULL) {
+    return tsdbNextDataBlock(pTableScanInfo->pQueryHandle);
+  }
+
+  if (parallelScanNextBlock(pRuntimeEnv, pScan, &pTableScanInfo->pQueryHandle)) {
+    return true;
+  }
+
+  // all parts are completed, release the query handles as early as possible
+  pTableScanInfo->pQueryHandle = pRuntimeEnv->pQueryHandle;
+  pTableScanInfo->pParScan = NULL;
+  destroyParallelScan(pScan);
+  return false;
+}
+
 static SSDataBlock* doTableScanImpl(void* param, bool* newgroup) {
   SOperatorInfo    *pOperator = (SOperatorInfo*) param;
 
@@ -4917,7 +5265,7 @@ static SSDataBlock* doTableScanImpl(void* param, bool* newgroup) {
 
   *newgroup = false;
 
-  while (tsdbNextDataBlock(pTableScanInfo->pQueryHandle)) {
+  while (tableScanNextBlock(pRuntimeEnv, pTableScanInfo)) {
     if (isQueryKilled(pOperator->pRuntimeEnv->qinfo)) {
       longjmp(pOperator->pRuntimeEnv->env, TSDB_CODE_TSC_QUERY_CANCELLED);
     }
@@ -5100,6 +5448,7 @@ SOperatorInfo* createTableScanOperator(void* pTsdbQueryHandle, SQueryRuntimeEnv*
   pOperator->numOfOutput  = pRuntimeEnv->pQueryAttr->numOfCols;
   pOperator->pRuntimeEnv  = pRuntimeEnv;
   pOperator->exec         = doTableScan;
+  pOperator->cleanup      = destroyTableScanOperatorInfo;
 
   return pOperator;
 }
@@ -5158,6 +5507,7 @@ void setTableScanFilterOperatorInfo(STableScanInfo* pTableScanInfo, SOperatorInf
 
   pTableScanInfo->pExpr = pDownstream->pExpr;   // TODO refactor to use colId instead of pExpr
   pTableScanInfo->numOfOutput = pDownstream->numOfOutput;
+  pTableScanInfo->downstreamType = pDownstream->operatorType;
 
   if (pDownstream->operatorType == OP_Aggregate || pDownstream->operatorType == OP_MultiTableAggregate) {
     SAggOperatorInfo* pAggInfo = pDownstream->info;
@@ -5236,6 +5586,7 @@ SOperatorInfo* createDataBlocksOptScanInfo(void* pTsdbQueryHandle, SQueryRuntime
   pOptr->info          = pInfo;
   pOptr->exec          = doTableScan;
   pOptr->notify        = notifyTableScan;
+  pOptr->cleanup       = destroyTableScanOperatorInfo;
 
   return pOptr;
 }
@@ -5438,55 +5789,134 @@ SOperatorInfo *createMultiwaySortOperatorInfo(SQueryRuntimeEnv *pRuntimeEnv, SEx
   return pOperator;
 }
 
-static int32_t doMergeSDatablock(SSDataBlock* pDest, SSDataBlock* pSrc) {
-  assert(pSrc != NULL && pDest != NULL && pDest->info.numOfCols == pSrc->info.numOfCols);
+static void ensureOrderBufCapacity(SOperatorInfo* pOperator, int32_t numOfRows) {
+  SOrderOperatorInfo* pInfo = pOperator->info;
+  if (numOfRows <= pInfo->capacity) {
+    return;
+  }
 
-  int32_t numOfCols = pSrc->info.numOfCols;
-  for(int32_t i = 0; i < numOfCols; ++i) {
+  int64_t maxRows = (pInfo->topN > 0)? pInfo->topN:pInfo->maxRowsInMem;
+  int64_t newCap  = MIN(((int64_t) pInfo->capacity) * 2, maxRows);
+  newCap = MAX(numOfRows, newCap);
+
+  SSDataBlock* pBlock = pInfo->pDataBlock;
+  for(int32_t i = 0; i < pBlock->info.numOfCols; ++i) {
+    SColumnInfoData* pCol = taosArrayGet(pBlock->pDataBlock, i);
+
+    char* tmp = realloc(pCol->pData, ((size_t) newCap) * pCol->info.bytes);
+    if (tmp == NULL) {
+      longjmp(pOperator->pRuntimeEnv->env, TSDB_CODE_QRY_OUT_OF_MEMORY);
+    }
+
+    pCol->pData = tmp;
+  }
+
+  if (pInfo->topN > 0) {
+    int32_t* tmp = realloc(pInfo->pHeap, ((size_t) newCap) * sizeof(int32_t));
+    if (tmp == NULL) {
+      longjmp(pOperator->pRuntimeEnv->env, TSDB_CODE_QRY_OUT_OF_MEMORY);
+    }
+
+    pInfo->pHeap = tmp;
+  }
+
+  pInfo->capacity = (int32_t) newCap;
+}
+
+static void doAppendDataBlock(SOperatorInfo* pOperator, SSDataBlock* pSrc) {
+  SOrderOperatorInfo* pInfo = pOperator->info;
+  SSDataBlock* pDest = pInfo->pDataBlock;
+  assert(pDest->info.numOfCols == pSrc->info.numOfCols);
+
+  ensureOrderBufCapacity(pOperator, pDest->info.rows + pSrc->info.rows);
+
+  for(int32_t i = 0; i < pSrc->info.numOfCols; ++i) {
     SColumnInfoData* pCol2 = taosArrayGet(pDest->pDataBlock, i);
     SColumnInfoData* pCol1 = taosArrayGet(pSrc->pDataBlock, i);
 
-    int32_t newSize = (pDest->info.rows + pSrc->info.rows) * pCol2->info.bytes;
-    char* tmp = realloc(pCol2->pData, newSize);
-    if (tmp != NULL) {
-      pCol2->pData = tmp;
-      int32_t offset = pCol2->info.bytes * pDest->info.rows;
-      memcpy(pCol2->pData + offset, pCol1->pData, pSrc->info.rows * pCol2->info.bytes);
-    } else {
-      return TSDB_CODE_VND_OUT_OF_MEMORY;
-    }
+    int32_t bytes = pCol2->info.bytes;
+    memcpy(pCol2->pData + ((size_t) bytes) * pDest->info.rows, pCol1->pData, ((size_t) bytes) * pSrc->info.rows);
   }
 
   pDest->info.rows += pSrc->info.rows;
+}
 
-  return TSDB_CODE_SUCCESS;
+static void doCopyOneRow(SSDataBlock* pDest, int32_t dstIndex, SSDataBlock* pSrc, int32_t srcIndex) {
+  for(int32_t i = 0; i < pDest->info.numOfCols; ++i) {
+    SColumnInfoData* pCol2 = taosArrayGet(pDest->pDataBlock, i);
+    SColumnInfoData* pCol1 = taosArrayGet(pSrc->pDataBlock, i);
+
+    int32_t bytes = pCol2->info.bytes;
+    memcpy(pCol2->pData + ((size_t) bytes) * dstIndex, pCol1->pData + ((size_t) bytes) * srcIndex, bytes);
+  }
 }
 
-static SSDataBlock* doSort(void* param, bool* newgroup) {
-  SOperatorInfo* pOperator = (SOperatorInfo*) param;
-  if (pOperator->status == OP_EXEC_DONE) {
-    return NULL;
+// the heap keeps the last row of the current top-N rows in the required order on the top, which is replaced by
+// any subsequent row that precedes it.
+static void doSiftUpTopNHeap(int32_t* pHeap, int32_t pos, char* pKeys, int32_t bytes, __compar_fn_t comp) {
+  while (pos > 0) {
+    int32_t parent = (pos - 1) >> 1;
+    if (comp(pKeys + ((size_t) bytes) * pHeap[pos], pKeys + ((size_t) bytes) * pHeap[parent]) <= 0) {
+      break;
+    }
+
+    SWAP(pHeap[pos], pHeap[parent], int32_t);
+    pos = parent;
   }
+}
 
-  SOrderOperatorInfo* pInfo = pOperator->info;
+static void doSiftDownTopNHeap(int32_t* pHeap, int32_t size, char* pKeys, int32_t bytes, __compar_fn_t comp) {
+  int32_t pos = 0;
+  while (1) {
+    int32_t child = (pos << 1) + 1;
+    if (child >= size) {
+      break;
+    }
 
-  SSDataBlock* pBlock = NULL;
-  while(1) {
-    publishOperatorProfEvent(pOperator->upstream[0], QUERY_PROF_BEFORE_OPERATOR_EXEC);
-    pBlock = pOperator->upstream[0]->exec(pOperator->upstream[0], newgroup);
-    publishOperatorProfEvent(pOperator->upstream[0], QUERY_PROF_AFTER_OPERATOR_EXEC);
+    if (child + 1 < size && comp(pKeys + ((size_t) bytes) * pHeap[child + 1], pKeys + ((size_t) bytes) * pHeap[child]) > 0) {
+      child += 1;
+    }
 
-    // start to flush data into disk and try do multiway merge sort
-    if (pBlock == NULL) {
-      doSetOperatorCompleted(pOperator);
+    if (comp(pKeys + ((size_t) bytes) * pHeap[child], pKeys + ((size_t) bytes) * pHeap[pos]) <= 0) {
       break;
     }
 
-    int32_t code = doMergeSDatablock(pInfo->pDataBlock, pBlock);
-    if (code != TSDB_CODE_SUCCESS) {
-      // todo handle error
+    SWAP(pHeap[pos], pHeap[child], int32_t);
+    pos = child;
+  }
+}
+
+static void doAddIntoTopN(SOperatorInfo* pOperator, SSDataBlock* pSrc) {
+  SOrderOperatorInfo* pInfo = pOperator->info;
+  SSDataBlock* pDest = pInfo->pDataBlock;
+
+  SColumnInfoData* pDestKey = taosArrayGet(pDest->pDataBlock, pInfo->colIndex);
+  SColumnInfoData* pSrcKey  = taosArrayGet(pSrc->pDataBlock, pInfo->colIndex);
+
+  int32_t       bytes = pDestKey->info.bytes;
+  __compar_fn_t comp  = getKeyComparFunc(pDestKey->info.type, pInfo->order);
+
+  for(int32_t i = 0; i < pSrc->info.rows; ++i) {
+    if (pDest->info.rows < pInfo->topN) {
+      int32_t slot = pDest->info.rows;
+      ensureOrderBufCapacity(pOperator, slot + 1);
+
+      doCopyOneRow(pDest, slot, pSrc, i);
+      pInfo->pHeap[slot] = slot;
+      pDest->info.rows += 1;
+
+      doSiftUpTopNHeap(pInfo->pHeap, slot, pDestKey->pData, bytes, comp);
+    } else if (comp(pSrcKey->pData + ((size_t) bytes) * i, pDestKey->pData + ((size_t) bytes) * pInfo->pHeap[0]) < 0) {
+      doCopyOneRow(pDest, pInfo->pHeap[0], pSrc, i);
+      doSiftDownTopNHeap(pInfo->pHeap, pDest->info.rows, pDestKey->pData, bytes, comp);
     }
   }
+}
+
+static void doSortDataBlockInMem(SOrderOperatorInfo* pInfo) {
+  if (pInfo->pDataBlock->info.rows == 0) {
+    return;
+  }
 
   int32_t numOfCols = pInfo->pDataBlock->info.numOfCols;
   void** pCols     = calloc(numOfCols, POINTER_BYTES);
@@ -5501,16 +5931,220 @@ static SSDataBlock* doSort(void* param, bool* newgroup) {
   }
 
   __compar_fn_t  comp = getKeyComparFunc(pSchema[pInfo->colIndex].type, pInfo->order);
-  if (pInfo->pDataBlock->info.rows) {
-    taoscQSort(pCols, pSchema, numOfCols, pInfo->pDataBlock->info.rows, pInfo->colIndex, comp);
-  }
-  
+  taoscQSort(pCols, pSchema, numOfCols, pInfo->pDataBlock->info.rows, pInfo->colIndex, comp);
+
   tfree(pCols);
   tfree(pSchema);
-  return (pInfo->pDataBlock->info.rows > 0)? pInfo->pDataBlock:NULL;
 }
 
-SOperatorInfo *createOrderOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SExprInfo* pExpr, int32_t numOfOutput, SOrderVal* pOrderVal) {
+// sort the buffered rows and write them into the disk-based buffer as a new run, each page of the run keeps the
+// values of every column one after another
+static void doSpillSortedRun(SOperatorInfo* pOperator) {
+  SOrderOperatorInfo* pInfo = pOperator->info;
+  SQueryRuntimeEnv* pRuntimeEnv = pOperator->pRuntimeEnv;
+  SSDataBlock* pBlock = pInfo->pDataBlock;
+
+  doSortDataBlockInMem(pInfo);
+
+  if (pInfo->pSortBuf == NULL) {
+    int32_t pageSize = pInfo->rowsPerPage * pInfo->rowSize + sizeof(tFilePage);
+    int32_t code = createDiskbasedResultBuffer(&pInfo->pSortBuf, pageSize, pageSize * 4, GET_QID(pRuntimeEnv));
+    if (code != TSDB_CODE_SUCCESS) {
+      longjmp(pRuntimeEnv->env, code);
+    }
+  }
+
+  SSortRunCursor run = {.runId = (int32_t) taosArrayGetSize(pInfo->pRuns), .pageIndex = 0, .rowIndex = 0, .pPage = NULL};
+
+  for(int32_t start = 0; start < pBlock->info.rows; start += pInfo->rowsPerPage) {
+    int32_t pageId = -1;
+    tFilePage* pPage = getNewDataBuf(pInfo->pSortBuf, run.runId, &pageId);
+    if (pPage == NULL) {
+      longjmp(pRuntimeEnv->env, TSDB_CODE_QRY_OUT_OF_MEMORY);
+    }
+
+    int32_t num = MIN(pInfo->rowsPerPage, pBlock->info.rows - start);
+    int32_t offset = 0;
+
+    for(int32_t i = 0; i < pBlock->info.numOfCols; ++i) {
+      SColumnInfoData* pCol = taosArrayGet(pBlock->pDataBlock, i);
+
+      int32_t bytes = pCol->info.bytes;
+      memcpy(pPage->data + offset * pInfo->rowsPerPage, pCol->pData + ((size_t) bytes) * start, ((size_t) bytes) * num);
+      offset += bytes;
+    }
+
+    pPage->num = num;
+    releaseResBufPage(pInfo->pSortBuf, pPage);
+  }
+
+  taosArrayPush(pInfo->pRuns, &run);
+
+  qDebug("QInfo:0x%"PRIx64" sorted run:%d of %d rows is spilled into disk-based buffer", GET_QID(pRuntimeEnv), run.runId,
+         pBlock->info.rows);
+  pBlock->info.rows = 0;
+}
+
+static int32_t sortRunComparator(const void* pLeft, const void* pRight, void* param) {
+  int32_t leftIndex  = *(int32_t*) pLeft;
+  int32_t rightIndex = *(int32_t*) pRight;
+
+  SOrderOperatorInfo* pInfo = (SOrderOperatorInfo*) param;
+
+  SSortRunCursor* pLeftRun  = taosArrayGet(pInfo->pRuns, leftIndex);
+  SSortRunCursor* pRightRun = taosArrayGet(pInfo->pRuns, rightIndex);
+
+  // this run is exhausted, set the special value to denote this
+  if (pLeftRun->rowIndex == -1) {
+    return 1;
+  }
+
+  if (pRightRun->rowIndex == -1) {
+    return -1;
+  }
+
+  SColumnInfoData* pKey = taosArrayGet(pInfo->pDataBlock->pDataBlock, pInfo->colIndex);
+  int32_t bytes = pKey->info.bytes;
+
+  char* pLeftKey  = pLeftRun->pPage->data + pInfo->keyOffset * pInfo->rowsPerPage + ((size_t) bytes) * pLeftRun->rowIndex;
+  char* pRightKey = pRightRun->pPage->data + pInfo->keyOffset * pInfo->rowsPerPage + ((size_t) bytes) * pRightRun->rowIndex;
+
+  __compar_fn_t comp = getKeyComparFunc(pKey->info.type, pInfo->order);
+  return comp(pLeftKey, pRightKey);
+}
+
+static void doInitSortRunMerge(SOperatorInfo* pOperator) {
+  SOrderOperatorInfo* pInfo = pOperator->info;
+
+  int32_t numOfRuns = (int32_t) taosArrayGetSize(pInfo->pRuns);
+
+  // the current page of each run is kept in memory during the merge
+  pInfo->pSortBuf->inMemPages = MAX(pInfo->pSortBuf->inMemPages, numOfRuns + 1);
+
+  for(int32_t i = 0; i < numOfRuns; ++i) {
+    SSortRunCursor* pRun = taosArrayGet(pInfo->pRuns, i);
+
+    SIDList list = getDataBufPagesIdList(pInfo->pSortBuf, pRun->runId);
+    SPageInfo* pgInfo = *(SPageInfo**) taosArrayGet(list, 0);
+
+    pRun->pPage = getResBufPage(pInfo->pSortBuf, pgInfo->pageId);
+    pRun->pageIndex = 0;
+    pRun->rowIndex = 0;
+  }
+
+  uint32_t code = tLoserTreeCreate(&pInfo->pMergeTree, numOfRuns, pInfo, sortRunComparator);
+  if (code != TSDB_CODE_SUCCESS) {
+    longjmp(pOperator->pRuntimeEnv->env, code);
+  }
+}
+
+static SSDataBlock* doMergeSortedRuns(SOperatorInfo* pOperator) {
+  SOrderOperatorInfo* pInfo = pOperator->info;
+  SSDataBlock* pBlock = pInfo->pDataBlock;
+
+  int32_t threshold = MIN(pOperator->pRuntimeEnv->resultInfo.capacity, pInfo->maxRowsInMem);
+  threshold = MAX(threshold, 1);
+  ensureOrderBufCapacity(pOperator, threshold);
+
+  pBlock->info.rows = 0;
+  while(pBlock->info.rows < threshold) {
+    int32_t index = pInfo->pMergeTree->pNode[0].index;
+
+    SSortRunCursor* pRun = taosArrayGet(pInfo->pRuns, index);
+    if (pRun->rowIndex == -1) {  // all runs are exhausted
+      doSetOperatorCompleted(pOperator);
+      break;
+    }
+
+    int32_t offset = 0;
+    for(int32_t i = 0; i < pBlock->info.numOfCols; ++i) {
+      SColumnInfoData* pCol = taosArrayGet(pBlock->pDataBlock, i);
+
+      int32_t bytes = pCol->info.bytes;
+      memcpy(pCol->pData + ((size_t) bytes) * pBlock->info.rows,
+             pRun->pPage->data + offset * pInfo->rowsPerPage + ((size_t) bytes) * pRun->rowIndex, bytes);
+      offset += bytes;
+    }
+
+    pBlock->info.rows += 1;
+
+    // move to the next row of this run
+    pRun->rowIndex += 1;
+    if (pRun->rowIndex >= (int32_t) pRun->pPage->num) {
+      releaseResBufPage(pInfo->pSortBuf, pRun->pPage);
+
+      SIDList list = getDataBufPagesIdList(pInfo->pSortBuf, pRun->runId);
+      pRun->pageIndex += 1;
+
+      if (pRun->pageIndex < (int32_t) taosArrayGetSize(list)) {
+        SPageInfo* pgInfo = *(SPageInfo**) taosArrayGet(list, pRun->pageIndex);
+        pRun->pPage = getResBufPage(pInfo->pSortBuf, pgInfo->pageId);
+        pRun->rowIndex = 0;
+      } else {
+        pRun->pPage = NULL;
+        pRun->rowIndex = -1;
+      }
+    }
+
+    tLoserTreeAdjust(pInfo->pMergeTree, index + pInfo->pMergeTree->numOfEntries);
+  }
+
+  return (pBlock->info.rows > 0)? pBlock:NULL;
+}
+
+static SSDataBlock* doSort(void* param, bool* newgroup) {
+  SOperatorInfo* pOperator = (SOperatorInfo*) param;
+  if (pOperator->status == OP_EXEC_DONE) {
+    return NULL;
+  }
+
+  SOrderOperatorInfo* pInfo = pOperator->info;
+  if (pInfo->loaded) {
+    return doMergeSortedRuns(pOperator);
+  }
+
+  SSDataBlock* pBlock = NULL;
+  while(1) {
+    publishOperatorProfEvent(pOperator->upstream[0], QUERY_PROF_BEFORE_OPERATOR_EXEC);
+    pBlock = pOperator->upstream[0]->exec(pOperator->upstream[0], newgroup);
+    publishOperatorProfEvent(pOperator->upstream[0], QUERY_PROF_AFTER_OPERATOR_EXEC);
+
+    if (pBlock == NULL) {
+      break;
+    }
+
+    // only the leading rows are required, the others are discarded once they are out of the top-N rows
+    if (pInfo->topN > 0) {
+      doAddIntoTopN(pOperator, pBlock);
+      continue;
+    }
+
+    int32_t rows = pInfo->pDataBlock->info.rows;
+    if (rows > 0 && rows + pBlock->info.rows > pInfo->maxRowsInMem) {
+      doSpillSortedRun(pOperator);
+    }
+
+    doAppendDataBlock(pOperator, pBlock);
+  }
+
+  pInfo->loaded = true;
+
+  if (taosArrayGetSize(pInfo->pRuns) == 0) {
+    doSetOperatorCompleted(pOperator);
+    doSortDataBlockInMem(pInfo);
+    return (pInfo->pDataBlock->info.rows > 0)? pInfo->pDataBlock:NULL;
+  }
+
+  // start to flush the remain rows into disk and do multiway merge sort
+  if (pInfo->pDataBlock->info.rows > 0) {
+    doSpillSortedRun(pOperator);
+  }
+
+  doInitSortRunMerge(pOperator);
+  return doMergeSortedRuns(pOperator);
+}
+
+SOperatorInfo *createOrderOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorInfo* upstream, SExprInfo* pExpr, int32_t numOfOutput, SOrderVal* pOrderVal, SLimitVal* pLimit) {
   SOrderOperatorInfo* pInfo = calloc(1, sizeof(SOrderOperatorInfo));
 
   {
@@ -5525,7 +6159,10 @@ SOperatorInfo *createOrderOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorI
 
         if (col.info.colId == pOrderVal->orderColId) {
           pInfo->colIndex = i;
+          pInfo->keyOffset = pInfo->rowSize;
         }
+
+        pInfo->rowSize += col.info.bytes;
       }
 
       pDataBlock->info.numOfCols = numOfOutput;
@@ -5533,8 +6170,19 @@ SOperatorInfo *createOrderOperatorInfo(SQueryRuntimeEnv* pRuntimeEnv, SOperatorI
       pInfo->pDataBlock = pDataBlock;
   }
 
+  pInfo->rowSize      = MAX(pInfo->rowSize, 1);
+  int64_t maxRowsInMem = MAX(tsSortBufferSize * 1048576L / pInfo->rowSize, 1);
+  pInfo->maxRowsInMem = (int32_t) MIN(maxRowsInMem, INT32_MAX);
+  pInfo->rowsPerPage  = MAX(DEFAULT_ORDER_PAGE_SIZE / pInfo->rowSize, 1);
+  pInfo->pRuns        = taosArrayInit(4, sizeof(SSortRunCursor));
+
+  // a bounded heap is used instead of sorting all rows if the rows required by the limit clause fit in memory
+  if (pLimit->limit > 0 && MAX(pLimit->offset, 0) + pLimit->limit <= pInfo->maxRowsInMem) {
+    pInfo->topN = MAX(pLimit->offset, 0) + pLimit->limit;
+  }
+
   SOperatorInfo* pOperator = calloc(1, sizeof(SOperatorInfo));
-  pOperator->name          = "InMemoryOrder";
+  pOperator->name          = "Order";
   pOperator->operatorType  = OP_Order;
   pOperator->blockingOptr  = true;
   pOperator->status        = OP_IN_EXECUTING;
@@ -6955,6 +7603,12 @@ static void destroyTimeEveryOperatorInfo(void* param, int32_t numOfOutput) {
 }
 
 
+static void destroyTableScanOperatorInfo(void* param, int32_t numOfOutput) {
+  STableScanInfo* pInfo = (STableScanInfo*) param;
+  destroyParallelScan(pInfo->pParScan);
+  pInfo->pParScan = NULL;
+}
+
 static void destroyTagScanOperatorInfo(void* param, int32_t numOfOutput) {
   STagScanInfo* pInfo = (STagScanInfo*) param;
   pInfo->pRes = destroyOutputBuf(pInfo->pRes);
@@ -6963,6 +7617,13 @@ static void destroyTagScanOperatorInfo(void* param, int32_t numOfOutput) {
 static void destroyOrderOperatorInfo(void* param, int32_t numOfOutput) {
   SOrderOperatorInfo* pInfo = (SOrderOperatorInfo*) param;
   pInfo->pDataBlock = destroyOutputBuf(pInfo->pDataBlock);
+
+  tfree(pInfo->pHeap);
+  tfree(pInfo->pMergeTree);
+  taosArrayDestroy(pInfo->pRuns);
+
+  destroyResultBuf(pInfo->pSortBuf);
+  pInfo->pSortBuf = NULL;
 }
 
 static void destroyConditionOperatorInfo(void* param, int32_t numOfOutput) {
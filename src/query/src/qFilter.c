@@ -1720,6 +1720,8 @@ void filterFreeInfo(SFilterInfo *info) {
   tfree(info->cunits);
   tfree(info->blkUnitRes);
   tfree(info->blkUnits);
+  tfree(info->rowRes);
+  tfree(info->tmpRes);
   
   for (int32_t i = 0; i < FLD_TYPE_MAX; ++i) {
     for (uint32_t f = 0; f < info->fields[i].num; ++f) {
@@ -2554,6 +2556,150 @@ int32_t filterPostProcessRange(SFilterInfo *info) {
 }
 
 
+/*
+ * Column kernels, one for each data type and operator. A kernel evaluates a whole column against the value range of
+ * a filter unit and writes 0/1 for each row, NULL rows included, without any function call or branch per row, so
+ * that the compiler is able to vectorize the loops.
+ */
+#define FILTER_KERNEL_EE      0
+#define FILTER_KERNEL_EI      1
+#define FILTER_KERNEL_IE      2
+#define FILTER_KERNEL_II      3
+#define FILTER_KERNEL_GE      4
+#define FILTER_KERNEL_GI      5
+#define FILTER_KERNEL_LE      6
+#define FILTER_KERNEL_LI      7
+#define FILTER_KERNEL_EQ      8
+#define FILTER_KERNEL_NE      9
+#define FILTER_KERNEL_ISNULL  10
+#define FILTER_KERNEL_NOTNULL 11
+#define FILTER_KERNEL_NUM     12
+
+#define FILTER_INT_GT(v, c) ((v) > (c))
+#define FILTER_INT_GE(v, c) ((v) >= (c))
+#define FILTER_INT_LT(v, c) ((v) < (c))
+#define FILTER_INT_LE(v, c) ((v) <= (c))
+#define FILTER_INT_EQ(v, c) ((v) == (c))
+
+// same results as compareFloatVal/compareDoubleVal, in which NAN is less than any other value
+#define FILTER_FLT_GT(v, c) (!FLT_EQUAL(v, c) & ((v) > (c)))
+#define FILTER_FLT_GE(v, c) (FLT_EQUAL(v, c) | ((v) > (c)))
+#define FILTER_FLT_LT(v, c) (((v) != (v)) | (!FLT_EQUAL(v, c) & ((v) < (c))))
+#define FILTER_FLT_LE(v, c) (((v) != (v)) | FLT_EQUAL(v, c) | ((v) < (c)))
+#define FILTER_FLT_EQ(v, c) (FLT_EQUAL(v, c))
+
+#define FILTER_KERNEL_FUNC(_name, _type, _utype, _null, _expr)                                                 \
+  static void _name(const void *colData, int32_t numOfRows, const void *minr, const void *maxr, int8_t *res) { \
+    const _type  *pv = (const _type *)colData;                                                                 \
+    const _utype *pn = (const _utype *)colData;                                                                \
+    const _type   lo = *(const _type *)minr;                                                                   \
+    const _type   hi = *(const _type *)maxr;                                                                   \
+    (void)lo;                                                                                                  \
+    (void)hi;                                                                                                  \
+    for (int32_t i = 0; i < numOfRows; ++i) {                                                                  \
+      const _type v = pv[i];                                                                                   \
+      const int32_t nn = (pn[i] != (_utype)(_null));                                                           \
+      res[i] = (int8_t)(_expr);                                                                                \
+    }                                                                                                          \
+  }
+
+#define FILTER_NULL_KERNEL_FUNC(_name, _utype, _null, _expr)                                                  \
+  static void _name(const void *colData, int32_t numOfRows, const void *minr, const void *maxr, int8_t *res) { \
+    const _utype *pn = (const _utype *)colData;                                                                \
+    for (int32_t i = 0; i < numOfRows; ++i) {                                                                  \
+      const int32_t nn = (pn[i] != (_utype)(_null));                                                           \
+      res[i] = (int8_t)(_expr);                                                                                \
+    }                                                                                                          \
+  }
+
+#define FILTER_KERNEL_FUNCS(_tn, _type, _utype, _null, _p)                                                    \
+  FILTER_KERNEL_FUNC(filterKernel##_tn##EE, _type, _utype, _null, nn & _p##_GT(v, lo) & _p##_LT(v, hi))      \
+  FILTER_KERNEL_FUNC(filterKernel##_tn##EI, _type, _utype, _null, nn & _p##_GT(v, lo) & _p##_LE(v, hi))      \
+  FILTER_KERNEL_FUNC(filterKernel##_tn##IE, _type, _utype, _null, nn & _p##_GE(v, lo) & _p##_LT(v, hi))      \
+  FILTER_KERNEL_FUNC(filterKernel##_tn##II, _type, _utype, _null, nn & _p##_GE(v, lo) & _p##_LE(v, hi))      \
+  FILTER_KERNEL_FUNC(filterKernel##_tn##GE, _type, _utype, _null, nn & _p##_GT(v, lo))                       \
+  FILTER_KERNEL_FUNC(filterKernel##_tn##GI, _type, _utype, _null, nn & _p##_GE(v, lo))                       \
+  FILTER_KERNEL_FUNC(filterKernel##_tn##LE, _type, _utype, _null, nn & _p##_LT(v, hi))                       \
+  FILTER_KERNEL_FUNC(filterKernel##_tn##LI, _type, _utype, _null, nn & _p##_LE(v, hi))                       \
+  FILTER_KERNEL_FUNC(filterKernel##_tn##EQ, _type, _utype, _null, nn & _p##_EQ(v, lo))                       \
+  FILTER_KERNEL_FUNC(filterKernel##_tn##NE, _type, _utype, _null, nn & !_p##_EQ(v, lo))                      \
+  FILTER_NULL_KERNEL_FUNC(filterKernel##_tn##IsNull, _utype, _null, !nn)                                    \
+  FILTER_NULL_KERNEL_FUNC(filterKernel##_tn##NotNull, _utype, _null, nn)
+
+#define FILTER_KERNEL_LIST(_tn)                                                                               \
+  { filterKernel##_tn##EE, filterKernel##_tn##EI, filterKernel##_tn##IE, filterKernel##_tn##II,              \
+    filterKernel##_tn##GE, filterKernel##_tn##GI, filterKernel##_tn##LE, filterKernel##_tn##LI,              \
+    filterKernel##_tn##EQ, filterKernel##_tn##NE, filterKernel##_tn##IsNull, filterKernel##_tn##NotNull }
+
+FILTER_KERNEL_FUNCS(Bool, int8_t, uint8_t, TSDB_DATA_BOOL_NULL, FILTER_INT)
+FILTER_KERNEL_FUNCS(Int8, int8_t, uint8_t, TSDB_DATA_TINYINT_NULL, FILTER_INT)
+FILTER_KERNEL_FUNCS(Int16, int16_t, uint16_t, TSDB_DATA_SMALLINT_NULL, FILTER_INT)
+FILTER_KERNEL_FUNCS(Int32, int32_t, uint32_t, TSDB_DATA_INT_NULL, FILTER_INT)
+FILTER_KERNEL_FUNCS(Int64, int64_t, uint64_t, TSDB_DATA_BIGINT_NULL, FILTER_INT)
+FILTER_KERNEL_FUNCS(Uint8, uint8_t, uint8_t, TSDB_DATA_UTINYINT_NULL, FILTER_INT)
+FILTER_KERNEL_FUNCS(Uint16, uint16_t, uint16_t, TSDB_DATA_USMALLINT_NULL, FILTER_INT)
+FILTER_KERNEL_FUNCS(Uint32, uint32_t, uint32_t, TSDB_DATA_UINT_NULL, FILTER_INT)
+FILTER_KERNEL_FUNCS(Uint64, uint64_t, uint64_t, TSDB_DATA_UBIGINT_NULL, FILTER_INT)
+FILTER_KERNEL_FUNCS(Float, float, uint32_t, TSDB_DATA_FLOAT_NULL, FILTER_FLT)
+FILTER_KERNEL_FUNCS(Double, double, uint64_t, TSDB_DATA_DOUBLE_NULL, FILTER_FLT)
+
+static filter_kernel_func gFilterKernel[][FILTER_KERNEL_NUM] = {
+  FILTER_KERNEL_LIST(Bool),   FILTER_KERNEL_LIST(Int8),   FILTER_KERNEL_LIST(Int16),  FILTER_KERNEL_LIST(Int32),
+  FILTER_KERNEL_LIST(Int64),  FILTER_KERNEL_LIST(Uint8),  FILTER_KERNEL_LIST(Uint16), FILTER_KERNEL_LIST(Uint32),
+  FILTER_KERNEL_LIST(Uint64), FILTER_KERNEL_LIST(Float),  FILTER_KERNEL_LIST(Double),
+};
+
+static filter_kernel_func filterGetKernelFunc(SFilterComUnit *cunit) {
+  int32_t k = -1;
+  if (cunit->optr == TSDB_RELATION_ISNULL) {
+    k = FILTER_KERNEL_ISNULL;
+  } else if (cunit->optr == TSDB_RELATION_NOTNULL) {
+    k = FILTER_KERNEL_NOTNULL;
+  } else if (cunit->rfunc >= 0) {
+    k = cunit->rfunc;
+  } else if (cunit->optr == TSDB_RELATION_EQUAL) {
+    k = FILTER_KERNEL_EQ;
+  } else if (cunit->optr == TSDB_RELATION_NOT_EQUAL) {
+    k = FILTER_KERNEL_NE;
+  } else {
+    return NULL;
+  }
+
+  if (k < FILTER_KERNEL_ISNULL) {
+    if (cunit->valData == NULL || cunit->valData2 == NULL) {
+      return NULL;
+    }
+
+    // the compare functions treat NAN as the smallest value, which is not the case in the kernels
+    if (cunit->dataType == TSDB_DATA_TYPE_FLOAT &&
+        (isnan(GET_FLOAT_VAL(cunit->valData)) || isnan(GET_FLOAT_VAL(cunit->valData2)))) {
+      return NULL;
+    }
+
+    if (cunit->dataType == TSDB_DATA_TYPE_DOUBLE &&
+        (isnan(GET_DOUBLE_VAL(cunit->valData)) || isnan(GET_DOUBLE_VAL(cunit->valData2)))) {
+      return NULL;
+    }
+  }
+
+  switch (cunit->dataType) {
+    case TSDB_DATA_TYPE_BOOL:      return gFilterKernel[0][k];
+    case TSDB_DATA_TYPE_TINYINT:   return gFilterKernel[1][k];
+    case TSDB_DATA_TYPE_SMALLINT:  return gFilterKernel[2][k];
+    case TSDB_DATA_TYPE_INT:       return gFilterKernel[3][k];
+    case TSDB_DATA_TYPE_BIGINT:
+    case TSDB_DATA_TYPE_TIMESTAMP: return gFilterKernel[4][k];
+    case TSDB_DATA_TYPE_UTINYINT:  return gFilterKernel[5][k];
+    case TSDB_DATA_TYPE_USMALLINT: return gFilterKernel[6][k];
+    case TSDB_DATA_TYPE_UINT:      return gFilterKernel[7][k];
+    case TSDB_DATA_TYPE_UBIGINT:   return gFilterKernel[8][k];
+    case TSDB_DATA_TYPE_FLOAT:     return gFilterKernel[9][k];
+    case TSDB_DATA_TYPE_DOUBLE:    return gFilterKernel[10][k];
+    default:
+      return NULL;
+  }
+}
+
 int32_t filterGenerateComInfo(SFilterInfo *info) {
   info->cunits = malloc(info->unitNum * sizeof(*info->cunits));
   info->blkUnitRes = malloc(sizeof(*info->blkUnitRes) * info->unitNum);
@@ -2581,6 +2727,7 @@ int32_t filterGenerateComInfo(SFilterInfo *info) {
     
     info->cunits[i].dataSize = FILTER_UNIT_COL_SIZE(info, unit);
     info->cunits[i].dataType = FILTER_UNIT_DATA_TYPE(unit);
+    info->cunits[i].kfunc = filterGetKernelFunc(&info->cunits[i]);
   }
   
   return TSDB_CODE_SUCCESS;
@@ -2774,66 +2921,124 @@ _return:
   return TSDB_CODE_SUCCESS;
 }
 
+int8_t* filterGetResultBuf(SFilterInfo *info, int32_t numOfRows) {
+  if (info->rowResSize < numOfRows) {
+    int8_t *tmp = realloc(info->rowRes, numOfRows * sizeof(int8_t));
+    if (tmp == NULL) {
+      return NULL;
+    }
+
+    info->rowRes = tmp;
+    info->rowResSize = numOfRows;
+  }
+
+  return info->rowRes;
+}
+
+static int8_t* filterGetTmpResBuf(SFilterInfo *info, int32_t numOfRows) {
+  if (info->tmpResSize < numOfRows) {
+    int8_t *tmp = realloc(info->tmpRes, 2 * numOfRows * sizeof(int8_t));
+    if (tmp == NULL) {
+      return NULL;
+    }
+
+    info->tmpRes = tmp;
+    info->tmpResSize = numOfRows;
+  }
+
+  return info->tmpRes;
+}
+
+static void filterExecuteUnitByRow(SFilterComUnit *cunit, int32_t numOfRows, int8_t *res) {
+  uint8_t optr = cunit->optr;
+
+  for (int32_t i = 0; i < numOfRows; ++i) {
+    void *colData = (char *)cunit->colData + cunit->dataSize * i;
+
+    if (isNull(colData, cunit->dataType)) {
+      res[i] = optr == TSDB_RELATION_ISNULL ? true : false;
+    } else if (optr == TSDB_RELATION_NOTNULL) {
+      res[i] = 1;
+    } else if (optr == TSDB_RELATION_ISNULL) {
+      res[i] = 0;
+    } else if (cunit->rfunc >= 0) {
+      res[i] = (*gRangeCompare[cunit->rfunc])(colData, colData, cunit->valData, cunit->valData2, gDataCompare[cunit->func]);
+    } else if (cunit->dataType == TSDB_DATA_TYPE_NCHAR && (optr == TSDB_RELATION_MATCH || optr == TSDB_RELATION_NMATCH)) {
+      // match/nmatch for nchar type need convert from ucs4 to mbs
+      char *newColData = calloc(cunit->dataSize * TSDB_NCHAR_SIZE + VARSTR_HEADER_SIZE, 1);
+      int len = taosUcs4ToMbs(varDataVal(colData), varDataLen(colData), varDataVal(newColData));
+      varDataSetLen(newColData, len);
+      res[i] = filterDoCompare(gDataCompare[cunit->func], optr, newColData, cunit->valData);
+      tfree(newColData);
+    } else {
+      res[i] = filterDoCompare(gDataCompare[cunit->func], optr, colData, cunit->valData);
+    }
+  }
+}
+
+static void filterExecuteUnit(SFilterComUnit *cunit, int32_t numOfRows, int8_t *res) {
+  if (cunit->colData == NULL) {
+    memset(res, cunit->optr == TSDB_RELATION_ISNULL, numOfRows);
+  } else if (cunit->kfunc == NULL) {
+    filterExecuteUnitByRow(cunit, numOfRows, res);
+  } else {
+    (*cunit->kfunc)(cunit->colData, numOfRows, cunit->valData, cunit->valData2, res);
+  }
+}
+
+static FORCE_INLINE bool filterAllRowsPassed(const int8_t *p, int32_t numOfRows) {
+  int8_t all = 1;
+  for (int32_t i = 0; i < numOfRows; ++i) {
+    all &= p[i];
+  }
+
+  return all != 0;
+}
+
+// the units of a group are evaluated one column at a time, and AND-ed into dst
+static void filterExecuteGroup(SFilterInfo *info, uint32_t unitNum, uint32_t *unitIdxs, int32_t numOfRows, int8_t *dst,
+                               int8_t *ures) {
+  filterExecuteUnit(&info->cunits[unitIdxs[0]], numOfRows, dst);
+
+  for (uint32_t u = 1; u < unitNum; ++u) {
+    filterExecuteUnit(&info->cunits[unitIdxs[u]], numOfRows, ures);
+    for (int32_t i = 0; i < numOfRows; ++i) {
+      dst[i] &= ures[i];
+    }
+  }
+}
+
 bool filterExecuteBasedOnStatisImpl(void *pinfo, int32_t numOfRows, int8_t** p, SDataStatis *statis, int16_t numOfCols) {
   SFilterInfo *info = (SFilterInfo *)pinfo;
-  bool all = true;
-  uint32_t *unitIdx = NULL;
+  uint32_t *unitIdx = info->blkUnits;
 
   if (*p == NULL) {
     *p = calloc(numOfRows, sizeof(int8_t));
   }
-  
-  for (int32_t i = 0; i < numOfRows; ++i) {
-    //FILTER_UNIT_CLR_F(info);
-
-    unitIdx = info->blkUnits;
-    
-    for (uint32_t g = 0; g < info->blkGroupNum; ++g) {
-      uint32_t unitNum = *(unitIdx++);
-      for (uint32_t u = 0; u < unitNum; ++u) {
-        SFilterComUnit *cunit = &info->cunits[*(unitIdx + u)];
-        void *colData = (char *)cunit->colData + cunit->dataSize * i;
-      
-        //if (FILTER_UNIT_GET_F(info, uidx)) {
-        //  p[i] = FILTER_UNIT_GET_R(info, uidx);
-        //} else {
-          uint8_t optr = cunit->optr;
 
-          if (isNull(colData, cunit->dataType)) {
-            (*p)[i] = optr == TSDB_RELATION_ISNULL ? true : false;
-          } else {
-            if (optr == TSDB_RELATION_NOTNULL) {
-              (*p)[i] = 1;
-            } else if (optr == TSDB_RELATION_ISNULL) {
-              (*p)[i] = 0;
-            } else if (cunit->rfunc >= 0) {
-              (*p)[i] = (*gRangeCompare[cunit->rfunc])(colData, colData, cunit->valData, cunit->valData2, gDataCompare[cunit->func]);
-            } else {
-              (*p)[i] = filterDoCompare(gDataCompare[cunit->func], cunit->optr, colData, cunit->valData);
-            }
-          
-          //FILTER_UNIT_SET_R(info, uidx, p[i]);
-          //FILTER_UNIT_SET_F(info, uidx);
-          }
+  int8_t *tmp = filterGetTmpResBuf(info, numOfRows);
+  if (tmp == NULL) {
+    memset(*p, 0, numOfRows);
+    return false;
+  }
 
-        if ((*p)[i] == 0) {
-          break;
-        }
-      }
+  // the groups are OR-ed, and each of them is stored as the number of units followed by the unit indexes
+  for (uint32_t g = 0; g < info->blkGroupNum; ++g) {
+    uint32_t unitNum = *(unitIdx++);
 
-      if ((*p)[i]) {
-        break;
+    if (g == 0) {
+      filterExecuteGroup(info, unitNum, unitIdx, numOfRows, *p, tmp + numOfRows);
+    } else {
+      filterExecuteGroup(info, unitNum, unitIdx, numOfRows, tmp, tmp + numOfRows);
+      for (int32_t i = 0; i < numOfRows; ++i) {
+        (*p)[i] |= tmp[i];
       }
-
-      unitIdx += unitNum;
     }
 
-    if ((*p)[i] == 0) {
-      all = false;
-    }    
+    unitIdx += unitNum;
   }
 
-  return all;
+  return filterAllRowsPassed(*p, numOfRows);
 }
 
 
@@ -2849,6 +3054,11 @@ int32_t filterExecuteBasedOnStatis(SFilterInfo *info, int32_t numOfRows, int8_t*
         *all = true;
         goto _return;
       } else if (FILTER_GET_FLAG(info->blkFlag, FI_STATUS_BLK_EMPTY)) {
+        // the buffer may be provided by the caller and hold the results of the previous block
+        if (*p != NULL) {
+          memset(*p, 0, numOfRows);
+        }
+
         *all = false;
         goto _return;
       }
@@ -2874,64 +3084,17 @@ static FORCE_INLINE bool filterExecuteImplAll(void *info, int32_t numOfRows, int
   return true;
 }
 static FORCE_INLINE bool filterExecuteImplEmpty(void *info, int32_t numOfRows, int8_t** p, SDataStatis *statis, int16_t numOfCols) {
-  return false;
-}
-static FORCE_INLINE bool filterExecuteImplIsNull(void *pinfo, int32_t numOfRows, int8_t** p, SDataStatis *statis, int16_t numOfCols) {
-  SFilterInfo *info = (SFilterInfo *)pinfo;
-  bool all = true;
-
-  if (filterExecuteBasedOnStatis(info, numOfRows, p, statis, numOfCols, &all) == 0) {
-    return all;
-  }
-
-  if (*p == NULL) {
-    *p = calloc(numOfRows, sizeof(int8_t));
-  }
-  
-  for (int32_t i = 0; i < numOfRows; ++i) {
-    uint32_t uidx = info->groups[0].unitIdxs[0];
-    void *colData = (char *)info->cunits[uidx].colData + info->cunits[uidx].dataSize * i;
-    (*p)[i] = ((colData == NULL) || isNull(colData, info->cunits[uidx].dataType));
-    if ((*p)[i] == 0) {
-      all = false;
-    }    
-  }
-
-  return all;
-}
-static FORCE_INLINE bool filterExecuteImplNotNull(void *pinfo, int32_t numOfRows, int8_t** p, SDataStatis *statis, int16_t numOfCols) {
-  SFilterInfo *info = (SFilterInfo *)pinfo;
-  bool all = true;
-
-  if (filterExecuteBasedOnStatis(info, numOfRows, p, statis, numOfCols, &all) == 0) {
-    return all;
-  }
-
-  if (*p == NULL) {
-    *p = calloc(numOfRows, sizeof(int8_t));
-  }
-  
-  for (int32_t i = 0; i < numOfRows; ++i) {
-    uint32_t uidx = info->groups[0].unitIdxs[0];
-    void *colData = (char *)info->cunits[uidx].colData + info->cunits[uidx].dataSize * i;
-    (*p)[i] = ((colData != NULL) && !isNull(colData, info->cunits[uidx].dataType));
-    if ((*p)[i] == 0) {
-      all = false;
-    }
+  if (*p != NULL) {
+    memset(*p, 0, numOfRows);
   }
 
-  return all;
+  return false;
 }
 
-bool filterExecuteImplRange(void *pinfo, int32_t numOfRows, int8_t** p, SDataStatis *statis, int16_t numOfCols) {
+// only one unit, evaluated by the kernel of its data type if any
+bool filterExecuteImplUnit(void *pinfo, int32_t numOfRows, int8_t** p, SDataStatis *statis, int16_t numOfCols) {
   SFilterInfo *info = (SFilterInfo *)pinfo;
   bool all = true;
-  uint16_t dataSize = info->cunits[0].dataSize;
-  char *colData = (char *)info->cunits[0].colData;
-  rangeCompFunc rfunc = gRangeCompare[info->cunits[0].rfunc];
-  void *valData = info->cunits[0].valData;
-  void *valData2 = info->cunits[0].valData2;
-  __compar_fn_t func = gDataCompare[info->cunits[0].func];
 
   if (filterExecuteBasedOnStatis(info, numOfRows, p, statis, numOfCols, &all) == 0) {
     return all;
@@ -2940,67 +3103,11 @@ bool filterExecuteImplRange(void *pinfo, int32_t numOfRows, int8_t** p, SDataSta
   if (*p == NULL) {
     *p = calloc(numOfRows, sizeof(int8_t));
   }
-  
-  for (int32_t i = 0; i < numOfRows; ++i) {
-    if (colData == NULL || isNull(colData, info->cunits[0].dataType)) {
-      all = false;
-      colData += dataSize;
-      continue;
-    }
-
-    (*p)[i] = (*rfunc)(colData, colData, valData, valData2, func);
-            
-    if ((*p)[i] == 0) {
-      all = false;
-    }
-    
-    colData += dataSize;
-  }
-
-  return all;
-}
-
-bool filterExecuteImplMisc(void *pinfo, int32_t numOfRows, int8_t** p, SDataStatis *statis, int16_t numOfCols) {
-  SFilterInfo *info = (SFilterInfo *)pinfo;
-  bool all = true;
-
-  if (filterExecuteBasedOnStatis(info, numOfRows, p, statis, numOfCols, &all) == 0) {
-    return all;
-  }
-  
-  if (*p == NULL) {
-    *p = calloc(numOfRows, sizeof(int8_t));
-  }
-  
-  for (int32_t i = 0; i < numOfRows; ++i) {
-    uint32_t uidx = info->groups[0].unitIdxs[0];
-    void *colData = (char *)info->cunits[uidx].colData + info->cunits[uidx].dataSize * i;
-    if (colData == NULL || isNull(colData, info->cunits[uidx].dataType)) {
-      (*p)[i] = 0;
-      all = false;
-      continue;
-    }
-    // match/nmatch for nchar type need convert from ucs4 to mbs
-
-    if(info->cunits[uidx].dataType == TSDB_DATA_TYPE_NCHAR && (info->cunits[uidx].optr == TSDB_RELATION_MATCH || info->cunits[uidx].optr == TSDB_RELATION_NMATCH)){
-      char *newColData = calloc(info->cunits[uidx].dataSize * TSDB_NCHAR_SIZE + VARSTR_HEADER_SIZE, 1);
-      int len = taosUcs4ToMbs(varDataVal(colData), varDataLen(colData), varDataVal(newColData));
-      varDataSetLen(newColData, len);
-      (*p)[i] = filterDoCompare(gDataCompare[info->cunits[uidx].func], info->cunits[uidx].optr, newColData, info->cunits[uidx].valData);
-      tfree(newColData);
-    }else{
-      (*p)[i] = filterDoCompare(gDataCompare[info->cunits[uidx].func], info->cunits[uidx].optr, colData, info->cunits[uidx].valData);
-    }
-
-    if ((*p)[i] == 0) {
-      all = false;
-    }
-  }
 
-  return all;
+  filterExecuteUnit(&info->cunits[info->groups[0].unitIdxs[0]], numOfRows, *p);
+  return filterAllRowsPassed(*p, numOfRows);
 }
 
-
 bool filterExecuteImpl(void *pinfo, int32_t numOfRows, int8_t** p, SDataStatis *statis, int16_t numOfCols) {
   SFilterInfo *info = (SFilterInfo *)pinfo;
   bool all = true;
@@ -3012,63 +3119,27 @@ bool filterExecuteImpl(void *pinfo, int32_t numOfRows, int8_t** p, SDataStatis *
   if (*p == NULL) {
     *p = calloc(numOfRows, sizeof(int8_t));
   }
-  
-  for (int32_t i = 0; i < numOfRows; ++i) {
-    //FILTER_UNIT_CLR_F(info);
-  
-    for (uint32_t g = 0; g < info->groupNum; ++g) {
-      SFilterGroup *group = &info->groups[g];
-      for (uint32_t u = 0; u < group->unitNum; ++u) {
-        uint32_t uidx = group->unitIdxs[u];
-        SFilterComUnit *cunit = &info->cunits[uidx];
-        void *colData = (char *)cunit->colData + cunit->dataSize * i;
-      
-        //if (FILTER_UNIT_GET_F(info, uidx)) {
-        //  p[i] = FILTER_UNIT_GET_R(info, uidx);
-        //} else {
-          uint8_t optr = cunit->optr;
 
-          if (colData == NULL || isNull(colData, cunit->dataType)) {
-            (*p)[i] = optr == TSDB_RELATION_ISNULL ? true : false;
-          } else {
-            if (optr == TSDB_RELATION_NOTNULL) {
-              (*p)[i] = 1;
-            } else if (optr == TSDB_RELATION_ISNULL) {
-              (*p)[i] = 0;
-            } else if (cunit->rfunc >= 0) {
-              (*p)[i] = (*gRangeCompare[cunit->rfunc])(colData, colData, cunit->valData, cunit->valData2, gDataCompare[cunit->func]);
-            } else {
-              if(cunit->dataType == TSDB_DATA_TYPE_NCHAR && (cunit->optr == TSDB_RELATION_MATCH || cunit->optr == TSDB_RELATION_NMATCH)){
-                char *newColData = calloc(cunit->dataSize * TSDB_NCHAR_SIZE + VARSTR_HEADER_SIZE, 1);
-                int len = taosUcs4ToMbs(varDataVal(colData), varDataLen(colData), varDataVal(newColData));
-                varDataSetLen(newColData, len);
-                (*p)[i] = filterDoCompare(gDataCompare[cunit->func], cunit->optr, newColData, cunit->valData);
-                tfree(newColData);
-              }else{
-                (*p)[i] = filterDoCompare(gDataCompare[cunit->func], cunit->optr, colData, cunit->valData);
-              }
-            }
-          
-          //FILTER_UNIT_SET_R(info, uidx, p[i]);
-          //FILTER_UNIT_SET_F(info, uidx);
-          }
+  int8_t *tmp = filterGetTmpResBuf(info, numOfRows);
+  if (tmp == NULL) {
+    memset(*p, 0, numOfRows);
+    return false;
+  }
 
-        if ((*p)[i] == 0) {
-          break;
-        }
-      }
+  for (uint32_t g = 0; g < info->groupNum; ++g) {
+    SFilterGroup *group = &info->groups[g];
 
-      if ((*p)[i]) {
-        break;
+    if (g == 0) {
+      filterExecuteGroup(info, group->unitNum, group->unitIdxs, numOfRows, *p, tmp + numOfRows);
+    } else {
+      filterExecuteGroup(info, group->unitNum, group->unitIdxs, numOfRows, tmp, tmp + numOfRows);
+      for (int32_t i = 0; i < numOfRows; ++i) {
+        (*p)[i] |= tmp[i];
       }
     }
-
-    if ((*p)[i] == 0) {
-      all = false;
-    }    
   }
 
-  return all;
+  return filterAllRowsPassed(*p, numOfRows);
 }
 
 
@@ -3092,22 +3163,7 @@ int32_t filterSetExecFunc(SFilterInfo *info) {
     return TSDB_CODE_SUCCESS;
   }
 
-  if (info->units[0].compare.optr == TSDB_RELATION_ISNULL) {
-    info->func = filterExecuteImplIsNull;
-    return TSDB_CODE_SUCCESS;
-  }
-
-  if (info->units[0].compare.optr == TSDB_RELATION_NOTNULL) {
-    info->func = filterExecuteImplNotNull;
-    return TSDB_CODE_SUCCESS;
-  }
-
-  if (info->cunits[0].rfunc >= 0) {
-    info->func = filterExecuteImplRange;
-    return TSDB_CODE_SUCCESS;  
-  }
-
-  info->func = filterExecuteImplMisc;
+  info->func = filterExecuteImplUnit;
   return TSDB_CODE_SUCCESS;  
 }
 
@@ -3507,6 +3563,69 @@ int32_t filterGetIndexedColumnInfo(SFilterInfo* info, char** val, int32_t *order
   return TSDB_CODE_SUCCESS;
 }
 
+static int32_t filterGetIndexUnitPriority(SFilterUnit *unit) {
+  switch (FILTER_UNIT_OPTR(unit)) {
+    case TSDB_RELATION_EQUAL:
+      return 0;
+    case TSDB_RELATION_GREATER:
+    case TSDB_RELATION_GREATER_EQUAL:
+      return unit->compare.optr2 ? 1 : 3;
+    case TSDB_RELATION_LIKE:
+      return 2;
+    case TSDB_RELATION_LESS:
+    case TSDB_RELATION_LESS_EQUAL:
+      return 3;
+    default:
+      return -1;
+  }
+}
+
+/*
+ * Pick one unit from each group that can be resolved by an index of its column, so that the union of the rows
+ * satisfying the picked units contains all the qualified rows. The units of a group are tried from the most selective
+ * operator, fp tells if the column of a unit has an index supporting the operator. Return false if any group has no
+ * such unit.
+ */
+bool filterGetIndexUnits(SFilterInfo *info, filter_index_check_func fp, void *param, SArray *res) {
+  if (info == NULL || FILTER_ALL_RES(info) || FILTER_EMPTY_RES(info) || info->groupNum == 0) {
+    return false;
+  }
+
+  for (uint32_t g = 0; g < info->groupNum; ++g) {
+    SFilterGroup *group = &info->groups[g];
+    bool          found = false;
+
+    for (int32_t p = 0; p <= 3 && !found; ++p) {
+      for (uint32_t u = 0; u < group->unitNum; ++u) {
+        uint32_t     uidx = group->unitIdxs[u];
+        SFilterUnit *unit = &info->units[uidx];
+
+        if (filterGetIndexUnitPriority(unit) != p || info->cunits[uidx].valData == NULL) {
+          continue;
+        }
+
+        SFilterComUnit *cunit = &info->cunits[uidx];
+        if (!(*fp)(param, (int16_t)cunit->colId, cunit->optr, cunit->valData)) {
+          continue;
+        }
+
+        SFilterIndexUnit iu = {.colId = (int16_t)cunit->colId, .optr = cunit->optr, .optr2 = unit->compare.optr2,
+                               .val = cunit->valData, .val2 = cunit->valData2};
+        taosArrayPush(res, &iu);
+        found = true;
+        break;
+      }
+    }
+
+    if (!found) {
+      taosArrayClear(res);
+      return false;
+    }
+  }
+
+  return true;
+}
+
 
 
 
@@ -0,0 +1,198 @@
+#include <gtest/gtest.h>
+#include <iostream>
+
+#include "taos.h"
+#include "taosdef.h"
+#include "tvariant.h"
+
+#include "qFilter.h"
+
+#pragma GCC diagnostic ignored "-Wunused-function"
+#pragma GCC diagnostic ignored "-Wunused-variable"
+
+namespace {
+
+const int32_t numOfRows = 1000;
+
+int32_t  intCol[numOfRows];
+double   dblCol[numOfRows];
+
+tExprNode* createColNode(int16_t colId, int8_t type) {
+  tExprNode* pNode = (tExprNode*)calloc(1, sizeof(tExprNode));
+  pNode->nodeType = TSQL_NODE_COL;
+  pNode->pSchema = (SSchema*)calloc(1, sizeof(SSchema));
+  pNode->pSchema->colId = colId;
+  pNode->pSchema->type = type;
+  pNode->pSchema->bytes = tDataTypes[type].bytes;
+  return pNode;
+}
+
+tExprNode* createIntValNode(int64_t v) {
+  tExprNode* pNode = (tExprNode*)calloc(1, sizeof(tExprNode));
+  pNode->nodeType = TSQL_NODE_VALUE;
+  pNode->pVal = (tVariant*)calloc(1, sizeof(tVariant));
+  pNode->pVal->nType = TSDB_DATA_TYPE_BIGINT;
+  pNode->pVal->i64 = v;
+  return pNode;
+}
+
+tExprNode* createDoubleValNode(double v) {
+  tExprNode* pNode = (tExprNode*)calloc(1, sizeof(tExprNode));
+  pNode->nodeType = TSQL_NODE_VALUE;
+  pNode->pVal = (tVariant*)calloc(1, sizeof(tVariant));
+  pNode->pVal->nType = TSDB_DATA_TYPE_DOUBLE;
+  pNode->pVal->dKey = v;
+  return pNode;
+}
+
+tExprNode* createNullValNode() {
+  tExprNode* pNode = (tExprNode*)calloc(1, sizeof(tExprNode));
+  pNode->nodeType = TSQL_NODE_VALUE;
+  pNode->pVal = (tVariant*)calloc(1, sizeof(tVariant));
+  pNode->pVal->nType = TSDB_DATA_TYPE_NULL;
+  return pNode;
+}
+
+tExprNode* createExprNode(uint8_t optr, tExprNode* pLeft, tExprNode* pRight) {
+  tExprNode* pNode = (tExprNode*)calloc(1, sizeof(tExprNode));
+  pNode->nodeType = TSQL_NODE_EXPR;
+  pNode->_node.optr = optr;
+  pNode->_node.pLeft = pLeft;
+  pNode->_node.pRight = pRight;
+  return pNode;
+}
+
+int32_t getColData(void* param, int32_t colId, void** data) {
+  *data = (colId == 1) ? (void*)intCol : (void*)dblCol;
+  return TSDB_CODE_SUCCESS;
+}
+
+void prepareData() {
+  for (int32_t i = 0; i < numOfRows; ++i) {
+    intCol[i] = i - 500;
+    dblCol[i] = (i - 500) * 0.01;
+  }
+
+  for (int32_t i = 0; i < numOfRows; i += 7) {
+    *(uint32_t*)&intCol[i] = TSDB_DATA_INT_NULL;
+  }
+
+  for (int32_t i = 3; i < numOfRows; i += 11) {
+    *(uint64_t*)&dblCol[i] = TSDB_DATA_DOUBLE_NULL;
+  }
+}
+
+bool isIntNull(int32_t i) { return *(uint32_t*)&intCol[i] == TSDB_DATA_INT_NULL; }
+bool isDblNull(int32_t i) { return *(uint64_t*)&dblCol[i] == TSDB_DATA_DOUBLE_NULL; }
+
+void checkFilter(tExprNode* pTree, bool (*expect)(int32_t)) {
+  SFilterInfo* info = NULL;
+  ASSERT_EQ(filterInitFromTree(pTree, (void**)&info, 0), TSDB_CODE_SUCCESS);
+  filterSetColFieldData(info, NULL, getColData);
+
+  // run twice to make sure the reused result buffer is fully rewritten
+  for (int32_t k = 0; k < 2; ++k) {
+    int8_t* p = filterGetResultBuf(info, numOfRows);
+    memset(p, k, numOfRows);
+
+    bool all = filterExecute(info, numOfRows, &p, NULL, 0);
+    ASSERT_FALSE(all);
+
+    for (int32_t i = 0; i < numOfRows; ++i) {
+      ASSERT_EQ(p[i], expect(i) ? 1 : 0) << "row " << i;
+    }
+  }
+
+  filterFreeInfo(info);
+  tExprTreeDestroy(pTree, NULL);
+}
+
+bool intRange(int32_t i) { return !isIntNull(i) && intCol[i] > -100 && intCol[i] <= 200; }
+bool dblOrNull(int32_t i) { return isDblNull(i) || dblCol[i] < -2.5; }
+bool mixedGroups(int32_t i) {
+  return (!isIntNull(i) && intCol[i] >= 0 && !isDblNull(i) && dblCol[i] <= 1.5) || (!isIntNull(i) && intCol[i] == -300);
+}
+
+}  // namespace
+
+TEST(testCase, filterKernelTest) {
+  prepareData();
+
+  // v > -100 and v <= 200
+  checkFilter(createExprNode(TSDB_RELATION_AND,
+                             createExprNode(TSDB_RELATION_GREATER, createColNode(1, TSDB_DATA_TYPE_INT), createIntValNode(-100)),
+                             createExprNode(TSDB_RELATION_LESS_EQUAL, createColNode(1, TSDB_DATA_TYPE_INT), createIntValNode(200))),
+              intRange);
+
+  // f is null or f < -2.5
+  checkFilter(createExprNode(TSDB_RELATION_OR,
+                             createExprNode(TSDB_RELATION_ISNULL, createColNode(2, TSDB_DATA_TYPE_DOUBLE), createNullValNode()),
+                             createExprNode(TSDB_RELATION_LESS, createColNode(2, TSDB_DATA_TYPE_DOUBLE), createDoubleValNode(-2.5))),
+              dblOrNull);
+
+  // (v >= 0 and f <= 1.5) or v = -300
+  checkFilter(createExprNode(TSDB_RELATION_OR,
+                             createExprNode(TSDB_RELATION_AND,
+                                            createExprNode(TSDB_RELATION_GREATER_EQUAL, createColNode(1, TSDB_DATA_TYPE_INT), createIntValNode(0)),
+                                            createExprNode(TSDB_RELATION_LESS_EQUAL, createColNode(2, TSDB_DATA_TYPE_DOUBLE), createDoubleValNode(1.5))),
+                             createExprNode(TSDB_RELATION_EQUAL, createColNode(1, TSDB_DATA_TYPE_INT), createIntValNode(-300))),
+              mixedGroups);
+}
+
+namespace {
+
+bool indexOnIntCol(void* param, int16_t colId, uint8_t optr, void* val) {
+  return colId == 1 && optr != TSDB_RELATION_NOT_EQUAL;
+}
+
+}  // namespace
+
+TEST(testCase, filterIndexUnitsTest) {
+  // (f <= 1.5 and v = 5) or v > 100
+  tExprNode* pTree = createExprNode(
+      TSDB_RELATION_OR,
+      createExprNode(TSDB_RELATION_AND,
+                     createExprNode(TSDB_RELATION_LESS_EQUAL, createColNode(2, TSDB_DATA_TYPE_DOUBLE), createDoubleValNode(1.5)),
+                     createExprNode(TSDB_RELATION_EQUAL, createColNode(1, TSDB_DATA_TYPE_INT), createIntValNode(5))),
+      createExprNode(TSDB_RELATION_GREATER, createColNode(1, TSDB_DATA_TYPE_INT), createIntValNode(100)));
+
+  SFilterInfo* info = NULL;
+  ASSERT_EQ(filterInitFromTree(pTree, (void**)&info, 0), TSDB_CODE_SUCCESS);
+
+  SArray* pUnits = (SArray*)taosArrayInit(4, sizeof(SFilterIndexUnit));
+  ASSERT_TRUE(filterGetIndexUnits(info, indexOnIntCol, NULL, pUnits));
+  ASSERT_EQ(taosArrayGetSize(pUnits), 2);
+
+  int32_t eq = 0, gt = 0;
+  for (int32_t i = 0; i < 2; ++i) {
+    SFilterIndexUnit* pUnit = (SFilterIndexUnit*)taosArrayGet(pUnits, i);
+    ASSERT_EQ(pUnit->colId, 1);
+    if (pUnit->optr == TSDB_RELATION_EQUAL) {
+      ASSERT_EQ(*(int32_t*)pUnit->val, 5);
+      eq += 1;
+    } else if (pUnit->optr == TSDB_RELATION_GREATER) {
+      ASSERT_EQ(*(int32_t*)pUnit->val, 100);
+      gt += 1;
+    }
+  }
+  ASSERT_EQ(eq, 1);
+  ASSERT_EQ(gt, 1);
+
+  filterFreeInfo(info);
+  tExprTreeDestroy(pTree, NULL);
+
+  // v = 5 or f < -2.5, the second group has no indexed column
+  pTree = createExprNode(TSDB_RELATION_OR,
+                         createExprNode(TSDB_RELATION_EQUAL, createColNode(1, TSDB_DATA_TYPE_INT), createIntValNode(5)),
+                         createExprNode(TSDB_RELATION_LESS, createColNode(2, TSDB_DATA_TYPE_DOUBLE), createDoubleValNode(-2.5)));
+  info = NULL;
+  ASSERT_EQ(filterInitFromTree(pTree, (void**)&info, 0), TSDB_CODE_SUCCESS);
+
+  taosArrayClear(pUnits);
+  ASSERT_FALSE(filterGetIndexUnits(info, indexOnIntCol, NULL, pUnits));
+  ASSERT_EQ(taosArrayGetSize(pUnits), 0);
+
+  filterFreeInfo(info);
+  tExprTreeDestroy(pTree, NULL);
+  taosArrayDestroy(pUnits);
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TDENGINE_RPC_BUF_H
+#define TDENGINE_RPC_BUF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void *rpcBufMalloc(int32_t size);
+void *rpcBufRealloc(void *p, int32_t size);
+void  rpcBufFree(void *p);
+void  rpcBufCleanUp();
+void  rpcBufAddCopied(int64_t bytes);
+void  rpcBufAddDirect(int64_t bytes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TDENGINE_RPC_BUF_H
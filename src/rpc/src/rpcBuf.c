@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "os.h"
+#include "tutil.h"
+#include "trpc.h"
+#include "rpcLog.h"
+#include "rpcBuf.h"
+
+/*
+ * Message buffers are pooled by size classes of power of 2. A buffer is usually allocated by the thread receiving the
+ * message and freed by the worker processing it, so each thread caches a few freed buffers for its own allocations,
+ * and moves the ones beyond its cache to the shared pool of the class, where the receiving threads get them back.
+ * Buffers larger than the largest class are not pooled.
+ */
+#define RPC_BUF_MIN_SHIFT    8
+#define RPC_BUF_CLASSES      13                                  // 256 bytes to 1MB
+#define RPC_BUF_THREAD_BYTES (512 * 1024)                        // bytes cached by a thread
+#define RPC_BUF_POOL_BYTES   (2 * 1024 * 1024)                   // bytes pooled by a class
+#define RPC_BUF_BATCH        8                                   // buffers moved between a thread and a pool at a time
+#define RPC_BUF_NO_CLASS     -1
+#define RPC_BUF_SIGNATURE    0x52425546
+
+typedef struct {
+  int32_t cls;
+  int32_t signature;
+  int32_t size;  // capacity of the buffer
+  int32_t reserved;
+} SRpcBufHead;
+
+typedef struct SRpcBufNode {
+  struct SRpcBufNode *next;
+} SRpcBufNode;
+
+typedef struct {
+  SRpcBufNode *head[RPC_BUF_CLASSES];
+  int32_t      num[RPC_BUF_CLASSES];
+  int64_t      bytes;
+} SRpcBufCache;
+
+typedef struct {
+  pthread_mutex_t mutex;
+  SRpcBufNode *   head;
+  int32_t         num;
+  int32_t         maxNum;
+} SRpcBufPool;
+
+static pthread_once_t             tsRpcBufInit = PTHREAD_ONCE_INIT;
+static pthread_key_t              tsRpcBufKey;
+static SRpcBufPool                tsRpcBufPools[RPC_BUF_CLASSES];
+static SRpcBufStat                tsRpcBufStat = {0};
+static threadlocal SRpcBufCache * tsRpcBufCache = NULL;
+
+static FORCE_INLINE int32_t rpcBufClassSize(int32_t cls) { return 1 << (cls + RPC_BUF_MIN_SHIFT); }
+
+static FORCE_INLINE SRpcBufHead *rpcBufHead(void *p) { return (SRpcBufHead *)((char *)p - sizeof(SRpcBufHead)); }
+
+static int32_t rpcBufClass(int32_t size) {
+  for (int32_t cls = 0; cls < RPC_BUF_CLASSES; ++cls) {
+    if (size <= rpcBufClassSize(cls)) return cls;
+  }
+  return RPC_BUF_NO_CLASS;
+}
+
+// push the buffers to the pool of the class, and returns the ones it can not take
+static SRpcBufNode *rpcBufPushToPool(int32_t cls, SRpcBufNode *pNode) {
+  SRpcBufPool *pPool = &tsRpcBufPools[cls];
+
+  pthread_mutex_lock(&pPool->mutex);
+  while (pNode != NULL && pPool->num < pPool->maxNum) {
+    SRpcBufNode *pNext = pNode->next;
+    pNode->next = pPool->head;
+    pPool->head = pNode;
+    pPool->num++;
+    pNode = pNext;
+  }
+  pthread_mutex_unlock(&pPool->mutex);
+
+  return pNode;
+}
+
+static void rpcBufFreeNodes(SRpcBufNode *pNode) {
+  while (pNode != NULL) {
+    SRpcBufNode *pNext = pNode->next;
+    free(rpcBufHead(pNode));
+    pNode = pNext;
+  }
+}
+
+static void rpcBufDestroyCache(void *param) {
+  SRpcBufCache *pCache = param;
+  if (pCache == NULL) return;
+  tsRpcBufCache = NULL;
+
+  for (int32_t cls = 0; cls < RPC_BUF_CLASSES; ++cls) {
+    rpcBufFreeNodes(rpcBufPushToPool(cls, pCache->head[cls]));
+  }
+
+  free(pCache);
+}
+
+static void rpcBufInitPools() {
+  for (int32_t cls = 0; cls < RPC_BUF_CLASSES; ++cls) {
+    SRpcBufPool *pPool = &tsRpcBufPools[cls];
+    pthread_mutex_init(&pPool->mutex, NULL);
+    pPool->maxNum = MAX(RPC_BUF_POOL_BYTES / rpcBufClassSize(cls), 2);
+  }
+
+  // the buffers cached by a thread go back to the pools when it exits
+  pthread_key_create(&tsRpcBufKey, rpcBufDestroyCache);
+}
+
+static SRpcBufCache *rpcBufGetCache() {
+  if (tsRpcBufCache == NULL) {
+    pthread_once(&tsRpcBufInit, rpcBufInitPools);
+    tsRpcBufCache = calloc(1, sizeof(SRpcBufCache));
+    if (tsRpcBufCache != NULL) pthread_setspecific(tsRpcBufKey, tsRpcBufCache);
+  }
+
+  return tsRpcBufCache;
+}
+
+static void *rpcBufMallocDirectly(int32_t cls, int32_t size) {
+  SRpcBufHead *pHead = malloc(sizeof(SRpcBufHead) + size);
+  if (pHead == NULL) return NULL;
+
+  pHead->cls = cls;
+  pHead->signature = RPC_BUF_SIGNATURE;
+  pHead->size = size;
+  return (char *)pHead + sizeof(SRpcBufHead);
+}
+
+// the returned buffer is not initialized
+void *rpcBufMalloc(int32_t size) {
+  atomic_add_fetch_64(&tsRpcBufStat.allocs, 1);
+
+  int32_t       cls = rpcBufClass(size);
+  SRpcBufCache *pCache = (cls == RPC_BUF_NO_CLASS) ? NULL : rpcBufGetCache();
+  if (pCache == NULL) return rpcBufMallocDirectly(RPC_BUF_NO_CLASS, size);
+
+  if (pCache->head[cls] == NULL) {
+    // refill the cache from the pool
+    SRpcBufPool *pPool = &tsRpcBufPools[cls];
+    pthread_mutex_lock(&pPool->mutex);
+    for (int32_t i = 0; i < RPC_BUF_BATCH && pPool->head != NULL; ++i) {
+      SRpcBufNode *pNode = pPool->head;
+      pPool->head = pNode->next;
+      pPool->num--;
+      pNode->next = pCache->head[cls];
+      pCache->head[cls] = pNode;
+      pCache->num[cls]++;
+      pCache->bytes += rpcBufClassSize(cls);
+    }
+    pthread_mutex_unlock(&pPool->mutex);
+  }
+
+  SRpcBufNode *pNode = pCache->head[cls];
+  if (pNode == NULL) return rpcBufMallocDirectly(cls, rpcBufClassSize(cls));
+
+  pCache->head[cls] = pNode->next;
+  pCache->num[cls]--;
+  pCache->bytes -= rpcBufClassSize(cls);
+  atomic_add_fetch_64(&tsRpcBufStat.hits, 1);
+
+  return pNode;
+}
+
+void rpcBufFree(void *p) {
+  if (p == NULL) return;
+
+  SRpcBufHead *pHead = rpcBufHead(p);
+  assert(pHead->signature == RPC_BUF_SIGNATURE);
+  atomic_add_fetch_64(&tsRpcBufStat.frees, 1);
+
+  int32_t       cls = pHead->cls;
+  SRpcBufCache *pCache = (cls == RPC_BUF_NO_CLASS) ? NULL : rpcBufGetCache();
+  if (pCache == NULL) {
+    free(pHead);
+    return;
+  }
+
+  SRpcBufNode *pNode = p;
+  pNode->next = pCache->head[cls];
+  pCache->head[cls] = pNode;
+  pCache->num[cls]++;
+  pCache->bytes += rpcBufClassSize(cls);
+
+  if (pCache->bytes <= RPC_BUF_THREAD_BYTES) return;
+
+  // the cache is full, move a batch of the class to its pool
+  SRpcBufNode *pBatch = pCache->head[cls];
+  SRpcBufNode *pTail = pBatch;
+  int32_t      num = 1;
+  while (num < RPC_BUF_BATCH && num < pCache->num[cls] && pTail->next != NULL) {
+    pTail = pTail->next;
+    num++;
+  }
+
+  pCache->head[cls] = pTail->next;
+  pCache->num[cls] -= num;
+  pCache->bytes -= (int64_t)num * rpcBufClassSize(cls);
+  pTail->next = NULL;
+
+  rpcBufFreeNodes(rpcBufPushToPool(cls, pBatch));
+}
+
+void *rpcBufRealloc(void *p, int32_t size) {
+  if (p == NULL) return rpcBufMalloc(size);
+
+  SRpcBufHead *pHead = rpcBufHead(p);
+  if (size <= pHead->size) return p;
+
+  void *pNew = rpcBufMalloc(size);
+  if (pNew == NULL) return NULL;
+
+  memcpy(pNew, p, pHead->size);
+  atomic_add_fetch_64(&tsRpcBufStat.copied, pHead->size);
+  rpcBufFree(p);
+
+  return pNew;
+}
+
+// only the buffers in the pools are freed, the ones cached by the threads are freed when the threads exit
+void rpcBufCleanUp() {
+  if (pthread_once(&tsRpcBufInit, rpcBufInitPools) != 0) return;
+
+  for (int32_t cls = 0; cls < RPC_BUF_CLASSES; ++cls) {
+    SRpcBufPool *pPool = &tsRpcBufPools[cls];
+    pthread_mutex_lock(&pPool->mutex);
+    SRpcBufNode *pNode = pPool->head;
+    pPool->head = NULL;
+    pPool->num = 0;
+    pthread_mutex_unlock(&pPool->mutex);
+    rpcBufFreeNodes(pNode);
+  }
+}
+
+void rpcBufAddCopied(int64_t bytes) { atomic_add_fetch_64(&tsRpcBufStat.copied, bytes); }
+
+void rpcBufAddDirect(int64_t bytes) { atomic_add_fetch_64(&tsRpcBufStat.direct, bytes); }
+
+void rpcGetBufStat(SRpcBufStat *pStat) {
+  pStat->allocs = atomic_load_64(&tsRpcBufStat.allocs);
+  pStat->hits = atomic_load_64(&tsRpcBufStat.hits);
+  pStat->frees = atomic_load_64(&tsRpcBufStat.frees);
+  pStat->copied = atomic_load_64(&tsRpcBufStat.copied);
+  pStat->direct = atomic_load_64(&tsRpcBufStat.direct);
+}
@@ -32,6 +32,7 @@
 #include "rpcCache.h"
 #include "rpcTcp.h"
 #include "rpcHead.h"
+#include "rpcBuf.h"
 
 #define RPC_MSG_OVERHEAD (sizeof(SRpcReqContext) + sizeof(SRpcHead) + sizeof(SRpcDigest)) 
 #define rpcHeadFromCont(cont) ((SRpcHead *) ((char*)cont - sizeof(SRpcHead)))
@@ -62,6 +63,7 @@ typedef struct {
   void     *idPool;   // handle to ID pool
   void     *tmrCtrl;  // handle to timer
   SHashObj *hash;     // handle returned by hash utility
+  SHashObj *linkHash; // chandle to the first connection on the link, protected by mutex
   void     *tcphandle;// returned handle from TCP initialization
   void     *udphandle;// returned handle from UDP initialization
   void     *pCache;   // connection cache
@@ -124,6 +126,8 @@ typedef struct SRpcConn {
   int8_t    connType;   // connection type
   int64_t   lockedBy;   // lock for connection
   SRpcReqContext *pContext; // request context
+  struct SRpcConn *prevOnLink; // connections sharing the same chandle
+  struct SRpcConn *nextOnLink;
 } SRpcConn;
 
 int tsRpcMaxUdpSize = 15000;  // bytes
@@ -178,6 +182,13 @@ void *(*taosOpenConn[])(void *shandle, void *thandle, uint32_t ip, uint16_t port
     taosOpenTcpClientConnection,
 };
 
+void (*taosRefConn[])(void *chandle) = {
+    NULL, 
+    NULL, 
+    taosRefTcpConnection, 
+    taosRefTcpConnection
+};
+
 void (*taosCloseConn[])(void *chandle) = {
     NULL, 
     NULL, 
@@ -187,6 +198,9 @@ void (*taosCloseConn[])(void *chandle) = {
 
 static SRpcConn *rpcOpenConn(SRpcInfo *pRpc, char *peerFqdn, uint16_t peerPort, int8_t connType);
 static void      rpcCloseConn(void *thandle);
+static void      rpcAddConnToLink(SRpcConn *pConn);
+static void      rpcRemoveConnFromLink(SRpcConn *pConn);
+static SRpcConn *rpcGetFirstConnOnLink(SRpcInfo *pRpc, void *chandle);
 static SRpcConn *rpcSetupConnToServer(SRpcReqContext *pContext);
 static SRpcConn *rpcAllocateClientConn(SRpcInfo *pRpc);
 static SRpcConn *rpcAllocateServerConn(SRpcInfo *pRpc, SRecvInfo *pRecv);
@@ -217,7 +231,7 @@ static void  rpcDecRef(SRpcInfo *pRpc);
 
 static void rpcFree(void *p) {
   tTrace("free mem: %p", p);
-  free(p);
+  rpcBufFree(p);
 }
 
 int32_t rpcInit(void) {
@@ -234,6 +248,7 @@ int32_t rpcInit(void) {
 void rpcCleanup(void) {
   taosCloseRef(tsRpcRefId);
   tsRpcRefId = -1;
+  rpcBufCleanUp();
 }
  
 void *rpcOpen(const SRpcInit *pInit) {
@@ -303,6 +318,13 @@ void *rpcOpen(const SRpcInit *pInit) {
     }
   }
 
+  pRpc->linkHash = taosHashInit(pRpc->sessions, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), true, HASH_NO_LOCK);
+  if (pRpc->linkHash == NULL) {
+    tError("%s failed to init link hash", pRpc->label);
+    rpcClose(pRpc);
+    return NULL;
+  }
+
   pthread_mutex_init(&pRpc->mutex, NULL);
 
   pRpc->tcphandle = (*taosInitConn[pRpc->connType|RPC_CONN_TCP])(0, pRpc->localPort, pRpc->label, 
@@ -346,11 +368,12 @@ void rpcClose(void *param) {
 void *rpcMallocCont(int contLen) {
   int size = contLen + RPC_MSG_OVERHEAD;
 
-  char *start = (char *)calloc(1, (size_t)size);
+  char *start = rpcBufMalloc(size);
   if (start == NULL) {
     tError("failed to malloc msg, size:%d", size);
     return NULL;
   } else {
+    memset(start, 0, size);
     tTrace("malloc mem:%p size:%d", start, size);
   }
 
@@ -360,7 +383,7 @@ void *rpcMallocCont(int contLen) {
 void rpcFreeCont(void *cont) {
   if (cont) {
     char *temp = ((char *)cont) - sizeof(SRpcHead) - sizeof(SRpcReqContext);
-    free(temp);
+    rpcBufFree(temp);
     tTrace("free mem: %p", temp);
   }
 }
@@ -370,12 +393,12 @@ void *rpcReallocCont(void *ptr, int contLen) {
 
   char *start = ((char *)ptr) - sizeof(SRpcReqContext) - sizeof(SRpcHead);
   if (contLen == 0 ) {
-    free(start); 
+    rpcBufFree(start);
     return NULL;
   }
 
   int size = contLen + RPC_MSG_OVERHEAD;
-  start = realloc(start, size);
+  start = rpcBufRealloc(start, size);
   if (start == NULL) {
     tError("failed to realloc cont, size:%d", size);
     return NULL;
@@ -572,7 +595,7 @@ void rpcCancelRequest(int64_t rid) {
 static void rpcFreeMsg(void *msg) {
   if ( msg ) {
     char *temp = (char *)msg - sizeof(SRpcReqContext);
-    free(temp);
+    rpcBufFree(temp);
     tTrace("free mem: %p", temp);
   }
 }
@@ -605,6 +628,8 @@ static SRpcConn *rpcOpenConn(SRpcInfo *pRpc, char *peerFqdn, uint16_t peerPort,
         terrno = TSDB_CODE_RPC_NETWORK_UNAVAIL;
         rpcCloseConn(pConn);
         pConn = NULL;
+      } else {
+        rpcAddConnToLink(pConn);
       }
     }
   }
@@ -617,6 +642,9 @@ static void rpcReleaseConn(SRpcConn *pConn) {
   if (pConn->user[0] == 0) return;
 
   pConn->user[0] = 0;
+
+  // the chandle may be reused by a new link once it is closed
+  rpcRemoveConnFromLink(pConn);
   if (taosCloseConn[pConn->connType]) (*taosCloseConn[pConn->connType])(pConn->chandle);
 
   taosTmrStopA(&pConn->pTimer);
@@ -681,6 +709,55 @@ static void rpcCloseConn(void *thandle) {
   rpcUnlockConn(pConn);
 }
 
+static void rpcAddConnToLink(SRpcConn *pConn) {
+  SRpcInfo *pRpc = pConn->pRpc;
+
+  pthread_mutex_lock(&pRpc->mutex);
+
+  SRpcConn **ppFirst = taosHashGet(pRpc->linkHash, &pConn->chandle, sizeof(pConn->chandle));
+  pConn->prevOnLink = NULL;
+  pConn->nextOnLink = (ppFirst != NULL) ? *ppFirst : NULL;
+  if (pConn->nextOnLink) pConn->nextOnLink->prevOnLink = pConn;
+  taosHashPut(pRpc->linkHash, &pConn->chandle, sizeof(pConn->chandle), &pConn, sizeof(pConn));
+
+  pthread_mutex_unlock(&pRpc->mutex);
+}
+
+static void rpcRemoveConnFromLink(SRpcConn *pConn) {
+  SRpcInfo *pRpc = pConn->pRpc;
+  if (pConn->chandle == NULL) return;
+
+  pthread_mutex_lock(&pRpc->mutex);
+
+  if (pConn->prevOnLink) {
+    pConn->prevOnLink->nextOnLink = pConn->nextOnLink;
+  } else {
+    SRpcConn **ppFirst = taosHashGet(pRpc->linkHash, &pConn->chandle, sizeof(pConn->chandle));
+    if (ppFirst != NULL && *ppFirst == pConn) {
+      if (pConn->nextOnLink) {
+        taosHashPut(pRpc->linkHash, &pConn->chandle, sizeof(pConn->chandle), &pConn->nextOnLink, sizeof(pConn));
+      } else {
+        taosHashRemove(pRpc->linkHash, &pConn->chandle, sizeof(pConn->chandle));
+      }
+    }
+  }
+
+  if (pConn->nextOnLink) pConn->nextOnLink->prevOnLink = pConn->prevOnLink;
+  pConn->prevOnLink = NULL;
+  pConn->nextOnLink = NULL;
+
+  pthread_mutex_unlock(&pRpc->mutex);
+}
+
+static SRpcConn *rpcGetFirstConnOnLink(SRpcInfo *pRpc, void *chandle) {
+  pthread_mutex_lock(&pRpc->mutex);
+  SRpcConn **ppFirst = taosHashGet(pRpc->linkHash, &chandle, sizeof(chandle));
+  SRpcConn  *pConn = (ppFirst != NULL) ? *ppFirst : NULL;
+  pthread_mutex_unlock(&pRpc->mutex);
+
+  return pConn;
+}
+
 static SRpcConn *rpcAllocateClientConn(SRpcInfo *pRpc) {
   SRpcConn *pConn = NULL;
 
@@ -982,7 +1059,13 @@ static SRpcConn *rpcProcessMsgHead(SRpcInfo *pRpc, SRecvInfo *pRecv, SRpcReqCont
   }
 
   sid = pConn->sid;
-  if (pConn->chandle == NULL) pConn->chandle = pRecv->chandle;
+
+  // the connection may be released while waiting for the lock, it shall not be bound to the link again
+  if (pConn->chandle == NULL && pConn->user[0]) {
+    pConn->chandle = pRecv->chandle;
+    if (taosRefConn[pRecv->connType]) (*taosRefConn[pRecv->connType])(pConn->chandle);
+    rpcAddConnToLink(pConn);
+  }
   pConn->peerIp = pRecv->ip; 
   pConn->peerPort = pRecv->port;
   if (pHead->port) pConn->peerPort = htons(pHead->port); 
@@ -1049,13 +1132,19 @@ static void rpcReportBrokenLinkToServer(SRpcConn *pConn) {
   }
 }
 
-static void rpcProcessBrokenLink(SRpcConn *pConn) {
-  if (pConn == NULL) return;
+static void rpcProcessBrokenLink(SRpcConn *pConn, void *chandle) {
   SRpcInfo *pRpc = pConn->pRpc;
-  tDebug("%s, link is broken", pConn->info);
 
   rpcLockConn(pConn);
 
+  // it may be released or moved to another link already
+  if (pConn->user[0] == 0 || pConn->chandle != chandle) {
+    rpcUnlockConn(pConn);
+    return;
+  }
+
+  tDebug("%s, link is broken", pConn->info);
+
   if (pConn->outType) {
     SRpcReqContext *pContext = pConn->pContext;
     pContext->code = TSDB_CODE_RPC_NETWORK_UNAVAIL;
@@ -1081,7 +1170,18 @@ static void *rpcProcessMsgFromPeer(SRecvInfo *pRecv) {
   pRecv->connType = pRecv->connType | pRpc->connType;  
 
   if (pRecv->msg == NULL) {
-    rpcProcessBrokenLink(pConn);
+    // in multiplexed mode, several connections may share the broken link, each one is removed from the link once
+    // it is released
+    SRpcConn *pPrev = NULL;
+    while (pRecv->chandle && (pConn = rpcGetFirstConnOnLink(pRpc, pRecv->chandle)) != NULL) {
+      if (pConn == pPrev) {
+        tError("%s, connection is not removed from the broken link", pConn->info);
+        break;
+      }
+
+      rpcProcessBrokenLink(pConn, pRecv->chandle);
+      pPrev = pConn;
+    }
     return NULL;
   }
 
@@ -1459,7 +1559,7 @@ static int32_t rpcCompressRpcMsg(char* pCont, int32_t contLen) {
     return contLen;
   }
   
-  char *buf = malloc (contLen + overhead + 8);  // 8 extra bytes
+  char *buf = rpcBufMalloc(contLen + overhead + 8);  // 8 extra bytes
   if (buf == NULL) {
     tError("failed to allocate memory for rpc msg compression, contLen:%d", contLen);
     return contLen;
@@ -1485,7 +1585,7 @@ static int32_t rpcCompressRpcMsg(char* pCont, int32_t contLen) {
     finalLen = contLen;
   }
 
-  free(buf);
+  rpcBufFree(buf);
   return finalLen;
 }
 
@@ -1500,11 +1600,11 @@ static SRpcHead *rpcDecompressRpcMsg(SRpcHead *pHead) {
     assert(pComp->reserved == 0);
     int contLen = htonl(pComp->contLen);
   
-    // prepare the temporary buffer to decompress message
-    char *temp = (char *)malloc(contLen + RPC_MSG_OVERHEAD);
+    // prepare the buffer to decompress message
+    char *temp = rpcBufMalloc(contLen + RPC_MSG_OVERHEAD);
     pNewHead = (SRpcHead *)(temp + sizeof(SRpcReqContext)); // reserve SRpcReqContext
   
-    if (pNewHead) {
+    if (temp) {
       int compLen = rpcContLenFromMsg(pHead->msgLen) - overhead;
       int origLen = LZ4_decompress_safe((char*)(pCont + overhead), (char *)pNewHead->content, compLen, contLen);
       assert(origLen == contLen);
@@ -1647,6 +1747,7 @@ static void rpcDecRef(SRpcInfo *pRpc)
   if (atomic_sub_fetch_32(&pRpc->refCount, 1) == 0) {
     rpcCloseConnCache(pRpc->pCache);
     taosHashCleanup(pRpc->hash);
+    taosHashCleanup(pRpc->linkHash);
     taosTmrCleanUp(pRpc->tmrCtrl);
     taosIdPoolCleanUp(pRpc->idPool);
 
@@ -18,9 +18,22 @@
 #include "tutil.h"
 #include "taosdef.h"
 #include "taoserror.h"
+#include "tglobal.h"
 #include "rpcLog.h"
 #include "rpcHead.h"
 #include "rpcTcp.h"
+#include "rpcBuf.h"
+
+#define RPC_TCP_READ_SIZE (64 * 1024)  // bytes read from a connection at a time
+#define RPC_TCP_MAX_IOV   64           // messages written by one writev at most
+
+typedef struct STcpSendReq {
+  struct STcpSendReq *next;
+  void               *data;
+  int32_t             len;
+  int32_t             ret;   // bytes written, or -1
+  bool                done;
+} STcpSendReq;
 
 typedef struct SFdObj {
   void              *signature;
@@ -29,9 +42,15 @@ typedef struct SFdObj {
   uint32_t           ip;
   uint16_t           port;
   int16_t            closedByApp; // 1: already closed by App
+  int32_t            refCount;    // one by the TCP thread, and one by each connection of upper layer using it
   struct SThreadObj *pThreadObj;
   struct SFdObj     *prev;
   struct SFdObj     *next;
+  pthread_mutex_t    sendMutex;
+  pthread_cond_t     sendCond;
+  STcpSendReq       *pSendHead;   // messages waiting to be written
+  STcpSendReq       *pSendTail;
+  bool               sending;     // a thread is writing the messages taken from the queue
 } SFdObj;
 
 typedef struct SThreadObj {
@@ -46,6 +65,7 @@ typedef struct SThreadObj {
   char            label[TSDB_LABEL_LEN];
   void           *shandle;  // handle passed by upper layer during server initialization
   void           *(*processData)(SRecvInfo *pPacket);
+  char           *rbuf;     // buffer of RPC_TCP_READ_SIZE, messages in it are copied out one by one
 } SThreadObj;
 
 typedef struct {
@@ -71,6 +91,7 @@ typedef struct {
 static void   *taosProcessTcpData(void *param);
 static SFdObj *taosMallocFdObj(SThreadObj *pThreadObj, SOCKET fd);
 static void    taosFreeFdObj(SFdObj *pFdObj);
+static void    taosReleaseFdObj(SFdObj *pFdObj);
 static void    taosReportBrokenLink(SFdObj *pFdObj);
 static void   *taosAcceptTcpConnection(void *arg);
 
@@ -390,8 +411,52 @@ void taosCleanUpTcpClient(void *chandle) {
   tfree(pClientObj);
 }
 
+/*
+ * In multiplexed mode, a connection to the peer is shared by all the rpc connections to it, the messages of them are
+ * told apart by the session IDs in their heads. A connection is shared only if some rpc connection is still using it,
+ * otherwise it may be being closed.
+ */
+static SFdObj *taosAcquireSharedFdObj(SClientObj *pClientObj, uint32_t ip, uint16_t port) {
+  SFdObj *pShared = NULL;
+
+  for (int i = 0; i < pClientObj->numOfThreads && pShared == NULL; ++i) {
+    SThreadObj *pThreadObj = pClientObj->pThreadObj[i];
+    pthread_mutex_lock(&pThreadObj->mutex);
+
+    for (SFdObj *pFdObj = pThreadObj->pHead; pFdObj != NULL; pFdObj = pFdObj->next) {
+      if (pFdObj->ip != ip || pFdObj->port != port || pFdObj->closedByApp) continue;
+
+      int32_t refCount = atomic_load_32(&pFdObj->refCount);
+      while (refCount > 1) {
+        int32_t oldCount = atomic_val_compare_exchange_32(&pFdObj->refCount, refCount, refCount + 1);
+        if (oldCount == refCount) {
+          pShared = pFdObj;
+          break;
+        }
+        refCount = oldCount;
+      }
+
+      if (pShared != NULL) break;
+    }
+
+    pthread_mutex_unlock(&pThreadObj->mutex);
+  }
+
+  return pShared;
+}
+
 void *taosOpenTcpClientConnection(void *shandle, void *thandle, uint32_t ip, uint16_t port) {
   SClientObj *    pClientObj = shandle;
+
+  if (tsRpcMultiplex) {
+    SFdObj *pFdObj = taosAcquireSharedFdObj(pClientObj, ip, port);
+    if (pFdObj != NULL) {
+      tDebug("%s %p TCP connection to 0x%x:%hu is shared, FD:%p refCount:%d", pFdObj->pThreadObj->label, thandle, ip,
+             port, pFdObj, pFdObj->refCount);
+      return pFdObj;
+    }
+  }
+
   int32_t index = atomic_load_32(&pClientObj->index) % pClientObj->numOfThreads;
     atomic_store_32(&pClientObj->index, index + 1);
   SThreadObj *pThreadObj = pClientObj->pThreadObj[index];
@@ -417,6 +482,7 @@ void *taosOpenTcpClientConnection(void *shandle, void *thandle, uint32_t ip, uin
     pFdObj->thandle = thandle;
     pFdObj->port = port;
     pFdObj->ip = ip;
+    atomic_add_fetch_32(&pFdObj->refCount, 1);
     tDebug("%s %p TCP connection to 0x%x:%hu is created, localPort:%hu FD:%p numOfFds:%d",
             pThreadObj->label, thandle, ip, port, localPort, pFdObj, pThreadObj->numOfFds);
   } else {
@@ -427,27 +493,104 @@ void *taosOpenTcpClientConnection(void *shandle, void *thandle, uint32_t ip, uin
   return pFdObj;
 }
 
+// an upper layer connection starts to use the connection, it shall be released by taosCloseTcpConnection
+void taosRefTcpConnection(void *chandle) {
+  SFdObj *pFdObj = chandle;
+  if (pFdObj == NULL) return;
+
+  atomic_add_fetch_32(&pFdObj->refCount, 1);
+}
+
+// the connection is closed when it is not used by the upper layer anymore
 void taosCloseTcpConnection(void *chandle) {
   SFdObj *pFdObj = chandle;
-  if (pFdObj == NULL || pFdObj->signature != pFdObj) return;
+  if (pFdObj == NULL) return;
 
   SThreadObj *pThreadObj = pFdObj->pThreadObj;
-  tDebug("%s %p TCP connection will be closed, FD:%p", pThreadObj->label, pFdObj->thandle, pFdObj);
+  int32_t     refCount = atomic_sub_fetch_32(&pFdObj->refCount, 1);
+
+  if (refCount == 1 && pFdObj->signature == pFdObj) {
+    tDebug("%s %p TCP connection will be closed, FD:%p", pThreadObj->label, pFdObj->thandle, pFdObj);
+
+    // pFdObj->thandle = NULL;
+    pFdObj->closedByApp = 1;
+    shutdown(pFdObj->fd, SHUT_WR);
+  }
+
+  if (refCount == 0) taosReleaseFdObj(pFdObj);
+}
 
-  // pFdObj->thandle = NULL;
-  pFdObj->closedByApp = 1;
-  shutdown(pFdObj->fd, SHUT_WR);
+// write the messages with as few writev as possible, the callers are waiting, so the messages are still there
+static void taosWriteTcpBatch(SFdObj *pFdObj, STcpSendReq *pReq) {
+  struct iovec iov[RPC_TCP_MAX_IOV];
+
+  while (pReq != NULL) {
+    STcpSendReq *pFirst = pReq;
+    int32_t      num = 0;
+    int32_t      total = 0;
+
+    for (; pReq != NULL && num < RPC_TCP_MAX_IOV; pReq = pReq->next, ++num) {
+      iov[num].iov_base = pReq->data;
+      iov[num].iov_len = pReq->len;
+      total += pReq->len;
+    }
+
+    int32_t ret = taosWriteMsgV(pFdObj->fd, iov, num);
+    for (STcpSendReq *p = pFirst; p != pReq; p = p->next) {
+      p->ret = (ret == total) ? p->len : -1;
+    }
+
+    tTrace("%s %p TCP data is sent, FD:%p fd:%d msgs:%d bytes:%d", pFdObj->pThreadObj->label, pFdObj->thandle, pFdObj,
+           pFdObj->fd, num, ret);
+  }
 }
 
+/*
+ * The messages sent at the same time to a connection are queued, and the first sender writes all the ones queued
+ * with writev, so several small messages of the connections sharing it go out in one system call.
+ */
 int taosSendTcpData(uint32_t ip, uint16_t port, void *data, int len, void *chandle) {
   SFdObj *pFdObj = chandle;
   if (pFdObj == NULL || pFdObj->signature != pFdObj) return -1;
-  SThreadObj *pThreadObj = pFdObj->pThreadObj;
 
-  int ret = taosWriteMsg(pFdObj->fd, data, len);
-  tTrace("%s %p TCP data is sent, FD:%p fd:%d bytes:%d", pThreadObj->label, pFdObj->thandle, pFdObj, pFdObj->fd, ret);
+  STcpSendReq req = {.next = NULL, .data = data, .len = len, .ret = -1, .done = false};
 
-  return ret;
+  pthread_mutex_lock(&pFdObj->sendMutex);
+
+  if (pFdObj->pSendTail) {
+    pFdObj->pSendTail->next = &req;
+  } else {
+    pFdObj->pSendHead = &req;
+  }
+  pFdObj->pSendTail = &req;
+
+  while (!req.done) {
+    if (pFdObj->sending) {
+      pthread_cond_wait(&pFdObj->sendCond, &pFdObj->sendMutex);
+      continue;
+    }
+
+    STcpSendReq *pBatch = pFdObj->pSendHead;
+    pFdObj->pSendHead = NULL;
+    pFdObj->pSendTail = NULL;
+    pFdObj->sending = true;
+    pthread_mutex_unlock(&pFdObj->sendMutex);
+
+    taosWriteTcpBatch(pFdObj, pBatch);
+
+    pthread_mutex_lock(&pFdObj->sendMutex);
+    while (pBatch != NULL) {
+      STcpSendReq *pNext = pBatch->next;
+      pBatch->done = true;
+      pBatch = pNext;
+    }
+    pFdObj->sending = false;
+    pthread_cond_broadcast(&pFdObj->sendCond);
+  }
+
+  pthread_mutex_unlock(&pFdObj->sendMutex);
+
+  return req.ret;
 }
 
 static void taosReportBrokenLink(SFdObj *pFdObj) {
@@ -465,7 +608,7 @@ static void taosReportBrokenLink(SFdObj *pFdObj) {
     recvInfo.port = 0;
     recvInfo.shandle = pThreadObj->shandle;
     recvInfo.thandle = pFdObj->thandle;
-    recvInfo.chandle = NULL;
+    recvInfo.chandle = pFdObj;
     recvInfo.connType = RPC_CONN_TCP;
     (*(pThreadObj->processData))(&recvInfo);
   }
@@ -473,54 +616,94 @@ static void taosReportBrokenLink(SFdObj *pFdObj) {
   taosFreeFdObj(pFdObj);
 }
 
-static int taosReadTcpData(SFdObj *pFdObj, SRecvInfo *pInfo) {
-  SRpcHead    rpcHead;
-  int32_t     msgLen, leftLen, retLen, headLen;
-  char       *buffer, *msg;
-
+/*
+ * Messages arrived are read with one read, and copied out of the read buffer one by one. A message that is only partly
+ * in the read buffer is completed by reading the rest of it directly into its own buffer, so a large message is not
+ * copied. It returns -1 if the connection is broken, and 1 if the connection is freed by the upper layer.
+ */
+static int taosReadTcpData(SFdObj *pFdObj) {
   SThreadObj *pThreadObj = pFdObj->pThreadObj;
+  char *      rbuf = pThreadObj->rbuf;
+  SRecvInfo   recvInfo;
 
-  headLen = taosReadMsg(pFdObj->fd, &rpcHead, sizeof(SRpcHead));
-  if (headLen != sizeof(SRpcHead)) {
-    tDebug("%s %p read error, FD:%p headLen:%d", pThreadObj->label, pFdObj->thandle, pFdObj, headLen);
+  int32_t len = (int32_t)taosReadSocket(pFdObj->fd, rbuf, RPC_TCP_READ_SIZE);
+  if (len <= 0) {
+    if (len < 0 && errno == EINTR) return 0;
+    tDebug("%s %p read error, FD:%p len:%d", pThreadObj->label, pFdObj->thandle, pFdObj, len);
     return -1;
   }
 
-  msgLen = (int32_t)htonl((uint32_t)rpcHead.msgLen);
-  int32_t size = msgLen + tsRpcOverhead;
-  buffer = malloc(size);
-  if (NULL == buffer) {
-    tError("%s %p TCP malloc(size:%d) fail", pThreadObj->label, pFdObj->thandle, msgLen);
-    return -1;
-  } else {
-    tTrace("%s %p read data, FD:%p fd:%d TCP malloc mem:%p", pThreadObj->label, pFdObj->thandle, pFdObj, pFdObj->fd, buffer);
-  }
+  int32_t pos = 0;
+  while (pos < len) {
+    SRpcHead rpcHead;
+    int32_t  headLen = MIN(len - pos, (int32_t)sizeof(SRpcHead));
+
+    memcpy(&rpcHead, rbuf + pos, headLen);
+    pos += headLen;
+    if (headLen < sizeof(SRpcHead) &&
+        taosReadMsg(pFdObj->fd, (char *)&rpcHead + headLen, sizeof(SRpcHead) - headLen) != sizeof(SRpcHead) - headLen) {
+      tDebug("%s %p read error, FD:%p headLen:%d", pThreadObj->label, pFdObj->thandle, pFdObj, headLen);
+      return -1;
+    }
 
-  msg = buffer + tsRpcOverhead;
-  leftLen = msgLen - headLen;
-  retLen = taosReadMsg(pFdObj->fd, msg + headLen, leftLen);
+    int32_t msgLen = (int32_t)htonl((uint32_t)rpcHead.msgLen);
+    if (msgLen < (int32_t)sizeof(SRpcHead)) {
+      tError("%s %p invalid msgLen:%d, FD:%p", pThreadObj->label, pFdObj->thandle, msgLen, pFdObj);
+      return -1;
+    }
 
-  if (leftLen != retLen) {
-    tError("%s %p read error, leftLen:%d retLen:%d FD:%p",
-            pThreadObj->label, pFdObj->thandle, leftLen, retLen, pFdObj);
-    free(buffer);
-    return -1;
-  }
+    char *buffer = rpcBufMalloc(msgLen + tsRpcOverhead);
+    if (NULL == buffer) {
+      tError("%s %p TCP malloc(size:%d) fail", pThreadObj->label, pFdObj->thandle, msgLen);
+      return -1;
+    } else {
+      tTrace("%s %p read data, FD:%p fd:%d TCP malloc mem:%p", pThreadObj->label, pFdObj->thandle, pFdObj, pFdObj->fd,
+             buffer);
+    }
 
-  memcpy(msg, &rpcHead, sizeof(SRpcHead));
+    char *  msg = buffer + tsRpcOverhead;
+    int32_t bodyLen = msgLen - (int32_t)sizeof(SRpcHead);
+    int32_t copyLen = MIN(len - pos, bodyLen);
+
+    memcpy(msg, &rpcHead, sizeof(SRpcHead));
+    memcpy(msg + sizeof(SRpcHead), rbuf + pos, copyLen);
+    pos += copyLen;
+    rpcBufAddCopied(sizeof(SRpcHead) + copyLen);
+
+    int32_t leftLen = bodyLen - copyLen;
+    if (leftLen > 0) {
+      int32_t retLen = taosReadMsg(pFdObj->fd, msg + msgLen - leftLen, leftLen);
+      if (leftLen != retLen) {
+        tError("%s %p read error, leftLen:%d retLen:%d FD:%p", pThreadObj->label, pFdObj->thandle, leftLen, retLen,
+               pFdObj);
+        rpcBufFree(buffer);
+        return -1;
+      }
+      rpcBufAddDirect(leftLen);
+    }
 
-  pInfo->msg = msg;
-  pInfo->msgLen = msgLen;
-  pInfo->ip = pFdObj->ip;
-  pInfo->port = pFdObj->port;
-  pInfo->shandle = pThreadObj->shandle;
-  pInfo->thandle = pFdObj->thandle;
-  pInfo->chandle = pFdObj;
-  pInfo->connType = RPC_CONN_TCP;
+    if (pFdObj->closedByApp) {
+      rpcBufFree(buffer);
+      return -1;
+    }
 
-  if (pFdObj->closedByApp) {
-    free(buffer);
-    return -1;
+    recvInfo.msg = msg;
+    recvInfo.msgLen = msgLen;
+    recvInfo.ip = pFdObj->ip;
+    recvInfo.port = pFdObj->port;
+    recvInfo.shandle = pThreadObj->shandle;
+    recvInfo.thandle = pFdObj->thandle;
+    recvInfo.chandle = pFdObj;
+    recvInfo.connType = RPC_CONN_TCP;
+
+    void *thandle = (*(pThreadObj->processData))(&recvInfo);
+    if (thandle != NULL) {
+      pFdObj->thandle = thandle;
+    } else if (atomic_load_32(&pFdObj->refCount) <= 1) {
+      // no connection of upper layer uses it
+      taosFreeFdObj(pFdObj);
+      return 1;
+    }
   }
 
   return 0;
@@ -532,12 +715,17 @@ static void *taosProcessTcpData(void *param) {
   SThreadObj        *pThreadObj = param;
   SFdObj            *pFdObj;
   struct epoll_event events[maxEvents];
-  SRecvInfo          recvInfo;
 
   char name[16] = {0};
   snprintf(name, tListLen(name), "%s-tcp", pThreadObj->label);
   setThreadName(name);
 
+  pThreadObj->rbuf = malloc(RPC_TCP_READ_SIZE);
+  if (pThreadObj->rbuf == NULL) {
+    tError("%s failed to malloc TCP read buffer, TCP thread exits", pThreadObj->label);
+    pThreadObj->stop = true;
+  }
+
   while (1) {
     int fdNum = epoll_wait(pThreadObj->pollFd, events, maxEvents, TAOS_EPOLL_WAIT_TIME);
     if (pThreadObj->stop) {
@@ -567,13 +755,10 @@ static void *taosProcessTcpData(void *param) {
         continue;
       }
 
-      if (taosReadTcpData(pFdObj, &recvInfo) < 0) {
+      if (taosReadTcpData(pFdObj) < 0) {
         shutdown(pFdObj->fd, SHUT_WR);
         continue;
       }
-
-      pFdObj->thandle = (*(pThreadObj->processData))(&recvInfo);
-      if (pFdObj->thandle == NULL) taosFreeFdObj(pFdObj);
     }
 
     if (pThreadObj->stop) break;
@@ -592,6 +777,7 @@ static void *taosProcessTcpData(void *param) {
 
   pthread_mutex_destroy(&(pThreadObj->mutex));
   tDebug("%s TCP thread exits ...", pThreadObj->label);
+  tfree(pThreadObj->rbuf);
   tfree(pThreadObj);
 
   return NULL;
@@ -608,12 +794,15 @@ static SFdObj *taosMallocFdObj(SThreadObj *pThreadObj, SOCKET fd) {
   pFdObj->closedByApp = 0;
   pFdObj->fd = fd;
   pFdObj->pThreadObj = pThreadObj;
+  pFdObj->refCount = 1;
   pFdObj->signature = pFdObj;
+  pthread_mutex_init(&pFdObj->sendMutex, NULL);
+  pthread_cond_init(&pFdObj->sendCond, NULL);
 
   event.events = EPOLLIN | EPOLLRDHUP;
   event.data.ptr = pFdObj;
   if (epoll_ctl(pThreadObj->pollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
-    tfree(pFdObj);
+    taosReleaseFdObj(pFdObj);
     terrno = TAOS_SYSTEM_ERROR(errno);
     return NULL;
   }
@@ -666,5 +855,12 @@ static void taosFreeFdObj(SFdObj *pFdObj) {
   tDebug("%s %p TCP connection is closed, FD:%p fd:%d numOfFds:%d",
           pThreadObj->label, pFdObj->thandle, pFdObj, pFdObj->fd, pThreadObj->numOfFds);
 
+  // it is freed after all the connections of upper layer release it
+  if (atomic_sub_fetch_32(&pFdObj->refCount, 1) == 0) taosReleaseFdObj(pFdObj);
+}
+
+static void taosReleaseFdObj(SFdObj *pFdObj) {
+  pthread_mutex_destroy(&pFdObj->sendMutex);
+  pthread_cond_destroy(&pFdObj->sendCond);
   tfree(pFdObj);
 }
@@ -21,6 +21,7 @@
 #include "taoserror.h"
 #include "rpcLog.h"
 #include "rpcUdp.h"
+#include "rpcBuf.h"
 #include "rpcHead.h"
 
 #define RPC_MAX_UDP_CONNS 256
@@ -219,7 +220,7 @@ static void *taosRecvUdpData(void *param) {
     }
 
     int32_t size = dataLen + tsRpcOverhead;
-    char *tmsg = malloc(size);
+    char *tmsg = rpcBufMalloc(size);
     if (NULL == tmsg) {
       tError("%s failed to allocate memory, size:%" PRId64, pConn->label, (int64_t)dataLen);
       continue;
@@ -229,6 +230,7 @@ static void *taosRecvUdpData(void *param) {
 
     tmsg += tsRpcOverhead;  // overhead for SRpcReqContext
     memcpy(tmsg, msg, dataLen);
+    rpcBufAddCopied(dataLen);
     recvInfo.msg = tmsg;
     recvInfo.msgLen = dataLen;
     recvInfo.ip = sourceAdd.sin_addr.s_addr;
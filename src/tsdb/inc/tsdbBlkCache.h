@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _TD_TSDB_BLK_CACHE_H_
+#define _TD_TSDB_BLK_CACHE_H_
+
+// Dnode-wide LRU cache of decompressed column chunks loaded from .data/.last files. The file magic is part of the
+// key, so an entry can never be served for a file whose content changed after the entry was built.
+typedef struct {
+  int32_t  vgId;
+  int32_t  fid;
+  uint32_t magic;   // magic of the SDFile the column is read from
+  int16_t  colId;
+  int8_t   ftype;   // TSDB_FILE_DATA or TSDB_FILE_LAST
+  int8_t   reserved;
+  int64_t  offset;  // offset of the column data in the file
+} SBlkCacheKey;
+
+static FORCE_INLINE void tsdbInitBlkCacheKey(SBlkCacheKey *pKey, int32_t vgId, SDFileSet *pSet, TSDB_FILE_T ftype,
+                                             int16_t colId, int64_t offset) {
+  memset(pKey, 0, sizeof(*pKey));
+  pKey->vgId = vgId;
+  pKey->fid = TSDB_FSET_FID(pSet);
+  pKey->magic = TSDB_DFILE_IN_SET(pSet, ftype)->info.magic;
+  pKey->colId = colId;
+  pKey->ftype = (int8_t)ftype;
+  pKey->offset = offset;
+}
+
+bool tsdbBlkCacheEnabled();
+bool tsdbBlkCacheGet(const SBlkCacheKey *pKey, SDataCol *pDataCol, int numOfRows, int maxPoints);
+void tsdbBlkCachePut(const SBlkCacheKey *pKey, const SDataCol *pDataCol, int numOfRows);
+void tsdbBlkCacheInvalidate(int32_t vgId, int32_t fid);
+
+#endif /* _TD_TSDB_BLK_CACHE_H_ */
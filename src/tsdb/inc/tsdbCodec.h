@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _TD_TSDB_CODEC_H_
+#define _TD_TSDB_CODEC_H_
+
+/*
+ * Column codec recorded in SBlockCol.codec. The low 4 bits select the first stage which encodes the values, the high
+ * 4 bits select the second stage which compresses the encoded bytes when the block is TWO_STAGE_COMP. Blocks written
+ * before the codecs were introduced have 0 there, which is the encoding of tDataTypes followed by LZ4.
+ */
+#define TSDB_COL_CODEC_DEFAULT 0  // simple8b, delta-of-delta, XOR or LZ4 for strings, by type
+#define TSDB_COL_CODEC_BITPACK 1  // frame of reference with bit packing, integer types
+#define TSDB_COL_CODEC_DICT 2     // dictionary with one byte indices, binary and nchar types
+
+#define TSDB_COL_STAGE2_LZ4 0
+#define TSDB_COL_STAGE2_ZLIB 1
+
+#define TSDB_COL_CODEC(s1, s2) ((uint8_t)(((s2) << 4) | (s1)))
+#define TSDB_COL_CODEC_STAGE1(c) ((c)&0xF)
+#define TSDB_COL_CODEC_STAGE2(c) (((c) >> 4) & 0xF)
+
+int tsdbEncodeColData(SDataCol *pDataCol, int numOfRows, int8_t comp, char *output, int outputSize, char *buffer,
+                      int bufferSize, uint8_t *pCodec);
+int tsdbDecodeColData(SDataCol *pDataCol, const char *input, int len, int numOfRows, int8_t comp, uint8_t codec,
+                      char *buffer, int bufferSize);
+
+#endif /* _TD_TSDB_CODEC_H_ */
@@ -16,8 +16,12 @@
 #ifndef _TD_TSDB_COMMIT_QUEUE_H_
 #define _TD_TSDB_COMMIT_QUEUE_H_
 
-typedef enum { COMMIT_REQ, COMPACT_REQ,COMMIT_CONFIG_REQ } TSDB_REQ_T;
+typedef enum { COMMIT_REQ, COMPACT_REQ,COMMIT_CONFIG_REQ, COMMIT_TASK_REQ } TSDB_REQ_T;
 
-int tsdbScheduleCommit(STsdbRepo *pRepo, TSDB_REQ_T req);
+typedef void (*__tsdb_commit_task_fn_t)(void *param, int idx);
+
+int  tsdbScheduleCommit(STsdbRepo *pRepo, TSDB_REQ_T req);
+int  tsdbGetCommitThreads();
+void tsdbRunCommitTasks(int numOfTasks, __tsdb_commit_task_fn_t fp, void *param);
 
 #endif /* _TD_TSDB_COMMIT_QUEUE_H_ */
\ No newline at end of file
@@ -72,6 +72,9 @@ typedef struct {
   SHashObj*  metaCacheComp;   // meta cache for compact
   bool       intxn;
   SFSStatus* nstatus;  // new status
+
+  pthread_mutex_t idxLock;
+  SArray*         aHeadIdx;  // SHeadIdx cache slot of each current file set, sorted by fid
 } STsdbFS;
 
 #define FS_CURRENT_STATUS(pfs) ((pfs)->cstatus)
@@ -108,6 +111,11 @@ void       tsdbFSIterSeek(SFSIter *pIter, int fid);
 SDFileSet *tsdbFSIterNext(SFSIter *pIter);
 int        tsdbLoadMetaCache(STsdbRepo *pRepo, bool recoverMeta);
 
+// head file index cache, implemented in tsdbReadImpl.c
+int  tsdbInitHeadIdxCache(STsdbFS *pfs);
+void tsdbDestroyHeadIdxCache(STsdbFS *pfs);
+void tsdbRefreshHeadIdxCache(STsdbFS *pfs);
+
 static FORCE_INLINE int tsdbRLockFS(STsdbFS* pFs) {
   int code = pthread_rwlock_rdlock(&(pFs->lock));
   if (code != 0) {
@@ -286,6 +286,11 @@ static FORCE_INLINE int64_t tsdbReadDFile(SDFile* pDFile, void* buf, int64_t nby
   return nread;
 }
 
+static FORCE_INLINE void tsdbAdviseDFile(SDFile* pDFile, int64_t offset, int64_t len) {
+  ASSERT(TSDB_FILE_OPENED(pDFile));
+  (void)taosFadviseWillNeed(TSDB_FILE_FD(pDFile), offset, len);
+}
+
 static FORCE_INLINE int tsdbCopyDFile(SDFile* pSrc, SDFile* pDest) {
   if (tfscopy(TSDB_FILE_F(pSrc), TSDB_FILE_F(pDest)) < 0) {
     terrno = TAOS_SYSTEM_ERROR(errno);
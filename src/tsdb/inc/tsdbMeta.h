@@ -28,6 +28,7 @@ typedef struct STable {
   STSchema*      tagSchema;
   SKVRow         tagVal;
   SSkipList*     pIndex;         // For TSDB_SUPER_TABLE, it is the skiplist index
+  SArray*        pTagIndex;      // For TSDB_SUPER_TABLE, SArray<STagIndex*> secondary tag indexes built on demand
   void*          eventHandler;   // TODO
   void*          streamHandler;  // TODO
   TSKEY          lastKey;
@@ -45,6 +46,19 @@ typedef struct STable {
   T_REF_DECLARE()
 } STable;
 
+// element of a secondary tag index, the key is the value of tag colId of pTable
+typedef struct {
+  STable* pTable;
+  int16_t colId;
+  int8_t  type;
+} STagIndexElem;
+
+typedef struct {
+  int16_t    colId;
+  int8_t     type;
+  SSkipList* pList;  // SSkipList<STagIndexElem*>, binary values are ordered case-insensitively
+} STagIndex;
+
 typedef struct {
   pthread_rwlock_t rwLock;
 
@@ -89,6 +103,7 @@ int16_t    tsdbGetLastColumnsIndexByColId(STable* pTable, int16_t colId);
 int        tsdbUpdateLastColSchema(STable *pTable, STSchema *pNewSchema);
 STSchema*  tsdbGetTableLatestSchema(STable *pTable);
 void       tsdbFreeLastColumns(STable* pTable);
+STagIndex* tsdbGetTagIndex(STable* pSTable, int16_t colId);
 
 static FORCE_INLINE int tsdbCompareSchemaVersion(const void *key1, const void *key2) {
   if (*(int16_t *)key1 < schemaVersion(*(STSchema **)key2)) {
@@ -120,7 +120,7 @@ typedef struct {
 typedef struct {
   int16_t  colId;
   uint8_t  offsetH;
-  uint8_t  reserved;  // reserved field, not used
+  uint8_t  codec;     // column codec of tsdbCodec.h, 0 for blocks written before codecs
   int32_t  len;
   uint32_t type : 8;
   uint32_t offset : 24;
@@ -161,13 +161,22 @@ typedef struct {
 
 typedef void SAggrBlkData;  // SBlockCol cols[];
 
+// Decoded SBlockIdx part of a head file. It never changes once built, so the index of a current file set is shared
+// by all the readers through the cache of STsdbFS and searched in place.
+typedef struct {
+  T_REF_DECLARE()
+  int32_t   fid;
+  SDFInfo   info;       // info of the head file the index is decoded from
+  int32_t   numOfIdx;
+  SBlockIdx aBlkIdx[];  // sorted by tid
+} SHeadIdx;
+
 struct SReadH {
   STsdbRepo * pRepo;
-  SDFileSet   rSet;     // FSET to read
-  SArray *    aBlkIdx;  // SBlockIdx array
-  STable *    pTable;   // table to read
-  SBlockIdx * pBlkIdx;  // current reading table SBlockIdx
-  int         cidx;
+  SDFileSet   rSet;      // FSET to read
+  SHeadIdx *  pHeadIdx;  // SBlockIdx of the FSET, NULL if the head file is empty
+  STable *    pTable;    // table to read
+  SBlockIdx * pBlkIdx;   // current reading table SBlockIdx
   SBlockInfo *  pBlkInfo;  // SBlockInfoV#
   SBlockData *pBlkData;  // Block info
   SAggrBlkData *pAggrBlkData;  // Aggregate Block info
@@ -230,6 +239,7 @@ int   tsdbLoadBlockOffset(SReadH *pReadh, SBlock *pBlock);
 int   tsdbEncodeSBlockIdx(void **buf, SBlockIdx *pIdx);
 void *tsdbDecodeSBlockIdx(void *buf, SBlockIdx *pIdx);
 void  tsdbGetBlockStatis(SReadH *pReadh, SDataStatis *pStatis, int numOfCols, SBlock *pBlock);
+void  tsdbGetHeadIdxStat(int64_t *numOfIdx, int64_t *used);
 
 static FORCE_INLINE int tsdbMakeRoom(void **ppBuf, size_t size) {
   void * pBuf = *ppBuf;
@@ -265,6 +275,7 @@ static FORCE_INLINE SBlockCol *tsdbGetSBlockCol(SBlock *pBlock, SBlockCol **pDes
     (*pDestBlkCol)->type = pBlkCol->type;
     (*pDestBlkCol)->offset = pBlkCol->offset;
     (*pDestBlkCol)->offsetH = pBlkCol->offsetH;
+    (*pDestBlkCol)->codec = 0;
   }
   return *pDestBlkCol;
 }
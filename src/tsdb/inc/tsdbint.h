@@ -62,6 +62,10 @@ extern "C" {
 #include "tsdbFS.h"
 // ReadImpl
 #include "tsdbReadImpl.h"
+// Column codecs
+#include "tsdbCodec.h"
+// Block Cache
+#include "tsdbBlkCache.h"
 // Commit
 #include "tsdbCommit.h"
 // Compact
@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tsdbint.h"
+
+typedef struct SBlkCacheEntry {
+  SBlkCacheKey           key;
+  struct SBlkCacheEntry *prev;
+  struct SBlkCacheEntry *next;
+  int32_t                numOfRows;
+  int32_t                len;
+  char                   data[];
+} SBlkCacheEntry;
+
+typedef struct {
+  bool            inited;
+  pthread_mutex_t lock;
+  SHashObj *      pHash;  // SBlkCacheKey -> SBlkCacheEntry *
+  SBlkCacheEntry *head;   // most recently used
+  SBlkCacheEntry *tail;   // least recently used
+  int64_t         capacity;
+  int64_t         used;
+  int64_t         nEntries;
+  int64_t         hits;
+  int64_t         misses;
+  int64_t         evicts;
+} SBlkCache;
+
+#define TSDB_BLK_CACHE_ENTRY_SIZE(len) ((int64_t)sizeof(SBlkCacheEntry) + (len))
+
+static SBlkCache tsBlkCache = {0};
+
+static void tsdbBlkCacheUnlink(SBlkCache *pCache, SBlkCacheEntry *pEntry);
+static void tsdbBlkCacheLinkHead(SBlkCache *pCache, SBlkCacheEntry *pEntry);
+static void tsdbBlkCacheRemoveEntry(SBlkCache *pCache, SBlkCacheEntry *pEntry);
+
+int tsdbInitBlkCache() {
+  SBlkCache *pCache = &tsBlkCache;
+
+  memset(pCache, 0, sizeof(*pCache));
+  if (tsdbBlkCacheSize <= 0) {
+    tsdbInfo("tsdb block cache is disabled");
+    return 0;
+  }
+
+  pCache->pHash = taosHashInit(4096, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), true, HASH_NO_LOCK);
+  if (pCache->pHash == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  pthread_mutex_init(&(pCache->lock), NULL);
+  pCache->capacity = (int64_t)tsdbBlkCacheSize * 1024 * 1024;
+  pCache->inited = true;
+
+  tsdbInfo("tsdb block cache is initialized, capacity:%" PRId64 " bytes", pCache->capacity);
+  return 0;
+}
+
+void tsdbDestroyBlkCache() {
+  SBlkCache *pCache = &tsBlkCache;
+  if (!pCache->inited) return;
+
+  pthread_mutex_lock(&(pCache->lock));
+  pCache->inited = false;
+  while (pCache->head) {
+    tsdbBlkCacheRemoveEntry(pCache, pCache->head);
+  }
+  taosHashCleanup(pCache->pHash);
+  pCache->pHash = NULL;
+  pthread_mutex_unlock(&(pCache->lock));
+
+  pthread_mutex_destroy(&(pCache->lock));
+}
+
+bool tsdbBlkCacheEnabled() { return tsBlkCache.inited; }
+
+bool tsdbBlkCacheGet(const SBlkCacheKey *pKey, SDataCol *pDataCol, int numOfRows, int maxPoints) {
+  SBlkCache *pCache = &tsBlkCache;
+  if (!pCache->inited) return false;
+
+  if (tdAllocMemForCol(pDataCol, maxPoints) < 0) return false;
+
+  pthread_mutex_lock(&(pCache->lock));
+
+  SBlkCacheEntry **ppEntry = taosHashGet(pCache->pHash, pKey, sizeof(*pKey));
+  if (ppEntry == NULL || (*ppEntry)->numOfRows != numOfRows || (*ppEntry)->len > pDataCol->spaceSize) {
+    pCache->misses++;
+    pthread_mutex_unlock(&(pCache->lock));
+    return false;
+  }
+
+  SBlkCacheEntry *pEntry = *ppEntry;
+  tsdbBlkCacheUnlink(pCache, pEntry);
+  tsdbBlkCacheLinkHead(pCache, pEntry);
+  pCache->hits++;
+
+  // Copy out under the lock so the entry may be evicted as soon as we release it
+  memcpy(pDataCol->pData, pEntry->data, pEntry->len);
+  pDataCol->len = pEntry->len;
+
+  pthread_mutex_unlock(&(pCache->lock));
+
+  if (IS_VAR_DATA_TYPE(pDataCol->type)) {
+    dataColSetOffset(pDataCol, numOfRows);
+  }
+
+  return true;
+}
+
+void tsdbBlkCachePut(const SBlkCacheKey *pKey, const SDataCol *pDataCol, int numOfRows) {
+  SBlkCache *pCache = &tsBlkCache;
+  if (!pCache->inited) return;
+
+  int64_t esize = TSDB_BLK_CACHE_ENTRY_SIZE(pDataCol->len);
+  if (esize > pCache->capacity / 8) return;  // do not let one huge column flush the whole cache
+
+  SBlkCacheEntry *pEntry = malloc((size_t)esize);
+  if (pEntry == NULL) return;
+
+  pEntry->key = *pKey;
+  pEntry->prev = NULL;
+  pEntry->next = NULL;
+  pEntry->numOfRows = numOfRows;
+  pEntry->len = pDataCol->len;
+  memcpy(pEntry->data, pDataCol->pData, pDataCol->len);
+
+  pthread_mutex_lock(&(pCache->lock));
+
+  if (taosHashGet(pCache->pHash, pKey, sizeof(*pKey)) != NULL) {
+    // Another reader loaded the same column concurrently
+    pthread_mutex_unlock(&(pCache->lock));
+    free(pEntry);
+    return;
+  }
+
+  while (pCache->tail != NULL && pCache->used + esize > pCache->capacity) {
+    tsdbBlkCacheRemoveEntry(pCache, pCache->tail);
+    pCache->evicts++;
+  }
+
+  if (taosHashPut(pCache->pHash, pKey, sizeof(*pKey), &pEntry, sizeof(pEntry)) < 0) {
+    pthread_mutex_unlock(&(pCache->lock));
+    free(pEntry);
+    return;
+  }
+
+  tsdbBlkCacheLinkHead(pCache, pEntry);
+  pCache->used += esize;
+  pCache->nEntries++;
+
+  pthread_mutex_unlock(&(pCache->lock));
+}
+
+// Drop all the entries of a file set (or of the whole vnode if fid is TSDB_IVLD_FID). Entries of retired files can
+// never be hit again since the file magic is part of the key, this only gives the memory back early.
+void tsdbBlkCacheInvalidate(int32_t vgId, int32_t fid) {
+  SBlkCache *pCache = &tsBlkCache;
+  if (!pCache->inited) return;
+
+  int64_t nDropped = 0;
+
+  pthread_mutex_lock(&(pCache->lock));
+  SBlkCacheEntry *pEntry = pCache->head;
+  while (pEntry) {
+    SBlkCacheEntry *pNext = pEntry->next;
+    if (pEntry->key.vgId == vgId && (fid == TSDB_IVLD_FID || pEntry->key.fid == fid)) {
+      tsdbBlkCacheRemoveEntry(pCache, pEntry);
+      nDropped++;
+    }
+    pEntry = pNext;
+  }
+  pthread_mutex_unlock(&(pCache->lock));
+
+  if (nDropped > 0) {
+    tsdbDebug("vgId:%d fid:%d %" PRId64 " entries are dropped from block cache", vgId, fid, nDropped);
+  }
+}
+
+void tsdbGetBlkCacheStat(STsdbBlkCacheStat *pStat) {
+  SBlkCache *pCache = &tsBlkCache;
+
+  memset(pStat, 0, sizeof(*pStat));
+  tsdbGetHeadIdxStat(&(pStat->numOfHeadIdx), &(pStat->headIdxUsed));
+  if (!pCache->inited) return;
+
+  pthread_mutex_lock(&(pCache->lock));
+  pStat->capacity = pCache->capacity;
+  pStat->used = pCache->used;
+  pStat->numOfEntries = pCache->nEntries;
+  pStat->hits = pCache->hits;
+  pStat->misses = pCache->misses;
+  pStat->evicts = pCache->evicts;
+  pthread_mutex_unlock(&(pCache->lock));
+}
+
+static void tsdbBlkCacheUnlink(SBlkCache *pCache, SBlkCacheEntry *pEntry) {
+  if (pEntry->prev) {
+    pEntry->prev->next = pEntry->next;
+  } else {
+    pCache->head = pEntry->next;
+  }
+
+  if (pEntry->next) {
+    pEntry->next->prev = pEntry->prev;
+  } else {
+    pCache->tail = pEntry->prev;
+  }
+
+  pEntry->prev = NULL;
+  pEntry->next = NULL;
+}
+
+static void tsdbBlkCacheLinkHead(SBlkCache *pCache, SBlkCacheEntry *pEntry) {
+  pEntry->prev = NULL;
+  pEntry->next = pCache->head;
+  if (pCache->head) {
+    pCache->head->prev = pEntry;
+  } else {
+    pCache->tail = pEntry;
+  }
+  pCache->head = pEntry;
+}
+
+static void tsdbBlkCacheRemoveEntry(SBlkCache *pCache, SBlkCacheEntry *pEntry) {
+  tsdbBlkCacheUnlink(pCache, pEntry);
+  taosHashRemove(pCache->pHash, &(pEntry->key), sizeof(pEntry->key));
+  pCache->used -= TSDB_BLK_CACHE_ENTRY_SIZE(pEntry->len);
+  pCache->nEntries--;
+  free(pEntry);
+}
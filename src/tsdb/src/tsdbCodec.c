@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tsdbint.h"
+#include "tglobal.h"
+
+typedef struct {
+  uint8_t     id;
+  const char *name;
+  bool (*support)(int8_t type);
+  int (*encode)(const char *input, int inputSize, int nelements, int8_t type, char *output, int outputSize);
+  int (*decode)(const char *input, int inputSize, int nelements, int8_t type, char *output, int outputSize);
+} STsdbColCodec;
+
+static bool tsdbBitPackSupport(int8_t type);
+static int  tsdbBitPackEncode(const char *input, int inputSize, int nelements, int8_t type, char *output, int outputSize);
+static int  tsdbBitPackDecode(const char *input, int inputSize, int nelements, int8_t type, char *output, int outputSize);
+static bool tsdbDictSupport(int8_t type);
+static int  tsdbDictEncode(const char *input, int inputSize, int nelements, int8_t type, char *output, int outputSize);
+static int  tsdbDictDecode(const char *input, int inputSize, int nelements, int8_t type, char *output, int outputSize);
+static int  tsdbStage2Encode(uint8_t stage2, const char *input, int inputSize, char *output, int outputSize);
+static int  tsdbStage2Decode(uint8_t stage2, const char *input, int inputSize, char *output, int outputSize);
+
+// indexed by codec id, the default codec is handled by tDataTypes
+static STsdbColCodec tsdbColCodecs[] = {
+    {TSDB_COL_CODEC_DEFAULT, "default", NULL, NULL, NULL},
+    {TSDB_COL_CODEC_BITPACK, "bitpack", tsdbBitPackSupport, tsdbBitPackEncode, tsdbBitPackDecode},
+    {TSDB_COL_CODEC_DICT, "dict", tsdbDictSupport, tsdbDictEncode, tsdbDictDecode},
+};
+
+static const STsdbColCodec *tsdbGetColCodec(uint8_t id) {
+  if (id == TSDB_COL_CODEC_DEFAULT || id >= tListLen(tsdbColCodecs)) return NULL;
+  return &tsdbColCodecs[id];
+}
+
+// the codec tried against the default one for a type when columnCodec is enabled
+static const STsdbColCodec *tsdbGetColCodecForType(int8_t type) {
+  for (int i = 0; i < tListLen(tsdbColCodecs); i++) {
+    if (tsdbColCodecs[i].support && (*tsdbColCodecs[i].support)(type)) return &tsdbColCodecs[i];
+  }
+  return NULL;
+}
+
+/*
+ * Encode the column data into output, and return the encoded length or -1 on failure. pCodec is set to the codec
+ * used, which is 0 whenever the output is exactly what tDataTypes produces, so the file stays readable by older
+ * versions unless another codec is really picked.
+ */
+int tsdbEncodeColData(SDataCol *pDataCol, int numOfRows, int8_t comp, char *output, int outputSize, char *buffer,
+                      int bufferSize, uint8_t *pCodec) {
+  int8_t               type = pDataCol->type;
+  const char *         input = (const char *)pDataCol->pData;
+  int                  tlen = dataColGetNEleLen(pDataCol, numOfRows);
+  uint8_t              stage1 = TSDB_COL_CODEC_DEFAULT;
+  uint8_t              stage2 = (comp == TWO_STAGE_COMP) ? (uint8_t)tsdbSecondStageCodec : TSDB_COL_STAGE2_LZ4;
+  const STsdbColCodec *pColCodec = tsdbColumnCodec ? tsdbGetColCodecForType(type) : NULL;
+
+  *pCodec = TSDB_COL_CODEC(TSDB_COL_CODEC_DEFAULT, TSDB_COL_STAGE2_LZ4);
+
+  if (pColCodec == NULL && stage2 == TSDB_COL_STAGE2_LZ4) {
+    return (*(tDataTypes[type].compFunc))(input, tlen, numOfRows, output, outputSize, comp, buffer, bufferSize);
+  }
+
+  if (comp == ONE_STAGE_COMP) {
+    int flen = (*(tDataTypes[type].compFunc))(input, tlen, numOfRows, output, outputSize, comp, NULL, 0);
+    int clen = (*pColCodec->encode)(input, tlen, numOfRows, type, buffer, bufferSize);
+    if (clen > 0 && clen < flen) {
+      memcpy(output, buffer, clen);
+      *pCodec = TSDB_COL_CODEC(pColCodec->id, TSDB_COL_STAGE2_LZ4);
+      return clen;
+    }
+    return flen;
+  }
+
+  // The first stage of strings is the raw data, and LZ4 is their default compression
+  const char *src = input;
+  int         slen = tlen;
+  if (!IS_VAR_DATA_TYPE(type)) {
+    slen = (*(tDataTypes[type].compFunc))(input, tlen, numOfRows, buffer, bufferSize, ONE_STAGE_COMP, NULL, 0);
+    src = buffer;
+  }
+
+  // output is free before the second stage, use it to try the codec
+  if (pColCodec != NULL) {
+    int clen = (*pColCodec->encode)(input, tlen, numOfRows, type, output, outputSize);
+    if (clen > 0 && clen < slen && clen <= bufferSize) {
+      memcpy(buffer, output, clen);
+      src = buffer;
+      slen = clen;
+      stage1 = pColCodec->id;
+    }
+  }
+
+  int flen = tsdbStage2Encode(stage2, src, slen, output, outputSize);
+  if (flen < 0) return -1;
+
+  *pCodec = TSDB_COL_CODEC(stage1, stage2);
+  return flen;
+}
+
+/*
+ * Decode the column data into pDataCol->pData, and return the decoded length or -1 on failure.
+ */
+int tsdbDecodeColData(SDataCol *pDataCol, const char *input, int len, int numOfRows, int8_t comp, uint8_t codec,
+                      char *buffer, int bufferSize) {
+  int8_t               type = pDataCol->type;
+  char *               output = (char *)pDataCol->pData;
+  int                  outputSize = pDataCol->spaceSize;
+  uint8_t              stage1 = TSDB_COL_CODEC_STAGE1(codec);
+  uint8_t              stage2 = TSDB_COL_CODEC_STAGE2(codec);
+  const STsdbColCodec *pColCodec = tsdbGetColCodec(stage1);
+
+  if (codec == TSDB_COL_CODEC(TSDB_COL_CODEC_DEFAULT, TSDB_COL_STAGE2_LZ4)) {
+    return (*(tDataTypes[type].decompFunc))(input, len, numOfRows, output, outputSize, comp, buffer, bufferSize);
+  }
+
+  if ((stage1 != TSDB_COL_CODEC_DEFAULT && (pColCodec == NULL || !(*pColCodec->support)(type))) ||
+      stage2 > TSDB_COL_STAGE2_ZLIB) {
+    tsdbError("unknown column codec 0x%x for type %d", codec, type);
+    return -1;
+  }
+
+  if (comp == ONE_STAGE_COMP) {
+    if (pColCodec == NULL) return -1;
+    return (*pColCodec->decode)(input, len, numOfRows, type, output, outputSize);
+  }
+
+  if (stage1 == TSDB_COL_CODEC_DEFAULT && IS_VAR_DATA_TYPE(type)) {
+    return tsdbStage2Decode(stage2, input, len, output, outputSize);
+  }
+
+  int slen = tsdbStage2Decode(stage2, input, len, buffer, bufferSize);
+  if (slen < 0) return -1;
+
+  if (stage1 == TSDB_COL_CODEC_DEFAULT) {
+    return (*(tDataTypes[type].decompFunc))(buffer, slen, numOfRows, output, outputSize, ONE_STAGE_COMP, NULL, 0);
+  }
+
+  return (*pColCodec->decode)(buffer, slen, numOfRows, type, output, outputSize);
+}
+
+static bool tsdbBitPackSupport(int8_t type) {
+  return IS_SIGNED_NUMERIC_TYPE(type) || IS_UNSIGNED_NUMERIC_TYPE(type);
+}
+
+static int tsdbBitPackEncode(const char *input, int inputSize, int nelements, int8_t type, char *output,
+                             int outputSize) {
+  return tsCompressBitPackImp(input, nelements, output, outputSize, type);
+}
+
+static int tsdbBitPackDecode(const char *input, int inputSize, int nelements, int8_t type, char *output,
+                             int outputSize) {
+  if (nelements * tDataTypes[type].bytes > outputSize) return -1;
+  return tsDecompressBitPackImp(input, inputSize, nelements, output, type);
+}
+
+static bool tsdbDictSupport(int8_t type) { return IS_VAR_DATA_TYPE(type); }
+
+static int tsdbDictEncode(const char *input, int inputSize, int nelements, int8_t type, char *output, int outputSize) {
+  return tsCompressDictImp(input, inputSize, nelements, output, outputSize);
+}
+
+static int tsdbDictDecode(const char *input, int inputSize, int nelements, int8_t type, char *output, int outputSize) {
+  return tsDecompressDictImp(input, inputSize, nelements, output, outputSize);
+}
+
+static int tsdbStage2Encode(uint8_t stage2, const char *input, int inputSize, char *output, int outputSize) {
+  if (stage2 == TSDB_COL_STAGE2_ZLIB) {
+    return tsCompressZlibImp(input, inputSize, output, outputSize);
+  }
+  return tsCompressStringImp(input, inputSize, output, outputSize);
+}
+
+static int tsdbStage2Decode(uint8_t stage2, const char *input, int inputSize, char *output, int outputSize) {
+  if (stage2 == TSDB_COL_STAGE2_ZLIB) {
+    return tsDecompressZlibImp(input, inputSize, output, outputSize);
+  }
+  return tsDecompressStringImp(input, inputSize, output, outputSize);
+}
@@ -33,6 +33,9 @@ typedef struct {
   bool         isRFileSet; // read and commit FSET
   SReadH       readh;
   SDFileSet    wSet;
+  SDFileSet *  pWSet;   // FSET to write, wSet of the handle owning the FSET
+  pthread_mutex_t  wLock;
+  pthread_mutex_t *pWLock;  // serializes the appends of parallel commit tasks to pWSet
   bool         isDFileSame;
   bool         isLFileSame;
   TSKEY        minKey;
@@ -44,9 +47,22 @@ typedef struct {
   SDataCols *  pDataCols;
 } SCommitH;
 
+typedef struct {
+  SDFileSet *pSet;     // existing FSET, NULL if the FSET is to be created
+  int        fid;
+  bool       hasData;  // has memory data to commit, otherwise only apply retention on pSet
+} SCommitFSet;
+
+typedef struct {
+  SCommitH *pCommith;  // handle holding the references of all tables
+  SCommitH *pFileHs;   // write handles of the FSETs in this round
+  int       nSlices;   // table slices of each FSET, a slice is committed by one task
+  int32_t   code;
+} SCommitRound;
+
 #define TSDB_COMMIT_REPO(ch) TSDB_READ_REPO(&(ch->readh))
 #define TSDB_COMMIT_REPO_ID(ch) REPO_ID(TSDB_READ_REPO(&(ch->readh)))
-#define TSDB_COMMIT_WRITE_FSET(ch) (&((ch)->wSet))
+#define TSDB_COMMIT_WRITE_FSET(ch) ((ch)->pWSet)
 #define TSDB_COMMIT_TABLE(ch) ((ch)->pTable)
 #define TSDB_COMMIT_HEAD_FILE(ch) TSDB_DFILE_IN_SET(TSDB_COMMIT_WRITE_FSET(ch), TSDB_FILE_HEAD)
 #define TSDB_COMMIT_DATA_FILE(ch) TSDB_DFILE_IN_SET(TSDB_COMMIT_WRITE_FSET(ch), TSDB_FILE_DATA)
@@ -66,15 +82,18 @@ static int  tsdbCompactMetaFile(STsdbRepo *pRepo, STsdbFS *pfs, SMFile *pMFile);
 static int  tsdbCommitTSData(STsdbRepo *pRepo);
 static void tsdbStartCommit(STsdbRepo *pRepo);
 static void tsdbEndCommit(STsdbRepo *pRepo, int eno);
-static int  tsdbCommitToFile(SCommitH *pCommith, SDFileSet *pSet, int fid);
+static SArray *tsdbGetCommitFSets(SCommitH *pCommith);
+static int  tsdbCommitFSets(SCommitH *pCommith, SCommitFSet *pCSets, int nCSets, int nCommit);
 static int  tsdbCreateCommitIters(SCommitH *pCommith);
 static void tsdbDestroyCommitIters(SCommitH *pCommith);
-static void tsdbSeekCommitIter(SCommitH *pCommith, TSKEY key);
 static int  tsdbInitCommitH(SCommitH *pCommith, STsdbRepo *pRepo);
 static void tsdbDestroyCommitH(SCommitH *pCommith);
+static int  tsdbInitCommitFileH(SCommitH *pFileh, SCommitH *pCommith);
+static void tsdbDestroyCommitFileH(SCommitH *pFileh);
+static int  tsdbInitCommitTaskH(SCommitH *pCommith, SCommitH *pFileh);
+static void tsdbDestroyCommitTaskH(SCommitH *pCommith);
 static int  tsdbGetFidLevel(int fid, SRtn *pRtn);
-static int  tsdbNextCommitFid(SCommitH *pCommith);
-static int  tsdbCommitToTable(SCommitH *pCommith, int tid);
+static int  tsdbCommitToTable(SCommitH *pCommith, SCommitIter *pIter);
 static int  tsdbSetCommitTable(SCommitH *pCommith, STable *pTable);
 static int  tsdbComparKeyBlock(const void *arg1, const void *arg2);
 static int  tsdbWriteBlockInfo(SCommitH *pCommih);
@@ -84,7 +103,6 @@ static int  tsdbMoveBlock(SCommitH *pCommith, int bidx);
 static int  tsdbCommitAddBlock(SCommitH *pCommith, const SBlock *pSupBlock, const SBlock *pSubBlocks, int nSubBlocks);
 static int  tsdbMergeBlockData(SCommitH *pCommith, SCommitIter *pIter, SDataCols *pDataCols, TSKEY keyLimit,
                                bool isLastOneBlock);
-static void tsdbResetCommitFile(SCommitH *pCommith);
 static void tsdbResetCommitTable(SCommitH *pCommith);
 static int  tsdbSetAndOpenCommitFile(SCommitH *pCommith, SDFileSet *pSet, int fid);
 static void tsdbCloseCommitFile(SCommitH *pCommith, bool hasError);
@@ -604,8 +622,9 @@ _err:
 static int tsdbCommitTSData(STsdbRepo *pRepo) {
   SMemTable *pMem = pRepo->imem;
   SCommitH   commith;
-  SDFileSet *pSet = NULL;
-  int        fid;
+  SArray *   aCSet = NULL;
+  int        nthreads = MAX(tsdbGetCommitThreads(), 1);
+  size_t     nCSets;
 
   memset(&commith, 0, sizeof(commith));
 
@@ -622,57 +641,32 @@ static int tsdbCommitTSData(STsdbRepo *pRepo) {
     return -1;
   }
 
-  // Skip expired memory data and expired FSET
-  tsdbSeekCommitIter(&commith, commith.rtn.minKey);
-  while ((pSet = tsdbFSIterNext(&(commith.fsIter)))) {
-    if (pSet->fid < commith.rtn.minFid) {
-      tsdbInfo("vgId:%d FSET %d on level %d disk id %d expires, remove it", REPO_ID(pRepo), pSet->fid,
-               TSDB_FSET_LEVEL(pSet), TSDB_FSET_ID(pSet));
-    } else {
-      break;
-    }
+  if ((aCSet = tsdbGetCommitFSets(&commith)) == NULL) {
+    tsdbDestroyCommitH(&commith);
+    return -1;
   }
 
-  // Loop to commit to each file
-  fid = tsdbNextCommitFid(&(commith));
-  while (true) {
-    // Loop over both on disk and memory
-    if (pSet == NULL && fid == TSDB_IVLD_FID) break;
-
-    if (pSet && (fid == TSDB_IVLD_FID || pSet->fid < fid)) {
-      // Only has existing FSET but no memory data to commit in this
-      // existing FSET, only check if file in correct retention
-      if (tsdbApplyRtnOnFSet(pRepo, pSet, &(commith.rtn)) < 0) {
-        tsdbDestroyCommitH(&commith);
-        return -1;
-      }
-
-      pSet = tsdbFSIterNext(&(commith.fsIter));
-    } else {
-      // Has memory data to commit
-      SDFileSet *pCSet;
-      int        cfid;
-
-      if (pSet == NULL || pSet->fid > fid) {
-        // Commit to a new FSET with fid: fid
-        pCSet = NULL;
-        cfid = fid;
-      } else {
-        // Commit to an existing FSET
-        pCSet = pSet;
-        cfid = pSet->fid;
-        pSet = tsdbFSIterNext(&(commith.fsIter));
-      }
+  // Commit the FSETs round by round, each round commits at most nthreads FSETs in parallel
+  nCSets = taosArrayGetSize(aCSet);
+  for (size_t i = 0; i < nCSets;) {
+    size_t j = i;
+    int    nCommit = 0;
 
-      if (tsdbCommitToFile(&commith, pCSet, cfid) < 0) {
-        tsdbDestroyCommitH(&commith);
-        return -1;
-      }
+    while (j < nCSets && nCommit < nthreads) {
+      if (((SCommitFSet *)taosArrayGet(aCSet, j))->hasData) nCommit++;
+      j++;
+    }
 
-      fid = tsdbNextCommitFid(&commith);
+    if (tsdbCommitFSets(&commith, (SCommitFSet *)taosArrayGet(aCSet, i), (int)(j - i), nCommit) < 0) {
+      taosArrayDestroy(aCSet);
+      tsdbDestroyCommitH(&commith);
+      return -1;
     }
+
+    i = j;
   }
 
+  taosArrayDestroy(aCSet);
   tsdbDestroyCommitH(&commith);
   return 0;
 }
@@ -719,61 +713,358 @@ static bool tsdbHasDataToCommit(SCommitIter *iters, int nIters, TSKEY minKey, TS
 }
 #endif
 
-static int tsdbCommitToFile(SCommitH *pCommith, SDFileSet *pSet, int fid) {
+static int tsdbComparFid(const void *arg1, const void *arg2) {
+  int fid1 = *(int *)arg1;
+  int fid2 = *(int *)arg2;
+
+  if (fid1 < fid2) {
+    return -1;
+  } else if (fid1 > fid2) {
+    return 1;
+  } else {
+    return 0;
+  }
+}
+
+static int tsdbComparBlockIdx(const void *arg1, const void *arg2) {
+  int32_t tid1 = ((SBlockIdx *)arg1)->tid;
+  int32_t tid2 = ((SBlockIdx *)arg2)->tid;
+
+  if (tid1 < tid2) {
+    return -1;
+  } else if (tid1 > tid2) {
+    return 1;
+  } else {
+    return 0;
+  }
+}
+
+static STableData *tsdbGetCommitTableData(SCommitH *pCommith, int tid) {
+  SMemTable * pMem = TSDB_COMMIT_REPO(pCommith)->imem;
+  STable *    pTable = pCommith->iters[tid].pTable;
+  STableData *pTableData = pMem->tData[tid];
+
+  if (pTable == NULL || pTableData == NULL || TABLE_UID(pTable) != pTableData->uid) return NULL;
+  return pTableData;
+}
+
+// Create a memory iterator of the table positioned at the first row not less than key
+static int tsdbInitCommitIter(SCommitH *pCommith, int tid, TSKEY key, SCommitIter *pIter) {
+  STableData *pTableData = tsdbGetCommitTableData(pCommith, tid);
+
+  pIter->pTable = pCommith->iters[tid].pTable;
+  pIter->pIter = NULL;
+
+  if (pTableData == NULL) return 0;
+
+  pIter->pIter = tSkipListCreateIterFromVal(pTableData->pData, (const char *)(&key), TSDB_DATA_TYPE_TIMESTAMP,
+                                            TSDB_ORDER_ASC);
+  if (pIter->pIter == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  tSkipListIterNext(pIter->pIter);
+  return 0;
+}
+
+// Get the sorted fids of the FSETs the memory data goes to, expired data is skipped
+static SArray *tsdbGetCommitFids(SCommitH *pCommith) {
+  STsdbCfg *pCfg = REPO_CFG(TSDB_COMMIT_REPO(pCommith));
+  SArray *  aFid = taosArrayInit(16, sizeof(int));
+  TSKEY     minKey, maxKey;
+
+  if (aFid == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return NULL;
+  }
+
+  for (int tid = 1; tid < pCommith->niters; tid++) {
+    STableData *pTableData = tsdbGetCommitTableData(pCommith, tid);
+    if (pTableData == NULL) continue;
+
+    // Jump from FSET to FSET instead of walking through the rows
+    TSKEY key = MAX(pTableData->keyFirst, pCommith->rtn.minKey);
+    while (key <= pTableData->keyLast) {
+      SCommitIter iter;
+      if (tsdbInitCommitIter(pCommith, tid, key, &iter) < 0) {
+        taosArrayDestroy(aFid);
+        return NULL;
+      }
+
+      TSKEY nextKey = tsdbNextIterKey(iter.pIter);
+      tSkipListDestroyIter(iter.pIter);
+      if (nextKey == TSDB_DATA_TIMESTAMP_NULL) break;
+
+      int fid = TSDB_KEY_FID(nextKey, pCfg->daysPerFile, pCfg->precision);
+      if (taosArrayPush(aFid, &fid) == NULL) {
+        terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+        taosArrayDestroy(aFid);
+        return NULL;
+      }
+
+      tsdbGetFidKeyRange(pCfg->daysPerFile, pCfg->precision, fid, &minKey, &maxKey);
+      key = maxKey + 1;
+    }
+  }
+
+  taosArraySort(aFid, tsdbComparFid);
+  taosArrayRemoveDuplicate(aFid, tsdbComparFid, NULL);
+
+  return aFid;
+}
+
+// Get the FSETs to handle in this commit in fid order, both the existing ones and the ones to create
+static SArray *tsdbGetCommitFSets(SCommitH *pCommith) {
+  STsdbRepo * pRepo = TSDB_COMMIT_REPO(pCommith);
+  SArray *    aCSet = NULL;
+  SArray *    aFid = NULL;
+  SDFileSet * pSet = NULL;
+  SCommitFSet cset;
+  size_t      fidx = 0;
+
+  if ((aFid = tsdbGetCommitFids(pCommith)) == NULL) {
+    return NULL;
+  }
+
+  aCSet = taosArrayInit(taosArrayGetSize(aFid) + 16, sizeof(SCommitFSet));
+  if (aCSet == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    taosArrayDestroy(aFid);
+    return NULL;
+  }
+
+  // Skip expired FSET
+  while ((pSet = tsdbFSIterNext(&(pCommith->fsIter)))) {
+    if (pSet->fid < pCommith->rtn.minFid) {
+      tsdbInfo("vgId:%d FSET %d on level %d disk id %d expires, remove it", REPO_ID(pRepo), pSet->fid,
+               TSDB_FSET_LEVEL(pSet), TSDB_FSET_ID(pSet));
+    } else {
+      break;
+    }
+  }
+
+  // Loop over both on disk and memory
+  while (pSet != NULL || fidx < taosArrayGetSize(aFid)) {
+    int fid = (fidx < taosArrayGetSize(aFid)) ? *(int *)taosArrayGet(aFid, fidx) : TSDB_IVLD_FID;
+
+    memset(&cset, 0, sizeof(cset));
+    if (pSet && (fid == TSDB_IVLD_FID || pSet->fid < fid)) {
+      // Only has existing FSET but no memory data to commit in this
+      // existing FSET, only check if file in correct retention
+      cset.pSet = pSet;
+      cset.fid = pSet->fid;
+      cset.hasData = false;
+      pSet = tsdbFSIterNext(&(pCommith->fsIter));
+    } else {
+      cset.fid = fid;
+      cset.hasData = true;
+      if (pSet && pSet->fid == fid) {
+        // Commit to an existing FSET
+        cset.pSet = pSet;
+        pSet = tsdbFSIterNext(&(pCommith->fsIter));
+      }
+      fidx++;
+    }
+
+    if (taosArrayPush(aCSet, &cset) == NULL) {
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      taosArrayDestroy(aFid);
+      taosArrayDestroy(aCSet);
+      return NULL;
+    }
+  }
+
+  taosArrayDestroy(aFid);
+  return aCSet;
+}
+
+static void tsdbSetCommitRoundError(SCommitRound *pRound, int32_t code) {
+  atomic_val_compare_exchange_32(&(pRound->code), TSDB_CODE_SUCCESS, code);
+}
+
+/**
+ * A commit task commits a slice of tables to one FSET with its own read handle and buffers. Blocks of different
+ * tables are compressed by the tasks in parallel while the appends to the FSET files are serialized by the FSET
+ * write lock, so each task holds at most one compressed block waiting to be written.
+ */
+static void tsdbCommitTableSlice(void *param, int idx) {
+  SCommitRound *pRound = (SCommitRound *)param;
+  SCommitH *    pCommith = pRound->pCommith;
+  SCommitH *    pFileh = pRound->pFileHs + idx / pRound->nSlices;
+  int           sliceSize = (pCommith->niters - 1 + pRound->nSlices - 1) / pRound->nSlices;
+  int           ftid = 1 + (idx % pRound->nSlices) * sliceSize;
+  int           ltid = MIN(ftid + sliceSize, pCommith->niters);
+  SCommitH      commith;
+  SCommitIter   iter;
+
+  if (pFileh->pWSet == NULL || ftid >= ltid || pRound->code != TSDB_CODE_SUCCESS) return;
+
+  if (tsdbInitCommitTaskH(&commith, pFileh) < 0) {
+    tsdbSetCommitRoundError(pRound, terrno);
+    return;
+  }
+
+  for (int tid = ftid; tid < ltid; tid++) {
+    if (pRound->code != TSDB_CODE_SUCCESS) break;
+    if (pCommith->iters[tid].pTable == NULL) continue;
+
+    if (tsdbInitCommitIter(pCommith, tid, MAX(pFileh->minKey, pCommith->rtn.minKey), &iter) < 0) {
+      tsdbSetCommitRoundError(pRound, terrno);
+      break;
+    }
+
+    int code = tsdbCommitToTable(&commith, &iter);
+    tSkipListDestroyIter(iter.pIter);
+    if (code < 0) {
+      tsdbSetCommitRoundError(pRound, terrno);
+      break;
+    }
+  }
+
+  if (pRound->code == TSDB_CODE_SUCCESS && taosArrayGetSize(commith.aBlkIdx) > 0) {
+    pthread_mutex_lock(pFileh->pWLock);
+    if (taosArrayAddBatch(pFileh->aBlkIdx, taosArrayGet(commith.aBlkIdx, 0),
+                          (int)taosArrayGetSize(commith.aBlkIdx)) == NULL) {
+      tsdbSetCommitRoundError(pRound, TSDB_CODE_TDB_OUT_OF_MEMORY);
+    }
+    pthread_mutex_unlock(pFileh->pWLock);
+  }
+
+  tsdbDestroyCommitTaskH(&commith);
+}
+
+static int tsdbOpenCommitFile(SCommitH *pFileh, SCommitH *pCommith, SDFileSet *pSet, int fid) {
   STsdbRepo *pRepo = TSDB_COMMIT_REPO(pCommith);
   STsdbCfg * pCfg = REPO_CFG(pRepo);
 
   ASSERT(pSet == NULL || pSet->fid == fid);
 
-  tsdbResetCommitFile(pCommith);
-  tsdbGetFidKeyRange(pCfg->daysPerFile, pCfg->precision, fid, &(pCommith->minKey), &(pCommith->maxKey));
+  if (tsdbInitCommitFileH(pFileh, pCommith) < 0) {
+    return -1;
+  }
+
+  tsdbGetFidKeyRange(pCfg->daysPerFile, pCfg->precision, fid, &(pFileh->minKey), &(pFileh->maxKey));
 
   // Set and open files
-  if (tsdbSetAndOpenCommitFile(pCommith, pSet, fid) < 0) {
+  if (tsdbSetAndOpenCommitFile(pFileh, pSet, fid) < 0) {
+    tsdbDestroyCommitFileH(pFileh);
     return -1;
   }
 
-  // Loop to commit each table data
-  for (int tid = 1; tid < pCommith->niters; tid++) {
-    SCommitIter *pIter = pCommith->iters + tid;
+  return 0;
+}
 
-    if (pIter->pTable == NULL) continue;
+static int tsdbFinishCommitFile(SCommitH *pFileh) {
+  STsdbRepo *pRepo = TSDB_COMMIT_REPO(pFileh);
+  int        fid = TSDB_FSET_FID(TSDB_COMMIT_WRITE_FSET(pFileh));
 
-    if (tsdbCommitToTable(pCommith, tid) < 0) {
-      tsdbCloseCommitFile(pCommith, true);
-      // revert the file change
-      tsdbApplyDFileSetChange(TSDB_COMMIT_WRITE_FSET(pCommith), pSet);
-      return -1;
-    }
-  }
+  // Tables are committed in parallel, while SBlockIdx part must be in tid order
+  taosArraySort(pFileh->aBlkIdx, tsdbComparBlockIdx);
 
-  if (tsdbWriteBlockIdx(TSDB_COMMIT_HEAD_FILE(pCommith), pCommith->aBlkIdx, (void **)(&(TSDB_COMMIT_BUF(pCommith)))) <
-      0) {
+  if (tsdbWriteBlockIdx(TSDB_COMMIT_HEAD_FILE(pFileh), pFileh->aBlkIdx, (void **)(&(TSDB_COMMIT_BUF(pFileh)))) < 0) {
     tsdbError("vgId:%d failed to write SBlockIdx part to FSET %d since %s", REPO_ID(pRepo), fid, tstrerror(terrno));
-    tsdbCloseCommitFile(pCommith, true);
-    // revert the file change
-    tsdbApplyDFileSetChange(TSDB_COMMIT_WRITE_FSET(pCommith), pSet);
     return -1;
   }
 
-  if (tsdbUpdateDFileSetHeader(&(pCommith->wSet)) < 0) {
+  if (tsdbUpdateDFileSetHeader(TSDB_COMMIT_WRITE_FSET(pFileh)) < 0) {
     tsdbError("vgId:%d failed to update FSET %d header since %s", REPO_ID(pRepo), fid, tstrerror(terrno));
-    tsdbCloseCommitFile(pCommith, true);
-    // revert the file change
-    tsdbApplyDFileSetChange(TSDB_COMMIT_WRITE_FSET(pCommith), pSet);
     return -1;
   }
 
   // Close commit file
-  tsdbCloseCommitFile(pCommith, false);
+  tsdbCloseCommitFile(pFileh, false);
+  return 0;
+}
+
+/**
+ * Commit the memory data to a round of FSETs. The tables of each FSET are split into slices which are committed
+ * as tasks on the commit thread pool, then the FSETs are closed and applied to the new FS status in fid order.
+ */
+static int tsdbCommitFSets(SCommitH *pCommith, SCommitFSet *pCSets, int nCSets, int nCommit) {
+  STsdbRepo *  pRepo = TSDB_COMMIT_REPO(pCommith);
+  int          nthreads = tsdbGetCommitThreads();
+  SCommitRound round;
+
+  memset(&round, 0, sizeof(round));
+  round.pCommith = pCommith;
+  round.nSlices = 1;
+  round.code = TSDB_CODE_SUCCESS;
+
+  round.pFileHs = (SCommitH *)calloc(nCSets, sizeof(SCommitH));
+  if (round.pFileHs == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  for (int i = 0; i < nCSets; i++) {
+    if (!pCSets[i].hasData) continue;
+
+    if (tsdbOpenCommitFile(round.pFileHs + i, pCommith, pCSets[i].pSet, pCSets[i].fid) < 0) {
+      round.code = terrno;
+      break;
+    }
+  }
+
+  if (round.code == TSDB_CODE_SUCCESS && nCommit > 0) {
+    // Give every commit thread a few slices so that a slice of large tables does not hold the round
+    if (nthreads > 1) {
+      round.nSlices = MAX(nthreads * 4 / nCommit, 1);
+      if (round.nSlices > pCommith->niters - 1) round.nSlices = MAX(pCommith->niters - 1, 1);
+    }
+
+    tsdbDebug("vgId:%d commit %d FSETs in %d table slices each", REPO_ID(pRepo), nCommit, round.nSlices);
+    tsdbRunCommitTasks(nCSets * round.nSlices, tsdbCommitTableSlice, &round);
+  }
+
+  for (int i = 0; i < nCSets; i++) {
+    SCommitH *pFileh = round.pFileHs + i;
+    if (pFileh->pWSet == NULL || round.code != TSDB_CODE_SUCCESS) continue;
+
+    if (tsdbFinishCommitFile(pFileh) < 0) {
+      round.code = terrno;
+    }
+  }
+
+  // Apply the FSETs to the new FS status in fid order
+  for (int i = 0; i < nCSets && round.code == TSDB_CODE_SUCCESS; i++) {
+    SCommitH *pFileh = round.pFileHs + i;
+
+    if (pCSets[i].hasData) {
+      if (tsdbUpdateDFileSet(REPO_FS(pRepo), TSDB_COMMIT_WRITE_FSET(pFileh)) < 0) {
+        round.code = terrno;
+      }
+    } else {
+      if (tsdbApplyRtnOnFSet(pRepo, pCSets[i].pSet, &(pCommith->rtn)) < 0) {
+        round.code = terrno;
+      }
+    }
+  }
+
+  for (int i = 0; i < nCSets; i++) {
+    SCommitH *pFileh = round.pFileHs + i;
+    if (pFileh->pWSet == NULL) continue;
+
+    if (round.code != TSDB_CODE_SUCCESS) {
+      tsdbCloseCommitFile(pFileh, true);
+      // revert the file change
+      tsdbApplyDFileSetChange(TSDB_COMMIT_WRITE_FSET(pFileh), pCSets[i].pSet);
+    }
+
+    tsdbDestroyCommitFileH(pFileh);
+  }
+
+  free(round.pFileHs);
 
-  if (tsdbUpdateDFileSet(REPO_FS(pRepo), &(pCommith->wSet)) < 0) {
+  if (round.code != TSDB_CODE_SUCCESS) {
+    terrno = round.code;
     return -1;
   }
 
   return 0;
 }
 
+// Reference all tables, the memory iterators are created for each FSET to commit
 static int tsdbCreateCommitIters(SCommitH *pCommith) {
   STsdbRepo *pRepo = TSDB_COMMIT_REPO(pCommith);
   SMemTable *pMem = pRepo->imem;
@@ -798,18 +1089,6 @@ static int tsdbCreateCommitIters(SCommitH *pCommith) {
 
   if (tsdbUnlockRepoMeta(pRepo) < 0) return -1;
 
-  for (int i = 0; i < pMem->maxTables; i++) {
-    if ((pCommith->iters[i].pTable != NULL) && (pMem->tData[i] != NULL) &&
-        (TABLE_UID(pCommith->iters[i].pTable) == pMem->tData[i]->uid)) {
-      if ((pCommith->iters[i].pIter = tSkipListCreateIter(pMem->tData[i]->pData)) == NULL) {
-        terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
-        return -1;
-      }
-
-      tSkipListIterNext(pCommith->iters[i].pIter);
-    }
-  }
-
   return 0;
 }
 
@@ -828,22 +1107,13 @@ static void tsdbDestroyCommitIters(SCommitH *pCommith) {
   pCommith->niters = 0;
 }
 
-// Skip all keys until key (not included)
-static void tsdbSeekCommitIter(SCommitH *pCommith, TSKEY key) {
-  for (int i = 0; i < pCommith->niters; i++) {
-    SCommitIter *pIter = pCommith->iters + i;
-    if (pIter->pTable == NULL || pIter->pIter == NULL) continue;
-
-    tsdbLoadDataFromCache(pIter->pTable, pIter->pIter, key - 1, INT32_MAX, NULL, NULL, 0, true, NULL);
-  }
-}
-
 static int tsdbInitCommitH(SCommitH *pCommith, STsdbRepo *pRepo) {
   STsdbCfg *pCfg = REPO_CFG(pRepo);
 
   memset(pCommith, 0, sizeof(*pCommith));
   tsdbGetRtnSnap(pRepo, &(pCommith->rtn));
 
+  pCommith->pWSet = &(pCommith->wSet);
   TSDB_FSET_SET_CLOSED(TSDB_COMMIT_WRITE_FSET(pCommith));
 
   // Init read handle
@@ -900,32 +1170,95 @@ static void tsdbDestroyCommitH(SCommitH *pCommith) {
   tsdbCloseDFileSet(TSDB_COMMIT_WRITE_FSET(pCommith));
 }
 
-static int tsdbNextCommitFid(SCommitH *pCommith) {
+static int tsdbInitCommitFileH(SCommitH *pFileh, SCommitH *pCommith) {
   STsdbRepo *pRepo = TSDB_COMMIT_REPO(pCommith);
+
+  memset(pFileh, 0, sizeof(*pFileh));
+  pFileh->rtn = pCommith->rtn;
+
+  pFileh->pWSet = &(pFileh->wSet);
+  TSDB_FSET_SET_CLOSED(TSDB_COMMIT_WRITE_FSET(pFileh));
+
+  if (tsdbInitReadH(&(pFileh->readh), pRepo) < 0) {
+    pFileh->pWSet = NULL;
+    return -1;
+  }
+
+  pFileh->aBlkIdx = taosArrayInit(1024, sizeof(SBlockIdx));
+  if (pFileh->aBlkIdx == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    tsdbDestroyReadH(&(pFileh->readh));
+    pFileh->pWSet = NULL;
+    return -1;
+  }
+
+  pthread_mutex_init(&(pFileh->wLock), NULL);
+  pFileh->pWLock = &(pFileh->wLock);
+
+  return 0;
+}
+
+static void tsdbDestroyCommitFileH(SCommitH *pFileh) {
+  if (pFileh->pWSet == NULL) return;
+
+  tsdbDestroyCommitH(pFileh);
+  pthread_mutex_destroy(&(pFileh->wLock));
+  pFileh->pWLock = NULL;
+  pFileh->pWSet = NULL;
+}
+
+static int tsdbInitCommitTaskH(SCommitH *pCommith, SCommitH *pFileh) {
+  STsdbRepo *pRepo = TSDB_COMMIT_REPO(pFileh);
   STsdbCfg * pCfg = REPO_CFG(pRepo);
-  int        fid = TSDB_IVLD_FID;
 
-  for (int i = 0; i < pCommith->niters; i++) {
-    SCommitIter *pIter = pCommith->iters + i;
-    if (pIter->pTable == NULL || pIter->pIter == NULL) continue;
+  memset(pCommith, 0, sizeof(*pCommith));
+  pCommith->rtn = pFileh->rtn;
+  pCommith->isRFileSet = pFileh->isRFileSet;
+  pCommith->isDFileSame = pFileh->isDFileSame;
+  pCommith->isLFileSame = pFileh->isLFileSame;
+  pCommith->minKey = pFileh->minKey;
+  pCommith->maxKey = pFileh->maxKey;
+  pCommith->pWSet = pFileh->pWSet;
+  pCommith->pWLock = pFileh->pWLock;
 
-    TSKEY nextKey = tsdbNextIterKey(pIter->pIter);
-    if (nextKey == TSDB_DATA_TIMESTAMP_NULL) {
-      continue;
-    } else {
-      int tfid = (int)(TSDB_KEY_FID(nextKey, pCfg->daysPerFile, pCfg->precision));
-      if (fid == TSDB_IVLD_FID || fid > tfid) {
-        fid = tfid;  // find the least fid
-      }
+  if (tsdbInitReadH(&(pCommith->readh), pRepo) < 0) {
+    return -1;
+  }
+
+  // Each task reads the FSET with its own files and block index
+  if (pCommith->isRFileSet) {
+    if (tsdbSetAndOpenReadFSet(&(pCommith->readh), TSDB_READ_FSET(&(pFileh->readh))) < 0 ||
+        tsdbLoadBlockIdx(&(pCommith->readh)) < 0) {
+      tsdbDestroyCommitTaskH(pCommith);
+      return -1;
     }
   }
 
-  return fid;
+  pCommith->aBlkIdx = taosArrayInit(1024, sizeof(SBlockIdx));
+  pCommith->aSupBlk = taosArrayInit(1024, sizeof(SBlock));
+  pCommith->aSubBlk = taosArrayInit(1024, sizeof(SBlock));
+  pCommith->pDataCols = tdNewDataCols(0, pCfg->maxRowsPerFileBlock);
+  if (pCommith->aBlkIdx == NULL || pCommith->aSupBlk == NULL || pCommith->aSubBlk == NULL ||
+      pCommith->pDataCols == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    tsdbDestroyCommitTaskH(pCommith);
+    return -1;
+  }
+
+  return 0;
 }
 
-static int tsdbCommitToTable(SCommitH *pCommith, int tid) {
-  SCommitIter *pIter = pCommith->iters + tid;
-  TSKEY        nextKey = tsdbNextIterKey(pIter->pIter);
+static void tsdbDestroyCommitTaskH(SCommitH *pCommith) {
+  pCommith->pDataCols = tdFreeDataCols(pCommith->pDataCols);
+  pCommith->aSubBlk = taosArrayDestroy(pCommith->aSubBlk);
+  pCommith->aSupBlk = taosArrayDestroy(pCommith->aSupBlk);
+  pCommith->aBlkIdx = taosArrayDestroy(pCommith->aBlkIdx);
+  // the write FSET belongs to the file handle
+  tsdbDestroyReadH(&(pCommith->readh));
+}
+
+static int tsdbCommitToTable(SCommitH *pCommith, SCommitIter *pIter) {
+  TSKEY nextKey = tsdbNextIterKey(pIter->pIter);
 
   tsdbResetCommitTable(pCommith);
 
@@ -1014,7 +1347,11 @@ static int tsdbCommitToTable(SCommitH *pCommith, int tid) {
 
   TSDB_RUNLOCK_TABLE(pIter->pTable);
 
-  if (tsdbWriteBlockInfo(pCommith) < 0) {
+  if (pCommith->pWLock) pthread_mutex_lock(pCommith->pWLock);
+  int code = tsdbWriteBlockInfo(pCommith);
+  if (pCommith->pWLock) pthread_mutex_unlock(pCommith->pWLock);
+
+  if (code < 0) {
     tsdbError("vgId:%d failed to write SBlockInfo part into file %s since %s", TSDB_COMMIT_REPO_ID(pCommith),
               TSDB_FILE_FULL_NAME(TSDB_COMMIT_HEAD_FILE(pCommith)), tstrerror(terrno));
     return -1;
@@ -1057,7 +1394,8 @@ static int tsdbComparKeyBlock(const void *arg1, const void *arg2) {
 }
 
 int tsdbWriteBlockImpl(STsdbRepo *pRepo, STable *pTable, SDFile *pDFile, SDFile *pDFileAggr, SDataCols *pDataCols,
-                       SBlock *pBlock, bool isLast, bool isSuper, void **ppBuf, void **ppCBuf, void **ppExBuf) {
+                       SBlock *pBlock, bool isLast, bool isSuper, void **ppBuf, void **ppCBuf, void **ppExBuf,
+                       pthread_mutex_t *pWLock) {
   STsdbCfg *  pCfg = REPO_CFG(pRepo);
   SBlockData *pBlockData;
   SAggrBlkData *pAggrBlkData = NULL;
@@ -1131,6 +1469,7 @@ int tsdbWriteBlockImpl(STsdbRepo *pRepo, STable *pTable, SDFile *pDFile, SDFile
 
     int32_t flen;  // final length
     int32_t tlen = dataColGetNEleLen(pDataCol, rowsToWrite);
+    uint8_t codec = 0;
     void *  tptr;
 
     // Make room
@@ -1141,13 +1480,16 @@ int tsdbWriteBlockImpl(STsdbRepo *pRepo, STable *pTable, SDFile *pDFile, SDFile
     pBlockCol = pBlockData->cols + tcol;
     tptr = POINTER_SHIFT(pBlockData, lsize);
 
-    if (pCfg->compression == TWO_STAGE_COMP &&
+    if ((pCfg->compression == TWO_STAGE_COMP || tsdbColumnCodec) &&
         tsdbMakeRoom(ppCBuf, tlen + COMP_OVERFLOW_BYTES) < 0) {
       return -1;
     }
 
     // Compress or just copy
-    if (pCfg->compression) {
+    if (pCfg->compression && ncol != 0) {
+      flen = tsdbEncodeColData(pDataCol, rowsToWrite, pCfg->compression, tptr, tlen + COMP_OVERFLOW_BYTES, *ppCBuf,
+                               tlen + COMP_OVERFLOW_BYTES, &codec);
+    } else if (pCfg->compression) {
       flen = (*(tDataTypes[pDataCol->type].compFunc))((char *)pDataCol->pData, tlen, rowsToWrite, tptr,
                                                       tlen + COMP_OVERFLOW_BYTES, pCfg->compression, *ppCBuf,
                                                       tlen + COMP_OVERFLOW_BYTES);
@@ -1160,11 +1502,11 @@ int tsdbWriteBlockImpl(STsdbRepo *pRepo, STable *pTable, SDFile *pDFile, SDFile
     ASSERT(flen > 0);
     flen += sizeof(TSCKSUM);
     taosCalcChecksumAppend(0, (uint8_t *)tptr, flen);
-    tsdbUpdateDFileMagic(pDFile, POINTER_SHIFT(tptr, flen - sizeof(TSCKSUM)));
 
     if (ncol != 0) {
       tsdbSetBlockColOffset(pBlockCol, toffset);
       pBlockCol->len = flen;
+      pBlockCol->codec = codec;
       tcol++;
     } else {
       keyLen = flen;
@@ -1179,25 +1521,42 @@ int tsdbWriteBlockImpl(STsdbRepo *pRepo, STable *pTable, SDFile *pDFile, SDFile
   pBlockData->numOfCols = nColsNotAllNull;
 
   taosCalcChecksumAppend(0, (uint8_t *)pBlockData, tsize);
+
+  uint32_t aggrStatus = nColsNotAllNull > 0 ? 1 : 0;
+  if (aggrStatus > 0) {
+    taosCalcChecksumAppend(0, (uint8_t *)pAggrBlkData, tsizeAggr);
+  }
+
+  // The block is encoded, only the appends to the files need to be serialized. File magic is updated in the order
+  // of the checksums in the block.
+  if (pWLock) pthread_mutex_lock(pWLock);
+
+  tsdbUpdateDFileMagic(pDFile, POINTER_SHIFT(pBlockData, tsize + keyLen - sizeof(TSCKSUM)));
+  for (int i = 0; i < nColsNotAllNull; i++) {
+    SBlockCol *pBlockCol = pBlockData->cols + i;
+    tsdbUpdateDFileMagic(pDFile, POINTER_SHIFT(pBlockData, tsize + tsdbGetBlockColOffset(pBlockCol) + pBlockCol->len -
+                                                               sizeof(TSCKSUM)));
+  }
   tsdbUpdateDFileMagic(pDFile, POINTER_SHIFT(pBlockData, tsize - sizeof(TSCKSUM)));
 
   // Write the whole block to file
   if (tsdbAppendDFile(pDFile, (void *)pBlockData, lsize, &offset) < lsize) {
+    if (pWLock) pthread_mutex_unlock(pWLock);
     return -1;
   }
 
-  uint32_t aggrStatus = nColsNotAllNull > 0 ? 1 : 0;
   if (aggrStatus > 0) {
-
-    taosCalcChecksumAppend(0, (uint8_t *)pAggrBlkData, tsizeAggr);
     tsdbUpdateDFileMagic(pDFileAggr, POINTER_SHIFT(pAggrBlkData, tsizeAggr - sizeof(TSCKSUM)));
 
     // Write the whole block to file
     if (tsdbAppendDFile(pDFileAggr, (void *)pAggrBlkData, tsizeAggr, &offsetAggr) < tsizeAggr) {
+      if (pWLock) pthread_mutex_unlock(pWLock);
       return -1;
     }
   }
 
+  if (pWLock) pthread_mutex_unlock(pWLock);
+
   // Update pBlock membership variables
   pBlock->last = isLast;
   pBlock->offset = offset;
@@ -1227,7 +1586,8 @@ static int tsdbWriteBlock(SCommitH *pCommith, SDFile *pDFile, SDataCols *pDataCo
   return tsdbWriteBlockImpl(TSDB_COMMIT_REPO(pCommith), TSDB_COMMIT_TABLE(pCommith), pDFile,
                             isLast ? TSDB_COMMIT_SMAL_FILE(pCommith) : TSDB_COMMIT_SMAD_FILE(pCommith), pDataCols,
                             pBlock, isLast, isSuper, (void **)(&(TSDB_COMMIT_BUF(pCommith))),
-                            (void **)(&(TSDB_COMMIT_COMP_BUF(pCommith))), (void **)(&(TSDB_COMMIT_EXBUF(pCommith))));
+                            (void **)(&(TSDB_COMMIT_COMP_BUF(pCommith))), (void **)(&(TSDB_COMMIT_EXBUF(pCommith))),
+                            pCommith->pWLock);
 }
 
 static int tsdbWriteBlockInfo(SCommitH *pCommih) {
@@ -1513,13 +1873,6 @@ static void tsdbLoadAndMergeFromCache(SDataCols *pDataCols, int *iter, SCommitIt
   }
 }
 
-static void tsdbResetCommitFile(SCommitH *pCommith) {
-  pCommith->isRFileSet = false;
-  pCommith->isDFileSame = false;
-  pCommith->isLFileSame = false;
-  taosArrayClear(pCommith->aBlkIdx);
-}
-
 static void tsdbResetCommitTable(SCommitH *pCommith) {
   taosArrayClear(pCommith->aSubBlk);
   taosArrayClear(pCommith->aSupBlk);
@@ -1579,9 +1932,9 @@ static int tsdbSetAndOpenCommitFile(SCommitH *pCommith, SDFileSet *pSet, int fid
     did.level = TSDB_FSET_LEVEL(pSet);
     did.id = TSDB_FSET_ID(pSet);
 
-    pCommith->wSet.fid = fid;
-    pCommith->wSet.state = 0;
-    pCommith->wSet.ver = TSDB_LATEST_FSET_VER;
+    pWSet->fid = fid;
+    pWSet->state = 0;
+    pWSet->ver = TSDB_LATEST_FSET_VER;
 
     // TSDB_FILE_HEAD
     SDFile *pWHeadf = TSDB_COMMIT_HEAD_FILE(pCommith);
@@ -26,11 +26,23 @@ typedef struct {
 } SCommitQueue;
 
 typedef struct {
-  TSDB_REQ_T req;
-  STsdbRepo *pRepo;
+  int             numOfTasks;
+  int             nextTask;
+  int             numOfHelpers;  // commit threads currently working on the tasks
+  pthread_mutex_t lock;
+  pthread_cond_t  helpersDone;
+  __tsdb_commit_task_fn_t fp;
+  void *          param;
+} SCommitTasks;
+
+typedef struct {
+  TSDB_REQ_T    req;
+  STsdbRepo *   pRepo;
+  SCommitTasks *pTasks;
 } SReq;
 
 static void *tsdbLoopCommit(void *arg);
+static void  tsdbDoCommitTasks(SCommitTasks *pTasks);
 
 static SCommitQueue tsCommitQueue = {0};
 
@@ -114,6 +126,85 @@ int tsdbScheduleCommit(STsdbRepo *pRepo, TSDB_REQ_T req) {
   return 0;
 }
 
+int tsdbGetCommitThreads() { return tsCommitQueue.nthreads; }
+
+/**
+ * Run numOfTasks independent tasks of a commit on the commit thread pool. The calling thread works on the tasks
+ * as well, so the commit always makes progress even if no other commit thread is idle. Helper requests are put at
+ * the head of the queue so that an ongoing commit is finished before a new one is started.
+ */
+void tsdbRunCommitTasks(int numOfTasks, __tsdb_commit_task_fn_t fp, void *param) {
+  SCommitQueue *pQueue = &tsCommitQueue;
+  SCommitTasks  tasks = {0};
+  int           nhelpers = MIN(pQueue->nthreads, numOfTasks) - 1;
+
+  tasks.numOfTasks = numOfTasks;
+  tasks.fp = fp;
+  tasks.param = param;
+
+  if (nhelpers <= 0) {
+    tsdbDoCommitTasks(&tasks);
+    return;
+  }
+
+  pthread_mutex_init(&(tasks.lock), NULL);
+  pthread_cond_init(&(tasks.helpersDone), NULL);
+
+  pthread_mutex_lock(&(pQueue->lock));
+  for (int i = 0; i < nhelpers; i++) {
+    SListNode *pNode = (SListNode *)calloc(1, sizeof(SListNode) + sizeof(SReq));
+    if (pNode == NULL) break;
+
+    ((SReq *)pNode->data)->req = COMMIT_TASK_REQ;
+    ((SReq *)pNode->data)->pTasks = &tasks;
+    tdListPrependNode(pQueue->queue, pNode);
+  }
+  pthread_cond_broadcast(&(pQueue->queueNotEmpty));
+  pthread_mutex_unlock(&(pQueue->lock));
+
+  tsdbDoCommitTasks(&tasks);
+
+  // Withdraw the helper requests no thread has picked up yet
+  pthread_mutex_lock(&(pQueue->lock));
+  SListIter  iter;
+  SListNode *pNode = NULL;
+  tdListInitIter(pQueue->queue, &iter, TD_LIST_FORWARD);
+  while ((pNode = tdListNext(&iter)) != NULL) {
+    if (((SReq *)pNode->data)->req == COMMIT_TASK_REQ && ((SReq *)pNode->data)->pTasks == &tasks) {
+      tdListPopNode(pQueue->queue, pNode);
+      listNodeFree(pNode);
+    }
+  }
+  pthread_mutex_unlock(&(pQueue->lock));
+
+  // Wait for the helpers still running the last tasks
+  pthread_mutex_lock(&(tasks.lock));
+  while (tasks.numOfHelpers > 0) {
+    pthread_cond_wait(&(tasks.helpersDone), &(tasks.lock));
+  }
+  pthread_mutex_unlock(&(tasks.lock));
+
+  pthread_cond_destroy(&(tasks.helpersDone));
+  pthread_mutex_destroy(&(tasks.lock));
+}
+
+static void tsdbDoCommitTasks(SCommitTasks *pTasks) {
+  int idx;
+
+  while ((idx = atomic_fetch_add_32(&(pTasks->nextTask), 1)) < pTasks->numOfTasks) {
+    (*pTasks->fp)(pTasks->param, idx);
+  }
+}
+
+static void tsdbHelpCommitTasks(SCommitTasks *pTasks) {
+  tsdbDoCommitTasks(pTasks);
+
+  pthread_mutex_lock(&(pTasks->lock));
+  pTasks->numOfHelpers--;
+  pthread_cond_signal(&(pTasks->helpersDone));
+  pthread_mutex_unlock(&(pTasks->lock));
+}
+
 static void tsdbApplyRepoConfig(STsdbRepo *pRepo) {
   pthread_mutex_lock(&pRepo->save_mutex);
 
@@ -158,6 +249,7 @@ static void *tsdbLoopCommit(void *arg) {
   SCommitQueue *pQueue = &tsCommitQueue;
   SListNode *   pNode = NULL;
   STsdbRepo *   pRepo = NULL;
+  SCommitTasks *pTasks = NULL;
   TSDB_REQ_T    req;
 
   setThreadName("tsdbCommit");
@@ -179,10 +271,18 @@ static void *tsdbLoopCommit(void *arg) {
       }
     }
 
-    pthread_mutex_unlock(&(pQueue->lock));
-
     req = ((SReq *)pNode->data)->req;
     pRepo = ((SReq *)pNode->data)->pRepo;
+    pTasks = ((SReq *)pNode->data)->pTasks;
+
+    // Register as a helper before the queue lock is released so the task owner cannot miss us
+    if (req == COMMIT_TASK_REQ) {
+      pthread_mutex_lock(&(pTasks->lock));
+      pTasks->numOfHelpers++;
+      pthread_mutex_unlock(&(pTasks->lock));
+    }
+
+    pthread_mutex_unlock(&(pQueue->lock));
 
     if (req == COMMIT_REQ) {
       tsdbCommitData(pRepo);
@@ -192,6 +292,8 @@ static void *tsdbLoopCommit(void *arg) {
       ASSERT(pRepo->config_changed);
       tsdbApplyRepoConfig(pRepo);
       tsem_post(&(pRepo->readyToCommit));
+    } else if (req == COMMIT_TASK_REQ) {
+      tsdbHelpCommitTasks(pTasks);
     } else {
       ASSERT(0);
     }
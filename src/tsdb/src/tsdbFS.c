@@ -25,6 +25,7 @@ static int  tsdbComparFidFSet(const void *arg1, const void *arg2);
 static void tsdbResetFSStatus(SFSStatus *pStatus);
 static int  tsdbSaveFSStatus(SFSStatus *pStatus, int vid);
 static void tsdbApplyFSTxnOnDisk(SFSStatus *pFrom, SFSStatus *pTo);
+static void tsdbDropRetiredFSetsFromCache(int vid, SFSStatus *pFrom, SFSStatus *pTo);
 static void tsdbGetTxnFname(int repoid, TSDB_TXN_FILE_T ftype, char fname[]);
 static int  tsdbOpenFSFromCurrent(STsdbRepo *pRepo);
 static int  tsdbScanAndTryFixFS(STsdbRepo *pRepo);
@@ -231,6 +232,11 @@ STsdbFS *tsdbNewFS(STsdbCfg *pCfg) {
   pfs->intxn = false;
   pfs->metaCacheComp = NULL;
 
+  if (tsdbInitHeadIdxCache(pfs) < 0) {
+    tsdbFreeFS(pfs);
+    return NULL;
+  }
+
   pfs->nstatus = tsdbNewFSStatus(maxFSet);
   if (pfs->nstatus == NULL) {
     tsdbFreeFS(pfs);
@@ -246,6 +252,7 @@ void *tsdbFreeFS(STsdbFS *pfs) {
     taosHashCleanup(pfs->metaCache);
     pfs->metaCache = NULL;
     pfs->cstatus = tsdbFreeFSStatus(pfs->cstatus);
+    tsdbDestroyHeadIdxCache(pfs);
     pthread_rwlock_destroy(&(pfs->lock));
     free(pfs);
   }
@@ -348,6 +355,7 @@ int tsdbOpenFS(STsdbRepo *pRepo) {
     return -1;
   }
 
+  tsdbRefreshHeadIdxCache(pfs);
   return 0;
 }
 
@@ -394,6 +402,8 @@ int tsdbEndFSTxn(STsdbRepo *pRepo) {
 
   // Apply actual change to each file and SDFileSet
   tsdbApplyFSTxnOnDisk(pfs->nstatus, pfs->cstatus);
+  tsdbDropRetiredFSetsFromCache(REPO_ID(pRepo), pfs->nstatus, pfs->cstatus);
+  tsdbRefreshHeadIdxCache(pfs);
 
   pfs->intxn = false;
   return 0;
@@ -552,6 +562,26 @@ static void tsdbApplyFSTxnOnDisk(SFSStatus *pFrom, SFSStatus *pTo) {
   }
 }
 
+static void tsdbDropRetiredFSetsFromCache(int vid, SFSStatus *pFrom, SFSStatus *pTo) {
+  if (!tsdbBlkCacheEnabled()) return;
+
+  size_t sizeFrom = taosArrayGetSize(pFrom->df);
+  for (size_t i = 0; i < sizeFrom; i++) {
+    SDFileSet *pSetFrom = taosArrayGet(pFrom->df, i);
+    SDFileSet *pSetTo = taosArraySearch(pTo->df, (void *)(&(pSetFrom->fid)), tsdbComparFidFSet, TD_EQ);
+
+    if (pSetTo != NULL &&
+        TSDB_DFILE_IN_SET(pSetFrom, TSDB_FILE_DATA)->info.magic ==
+            TSDB_DFILE_IN_SET(pSetTo, TSDB_FILE_DATA)->info.magic &&
+        TSDB_DFILE_IN_SET(pSetFrom, TSDB_FILE_LAST)->info.magic ==
+            TSDB_DFILE_IN_SET(pSetTo, TSDB_FILE_LAST)->info.magic) {
+      continue;
+    }
+
+    tsdbBlkCacheInvalidate(vid, pSetFrom->fid);
+  }
+}
+
 // ================== SFSIter
 // ASSUMPTIONS: the FS Should be read locked when calling these functions
 void tsdbFSIterInit(SFSIter *pIter, STsdbFS *pfs, int direction) {
@@ -145,6 +145,7 @@ int tsdbCloseRepo(STsdbRepo *repo, int toCommit) {
   pRepo->imem = NULL;
 
   tsdbCloseFS(pRepo);
+  tsdbBlkCacheInvalidate(vgId, TSDB_IVLD_FID);
   tsdbCloseBufPool(pRepo);
   tsdbCloseMeta(pRepo);
   tsdbFreeRepo(pRepo);
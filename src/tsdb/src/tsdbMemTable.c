@@ -36,7 +36,8 @@ typedef struct {
 
 static SMemTable *  tsdbNewMemTable(STsdbRepo *pRepo);
 static void         tsdbFreeMemTable(SMemTable *pMemTable);
-static STableData*  tsdbNewTableData(STsdbCfg *pCfg, STable *pTable);
+static STableData*  tsdbNewTableData(STsdbRepo *pRepo, STable *pTable);
+static void *       tsdbAllocSkipListNode(void *param, int32_t size);
 static void         tsdbFreeTableData(STableData *pTableData);
 static char *       tsdbGetTsTupleKey(const void *data);
 static int          tsdbAdjustMemMaxTables(SMemTable *pMemTable, int maxTables);
@@ -522,7 +523,8 @@ static void tsdbFreeMemTable(SMemTable* pMemTable) {
   }
 }
 
-static STableData *tsdbNewTableData(STsdbCfg *pCfg, STable *pTable) {
+static STableData *tsdbNewTableData(STsdbRepo *pRepo, STable *pTable) {
+  STsdbCfg *  pCfg = &(pRepo->config);
   STableData *pTableData = (STableData *)calloc(1, sizeof(*pTableData));
   if (pTableData == NULL) {
     terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
@@ -549,6 +551,9 @@ static STableData *tsdbNewTableData(STsdbCfg *pCfg, STable *pTable) {
     return NULL;
   }
 
+  // skiplist nodes live in the buffer blocks of the memtable together with the rows they point to
+  tSkipListSetNodeAllocator(pTableData->pData, tsdbAllocSkipListNode, pRepo);
+
   T_REF_INC(pTableData);
 
   return pTableData;
@@ -566,6 +571,14 @@ static void tsdbFreeTableData(STableData *pTableData) {
 
 static char *tsdbGetTsTupleKey(const void *data) { return memRowTuple((SMemRow)data); }
 
+static void *tsdbAllocSkipListNode(void *param, int32_t size) {
+  // rows are packed without padding, so align the node for the atomic pointer stores
+  char *ptr = (char *)tsdbAllocBytes((STsdbRepo *)param, size + sizeof(void *) - 1);
+  if (ptr == NULL) return NULL;
+
+  return (void *)ALIGN_NUM((uintptr_t)ptr, sizeof(void *));
+}
+
 static int tsdbAdjustMemMaxTables(SMemTable *pMemTable, int maxTables) {
   ASSERT(pMemTable->maxTables < maxTables);
 
@@ -794,7 +807,6 @@ static int tsdbInsertDataToTable(STsdbRepo* pRepo, SSubmitBlk* pBlock, int32_t *
   SSubmitBlkIter   blkIter = {0};
   SMemTable       *pMemTable = NULL;
   STableData      *pTableData = NULL;
-  STsdbCfg        *pCfg = &(pRepo->config);
 
   tsdbInitSubmitBlkIter(pBlock, &blkIter);
   if(blkIter.row == NULL) return 0;
@@ -826,7 +838,7 @@ static int tsdbInsertDataToTable(STsdbRepo* pRepo, SSubmitBlk* pBlock, int32_t *
       taosWUnLockLatch(&(pMemTable->latch));
     }
 
-    pTableData = tsdbNewTableData(pCfg, pTable);
+    pTableData = tsdbNewTableData(pRepo, pTable);
     if (pTableData == NULL) {
       tsdbError("vgId:%d failed to insert data to table %s uid %" PRId64 " tid %d since %s", REPO_ID(pRepo),
                 TABLE_CHAR_NAME(pTable), TABLE_UID(pTable), TABLE_TID(pTable), tstrerror(terrno));
@@ -18,6 +18,7 @@
 #define DEFAULT_TAG_INDEX_COLUMN 0
 
 static char *  getTagIndexKey(const void *pData);
+static char *  getTagIndexElemKey(const void *pData);
 static STable *tsdbNewTable();
 static STable *tsdbCreateTableFromCfg(STableCfg *pCfg, bool isSuper, STable *pSTable);
 static void    tsdbFreeTable(STable *pTable);
@@ -25,6 +26,10 @@ static int     tsdbAddTableToMeta(STsdbRepo *pRepo, STable *pTable, bool addIdx,
 static void    tsdbRemoveTableFromMeta(STsdbRepo *pRepo, STable *pTable, bool rmFromIdx, bool lock);
 static int     tsdbAddTableIntoIndex(STsdbMeta *pMeta, STable *pTable, bool refSuper);
 static int     tsdbRemoveTableFromIndex(STsdbMeta *pMeta, STable *pTable);
+static STagIndex *tsdbSearchTagIndex(STable *pSTable, int16_t colId);
+static int     tsdbAddTableIntoTagIndex(STagIndex *pTagIdx, STable *pTable);
+static void    tsdbRemoveTableFromTagIndex(STagIndex *pTagIdx, STable *pTable);
+static void    tsdbFreeTagIndex(STagIndex *pTagIdx);
 static int     tsdbInitTableCfg(STableCfg *config, ETableType type, uint64_t uid, int32_t tid);
 static int     tsdbTableSetSchema(STableCfg *config, STSchema *pSchema, bool dup);
 static int     tsdbTableSetName(STableCfg *config, char *name, bool dup);
@@ -388,12 +393,14 @@ int tsdbUpdateTableTagValue(STsdbRepo *repo, SUpdateTableTagValMsg *pMsg) {
     TSDB_WUNLOCK_TABLE(pTable->pSuper);
   }
 
-  bool      isChangeIndexCol = (pMsg->colId == colColId(schemaColAt(pTable->pSuper->tagSchema, 0)));
+  // the tag values are read by the tag index building of queries, which hold the meta read lock
+  tsdbWLockRepoMeta(pRepo);
+  bool isChangeIndexCol = (pMsg->colId == colColId(schemaColAt(pTable->pSuper->tagSchema, 0))) ||
+                          (tsdbSearchTagIndex(pTable->pSuper, pMsg->colId) != NULL);
   // STColumn *pCol = bsearch(&(pMsg->colId), pMsg->data, pMsg->numOfTags, sizeof(STColumn), colIdCompar);
   // ASSERT(pCol != NULL);
 
   if (isChangeIndexCol) {
-    tsdbWLockRepoMeta(pRepo);
     tsdbRemoveTableFromIndex(pMeta, pTable);
   }
   TSDB_WLOCK_TABLE(pTable);
@@ -401,8 +408,8 @@ int tsdbUpdateTableTagValue(STsdbRepo *repo, SUpdateTableTagValMsg *pMsg) {
   TSDB_WUNLOCK_TABLE(pTable);
   if (isChangeIndexCol) {
     tsdbAddTableIntoIndex(pMeta, pTable, false);
-    tsdbUnlockRepoMeta(pRepo);
   }
+  tsdbUnlockRepoMeta(pRepo);
 
   // Update on file
   int tlen1 = (pNewSchema) ? tsdbGetTableEncodeSize(TSDB_UPDATE_META, pTable->pSuper) : 0;
@@ -801,6 +808,16 @@ static char *getTagIndexKey(const void *pData) {
   return res;
 }
 
+static char *getTagIndexElemKey(const void *pData) {
+  STagIndexElem *pElem = (STagIndexElem *)pData;
+
+  void *res = tdGetKVRowValOfCol(pElem->pTable->tagVal, pElem->colId);
+  if (res == NULL) {
+    res = (char*)getNullValue(pElem->type);
+  }
+  return res;
+}
+
 static STable *tsdbNewTable() {
   STable *pTable = (STable *)calloc(1, sizeof(*pTable));
   if (pTable == NULL) {
@@ -924,6 +941,10 @@ static void tsdbFreeTable(STable *pTable) {
     kvRowFree(pTable->tagVal);
 
     tSkipListDestroy(pTable->pIndex);
+    for (int32_t i = 0; pTable->pTagIndex != NULL && i < taosArrayGetSize(pTable->pTagIndex); ++i) {
+      tsdbFreeTagIndex(taosArrayGetP(pTable->pTagIndex, i));
+    }
+    taosArrayDestroy(pTable->pTagIndex);
     taosTZfree(pTable->lastRow);    
     tfree(pTable->sql);
 
@@ -1057,6 +1078,10 @@ static int tsdbAddTableIntoIndex(STsdbMeta *pMeta, STable *pTable, bool refSuper
 
   tSkipListPut(pSTable->pIndex, (void *)pTable);
 
+  for (int32_t i = 0; pSTable->pTagIndex != NULL && i < taosArrayGetSize(pSTable->pTagIndex); ++i) {
+    tsdbAddTableIntoTagIndex(taosArrayGetP(pSTable->pTagIndex, i), pTable);
+  }
+
   if (refSuper) T_REF_INC(pSTable);
   return 0;
 }
@@ -1083,9 +1108,163 @@ static int tsdbRemoveTableFromIndex(STsdbMeta *pMeta, STable *pTable) {
   }
 
   taosArrayDestroy(res);
+
+  for (int32_t i = 0; pSTable->pTagIndex != NULL && i < taosArrayGetSize(pSTable->pTagIndex); ++i) {
+    tsdbRemoveTableFromTagIndex(taosArrayGetP(pSTable->pTagIndex, i), pTable);
+  }
   return 0;
 }
 
+// Order the binary tag values case-insensitively, so that the values matching a LIKE prefix are adjacent
+static int32_t tsdbCompareTagStr(const void *pLeft, const void *pRight) {
+  int32_t len1 = varDataLen(pLeft);
+  int32_t len2 = varDataLen(pRight);
+
+  int32_t ret = strncasecmp(varDataVal(pLeft), varDataVal(pRight), MIN(len1, len2));
+  if (ret != 0) {
+    return ret > 0 ? 1 : -1;
+  }
+
+  if (len1 == len2) {
+    return 0;
+  }
+  return len1 > len2 ? 1 : -1;
+}
+
+static STagIndex *tsdbSearchTagIndex(STable *pSTable, int16_t colId) {
+  for (int32_t i = 0; pSTable->pTagIndex != NULL && i < taosArrayGetSize(pSTable->pTagIndex); ++i) {
+    STagIndex *pTagIdx = taosArrayGetP(pSTable->pTagIndex, i);
+    if (pTagIdx->colId == colId) {
+      return pTagIdx;
+    }
+  }
+
+  return NULL;
+}
+
+static int tsdbAddTableIntoTagIndex(STagIndex *pTagIdx, STable *pTable) {
+  STagIndexElem *pElem = malloc(sizeof(STagIndexElem));
+  if (pElem == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  pElem->pTable = pTable;
+  pElem->colId = pTagIdx->colId;
+  pElem->type = pTagIdx->type;
+
+  if (tSkipListPut(pTagIdx->pList, pElem) == NULL) {
+    free(pElem);
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  return 0;
+}
+
+static void tsdbRemoveTableFromTagIndex(STagIndex *pTagIdx, STable *pTable) {
+  STagIndexElem elem = {.pTable = pTable, .colId = pTagIdx->colId, .type = pTagIdx->type};
+
+  SArray *res = tSkipListGet(pTagIdx->pList, getTagIndexElemKey(&elem));
+  for (int32_t i = 0; i < taosArrayGetSize(res); ++i) {
+    SSkipListNode *pNode = taosArrayGetP(res, i);
+
+    STagIndexElem *pElem = (STagIndexElem *)SL_GET_NODE_DATA(pNode);
+    if (pElem->pTable == pTable) {
+      tSkipListRemoveNode(pTagIdx->pList, pNode);
+      free(pElem);
+    }
+  }
+
+  taosArrayDestroy(res);
+}
+
+static void tsdbFreeTagIndex(STagIndex *pTagIdx) {
+  if (pTagIdx == NULL) return;
+
+  SSkipListIterator *pIter = tSkipListCreateIter(pTagIdx->pList);
+  while (tSkipListIterNext(pIter)) {
+    free(SL_GET_NODE_DATA(tSkipListIterGet(pIter)));
+  }
+  tSkipListDestroyIter(pIter);
+
+  tSkipListDestroy(pTagIdx->pList);
+  free(pTagIdx);
+}
+
+static STagIndex *tsdbNewTagIndex(STable *pSTable, STColumn *pCol) {
+  STagIndex *pTagIdx = calloc(1, sizeof(STagIndex));
+  if (pTagIdx == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return NULL;
+  }
+
+  pTagIdx->colId = colColId(pCol);
+  pTagIdx->type = colType(pCol);
+
+  __compar_fn_t comparFn = (colType(pCol) == TSDB_DATA_TYPE_BINARY) ? tsdbCompareTagStr : NULL;
+  pTagIdx->pList = tSkipListCreate(TSDB_SUPER_TABLE_SL_LEVEL, colType(pCol), (uint16_t)colBytes(pCol), comparFn,
+                                   SL_ALLOW_DUP_KEY, getTagIndexElemKey);
+  if (pTagIdx->pList == NULL) {
+    free(pTagIdx);
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return NULL;
+  }
+
+  SSkipListIterator *pIter = tSkipListCreateIter(pSTable->pIndex);
+  while (tSkipListIterNext(pIter)) {
+    STable *pTable = (STable *)SL_GET_NODE_DATA(tSkipListIterGet(pIter));
+    if (tsdbAddTableIntoTagIndex(pTagIdx, pTable) < 0) {
+      tSkipListDestroyIter(pIter);
+      tsdbFreeTagIndex(pTagIdx);
+      return NULL;
+    }
+  }
+  tSkipListDestroyIter(pIter);
+
+  return pTagIdx;
+}
+
+/**
+ * Get the secondary index of a tag column of the super table. The index is built on the first use if the super table
+ * has at least tsTagIndexMinTables child tables, and is maintained when the child tables are created, dropped or
+ * their tag values are changed. The caller should hold the meta read lock.
+ */
+STagIndex *tsdbGetTagIndex(STable *pSTable, int16_t colId) {
+  ASSERT(TABLE_TYPE(pSTable) == TSDB_SUPER_TABLE);
+
+  TSDB_RLOCK_TABLE(pSTable);
+  STagIndex *pTagIdx = tsdbSearchTagIndex(pSTable, colId);
+  TSDB_RUNLOCK_TABLE(pSTable);
+
+  if (pTagIdx != NULL || tsTagIndexMinTables <= 0 || SL_SIZE(pSTable->pIndex) < (uint32_t)tsTagIndexMinTables) {
+    return pTagIdx;
+  }
+
+  TSDB_WLOCK_TABLE(pSTable);
+  pTagIdx = tsdbSearchTagIndex(pSTable, colId);
+  if (pTagIdx == NULL) {
+    STColumn *pCol = tdGetColOfID(pSTable->tagSchema, colId);
+    if (pCol != NULL) {
+      int64_t st = taosGetTimestampUs();
+
+      if (pSTable->pTagIndex == NULL) {
+        pSTable->pTagIndex = taosArrayInit(4, POINTER_BYTES);
+      }
+
+      if (pSTable->pTagIndex != NULL && (pTagIdx = tsdbNewTagIndex(pSTable, pCol)) != NULL) {
+        taosArrayPush(pSTable->pTagIndex, &pTagIdx);
+        tsdbDebug("super table %s uid %" PRIu64 " tag index on colId %d is built, %u tables, elapsed time:%" PRId64
+                  " us", TABLE_CHAR_NAME(pSTable), TABLE_UID(pSTable), colId, SL_SIZE(pSTable->pIndex),
+                  taosGetTimestampUs() - st);
+      }
+    }
+  }
+  TSDB_WUNLOCK_TABLE(pSTable);
+
+  return pTagIdx;
+}
+
 static int tsdbInitTableCfg(STableCfg *config, ETableType type, uint64_t uid, int32_t tid) {
   if (type != TSDB_CHILD_TABLE && type != TSDB_NORMAL_TABLE && type != TSDB_STREAM_TABLE) {
     terrno = TSDB_CODE_TDB_INVALID_TABLE_TYPE;
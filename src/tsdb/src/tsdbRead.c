@@ -22,6 +22,7 @@
 #include "exception.h"
 
 #include "taosdef.h"
+#include "tglobal.h"
 #include "tlosertree.h"
 #include "tsdbint.h"
 #include "texpr.h"
@@ -90,6 +91,9 @@ typedef struct STableCheckInfo {
   bool          initBuf;        // whether to initialize the in-memory skip list iterator or not
   SSkipListIterator* iter;      // mem buffer skip list iterator
   SSkipListIterator* iiter;     // imem buffer skip list iterator
+  SDataStatis*  pBlockStatis;   // statistics loaded by pruning, QH_GET_NUM_OF_COLS entries for each qualified block
+  bool*         statisLoaded;   // whether the statistics of each qualified block are kept in pBlockStatis
+  int32_t       statisSize;     // number of blocks that pBlockStatis can hold
 } STableCheckInfo;
 
 typedef struct STableBlockInfo {
@@ -110,6 +114,9 @@ typedef struct SIOCostSummary {
   int64_t checkForNextTime;
   int64_t headFileLoad;
   int64_t headFileLoadTime;
+  int64_t prefetchBlocks;
+  int64_t prunedBlocks;
+  int64_t prunedFileSets;
 } SIOCostSummary;
 
 typedef struct STsdbQueryHandle {
@@ -138,7 +145,10 @@ typedef struct STsdbQueryHandle {
   STableBlockInfo* pDataBlockInfo;
   SDataCols     *pDataCols;        // in order to hold current file data block
   int32_t        allocSize;        // allocated data block size
+  int32_t        prefetchSlot;     // the farthest slot in pDataBlockInfo that has been read ahead
   SMemRef       *pMemRef;
+  __block_filter_fn_t blockFilterFp; // prune the file data blocks by their statistics before loading them
+  void          *blockFilterParam;
   SArray        *defaultLoadColumn;// default load column
   SDataBlockLoadInfo dataBlockLoadInfo; /* record current block load information */
   SLoadCompBlockInfo compBlockLoadInfo; /* record current compblock information in SQueryAttr */
@@ -154,6 +164,17 @@ typedef struct STableGroupSupporter {
   STSchema*  pTagSchema;
 } STableGroupSupporter;
 
+// group by columns of one table, encoded as ranks in the per-column value dictionary, -1 for NULL
+typedef struct STableGroupKey {
+  STable*  pTable;
+  int32_t* pCode;
+} STableGroupKey;
+
+typedef struct STagDictEntry {
+  char*   val;
+  int32_t slot;
+} STagDictEntry;
+
 static STimeWindow updateLastrowForEachGroup(STableGroupInfo *groupList);
 static int32_t checkForCachedLastRow(STsdbQueryHandle* pQueryHandle, STableGroupInfo *groupList);
 static int32_t checkForCachedLast(STsdbQueryHandle* pQueryHandle);
@@ -162,6 +183,7 @@ static int32_t tsdbGetCachedLastRow(STable* pTable, SMemRow* pRes, TSKEY* lastKe
 
 static void    changeQueryHandleForInterpQuery(TsdbQueryHandleT pHandle);
 static void    doMergeTwoLevelData(STsdbQueryHandle* pQueryHandle, STableCheckInfo* pCheckInfo, SBlock* pBlock);
+static void    doPrefetchFileDataBlocks(STsdbQueryHandle* pQueryHandle);
 static int32_t binarySearchForKey(char* pValue, int num, TSKEY key, int order);
 static int32_t tsdbReadRowsFromCache(STableCheckInfo* pCheckInfo, TSKEY maxKey, int maxRowsToRead, STimeWindow* win, STsdbQueryHandle* pQueryHandle);
 static int32_t tsdbCheckInfoCompar(const void* key1, const void* key2);
@@ -423,6 +445,8 @@ static STsdbQueryHandle* tsdbQueryTablesImpl(STsdbRepo* tsdb, STsdbQueryCond* pC
   pQueryHandle->locateStart = false;
   pQueryHandle->pMemRef     = pMemRef;
   pQueryHandle->loadType    = pCond->type;
+  pQueryHandle->blockFilterFp    = pCond->blockFilterFp;
+  pQueryHandle->blockFilterParam = pCond->blockFilterParam;
 
   pQueryHandle->outputCapacity  = ((STsdbRepo*)tsdb)->config.maxRowsPerFileBlock;
   pQueryHandle->loadExternalRow = pCond->loadExternalRows;
@@ -536,6 +560,8 @@ void tsdbResetQueryHandle(TsdbQueryHandleT queryHandle, STsdbQueryCond *pCond) {
   pQueryHandle->activeIndex = 0;   // current active table index
   pQueryHandle->locateStart = false;
   pQueryHandle->loadExternalRow = pCond->loadExternalRows;
+  pQueryHandle->blockFilterFp    = pCond->blockFilterFp;
+  pQueryHandle->blockFilterParam = pCond->blockFilterParam;
 
   if (ASCENDING_TRAVERSE(pCond->order)) {
     assert(pQueryHandle->window.skey <= pQueryHandle->window.ekey);
@@ -564,6 +590,8 @@ void tsdbResetQueryHandleForNewTable(TsdbQueryHandleT queryHandle, STsdbQueryCon
   pQueryHandle->activeIndex = 0;   // current active table index
   pQueryHandle->locateStart = false;
   pQueryHandle->loadExternalRow = pCond->loadExternalRows;
+  pQueryHandle->blockFilterFp    = pCond->blockFilterFp;
+  pQueryHandle->blockFilterParam = pCond->blockFilterParam;
 
   if (ASCENDING_TRAVERSE(pCond->order)) {
     assert(pQueryHandle->window.skey <= pQueryHandle->window.ekey);
@@ -1062,6 +1090,140 @@ static int32_t binarySearchForBlock(SBlock* pBlock, int32_t numOfBlocks, TSKEY s
   return midSlot;
 }
 
+static void doFillBlockStatis(STsdbQueryHandle* pQueryHandle, SBlock* pBlock) {
+  int16_t* colIds = pQueryHandle->defaultLoadColumn->pData;
+
+  size_t numOfCols = QH_GET_NUM_OF_COLS(pQueryHandle);
+  memset(pQueryHandle->statis, 0, numOfCols * sizeof(SDataStatis));
+  for(int32_t i = 0; i < numOfCols; ++i) {
+    pQueryHandle->statis[i].colId = colIds[i];
+  }
+
+  tsdbGetBlockStatis(&pQueryHandle->rhelper, pQueryHandle->statis, (int)numOfCols, pBlock);
+
+  // always load the first primary timestamp column data
+  SDataStatis* pPrimaryColStatis = &pQueryHandle->statis[0];
+  assert(pPrimaryColStatis->colId == PRIMARYKEY_TIMESTAMP_COL_INDEX);
+
+  pPrimaryColStatis->numOfNull = 0;
+  pPrimaryColStatis->min = pBlock->keyFirst;
+  pPrimaryColStatis->max = pBlock->keyLast;
+
+  //update the number of NULL data rows
+  for(int32_t i = 1; i < numOfCols; ++i) {
+    if (pQueryHandle->statis[i].numOfNull == -1) { // set the column data are all NULL
+      pQueryHandle->statis[i].numOfNull = pBlock->numOfRows;
+    }
+  }
+}
+
+// the key range of the data of this table in mem and imem buffer
+static STimeWindow getTableMemKeyRange(STsdbQueryHandle* pQueryHandle, STableCheckInfo* pCheckInfo) {
+  STimeWindow w = {.skey = INT64_MAX, .ekey = INT64_MIN};
+
+  SMemTable* pMemT[2] = {pQueryHandle->pMemRef->snapshot.mem, pQueryHandle->pMemRef->snapshot.imem};
+  for (int32_t i = 0; i < tListLen(pMemT); ++i) {
+    if (pMemT[i] == NULL || pCheckInfo->tableId.tid >= pMemT[i]->maxTables) {
+      continue;
+    }
+
+    STableData* pTableData = pMemT[i]->tData[pCheckInfo->tableId.tid];
+    if (pTableData == NULL || pTableData->uid != pCheckInfo->tableId.uid || pTableData->numOfRows == 0) {
+      continue;
+    }
+
+    w.skey = MIN(w.skey, pTableData->keyFirst);
+    w.ekey = MAX(w.ekey, pTableData->keyLast);
+  }
+
+  return w;
+}
+
+static int32_t allocBlockStatisBuf(STableCheckInfo* pCheckInfo, int32_t numOfBlocks, size_t numOfCols) {
+  if (pCheckInfo->statisSize < numOfBlocks) {
+    SDataStatis* pStatis = realloc(pCheckInfo->pBlockStatis, sizeof(SDataStatis) * numOfCols * numOfBlocks);
+    if (pStatis == NULL) {
+      return TSDB_CODE_TDB_OUT_OF_MEMORY;
+    }
+    pCheckInfo->pBlockStatis = pStatis;
+
+    bool* loaded = realloc(pCheckInfo->statisLoaded, sizeof(bool) * numOfBlocks);
+    if (loaded == NULL) {
+      return TSDB_CODE_TDB_OUT_OF_MEMORY;
+    }
+    pCheckInfo->statisLoaded = loaded;
+    pCheckInfo->statisSize = numOfBlocks;
+  }
+
+  if (numOfBlocks > 0) {
+    memset(pCheckInfo->statisLoaded, 0, sizeof(bool) * numOfBlocks);
+  }
+  return TSDB_CODE_SUCCESS;
+}
+
+/*
+ * Check the pre-calculated statistics of the data blocks against the block filter of the query, and discard the blocks
+ * that have no qualified rows, so they are neither put into the block list nor read from the data file. Only the blocks
+ * with their statistics kept in the separated .smad/.smal file are checked, and the blocks overlapped with the data in
+ * buffer are always kept, since the rows in buffer may be merged with the rows in file block. The statistics of the
+ * qualified blocks are kept, so they are not loaded again when the blocks are scanned.
+ */
+static int32_t doPruneFileBlocks(STsdbQueryHandle* pQueryHandle, STableCheckInfo* pCheckInfo) {
+  SBlock*     pBlocks = pCheckInfo->pCompInfo->blocks;
+  STimeWindow memWin = getTableMemKeyRange(pQueryHandle, pCheckInfo);
+  size_t      numOfCols = QH_GET_NUM_OF_COLS(pQueryHandle);
+
+  int32_t code = allocBlockStatisBuf(pCheckInfo, pCheckInfo->numOfBlocks, numOfCols);
+  if (code != TSDB_CODE_SUCCESS) {
+    return code;
+  }
+
+  int64_t stime = taosGetTimestampUs();
+  int32_t numOfQualified = 0;
+
+  for (int32_t i = 0; i < pCheckInfo->numOfBlocks; ++i) {
+    SBlock* pBlock = &pBlocks[i];
+
+    bool keep = true;
+    bool loaded = false;
+    if (pBlock->numOfSubBlocks <= 1 && pBlock->blkVer > TSDB_SBLK_VER_0 && pBlock->aggrStat &&
+        (pBlock->keyFirst > memWin.ekey || pBlock->keyLast < memWin.skey)) {
+      if (tsdbLoadBlockStatis(&pQueryHandle->rhelper, pBlock) < TSDB_STATIS_OK) {
+        tsdbError("%p failed to load the statistics of block %d for pruning since %s, 0x%"PRIx64, pQueryHandle, i,
+                  tstrerror(terrno), pQueryHandle->qId);
+        pQueryHandle->cost.statisInfoLoadTime += (taosGetTimestampUs() - stime);
+        return terrno;
+      }
+
+      doFillBlockStatis(pQueryHandle, pBlock);
+      keep = pQueryHandle->blockFilterFp(pQueryHandle->blockFilterParam, pQueryHandle->statis, (int32_t)numOfCols,
+                                         pBlock->numOfRows);
+      loaded = true;
+    }
+
+    if (!keep) {
+      pQueryHandle->cost.prunedBlocks += 1;
+      continue;
+    }
+
+    if (numOfQualified != i) {
+      pBlocks[numOfQualified] = *pBlock;
+    }
+
+    if (loaded) {
+      memcpy(&pCheckInfo->pBlockStatis[numOfQualified * numOfCols], pQueryHandle->statis,
+             sizeof(SDataStatis) * numOfCols);
+      pCheckInfo->statisLoaded[numOfQualified] = true;
+    }
+
+    numOfQualified += 1;
+  }
+
+  pQueryHandle->cost.statisInfoLoadTime += (taosGetTimestampUs() - stime);
+  pCheckInfo->numOfBlocks = numOfQualified;
+  return TSDB_CODE_SUCCESS;
+}
+
 static int32_t loadBlockInfo(STsdbQueryHandle * pQueryHandle, int32_t index, int32_t* numOfBlocks) {
   int32_t code = 0;
 
@@ -1118,6 +1280,14 @@ static int32_t loadBlockInfo(STsdbQueryHandle * pQueryHandle, int32_t index, int
     memmove(pCompInfo->blocks, &pCompInfo->blocks[start], pCheckInfo->numOfBlocks * sizeof(SBlock));
   }
 
+  if (pQueryHandle->blockFilterFp != NULL) {
+    code = doPruneFileBlocks(pQueryHandle, pCheckInfo);
+    if (code != TSDB_CODE_SUCCESS) {
+      pCheckInfo->numOfBlocks = 0;
+      return code;
+    }
+  }
+
   (*numOfBlocks) += pCheckInfo->numOfBlocks;
   return 0;
 }
@@ -1181,6 +1351,8 @@ static int32_t doLoadFileDataBlock(STsdbQueryHandle* pQueryHandle, SBlock* pBloc
 
   int16_t* colIds = pQueryHandle->defaultLoadColumn->pData;
 
+  doPrefetchFileDataBlocks(pQueryHandle);
+
   int32_t ret = tsdbLoadBlockDataCols(&(pQueryHandle->rhelper), pBlock, pCheckInfo->pCompInfo, colIds, (int)(QH_GET_NUM_OF_COLS(pQueryHandle)));
   if (ret != TSDB_CODE_SUCCESS) {
     int32_t c = terrno;
@@ -2361,15 +2533,20 @@ static int32_t getFirstFileDataBlock(STsdbQueryHandle* pQueryHandle, bool* exist
       break;
     }
 
+    int64_t prunedBlocks = pQueryHandle->cost.prunedBlocks;
     if ((code = getFileCompInfo(pQueryHandle, &numOfBlocks)) != TSDB_CODE_SUCCESS) {
       break;
     }
 
-    tsdbDebug("%p %d blocks found in file for %d table(s), fid:%d, 0x%"PRIx64, pQueryHandle, numOfBlocks, numOfTables,
-              pQueryHandle->pFileGroup->fid, pQueryHandle->qId);
+    prunedBlocks = pQueryHandle->cost.prunedBlocks - prunedBlocks;
+    tsdbDebug("%p %d blocks found in file for %d table(s), %" PRId64 " blocks pruned, fid:%d, 0x%"PRIx64, pQueryHandle,
+              numOfBlocks, numOfTables, prunedBlocks, pQueryHandle->pFileGroup->fid, pQueryHandle->qId);
 
     assert(numOfBlocks >= 0);
     if (numOfBlocks == 0) {
+      if (prunedBlocks > 0) {  // all blocks in this file set are discarded by the block filter
+        pQueryHandle->cost.prunedFileSets += 1;
+      }
       continue;
     }
 
@@ -2398,11 +2575,86 @@ static int32_t getFirstFileDataBlock(STsdbQueryHandle* pQueryHandle, bool* exist
   assert(pQueryHandle->pFileGroup != NULL && pQueryHandle->numOfBlocks > 0);
   cur->slot = ASCENDING_TRAVERSE(pQueryHandle->order)? 0:pQueryHandle->numOfBlocks-1;
   cur->fid = pQueryHandle->pFileGroup->fid;
+  pQueryHandle->prefetchSlot = cur->slot;
 
   STableBlockInfo* pBlockInfo = &pQueryHandle->pDataBlockInfo[cur->slot];
   return getDataBlockRv(pQueryHandle, pBlockInfo, exists);
 }
 
+typedef struct SPrefetchRange {
+  SDFile* pDFile;
+  int64_t offset;
+  int64_t len;
+} SPrefetchRange;
+
+static void addPrefetchRange(SPrefetchRange* pRange, SDFile* pDFile, int64_t offset, int64_t len) {
+  // coalesce adjacent ranges of the same file into one advice
+  if (pRange->pDFile == pDFile && pRange->offset + pRange->len == offset) {
+    pRange->len += len;
+    return;
+  }
+
+  if (pRange->pDFile != NULL) {
+    tsdbAdviseDFile(pRange->pDFile, pRange->offset, pRange->len);
+  }
+
+  pRange->pDFile = pDFile;
+  pRange->offset = offset;
+  pRange->len = len;
+}
+
+/*
+ * Blocks in pDataBlockInfo are visited in the order of their file offset, so the ranges of the next blocks are handed
+ * to the kernel to be read in background while the current block is decompressed and consumed by the operators.
+ */
+static void doPrefetchFileDataBlocks(STsdbQueryHandle* pQueryHandle) {
+  SQueryFilePos* cur = &pQueryHandle->cur;
+  int32_t        depth = tsdbReadAheadBlocks;
+  int32_t        step = ASCENDING_TRAVERSE(pQueryHandle->order)? 1 : -1;
+
+  if (depth <= 0 || pQueryHandle->numOfBlocks <= 1 || pQueryHandle->pDataBlockInfo == NULL) {
+    return;
+  }
+
+  // read ahead in batches of half of the depth, so that the advices are not issued for each block
+  int32_t ahead = (pQueryHandle->prefetchSlot - cur->slot) * step;
+  if (ahead > depth / 2) {
+    return;
+  }
+
+  int32_t start = (ahead > 0)? pQueryHandle->prefetchSlot + step : cur->slot + step;
+  int32_t end = cur->slot + step * depth;
+  if (end < 0) {
+    end = 0;
+  } else if (end >= pQueryHandle->numOfBlocks) {
+    end = pQueryHandle->numOfBlocks - 1;
+  }
+
+  SPrefetchRange range = {0};
+  for (int32_t slot = start; (step > 0)? (slot <= end) : (slot >= end); slot += step) {
+    STableBlockInfo* pBlockInfo = &pQueryHandle->pDataBlockInfo[slot];
+    SBlock*          pBlock = pBlockInfo->compBlock;
+    SDFile*          pDFile = pBlock->last? TSDB_READ_LAST_FILE(&pQueryHandle->rhelper) : TSDB_READ_DATA_FILE(&pQueryHandle->rhelper);
+
+    if (pBlock->numOfSubBlocks > 1) {
+      SBlock* pSubBlock = POINTER_SHIFT(pBlockInfo->pTableCheckInfo->pCompInfo, pBlock->offset);
+      for (int32_t i = 0; i < pBlock->numOfSubBlocks; ++i, ++pSubBlock) {
+        pDFile = pSubBlock->last? TSDB_READ_LAST_FILE(&pQueryHandle->rhelper) : TSDB_READ_DATA_FILE(&pQueryHandle->rhelper);
+        addPrefetchRange(&range, pDFile, pSubBlock->offset, pSubBlock->len);
+      }
+    } else {
+      addPrefetchRange(&range, pDFile, pBlock->offset, pBlock->len);
+    }
+
+    pQueryHandle->prefetchSlot = slot;
+    pQueryHandle->cost.prefetchBlocks++;
+  }
+
+  if (range.pDFile != NULL) {
+    tsdbAdviseDFile(range.pDFile, range.offset, range.len);
+  }
+}
+
 static bool isEndFileDataBlock(SQueryFilePos* cur, int32_t numOfBlocks, bool ascTrav) {
   assert(cur != NULL && numOfBlocks > 0);
   return (cur->slot == numOfBlocks - 1 && ascTrav) || (cur->slot == 0 && !ascTrav);
@@ -2512,6 +2764,55 @@ int32_t tsdbGetFileBlocksDistInfo(TsdbQueryHandleT* queryHandle, STableBlockDist
   return code;
 }
 
+int32_t tsdbSplitQueryWindow(STsdbRepo* tsdb, STimeWindow* pWin, STimeWindow* pParts, int32_t maxParts) {
+  STsdbFS*  pfs = REPO_FS(tsdb);
+  STsdbCfg* pCfg = &tsdb->config;
+  SFSIter   iter;
+
+  pParts[0] = *pWin;
+  if (maxParts <= 1 || pWin->skey > pWin->ekey) {
+    return 1;
+  }
+
+  // the start key of each file set overlapping with the query time window, in ascending order
+  SArray* pKeys = taosArrayInit(8, sizeof(TSKEY));
+  if (pKeys == NULL) {
+    return 1;
+  }
+
+  tsdbRLockFS(pfs);
+  tsdbFSIterInit(&iter, pfs, TSDB_FS_ITER_FORWARD);
+  tsdbFSIterSeek(&iter, getFileIdFromKey(pWin->skey, pCfg->daysPerFile, pCfg->precision));
+
+  SDFileSet* pSet = NULL;
+  while ((pSet = tsdbFSIterNext(&iter)) != NULL) {
+    STimeWindow win = TSWINDOW_INITIALIZER;
+    tsdbGetFidKeyRange(pCfg->daysPerFile, pCfg->precision, pSet->fid, &win.skey, &win.ekey);
+    if (win.skey > pWin->ekey) {
+      break;
+    }
+
+    taosArrayPush(pKeys, &win.skey);
+  }
+  tsdbUnLockFS(pfs);
+
+  int32_t numOfFiles = (int32_t)taosArrayGetSize(pKeys);
+  int32_t numOfParts = MIN(maxParts, numOfFiles);
+
+  // each part holds a run of consecutive file sets, the first and last parts also cover the query time window
+  // out of the file sets, i.e., data only in the cache.
+  for (int32_t i = 1; i < numOfParts; ++i) {
+    TSKEY skey = *(TSKEY*)taosArrayGet(pKeys, (int32_t)((int64_t)i * numOfFiles / numOfParts));
+    pParts[i - 1].ekey = skey - 1;
+    pParts[i].skey = skey;
+  }
+
+  pParts[MAX(numOfParts, 1) - 1].ekey = pWin->ekey;
+
+  taosArrayDestroy(pKeys);
+  return MAX(numOfParts, 1);
+}
+
 static int32_t getDataBlocksInFiles(STsdbQueryHandle* pQueryHandle, bool* exists) {
   STsdbFS*       pFileHandle = REPO_FS(pQueryHandle->pTsdb);
   SQueryFilePos* cur = &pQueryHandle->cur;
@@ -3011,6 +3312,7 @@ bool tsdbNextDataBlock(TsdbQueryHandleT pHandle) {
         pQueryHandle->activeIndex = 0;
         pQueryHandle->checkFiles = false;
 
+        terrno = code;
         return false;
       }
 
@@ -3377,6 +3679,19 @@ int32_t tsdbRetrieveDataBlockStatisInfo(TsdbQueryHandleT* pQueryHandle, SDataSta
   }
 
   int64_t stime = taosGetTimestampUs();
+
+  // the statistics have been loaded when the block was checked for pruning
+  STableCheckInfo* pCheckInfo = pBlockInfo->pTableCheckInfo;
+  int32_t          index = (int32_t)(pBlockInfo->compBlock - pCheckInfo->pCompInfo->blocks);
+  if (pCheckInfo->statisLoaded != NULL && index < pCheckInfo->statisSize && pCheckInfo->statisLoaded[index]) {
+    size_t numOfCols = QH_GET_NUM_OF_COLS(pHandle);
+    memcpy(pHandle->statis, &pCheckInfo->pBlockStatis[index * numOfCols], sizeof(SDataStatis) * numOfCols);
+
+    pHandle->cost.statisInfoLoadTime += (taosGetTimestampUs() - stime);
+    *pBlockStatis = pHandle->statis;
+    return TSDB_CODE_SUCCESS;
+  }
+
   int     statisStatus = tsdbLoadBlockStatis(&pHandle->rhelper, pBlockInfo->compBlock);
   if (statisStatus < TSDB_STATIS_OK) {
     return terrno;
@@ -3385,30 +3700,7 @@ int32_t tsdbRetrieveDataBlockStatisInfo(TsdbQueryHandleT* pQueryHandle, SDataSta
     return TSDB_CODE_SUCCESS;
   }
 
-  int16_t* colIds = pHandle->defaultLoadColumn->pData;
-
-  size_t numOfCols = QH_GET_NUM_OF_COLS(pHandle);
-  memset(pHandle->statis, 0, numOfCols * sizeof(SDataStatis));
-  for(int32_t i = 0; i < numOfCols; ++i) {
-    pHandle->statis[i].colId = colIds[i];
-  }
-
-  tsdbGetBlockStatis(&pHandle->rhelper, pHandle->statis, (int)numOfCols, pBlockInfo->compBlock);
-
-  // always load the first primary timestamp column data
-  SDataStatis* pPrimaryColStatis = &pHandle->statis[0];
-  assert(pPrimaryColStatis->colId == PRIMARYKEY_TIMESTAMP_COL_INDEX);
-
-  pPrimaryColStatis->numOfNull = 0;
-  pPrimaryColStatis->min = pBlockInfo->compBlock->keyFirst;
-  pPrimaryColStatis->max = pBlockInfo->compBlock->keyLast;
-
-  //update the number of NULL data rows
-  for(int32_t i = 1; i < numOfCols; ++i) {
-    if (pHandle->statis[i].numOfNull == -1) { // set the column data are all NULL
-      pHandle->statis[i].numOfNull = pBlockInfo->compBlock->numOfRows;
-    }
-  }
+  doFillBlockStatis(pHandle, pBlockInfo->compBlock);
 
   int64_t elapsed = taosGetTimestampUs() - stime;
   pHandle->cost.statisInfoLoadTime += elapsed;
@@ -3517,59 +3809,124 @@ void filterPrepare(void* expr, void* param) {
   }
 }
 
-static int32_t tableGroupComparFn(const void *p1, const void *p2, const void *param) {
-  STableGroupSupporter* pTableGroupSupp = (STableGroupSupporter*) param;
-  STable* pTable1 = ((STableKeyInfo*) p1)->pTable;
-  STable* pTable2 = ((STableKeyInfo*) p2)->pTable;
+static char* getTableGroupColVal(STableGroupSupporter* pSupp, STable* pTable, int32_t index, int32_t* type,
+                                 int32_t* bytes) {
+  int32_t colIndex = pSupp->pCols[index].colIndex;
+  assert(colIndex >= TSDB_TBNAME_COLUMN_INDEX);
 
-  for (int32_t i = 0; i < pTableGroupSupp->numOfCols; ++i) {
-    SColIndex* pColIndex = &pTableGroupSupp->pCols[i];
-    int32_t colIndex = pColIndex->colIndex;
+  if (colIndex == TSDB_TBNAME_COLUMN_INDEX) {
+    *type = TSDB_DATA_TYPE_BINARY;
+    *bytes = tGetTbnameColumnSchema()->bytes;
+    return (char*) TABLE_NAME(pTable);
+  }
 
-    assert(colIndex >= TSDB_TBNAME_COLUMN_INDEX);
+  if (pSupp->pTagSchema && colIndex < pSupp->pTagSchema->numOfCols) {
+    STColumn* pCol = schemaColAt(pSupp->pTagSchema, colIndex);
+    *type = pCol->type;
+    *bytes = pCol->bytes;
+    return tdGetKVRowValOfCol(pTable->tagVal, pCol->colId);
+  }
 
-    char *  f1 = NULL;
-    char *  f2 = NULL;
-    int32_t type = 0;
-    int32_t bytes = 0;
+  return NULL;
+}
 
-    if (colIndex == TSDB_TBNAME_COLUMN_INDEX) {
-      f1 = (char*) TABLE_NAME(pTable1);
-      f2 = (char*) TABLE_NAME(pTable2);
-      type = TSDB_DATA_TYPE_BINARY;
-      bytes = tGetTbnameColumnSchema()->bytes;
-    } else {
-      if (pTableGroupSupp->pTagSchema && colIndex < pTableGroupSupp->pTagSchema->numOfCols) {
-        STColumn* pCol = schemaColAt(pTableGroupSupp->pTagSchema, colIndex);
-        bytes = pCol->bytes;
-        type = pCol->type;
-        f1 = tdGetKVRowValOfCol(pTable1->tagVal, pCol->colId);
-        f2 = tdGetKVRowValOfCol(pTable2->tagVal, pCol->colId);
-      } 
+static int32_t tagDictEntryComparFn(const void *p1, const void *p2, const void *param) {
+  const int32_t* pType = param;
+  return doCompare(((STagDictEntry*) p1)->val, ((STagDictEntry*) p2)->val, pType[0], pType[1]);
+}
+
+static int32_t tableGroupKeyComparFn(const void *p1, const void *p2, const void *param) {
+  int32_t numOfCols = *(int32_t*) param;
+  int32_t* c1 = ((STableGroupKey*) p1)->pCode;
+  int32_t* c2 = ((STableGroupKey*) p2)->pCode;
+
+  for (int32_t i = 0; i < numOfCols; ++i) {
+    if (c1[i] != c2[i]) {
+      return (c1[i] < c2[i]) ? -1 : 1;
     }
+  }
+
+  return 0;
+}
+
+/*
+ * Replace the value of group by column index of each table with its rank among the distinct values of this column,
+ * so that tables are sorted and grouped on small integers instead of decoding and comparing the tag values for each
+ * comparison. Values that doCompare treats as equal share the same code, and NULL(-1) sorts first.
+ */
+static int32_t encodeTableGroupCol(STableGroupSupporter* pSupp, STableGroupKey* pKeys, size_t numOfTables,
+                                   int32_t index) {
+  int32_t  code = TSDB_CODE_SUCCESS;
+  int32_t  param[2] = {0};
+  int32_t* pRank = NULL;
+
+  SHashObj* pDict = taosHashInit(256, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), false, HASH_NO_LOCK);
+  SArray*   pVals = taosArrayInit(256, sizeof(STagDictEntry));
+  if (pDict == NULL || pVals == NULL) {
+    code = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    goto _end;
+  }
 
-    // this tags value may be NULL
-    if (f1 == NULL && f2 == NULL) {
+  for (int32_t i = 0; i < numOfTables; ++i) {
+    char* val = getTableGroupColVal(pSupp, pKeys[i].pTable, index, &param[0], &param[1]);
+    if (val == NULL) {
+      pKeys[i].pCode[index] = -1;
       continue;
     }
 
-    if (f1 == NULL) {
-      return -1;
+    int32_t  keyLen = IS_VAR_DATA_TYPE(param[0]) ? varDataTLen(val) : param[1];
+    int32_t* pSlot = taosHashGet(pDict, val, keyLen);
+    if (pSlot != NULL) {
+      pKeys[i].pCode[index] = *pSlot;
+      continue;
     }
 
-    if (f2 == NULL) {
-      return 1;
+    STagDictEntry entry = {.val = val, .slot = (int32_t)taosArrayGetSize(pVals)};
+    if (taosArrayPush(pVals, &entry) == NULL || taosHashPut(pDict, val, keyLen, &entry.slot, sizeof(int32_t)) != 0) {
+      code = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      goto _end;
     }
 
-    int32_t ret = doCompare(f1, f2, type, bytes);
-    if (ret == 0) {
-      continue;
-    } else {
-      return ret;
+    pKeys[i].pCode[index] = entry.slot;
+  }
+
+  size_t numOfVals = taosArrayGetSize(pVals);
+  if (numOfVals == 0) {
+    goto _end;
+  }
+
+  pRank = malloc(numOfVals * sizeof(int32_t));
+  if (pRank == NULL) {
+    code = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    goto _end;
+  }
+
+  taosqsort(pVals->pData, numOfVals, sizeof(STagDictEntry), param, tagDictEntryComparFn);
+
+  int32_t rank = 0;
+  for (int32_t i = 0; i < numOfVals; ++i) {
+    STagDictEntry* pEntry = taosArrayGet(pVals, i);
+    if (i > 0 && tagDictEntryComparFn(pEntry - 1, pEntry, param) != 0) {
+      rank += 1;
     }
+
+    pRank[pEntry->slot] = rank;
   }
 
-  return 0;
+  for (int32_t i = 0; i < numOfTables; ++i) {
+    if (pKeys[i].pCode[index] >= 0) {
+      pKeys[i].pCode[index] = pRank[pKeys[i].pCode[index]];
+    }
+  }
+
+  tsdbDebug("group by column:%d, %" PRIzu " tables, %d distinct values", pSupp->pCols[index].colIndex, numOfTables,
+            rank + 1);
+
+_end:
+  tfree(pRank);
+  taosArrayDestroy(pVals);
+  taosHashCleanup(pDict);
+  return code;
 }
 
 static int tsdbCheckInfoCompar(const void* key1, const void* key2) {
@@ -3583,39 +3940,54 @@ static int tsdbCheckInfoCompar(const void* key1, const void* key2) {
   }
 }
 
-void createTableGroupImpl(SArray* pGroups, SArray* pTableList, size_t numOfTables, TSKEY skey,
-                          STableGroupSupporter* pSupp, __ext_compar_fn_t compareFn) {
-  STable* pTable = taosArrayGetP(pTableList, 0);
+static int32_t createTableGroupImpl(SArray* pGroups, SArray* pTableList, size_t numOfTables, TSKEY skey,
+                                    STableGroupSupporter* pSupp) {
+  int32_t code = TSDB_CODE_SUCCESS;
 
-  SArray* g = taosArrayInit(16, sizeof(STableKeyInfo));
+  STableGroupKey* pKeys = malloc(numOfTables * sizeof(STableGroupKey));
+  int32_t*        pCodes = malloc(numOfTables * pSupp->numOfCols * sizeof(int32_t));
+  if (pKeys == NULL || pCodes == NULL) {
+    code = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    goto _end;
+  }
 
-  STableKeyInfo info = {.pTable = pTable, .lastKey = skey};
-  taosArrayPush(g, &info);
-  tsdbRefTable(pTable);
+  for (int32_t i = 0; i < numOfTables; ++i) {
+    pKeys[i].pTable = ((STableKeyInfo*) taosArrayGet(pTableList, i))->pTable;
+    pKeys[i].pCode = pCodes + i * pSupp->numOfCols;
+  }
 
-  for (int32_t i = 1; i < numOfTables; ++i) {
-    STable** prev = taosArrayGet(pTableList, i - 1);
-    STable** p = taosArrayGet(pTableList, i);
+  for (int32_t i = 0; i < pSupp->numOfCols; ++i) {
+    code = encodeTableGroupCol(pSupp, pKeys, numOfTables, i);
+    if (code != TSDB_CODE_SUCCESS) {
+      goto _end;
+    }
+  }
 
-    int32_t ret = compareFn(prev, p, pSupp);
-    assert(ret == 0 || ret == -1);
+  taosqsort(pKeys, numOfTables, sizeof(STableGroupKey), &pSupp->numOfCols, tableGroupKeyComparFn);
 
-    tsdbRefTable(*p);
-    assert((*p)->type == TSDB_CHILD_TABLE);
+  SArray* g = NULL;
+  for (int32_t i = 0; i < numOfTables; ++i) {
+    if (i == 0 || tableGroupKeyComparFn(&pKeys[i - 1], &pKeys[i], &pSupp->numOfCols) != 0) {
+      if (g != NULL) {
+        taosArrayPush(pGroups, &g);  // current group is ended, start a new group
+      }
 
-    if (ret == 0) {
-      STableKeyInfo info1 = {.pTable = *p, .lastKey = skey};
-      taosArrayPush(g, &info1);
-    } else {
-      taosArrayPush(pGroups, &g);  // current group is ended, start a new group
       g = taosArrayInit(16, sizeof(STableKeyInfo));
-
-      STableKeyInfo info1 = {.pTable = *p, .lastKey = skey};
-      taosArrayPush(g, &info1);
     }
+
+    tsdbRefTable(pKeys[i].pTable);
+    assert(pKeys[i].pTable->type == TSDB_CHILD_TABLE);
+
+    STableKeyInfo info = {.pTable = pKeys[i].pTable, .lastKey = skey};
+    taosArrayPush(g, &info);
   }
 
   taosArrayPush(pGroups, &g);
+
+_end:
+  tfree(pCodes);
+  tfree(pKeys);
+  return code;
 }
 
 SArray* createTableGroup(SArray* pTableList, STSchema* pTagSchema, SColIndex* pCols, int32_t numOfOrderCols, TSKEY skey) {
@@ -3651,8 +4023,12 @@ SArray* createTableGroup(SArray* pTableList, STSchema* pTagSchema, SColIndex* pC
     sup.pTagSchema = pTagSchema;
     sup.pCols = pCols;
 
-    taosqsort(pTableList->pData, size, sizeof(STableKeyInfo), &sup, tableGroupComparFn);
-    createTableGroupImpl(pTableGroup, pTableList, size, skey, &sup, tableGroupComparFn);
+    int32_t code = createTableGroupImpl(pTableGroup, pTableList, size, skey, &sup);
+    if (code != TSDB_CODE_SUCCESS) {
+      terrno = code;
+      taosArrayDestroy(pTableGroup);
+      return NULL;
+    }
   }
 
   return pTableGroup;
@@ -3847,6 +4223,8 @@ static void* destroyTableCheckInfo(SArray* pTableCheckInfo) {
     destroyTableMemIterator(p);
 
     tfree(p->pCompInfo);
+    tfree(p->pBlockStatis);
+    tfree(p->statisLoaded);
   }
 
   taosArrayDestroy(pTableCheckInfo);
@@ -3885,12 +4263,25 @@ void tsdbCleanupQueryHandle(TsdbQueryHandleT queryHandle) {
 
   SIOCostSummary* pCost = &pQueryHandle->cost;
 
-  tsdbDebug("%p :io-cost summary: head-file read cnt:%"PRIu64", head-file time:%"PRIu64" us, statis-info:%"PRId64" us, datablock:%" PRId64" us, check data:%"PRId64" us, 0x%"PRIx64,
-      pQueryHandle, pCost->headFileLoad, pCost->headFileLoadTime, pCost->statisInfoLoadTime, pCost->blockLoadTime, pCost->checkForNextTime, pQueryHandle->qId);
+  tsdbDebug("%p :io-cost summary: head-file read cnt:%"PRIu64", head-file time:%"PRIu64" us, statis-info:%"PRId64" us, datablock:%" PRId64" us, check data:%"PRId64" us, prefetch blocks:%"PRId64", pruned blocks:%"PRId64", pruned file sets:%"PRId64", 0x%"PRIx64,
+      pQueryHandle, pCost->headFileLoad, pCost->headFileLoadTime, pCost->statisInfoLoadTime, pCost->blockLoadTime, pCost->checkForNextTime, pCost->prefetchBlocks,
+      pCost->prunedBlocks, pCost->prunedFileSets, pQueryHandle->qId);
 
   tfree(pQueryHandle);
 }
 
+void tsdbGetPrunedBlocks(TsdbQueryHandleT queryHandle, int64_t *blocks, int64_t *fileSets) {
+  STsdbQueryHandle* pQueryHandle = (STsdbQueryHandle*)queryHandle;
+  if (pQueryHandle == NULL) {
+    *blocks = 0;
+    *fileSets = 0;
+    return;
+  }
+
+  *blocks = pQueryHandle->cost.prunedBlocks;
+  *fileSets = pQueryHandle->cost.prunedFileSets;
+}
+
 void tsdbDestroyTableGroup(STableGroupInfo *pGroupList) {
   assert(pGroupList != NULL);
 
@@ -4010,6 +4401,149 @@ static void queryIndexlessColumn(SSkipList* pSkipList, void* filterInfo, SArray*
 }
 
 
+static int32_t tsdbGetTagDataFromTable(void *param, int32_t id, void **data) {
+  STable* pTable = (STable*)param;
+
+  if (id == TSDB_TBNAME_COLUMN_INDEX) {
+    *data = TABLE_NAME(pTable);
+  } else {
+    *data = tdGetKVRowValOfCol(pTable->tagVal, id);
+  }
+
+  return TSDB_CODE_SUCCESS;
+}
+
+// the length of the leading characters of a LIKE pattern before the first wildcard or escape character
+static int32_t getLikePatternPrefixLen(const char* pattern) {
+  int32_t len = varDataLen(pattern);
+  for (int32_t i = 0; i < len; ++i) {
+    char c = ((char*)varDataVal(pattern))[i];
+    if (c == '%' || c == '_' || c == '\\') {
+      return i;
+    }
+  }
+
+  return len;
+}
+
+static bool tsdbCheckTagIndex(void* param, int16_t colId, uint8_t optr, void* val) {
+  STable*   pSTable = (STable*)param;
+  STColumn* pCol = tdGetColOfID(pSTable->tagSchema, colId);
+  if (pCol == NULL) {  // table name
+    return false;
+  }
+
+  switch (colType(pCol)) {
+    case TSDB_DATA_TYPE_FLOAT:
+    case TSDB_DATA_TYPE_DOUBLE:  // the values are compared approximately
+      return false;
+    case TSDB_DATA_TYPE_BINARY:
+      if (optr == TSDB_RELATION_LIKE && getLikePatternPrefixLen(val) == 0) {
+        return false;
+      }
+      if (optr != TSDB_RELATION_EQUAL && optr != TSDB_RELATION_LIKE) {
+        return false;
+      }
+      break;
+    case TSDB_DATA_TYPE_NCHAR:
+      if (optr != TSDB_RELATION_EQUAL) {
+        return false;
+      }
+      break;
+    default:
+      if (optr == TSDB_RELATION_LIKE) {
+        return false;
+      }
+  }
+
+  return tsdbGetTagIndex(pSTable, colId) != NULL;
+}
+
+static bool isTagIndexKeyInRange(SSkipList* pList, SFilterIndexUnit* pUnit, const char* key, const char* prefix) {
+  switch (pUnit->optr) {
+    case TSDB_RELATION_EQUAL:
+      return pList->comparFn(key, pUnit->val) == 0;
+    case TSDB_RELATION_LIKE:
+      return varDataLen(key) >= varDataLen(prefix) &&
+             strncasecmp(varDataVal(key), varDataVal(prefix), varDataLen(prefix)) == 0;
+    case TSDB_RELATION_GREATER:
+    case TSDB_RELATION_GREATER_EQUAL:
+      return pUnit->optr2 == 0 || pList->comparFn(key, pUnit->val2) <= 0;
+    default:
+      return true;
+  }
+}
+
+/*
+ * Collect the candidate tables from the secondary tag index of each picked unit, and check the whole filter on them.
+ * The binary values are ordered case-insensitively, so a LIKE pattern is resolved by scanning its leading characters.
+ */
+static void queryTagIndex(STable* pSTable, SArray* pUnits, void* filterInfo, SArray* res) {
+  size_t    numOfUnits = taosArrayGetSize(pUnits);
+  SHashObj* pSet = NULL;
+  int8_t*   addToResult = NULL;
+
+  if (numOfUnits > 1) {  // the tables qualified by more than one group should be added only once
+    pSet = taosHashInit(1024, taosGetDefaultHashFunction(TSDB_DATA_TYPE_BIGINT), false, HASH_NO_LOCK);
+  }
+
+  for (int32_t i = 0; i < numOfUnits; ++i) {
+    SFilterIndexUnit* pUnit = taosArrayGet(pUnits, i);
+    STagIndex*        pTagIdx = tsdbGetTagIndex(pSTable, pUnit->colId);
+    assert(pTagIdx != NULL);
+
+    int32_t     order = TSDB_ORDER_ASC;
+    const char* startVal = pUnit->val;
+    char*       prefix = NULL;
+    if (pUnit->optr == TSDB_RELATION_LESS || pUnit->optr == TSDB_RELATION_LESS_EQUAL) {
+      order = TSDB_ORDER_DESC;
+    } else if (pUnit->optr == TSDB_RELATION_LIKE) {
+      int32_t len = getLikePatternPrefixLen(pUnit->val);
+      if ((prefix = malloc(len + VARSTR_HEADER_SIZE)) == NULL) {
+        taosArrayClear(res);
+        queryIndexlessColumn(pSTable->pIndex, filterInfo, res);
+        break;
+      }
+      STR_WITH_SIZE_TO_VARSTR(prefix, varDataVal(pUnit->val), len);
+      startVal = prefix;
+    }
+
+    int32_t numOfChecked = 0;
+    SSkipListIterator* iter = tSkipListCreateIterFromVal(pTagIdx->pList, startVal, pTagIdx->type, order);
+    while (tSkipListIterNext(iter)) {
+      STagIndexElem* pElem = SL_GET_NODE_DATA(tSkipListIterGet(iter));
+      if (!isTagIndexKeyInRange(pTagIdx->pList, pUnit, SL_GET_NODE_KEY(pTagIdx->pList, tSkipListIterGet(iter)), prefix)) {
+        break;
+      }
+
+      numOfChecked += 1;
+
+      STable* pTable = pElem->pTable;
+      if (pSet != NULL && taosHashGet(pSet, &TABLE_UID(pTable), sizeof(TABLE_UID(pTable))) != NULL) {
+        continue;
+      }
+
+      filterSetColFieldData(filterInfo, pTable, tsdbGetTagDataFromTable);
+      bool all = filterExecute(filterInfo, 1, &addToResult, NULL, 0);
+      if (all || (addToResult && *addToResult)) {
+        STableKeyInfo info = {.pTable = (void*)pTable, .lastKey = TSKEY_INITIAL_VAL};
+        taosArrayPush(res, &info);
+
+        if (pSet != NULL) {
+          taosHashPut(pSet, &TABLE_UID(pTable), sizeof(TABLE_UID(pTable)), &pTable, POINTER_BYTES);
+        }
+      }
+    }
+
+    tSkipListDestroyIter(iter);
+    tfree(prefix);
+    tsdbDebug("filter tag index on colId:%d, optr:%d, %d tables checked", pUnit->colId, pUnit->optr, numOfChecked);
+  }
+
+  tfree(addToResult);
+  taosHashCleanup(pSet);
+}
+
 static int32_t tsdbQueryTableList(STable* pTable, SArray* pRes, void* filterInfo) {
   STSchema*   pTSSchema = pTable->tagSchema;
   bool indexQuery = false;
@@ -4019,10 +4553,17 @@ static int32_t tsdbQueryTableList(STable* pTable, SArray* pRes, void* filterInfo
 
   if (indexQuery) {
     queryIndexedColumn(pSkipList, filterInfo, pRes);
+    return TSDB_CODE_SUCCESS;
+  }
+
+  SArray* pUnits = taosArrayInit(4, sizeof(SFilterIndexUnit));
+  if (pUnits != NULL && filterGetIndexUnits(filterInfo, tsdbCheckTagIndex, pTable, pUnits)) {
+    queryTagIndex(pTable, pUnits, filterInfo, pRes);
   } else {
     queryIndexlessColumn(pSkipList, filterInfo, pRes);
   }
 
+  taosArrayDestroy(pUnits);
   return TSDB_CODE_SUCCESS;
 }
 
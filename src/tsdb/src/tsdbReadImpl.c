@@ -20,13 +20,27 @@
 static void tsdbResetReadTable(SReadH *pReadh);
 static void tsdbResetReadFile(SReadH *pReadh);
 static int  tsdbLoadBlockDataImpl(SReadH *pReadh, SBlock *pBlock, SDataCols *pDataCols);
-static int  tsdbCheckAndDecodeColumnData(SDataCol *pDataCol, void *content, int32_t len, int8_t comp, int numOfRows,
-                                         int maxPoints, char *buffer, int bufferSize);
+static int  tsdbCheckAndDecodeColumnData(SDataCol *pDataCol, void *content, int32_t len, int8_t comp, uint8_t codec,
+                                         int numOfRows, int maxPoints, char *buffer, int bufferSize);
 static int  tsdbLoadBlockDataColsImpl(SReadH *pReadh, SBlock *pBlock, SDataCols *pDataCols, int16_t *colIds,
                                       int numOfColIds);
 static int  tsdbLoadColData(SReadH *pReadh, SDFile *pDFile, SBlock *pBlock, SBlockCol *pBlockCol, SDataCol *pDataCol);
 static int  tsdbLoadBlockStatisFromDFile(SReadH *pReadh, SBlock *pBlock);
 static int  tsdbLoadBlockStatisFromAggr(SReadH *pReadh, SBlock *pBlock);
+static int       tsdbComparTidBlockIdx(const void *key, const void *arg);
+static SHeadIdx *tsdbDecodeHeadIdx(SReadH *pReadh);
+static SHeadIdx *tsdbAcquireHeadIdx(STsdbFS *pfs, SDFileSet *pSet);
+static SHeadIdx *tsdbPublishHeadIdx(STsdbFS *pfs, SHeadIdx *pHeadIdx);
+static void      tsdbReleaseHeadIdx(SHeadIdx *pHeadIdx);
+
+typedef struct {
+  int       fid;
+  SDFInfo   info;      // info of the head file of the current file set
+  SHeadIdx *pHeadIdx;  // NULL until a reader of the file set builds it
+} SHeadIdxSlot;
+
+static int64_t tsHeadIdxNum = 0;
+static int64_t tsHeadIdxUsed = 0;
 
 int tsdbInitReadH(SReadH *pReadh, STsdbRepo *pRepo) {
   ASSERT(pReadh != NULL && pRepo != NULL);
@@ -38,12 +52,6 @@ int tsdbInitReadH(SReadH *pReadh, STsdbRepo *pRepo) {
 
   TSDB_FSET_SET_CLOSED(TSDB_READ_FSET(pReadh));
 
-  pReadh->aBlkIdx = taosArrayInit(1024, sizeof(SBlockIdx));
-  if (pReadh->aBlkIdx == NULL) {
-    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
-    return -1;
-  }
-
   pReadh->pDCols[0] = tdNewDataCols(0, pCfg->maxRowsPerFileBlock);
   if (pReadh->pDCols[0] == NULL) {
     terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
@@ -71,10 +79,10 @@ void tsdbDestroyReadH(SReadH *pReadh) {
   pReadh->pAggrBlkData = taosTZfree(pReadh->pAggrBlkData);
   pReadh->pBlkData = taosTZfree(pReadh->pBlkData);
   pReadh->pBlkInfo = taosTZfree(pReadh->pBlkInfo);
-  pReadh->cidx = 0;
   pReadh->pBlkIdx = NULL;
   pReadh->pTable = NULL;
-  pReadh->aBlkIdx = taosArrayDestroy(pReadh->aBlkIdx);
+  tsdbReleaseHeadIdx(pReadh->pHeadIdx);
+  pReadh->pHeadIdx = NULL;
   tsdbCloseDFileSet(TSDB_READ_FSET(pReadh));
   pReadh->pRepo = NULL;
 }
@@ -97,108 +105,302 @@ int tsdbSetAndOpenReadFSet(SReadH *pReadh, SDFileSet *pSet) {
 void tsdbCloseAndUnsetFSet(SReadH *pReadh) { tsdbResetReadFile(pReadh); }
 
 int tsdbLoadBlockIdx(SReadH *pReadh) {
-  SDFile *  pHeadf = TSDB_READ_HEAD_FILE(pReadh);
-  SBlockIdx blkIdx;
+  SDFile * pHeadf = TSDB_READ_HEAD_FILE(pReadh);
+  STsdbFS *pfs = REPO_FS(TSDB_READ_REPO(pReadh));
 
-  ASSERT(taosArrayGetSize(pReadh->aBlkIdx) == 0);
+  ASSERT(pReadh->pHeadIdx == NULL);
 
   // No data at all, just return
   if (pHeadf->info.offset <= 0) return 0;
 
+  pReadh->pHeadIdx = tsdbAcquireHeadIdx(pfs, TSDB_READ_FSET(pReadh));
+  if (pReadh->pHeadIdx != NULL) return 0;
+
+  SHeadIdx *pHeadIdx = tsdbDecodeHeadIdx(pReadh);
+  if (pHeadIdx == NULL) return -1;
+
+  pReadh->pHeadIdx = tsdbPublishHeadIdx(pfs, pHeadIdx);
+  return 0;
+}
+
+int tsdbSetReadTable(SReadH *pReadh, STable *pTable) {
+  STSchema *pSchema = tsdbGetTableSchemaImpl(pTable, false, false, -1, -1);
+
+  pReadh->pTable = pTable;
+
+  if (tdInitDataCols(pReadh->pDCols[0], pSchema) < 0) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  if (tdInitDataCols(pReadh->pDCols[1], pSchema) < 0) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  pReadh->pBlkIdx = NULL;
+  if (pReadh->pHeadIdx != NULL) {
+    int32_t    tid = TABLE_TID(pTable);
+    SBlockIdx *pBlkIdx = taosbsearch(&tid, pReadh->pHeadIdx->aBlkIdx, pReadh->pHeadIdx->numOfIdx, sizeof(SBlockIdx),
+                                     tsdbComparTidBlockIdx, TD_EQ);
+    if (pBlkIdx != NULL && pBlkIdx->uid == TABLE_UID(pTable)) {
+      pReadh->pBlkIdx = pBlkIdx;
+    }
+  }
+
+  return 0;
+}
+
+// ================== Head file index cache
+// The SHeadIdx of each current file set is kept in the slot of the file set in STsdbFS. The slots follow the current
+// status of the FS, a slot is reset once its head file is rewritten or the file set retires, while the readers still
+// holding the old SHeadIdx keep it alive by reference.
+static int tsdbComparTidBlockIdx(const void *key, const void *arg) {
+  int32_t tid = *(int32_t *)key;
+  int32_t tid2 = ((SBlockIdx *)arg)->tid;
+
+  if (tid < tid2) {
+    return -1;
+  } else if (tid > tid2) {
+    return 1;
+  } else {
+    return 0;
+  }
+}
+
+static int tsdbComparFidHeadIdxSlot(const void *key, const void *arg) {
+  int fid = *(int *)key;
+  int fid2 = ((SHeadIdxSlot *)arg)->fid;
+
+  if (fid < fid2) {
+    return -1;
+  } else if (fid > fid2) {
+    return 1;
+  } else {
+    return 0;
+  }
+}
+
+static bool tsdbIsSameHeadFile(const SDFInfo *pInfo1, const SDFInfo *pInfo2) {
+  return pInfo1->magic == pInfo2->magic && pInfo1->offset == pInfo2->offset && pInfo1->len == pInfo2->len &&
+         pInfo1->size == pInfo2->size && pInfo1->fver == pInfo2->fver;
+}
+
+static size_t tsdbHeadIdxSize(int32_t numOfIdx) { return sizeof(SHeadIdx) + sizeof(SBlockIdx) * numOfIdx; }
+
+static SHeadIdx *tsdbDecodeHeadIdx(SReadH *pReadh) {
+  SDFile *  pHeadf = TSDB_READ_HEAD_FILE(pReadh);
+  SHeadIdx *pHeadIdx = NULL;
+  int32_t   capacity = 1024;
+
   if (tsdbSeekDFile(pHeadf, pHeadf->info.offset, SEEK_SET) < 0) {
     tsdbError("vgId:%d failed to load SBlockIdx part while seek file %s since %s, offset:%u len :%u",
               TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pHeadf), tstrerror(terrno), pHeadf->info.offset,
               pHeadf->info.len);
-    return -1;
+    return NULL;
   }
 
-  if (tsdbMakeRoom((void **)(&TSDB_READ_BUF(pReadh)), pHeadf->info.len) < 0) return -1;
+  if (tsdbMakeRoom((void **)(&TSDB_READ_BUF(pReadh)), pHeadf->info.len) < 0) return NULL;
 
   int64_t nread = tsdbReadDFile(pHeadf, TSDB_READ_BUF(pReadh), pHeadf->info.len);
   if (nread < 0) {
     tsdbError("vgId:%d failed to load SBlockIdx part while read file %s since %s, offset:%u len :%u",
               TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pHeadf), tstrerror(terrno), pHeadf->info.offset,
               pHeadf->info.len);
-    return -1;
+    return NULL;
   }
 
   if (nread < pHeadf->info.len) {
     terrno = TSDB_CODE_TDB_FILE_CORRUPTED;
     tsdbError("vgId:%d SBlockIdx part in file %s is corrupted, offset:%u expected bytes:%u read bytes: %" PRId64,
               TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pHeadf), pHeadf->info.offset, pHeadf->info.len, nread);
-    return -1;
+    return NULL;
   }
 
   if (!taosCheckChecksumWhole((uint8_t *)TSDB_READ_BUF(pReadh), pHeadf->info.len)) {
     terrno = TSDB_CODE_TDB_FILE_CORRUPTED;
     tsdbError("vgId:%d SBlockIdx part in file %s is corrupted since wrong checksum, offset:%u len :%u",
               TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pHeadf), pHeadf->info.offset, pHeadf->info.len);
-    return -1;
+    return NULL;
+  }
+
+  pHeadIdx = malloc(tsdbHeadIdxSize(capacity));
+  if (pHeadIdx == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return NULL;
   }
 
+  T_REF_INIT_VAL(pHeadIdx, 1);
+  pHeadIdx->fid = TSDB_FSET_FID(TSDB_READ_FSET(pReadh));
+  pHeadIdx->info = pHeadf->info;
+  pHeadIdx->numOfIdx = 0;
+
   void *ptr = TSDB_READ_BUF(pReadh);
-  int   tsize = 0;
   while (POINTER_DISTANCE(ptr, TSDB_READ_BUF(pReadh)) < (pHeadf->info.len - sizeof(TSCKSUM))) {
-    ptr = tsdbDecodeSBlockIdx(ptr, &blkIdx);
+    if (pHeadIdx->numOfIdx >= capacity) {
+      capacity *= 2;
+      SHeadIdx *tptr = realloc(pHeadIdx, tsdbHeadIdxSize(capacity));
+      if (tptr == NULL) {
+        terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+        free(pHeadIdx);
+        return NULL;
+      }
+      pHeadIdx = tptr;
+    }
+
+    SBlockIdx *pBlkIdx = pHeadIdx->aBlkIdx + pHeadIdx->numOfIdx;
+    ptr = tsdbDecodeSBlockIdx(ptr, pBlkIdx);
     ASSERT(ptr != NULL);
+    ASSERT(pHeadIdx->numOfIdx == 0 || (pBlkIdx - 1)->tid < pBlkIdx->tid);
 
-    if (taosArrayPush(pReadh->aBlkIdx, (void *)(&blkIdx)) == NULL) {
-      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
-      return -1;
-    }
+    pHeadIdx->numOfIdx++;
+  }
 
-    tsize++;
-    ASSERT(tsize == 1 || ((SBlockIdx *)taosArrayGet(pReadh->aBlkIdx, tsize - 2))->tid <
-                             ((SBlockIdx *)taosArrayGet(pReadh->aBlkIdx, tsize - 1))->tid);
+  // give the unused capacity back, the index lives as long as the file set
+  if (pHeadIdx->numOfIdx < capacity) {
+    SHeadIdx *tptr = realloc(pHeadIdx, tsdbHeadIdxSize(pHeadIdx->numOfIdx));
+    if (tptr != NULL) pHeadIdx = tptr;
   }
 
-  return 0;
+  size_t size = tsdbHeadIdxSize(pHeadIdx->numOfIdx);
+  atomic_add_fetch_64(&tsHeadIdxNum, 1);
+  atomic_add_fetch_64(&tsHeadIdxUsed, size);
+
+  tsdbDebug("vgId:%d fid:%d index of %d tables is decoded from file %s, %" PRIzu " bytes", TSDB_READ_REPO_ID(pReadh),
+            pHeadIdx->fid, pHeadIdx->numOfIdx, TSDB_FILE_FULL_NAME(pHeadf), size);
+  return pHeadIdx;
 }
 
-int tsdbSetReadTable(SReadH *pReadh, STable *pTable) {
-  STSchema *pSchema = tsdbGetTableSchemaImpl(pTable, false, false, -1, -1);
+static void tsdbReleaseHeadIdx(SHeadIdx *pHeadIdx) {
+  if (pHeadIdx == NULL) return;
 
-  pReadh->pTable = pTable;
+  if (T_REF_DEC(pHeadIdx) == 0) {
+    atomic_sub_fetch_64(&tsHeadIdxNum, 1);
+    atomic_sub_fetch_64(&tsHeadIdxUsed, tsdbHeadIdxSize(pHeadIdx->numOfIdx));
+    free(pHeadIdx);
+  }
+}
 
-  if (tdInitDataCols(pReadh->pDCols[0], pSchema) < 0) {
+static SHeadIdx *tsdbAcquireHeadIdx(STsdbFS *pfs, SDFileSet *pSet) {
+  SHeadIdx *pHeadIdx = NULL;
+  int       fid = TSDB_FSET_FID(pSet);
+
+  pthread_mutex_lock(&(pfs->idxLock));
+  SHeadIdxSlot *pSlot = taosArraySearch(pfs->aHeadIdx, &fid, tsdbComparFidHeadIdxSlot, TD_EQ);
+  if (pSlot != NULL && pSlot->pHeadIdx != NULL &&
+      tsdbIsSameHeadFile(&(pSlot->pHeadIdx->info), &(TSDB_DFILE_IN_SET(pSet, TSDB_FILE_HEAD)->info))) {
+    pHeadIdx = pSlot->pHeadIdx;
+    T_REF_INC(pHeadIdx);
+  }
+  pthread_mutex_unlock(&(pfs->idxLock));
+
+  return pHeadIdx;
+}
+
+// Keep the index in the cache if it is built from the head file of a current file set. The index of a file set read
+// by a reader that started before the FS changed is only used by the reader itself.
+static SHeadIdx *tsdbPublishHeadIdx(STsdbFS *pfs, SHeadIdx *pHeadIdx) {
+  pthread_mutex_lock(&(pfs->idxLock));
+  SHeadIdxSlot *pSlot = taosArraySearch(pfs->aHeadIdx, &(pHeadIdx->fid), tsdbComparFidHeadIdxSlot, TD_EQ);
+  if (pSlot != NULL && tsdbIsSameHeadFile(&(pSlot->info), &(pHeadIdx->info))) {
+    if (pSlot->pHeadIdx != NULL) {
+      // built by another reader concurrently
+      SHeadIdx *pOld = pHeadIdx;
+      pHeadIdx = pSlot->pHeadIdx;
+      T_REF_INC(pHeadIdx);
+      pthread_mutex_unlock(&(pfs->idxLock));
+      tsdbReleaseHeadIdx(pOld);
+      return pHeadIdx;
+    }
+
+    T_REF_INC(pHeadIdx);
+    pSlot->pHeadIdx = pHeadIdx;
+  }
+  pthread_mutex_unlock(&(pfs->idxLock));
+
+  return pHeadIdx;
+}
+
+int tsdbInitHeadIdxCache(STsdbFS *pfs) {
+  pfs->aHeadIdx = taosArrayInit(16, sizeof(SHeadIdxSlot));
+  if (pfs->aHeadIdx == NULL) {
     terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
     return -1;
   }
 
-  if (tdInitDataCols(pReadh->pDCols[1], pSchema) < 0) {
-    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+  int code = pthread_mutex_init(&(pfs->idxLock), NULL);
+  if (code != 0) {
+    terrno = TAOS_SYSTEM_ERROR(code);
+    pfs->aHeadIdx = taosArrayDestroy(pfs->aHeadIdx);
     return -1;
   }
 
-  size_t size = taosArrayGetSize(pReadh->aBlkIdx);
-  if (size > 0) {
-    while (true) {
-      if (pReadh->cidx >= size) {
-        pReadh->pBlkIdx = NULL;
-        break;
-      }
+  return 0;
+}
 
-      SBlockIdx *pBlkIdx = taosArrayGet(pReadh->aBlkIdx, pReadh->cidx);
-      if (pBlkIdx->tid == TABLE_TID(pTable)) {
-        if (pBlkIdx->uid == TABLE_UID(pTable)) {
-          pReadh->pBlkIdx = pBlkIdx;
-        } else {
-          pReadh->pBlkIdx = NULL;
-        }
-        pReadh->cidx++;
-        break;
-      } else if (pBlkIdx->tid > TABLE_TID(pTable)) {
-        pReadh->pBlkIdx = NULL;
-        break;
-      } else {
-        pReadh->cidx++;
-      }
+void tsdbDestroyHeadIdxCache(STsdbFS *pfs) {
+  if (pfs->aHeadIdx == NULL) return;
+
+  size_t size = taosArrayGetSize(pfs->aHeadIdx);
+  for (size_t i = 0; i < size; i++) {
+    SHeadIdxSlot *pSlot = taosArrayGet(pfs->aHeadIdx, i);
+    tsdbReleaseHeadIdx(pSlot->pHeadIdx);
+  }
+
+  pfs->aHeadIdx = taosArrayDestroy(pfs->aHeadIdx);
+  pthread_mutex_destroy(&(pfs->idxLock));
+}
+
+// Rebuild the slots from the current status of the FS, called each time the current status changes. The indexes of
+// file sets whose head file does not change are kept.
+void tsdbRefreshHeadIdxCache(STsdbFS *pfs) {
+  SFSStatus *pStatus = pfs->cstatus;
+  size_t     nSets = taosArrayGetSize(pStatus->df);
+  SArray *   aHeadIdx = taosArrayInit(MAX(nSets, 1), sizeof(SHeadIdxSlot));
+  SArray *   aRetired = NULL;
+
+  pthread_mutex_lock(&(pfs->idxLock));
+
+  if (aHeadIdx == NULL) {
+    // not able to track the current file sets, stop caching any index until the next refresh
+    for (size_t i = 0; i < taosArrayGetSize(pfs->aHeadIdx); i++) {
+      SHeadIdxSlot *pSlot = taosArrayGet(pfs->aHeadIdx, i);
+      memset(&(pSlot->info), 0, sizeof(pSlot->info));
+      tsdbReleaseHeadIdx(pSlot->pHeadIdx);
+      pSlot->pHeadIdx = NULL;
     }
   } else {
-    pReadh->pBlkIdx = NULL;
+    for (size_t i = 0; i < nSets; i++) {
+      SDFileSet *  pSet = taosArrayGet(pStatus->df, i);
+      SHeadIdxSlot slot = {.fid = TSDB_FSET_FID(pSet), .info = TSDB_DFILE_IN_SET(pSet, TSDB_FILE_HEAD)->info};
+
+      SHeadIdxSlot *pOld = taosArraySearch(pfs->aHeadIdx, &(slot.fid), tsdbComparFidHeadIdxSlot, TD_EQ);
+      if (pOld != NULL && pOld->pHeadIdx != NULL && tsdbIsSameHeadFile(&(pOld->pHeadIdx->info), &(slot.info))) {
+        slot.pHeadIdx = pOld->pHeadIdx;
+        pOld->pHeadIdx = NULL;
+      }
+
+      taosArrayPush(aHeadIdx, &slot);
+    }
+
+    aRetired = pfs->aHeadIdx;
+    pfs->aHeadIdx = aHeadIdx;
   }
 
-  return 0;
+  pthread_mutex_unlock(&(pfs->idxLock));
+
+  if (aRetired != NULL) {
+    for (size_t i = 0; i < taosArrayGetSize(aRetired); i++) {
+      SHeadIdxSlot *pSlot = taosArrayGet(aRetired, i);
+      tsdbReleaseHeadIdx(pSlot->pHeadIdx);
+    }
+    taosArrayDestroy(aRetired);
+  }
+}
+
+void tsdbGetHeadIdxStat(int64_t *numOfIdx, int64_t *used) {
+  *numOfIdx = atomic_load_64(&tsHeadIdxNum);
+  *used = atomic_load_64(&tsHeadIdxUsed);
 }
 
 #if 0
@@ -608,14 +810,14 @@ void tsdbGetBlockStatis(SReadH *pReadh, SDataStatis *pStatis, int numOfCols, SBl
 static void tsdbResetReadTable(SReadH *pReadh) {
   tdResetDataCols(pReadh->pDCols[0]);
   tdResetDataCols(pReadh->pDCols[1]);
-  pReadh->cidx = 0;
   pReadh->pBlkIdx = NULL;
   pReadh->pTable = NULL;
 }
 
 static void tsdbResetReadFile(SReadH *pReadh) {
   tsdbResetReadTable(pReadh);
-  taosArrayClear(pReadh->aBlkIdx);
+  tsdbReleaseHeadIdx(pReadh->pHeadIdx);
+  pReadh->pHeadIdx = NULL;
   tsdbCloseDFileSet(TSDB_READ_FSET(pReadh));
 }
 
@@ -699,8 +901,8 @@ static int tsdbLoadBlockDataImpl(SReadH *pReadh, SBlock *pBlock, SDataCols *pDat
       }
 
       if (tsdbCheckAndDecodeColumnData(pDataCol, POINTER_SHIFT(pBlockData, tsize + toffset), tlen, pBlock->algorithm,
-                                       pBlock->numOfRows, pDataCols->maxPoints, TSDB_READ_COMP_BUF(pReadh),
-                                       (int)taosTSizeof(TSDB_READ_COMP_BUF(pReadh))) < 0) {
+                                       (dcol == 0) ? 0 : pBlockCol->codec, pBlock->numOfRows, pDataCols->maxPoints,
+                                       TSDB_READ_COMP_BUF(pReadh), (int)taosTSizeof(TSDB_READ_COMP_BUF(pReadh))) < 0) {
         tsdbError("vgId:%d file %s is broken at column %d block offset %" PRId64 " column offset %u",
                   TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pDFile), tcolId, (int64_t)pBlock->offset, toffset);
         return -1;
@@ -722,8 +924,8 @@ static int tsdbLoadBlockDataImpl(SReadH *pReadh, SBlock *pBlock, SDataCols *pDat
   return 0;
 }
 
-static int tsdbCheckAndDecodeColumnData(SDataCol *pDataCol, void *content, int32_t len, int8_t comp, int numOfRows,
-                                        int maxPoints, char *buffer, int bufferSize) {
+static int tsdbCheckAndDecodeColumnData(SDataCol *pDataCol, void *content, int32_t len, int8_t comp, uint8_t codec,
+                                        int numOfRows, int maxPoints, char *buffer, int bufferSize) {
   if (!taosCheckChecksumWhole((uint8_t *)content, len)) {
     terrno = TSDB_CODE_TDB_FILE_CORRUPTED;
     return -1;
@@ -734,11 +936,11 @@ static int tsdbCheckAndDecodeColumnData(SDataCol *pDataCol, void *content, int32
   // Decode the data
   if (comp) {
     // Need to decompress
-    int tlen = (*(tDataTypes[pDataCol->type].decompFunc))(content, len - sizeof(TSCKSUM), numOfRows, pDataCol->pData,
-                                                             pDataCol->spaceSize, comp, buffer, bufferSize);
+    int tlen = tsdbDecodeColData(pDataCol, content, len - sizeof(TSCKSUM), numOfRows, comp, codec, buffer, bufferSize);
     if (tlen <= 0) {
-      tsdbError("Failed to decompress column, file corrupted, len:%d comp:%d numOfRows:%d maxPoints:%d bufferSize:%d",
-                len, comp, numOfRows, maxPoints, bufferSize);
+      tsdbError("Failed to decompress column, file corrupted, len:%d comp:%d codec:0x%x numOfRows:%d maxPoints:%d "
+                "bufferSize:%d",
+                len, comp, codec, numOfRows, maxPoints, bufferSize);
       terrno = TSDB_CODE_TDB_FILE_CORRUPTED;
       return -1;
     }
@@ -837,15 +1039,25 @@ static int tsdbLoadBlockDataColsImpl(SReadH *pReadh, SBlock *pBlock, SDataCols *
 static int tsdbLoadColData(SReadH *pReadh, SDFile *pDFile, SBlock *pBlock, SBlockCol *pBlockCol, SDataCol *pDataCol) {
   ASSERT(pDataCol->colId == pBlockCol->colId);
 
-  STsdbRepo *pRepo = TSDB_READ_REPO(pReadh);
-  STsdbCfg * pCfg = REPO_CFG(pRepo);
-  int        tsize = pDataCol->bytes * pBlock->numOfRows + COMP_OVERFLOW_BYTES;
+  STsdbRepo *  pRepo = TSDB_READ_REPO(pReadh);
+  STsdbCfg *   pCfg = REPO_CFG(pRepo);
+  int          tsize = pDataCol->bytes * pBlock->numOfRows + COMP_OVERFLOW_BYTES;
+  SBlkCacheKey cacheKey = {0};
+
+  int64_t offset = pBlock->offset + tsdbBlockStatisSize(pBlock->numOfCols, (uint32_t)pBlock->blkVer) +
+                   tsdbGetBlockColOffset(pBlockCol);
+
+  if (tsdbBlkCacheEnabled()) {
+    tsdbInitBlkCacheKey(&cacheKey, REPO_ID(pRepo), TSDB_READ_FSET(pReadh),
+                        pBlock->last ? TSDB_FILE_LAST : TSDB_FILE_DATA, pBlockCol->colId, offset);
+    if (tsdbBlkCacheGet(&cacheKey, pDataCol, pBlock->numOfRows, pCfg->maxRowsPerFileBlock)) {
+      return 0;
+    }
+  }
 
   if (tsdbMakeRoom((void **)(&TSDB_READ_BUF(pReadh)), pBlockCol->len) < 0) return -1;
   if (tsdbMakeRoom((void **)(&TSDB_READ_COMP_BUF(pReadh)), tsize) < 0) return -1;
 
-  int64_t offset = pBlock->offset + tsdbBlockStatisSize(pBlock->numOfCols, (uint32_t)pBlock->blkVer) +
-                   tsdbGetBlockColOffset(pBlockCol);
   if (tsdbSeekDFile(pDFile, offset, SEEK_SET) < 0) {
     tsdbError("vgId:%d failed to load block column data while seek file %s to offset %" PRId64 " since %s",
               TSDB_READ_REPO_ID(pReadh), TSDB_FILE_FULL_NAME(pDFile), offset, tstrerror(terrno));
@@ -867,12 +1079,17 @@ static int tsdbLoadColData(SReadH *pReadh, SDFile *pDFile, SBlock *pBlock, SBloc
     return -1;
   }
 
-  if (tsdbCheckAndDecodeColumnData(pDataCol, pReadh->pBuf, pBlockCol->len, pBlock->algorithm, pBlock->numOfRows,
-                                   pCfg->maxRowsPerFileBlock, pReadh->pCBuf, (int32_t)taosTSizeof(pReadh->pCBuf)) < 0) {
+  if (tsdbCheckAndDecodeColumnData(pDataCol, pReadh->pBuf, pBlockCol->len, pBlock->algorithm, pBlockCol->codec,
+                                   pBlock->numOfRows, pCfg->maxRowsPerFileBlock, pReadh->pCBuf,
+                                   (int32_t)taosTSizeof(pReadh->pCBuf)) < 0) {
     tsdbError("vgId:%d file %s is broken at column %d offset %" PRId64, REPO_ID(pRepo), TSDB_FILE_FULL_NAME(pDFile),
               pBlockCol->colId, offset);
     return -1;
   }
 
+  if (tsdbBlkCacheEnabled()) {
+    tsdbBlkCachePut(&cacheKey, pDataCol, pBlock->numOfRows);
+  }
+
   return 0;
 }
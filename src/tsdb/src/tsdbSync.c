@@ -16,22 +16,63 @@
 #define _DEFAULT_SOURCE
 #include "os.h"
 #include "taoserror.h"
+#include "tglobal.h"
+#include "tscompression.h"
 #include "tsdbint.h"
 
+// Decisions of the receiving side on a fileset
+#define TSDB_SYNC_SKIP 0   // local fileset is the same, nothing to send
+#define TSDB_SYNC_FULL 1   // send all files of the fileset
+#define TSDB_SYNC_DELTA 2  // send the head file and only the blocks missing on the receiving side
+
+// Block records sent after the head file in a delta sync
+#define TSDB_SYNC_BLOCK_END 0
+#define TSDB_SYNC_BLOCK_REUSE 1
+#define TSDB_SYNC_BLOCK_DATA 2
+
+#define TSDB_SYNC_BLOCK_HEAD_LEN 30
+#define TSDB_SYNC_SUMMARY_LEN 44
+#define TSDB_SYNC_FRAME_HEAD_LEN 8
+#define TSDB_SYNC_CHUNK_SIZE (1024 * 1024)
+
 // Sync handle
 typedef struct {
   STsdbRepo *pRepo;
   SRtn       rtn;
   SOCKET     socketFd;
   void *     pBuf;
+  void *     pCBuf;
   bool       mfChanged;
   SMFile *   pmf;
   SMFile     mf;
   SDFileSet  df;
   SDFileSet *pdf;
+  int64_t    nsent;   // bytes of filesets put on the wire
+  int64_t    nsaved;  // bytes of filesets not sent since the receiving side has them
 } SSyncH;
 
+// Summary of a data block, blocks with the same key and digest are taken as identical
+typedef struct {
+  uint64_t uid;
+  TSKEY    keyFirst;
+  TSKEY    keyLast;
+  int32_t  numOfRows;
+  int32_t  len;
+  int32_t  last;
+  int32_t  aggrLen;
+} SSyncBlockKey;
+
+typedef struct {
+  SSyncBlockKey key;
+  uint32_t      digest;
+  int64_t       offset;      // only valid on the receiving side
+  int64_t       aggrOffset;  // only valid on the receiving side
+} SSyncBlock;
+
+typedef int32_t (*__tsdb_sync_block_fn_t)(SSyncH *pSynch, SReadH *pReadh, uint64_t uid, SBlock *pBlock, void *param);
+
 #define SYNC_BUFFER(sh) ((sh)->pBuf)
+#define SYNC_CBUFFER(sh) ((sh)->pCBuf)
 
 static void    tsdbInitSyncH(SSyncH *pSyncH, STsdbRepo *pRepo, SOCKET socketFd);
 static void    tsdbDestroySyncH(SSyncH *pSyncH);
@@ -39,14 +80,23 @@ static int32_t tsdbSyncSendMeta(SSyncH *pSynch);
 static int32_t tsdbSyncRecvMeta(SSyncH *pSynch);
 static int32_t tsdbSendMetaInfo(SSyncH *pSynch);
 static int32_t tsdbRecvMetaInfo(SSyncH *pSynch);
-static int32_t tsdbSendDecision(SSyncH *pSynch, bool toSend);
-static int32_t tsdbRecvDecision(SSyncH *pSynch, bool *toSend);
+static int32_t tsdbSendDecision(SSyncH *pSynch, uint8_t decision);
+static int32_t tsdbRecvDecision(SSyncH *pSynch, uint8_t *decision);
 static int32_t tsdbSyncSendDFileSetArray(SSyncH *pSynch);
 static int32_t tsdbSyncRecvDFileSetArray(SSyncH *pSynch);
 static bool    tsdbIsTowFSetSame(SDFileSet *pSet1, SDFileSet *pSet2);
 static int32_t tsdbSyncSendDFileSet(SSyncH *pSynch, SDFileSet *pSet);
 static int32_t tsdbSendDFileSetInfo(SSyncH *pSynch, SDFileSet *pSet);
 static int32_t tsdbRecvDFileSetInfo(SSyncH *pSynch);
+static bool    tsdbCanSyncDelta(SDFileSet *pLSet, SDFileSet *pRSet);
+static int32_t tsdbSyncSendDFileSetDelta(SSyncH *pSynch, SDFileSet *pSet);
+static int32_t tsdbSyncRecvDFileSetDelta(SSyncH *pSynch, SDFileSet *pLSet, SDFileSet *pSet);
+static int32_t tsdbSendBlockSummary(SSyncH *pSynch, SReadH *pReadh, SDFileSet *pLSet, SArray *aBlocks);
+static int32_t tsdbRecvBlockSummary(SSyncH *pSynch, SArray *aBlocks);
+static int32_t tsdbForEachSyncBlock(SSyncH *pSynch, SReadH *pReadh, __tsdb_sync_block_fn_t fp, void *param);
+static int32_t tsdbReadSyncBlock(SReadH *pReadh, SBlock *pBlock, void **ppBuf, int32_t *aggrLen);
+static int32_t tsdbSendFrame(SSyncH *pSynch, void *head, int32_t headLen, void *data, int32_t len);
+static int32_t tsdbRecvFrame(SSyncH *pSynch, int32_t *len);
 static int     tsdbReload(STsdbRepo *pRepo, bool isMfChanged);
 
 int32_t tsdbSyncSend(void *tsdb, SOCKET socketFd) {
@@ -67,6 +117,9 @@ int32_t tsdbSyncSend(void *tsdb, SOCKET socketFd) {
     goto _err;
   }
 
+  tsdbInfo("vgId:%d, filesets are sent, %" PRId64 " bytes sent, %" PRId64 " bytes saved by delta sync", REPO_ID(pRepo),
+           synch.nsent, synch.nsaved);
+
   // Enable TSDB commit
   tsem_post(&(pRepo->readyToCommit));
   tsdbDestroySyncH(&synch);
@@ -98,6 +151,9 @@ int32_t tsdbSyncRecv(void *tsdb, SOCKET socketFd) {
     goto _err;
   }
 
+  tsdbInfo("vgId:%d, filesets are received, %" PRId64 " bytes received, %" PRId64 " bytes saved by delta sync",
+           REPO_ID(pRepo), synch.nsent, synch.nsaved);
+
   tsdbEndFSTxn(pRepo);
   tsem_post(&(pRepo->readyToCommit));
   tsdbDestroySyncH(&synch);
@@ -120,11 +176,14 @@ static void tsdbInitSyncH(SSyncH *pSyncH, STsdbRepo *pRepo, SOCKET socketFd) {
   tsdbGetRtnSnap(pRepo, &(pSyncH->rtn));
 }
 
-static void tsdbDestroySyncH(SSyncH *pSyncH) { taosTZfree(pSyncH->pBuf); }
+static void tsdbDestroySyncH(SSyncH *pSyncH) {
+  taosTZfree(pSyncH->pBuf);
+  taosTZfree(pSyncH->pCBuf);
+}
 
 static int32_t tsdbSyncSendMeta(SSyncH *pSynch) {
   STsdbRepo *pRepo = pSynch->pRepo;
-  bool       toSendMeta = false;
+  uint8_t    toSendMeta = TSDB_SYNC_SKIP;
   SMFile     mf;
 
   // Send meta info to remote
@@ -199,7 +258,7 @@ static int32_t tsdbSyncRecvMeta(SSyncH *pSynch) {
     // Local has no meta file or has a different meta file, need to copy from remote
     pSynch->mfChanged = true;
 
-    if (tsdbSendDecision(pSynch, true) < 0) {
+    if (tsdbSendDecision(pSynch, TSDB_SYNC_FULL) < 0) {
       tsdbError("vgId:%d, failed to send decision while recv metafile since %s", REPO_ID(pRepo), tstrerror(terrno));
       return -1;
     }
@@ -236,7 +295,7 @@ static int32_t tsdbSyncRecvMeta(SSyncH *pSynch) {
   } else {
     pSynch->mfChanged = false;
     tsdbInfo("vgId:%d, metafile is same, no need to recv", REPO_ID(pRepo));
-    if (tsdbSendDecision(pSynch, false) < 0) {
+    if (tsdbSendDecision(pSynch, TSDB_SYNC_SKIP) < 0) {
       tsdbError("vgId:%d, failed to send decision while recv metafile since %s", REPO_ID(pRepo), tstrerror(terrno));
       return -1;
     }
@@ -327,9 +386,8 @@ static int32_t tsdbRecvMetaInfo(SSyncH *pSynch) {
   return 0;
 }
 
-static int32_t tsdbSendDecision(SSyncH *pSynch, bool toSend) {
+static int32_t tsdbSendDecision(SSyncH *pSynch, uint8_t decision) {
   STsdbRepo *pRepo = pSynch->pRepo;
-  uint8_t    decision = toSend;
 
   int32_t writeLen = sizeof(uint8_t);
   int32_t ret = taosWriteMsg(pSynch->socketFd, (void *)(&decision), writeLen);
@@ -342,19 +400,17 @@ static int32_t tsdbSendDecision(SSyncH *pSynch, bool toSend) {
   return 0;
 }
 
-static int32_t tsdbRecvDecision(SSyncH *pSynch, bool *toSend) {
+static int32_t tsdbRecvDecision(SSyncH *pSynch, uint8_t *decision) {
   STsdbRepo *pRepo = pSynch->pRepo;
-  uint8_t    decision = 0;
 
   int32_t readLen = sizeof(uint8_t);
-  int32_t ret = taosReadMsg(pSynch->socketFd, (void *)(&decision), readLen);
+  int32_t ret = taosReadMsg(pSynch->socketFd, (void *)decision, readLen);
   if (ret != readLen) {
     terrno = TAOS_SYSTEM_ERROR(errno);
     tsdbError("vgId:%d, failed to recv decison, ret:%d readLen:%d", REPO_ID(pRepo), ret, readLen);
     return -1;
   }
 
-  *toSend = decision;
   return 0;
 }
 
@@ -423,7 +479,7 @@ static int32_t tsdbSyncRecvDFileSetArray(SSyncH *pSynch) {
           return -1;
         }
 
-        if (tsdbSendDecision(pSynch, false) < 0) {
+        if (tsdbSendDecision(pSynch, TSDB_SYNC_SKIP) < 0) {
           tsdbError("vgId:%d, failed to send decision since %s", REPO_ID(pRepo), tstrerror(terrno));
           return -1;
         }
@@ -432,7 +488,7 @@ static int32_t tsdbSyncRecvDFileSetArray(SSyncH *pSynch) {
         int fidLevel = tsdbGetFidLevel(pSynch->pdf->fid, &(pSynch->rtn));
         if (fidLevel < 0) {  // expired fileset
           tsdbInfo("vgId:%d, fileset:%d will be skipped as expired", REPO_ID(pRepo), pSynch->pdf->fid);
-          if (tsdbSendDecision(pSynch, false) < 0) {
+          if (tsdbSendDecision(pSynch, TSDB_SYNC_SKIP) < 0) {
             tsdbError("vgId:%d, failed to send decision since %s", REPO_ID(pRepo), tstrerror(terrno));
             return -1;
           }
@@ -446,13 +502,16 @@ static int32_t tsdbSyncRecvDFileSetArray(SSyncH *pSynch) {
           }
           // Next loop
           continue;
-        } else {
-          tsdbInfo("vgId:%d, fileset:%d will be received", REPO_ID(pRepo), pSynch->pdf->fid);
-          // Notify remote to send there file here
-          if (tsdbSendDecision(pSynch, true) < 0) {
-            tsdbError("vgId:%d, failed to send decision since %s", REPO_ID(pRepo), tstrerror(terrno));
-            return -1;
-          }
+        }
+
+        // A local fileset of the same fid mostly shares blocks with the remote one, only receive the others
+        bool delta = (pLSet && pLSet->fid == pSynch->pdf->fid && tsdbCanSyncDelta(pLSet, pSynch->pdf));
+
+        tsdbInfo("vgId:%d, fileset:%d will be received%s", REPO_ID(pRepo), pSynch->pdf->fid, delta ? " by delta" : "");
+        // Notify remote to send there file here
+        if (tsdbSendDecision(pSynch, delta ? TSDB_SYNC_DELTA : TSDB_SYNC_FULL) < 0) {
+          tsdbError("vgId:%d, failed to send decision since %s", REPO_ID(pRepo), tstrerror(terrno));
+          return -1;
         }
 
         // Create local files and copy from remote
@@ -474,7 +533,17 @@ static int32_t tsdbSyncRecvDFileSetArray(SSyncH *pSynch) {
           return -1;
         }
 
-        for (TSDB_FILE_T ftype = 0; ftype < tsdbGetNFiles(pSynch->pdf); ftype++) {
+        if (delta) {
+          if (tsdbSyncRecvDFileSetDelta(pSynch, pLSet, &fset) < 0) {
+            tsdbError("vgId:%d, failed to recv fileset:%d by delta since %s", REPO_ID(pRepo), fset.fid,
+                      tstrerror(terrno));
+            tsdbCloseDFileSet(&fset);
+            tsdbRemoveDFileSet(&fset);
+            return -1;
+          }
+        }
+
+        for (TSDB_FILE_T ftype = 0; !delta && ftype < tsdbGetNFiles(pSynch->pdf); ftype++) {
           SDFile *pDFile = TSDB_DFILE_IN_SET(&fset, ftype);         // local file
           SDFile *pRDFile = TSDB_DFILE_IN_SET(pSynch->pdf, ftype);  // remote file
 
@@ -494,6 +563,7 @@ static int32_t tsdbSyncRecvDFileSetArray(SSyncH *pSynch) {
 
           // Update new file info
           pDFile->info = pRDFile->info;
+          pSynch->nsent += writeLen;
           tsdbInfo("vgId:%d, file:%s is received, size:%" PRId64, REPO_ID(pRepo), pDFile->f.aname, writeLen);
         }
 
@@ -567,7 +637,7 @@ static bool tsdbIsTowFSetSame(SDFileSet *pSet1, SDFileSet *pSet2) {
 
 static int32_t tsdbSyncSendDFileSet(SSyncH *pSynch, SDFileSet *pSet) {
   STsdbRepo *pRepo = pSynch->pRepo;
-  bool toSend = false;
+  uint8_t    decision = TSDB_SYNC_SKIP;
 
   // skip expired fileset
   if (pSet && tsdbGetFidLevel(pSet->fid, &(pSynch->rtn)) < 0) {
@@ -586,13 +656,20 @@ static int32_t tsdbSyncSendDFileSet(SSyncH *pSynch, SDFileSet *pSet) {
     return 0;
   }
 
-  if (tsdbRecvDecision(pSynch, &toSend) < 0) {
+  if (tsdbRecvDecision(pSynch, &decision) < 0) {
     tsdbError("vgId:%d, failed to recv decision while send fileset:%d since %s", REPO_ID(pRepo), pSet->fid,
               tstrerror(terrno));
     return -1;
   }
 
-  if (toSend) {
+  if (decision == TSDB_SYNC_DELTA) {
+    tsdbInfo("vgId:%d, fileset:%d will be sent by delta", REPO_ID(pRepo), pSet->fid);
+
+    if (tsdbSyncSendDFileSetDelta(pSynch, pSet) < 0) {
+      tsdbError("vgId:%d, failed to send fileset:%d by delta since %s", REPO_ID(pRepo), pSet->fid, tstrerror(terrno));
+      return -1;
+    }
+  } else if (decision == TSDB_SYNC_FULL) {
     tsdbInfo("vgId:%d, fileset:%d will be sent", REPO_ID(pRepo), pSet->fid);
 
     for (TSDB_FILE_T ftype = 0; ftype < tsdbGetNFiles(pSet); ftype++) {
@@ -616,6 +693,7 @@ static int32_t tsdbSyncSendDFileSet(SSyncH *pSynch, SDFileSet *pSet) {
       }
 
       tsdbInfo("vgId:%d, file:%s is sent", REPO_ID(pRepo), df.f.aname);
+      pSynch->nsent += writeLen;
       tsdbCloseDFile(&df);
     }
 
@@ -703,6 +781,565 @@ static int32_t tsdbRecvDFileSetInfo(SSyncH *pSynch) {
   return 0;
 }
 
+static bool tsdbCanSyncDelta(SDFileSet *pLSet, SDFileSet *pRSet) {
+  return tsdbSyncDelta && pLSet->ver == pRSet->ver && tsdbFSetIsOk(pLSet);
+}
+
+static void tsdbInitSyncBlockKey(SSyncBlockKey *pKey, uint64_t uid, SBlock *pBlock, int32_t aggrLen) {
+  memset(pKey, 0, sizeof(*pKey));
+  pKey->uid = uid;
+  pKey->keyFirst = pBlock->keyFirst;
+  pKey->keyLast = pBlock->keyLast;
+  pKey->numOfRows = pBlock->numOfRows;
+  pKey->len = pBlock->len;
+  pKey->last = pBlock->last;
+  pKey->aggrLen = aggrLen;
+}
+
+typedef struct {
+  SArray *  aBlocks;  // SSyncBlock summary from the receiving side
+  SHashObj *pBlocks;  // SSyncBlockKey -> index in aBlocks
+  int32_t   nReused;
+  int32_t   nSent;
+} SSyncDeltaH;
+
+static int32_t tsdbSendSyncBlock(SSyncH *pSynch, SReadH *pReadh, uint64_t uid, SBlock *pBlock, void *param) {
+  SSyncDeltaH * pDelta = (SSyncDeltaH *)param;
+  SSyncBlockKey key;
+  int32_t       aggrLen = 0;
+  uint8_t       type = TSDB_SYNC_BLOCK_DATA;
+  uint32_t      ref = 0;
+  char          head[TSDB_SYNC_BLOCK_HEAD_LEN];
+
+  if (tsdbReadSyncBlock(pReadh, pBlock, &SYNC_BUFFER(pSynch), &aggrLen) < 0) return -1;
+
+  tsdbInitSyncBlockKey(&key, uid, pBlock, aggrLen);
+  int32_t *pIdx = (int32_t *)taosHashGet(pDelta->pBlocks, (void *)(&key), sizeof(key));
+  if (pIdx != NULL) {
+    SSyncBlock *pSBlock = (SSyncBlock *)taosArrayGet(pDelta->aBlocks, *pIdx);
+    if (pSBlock->digest == taosCalcChecksum(0, (uint8_t *)SYNC_BUFFER(pSynch), pBlock->len + aggrLen)) {
+      type = TSDB_SYNC_BLOCK_REUSE;
+      ref = (uint32_t)(*pIdx);
+    }
+  }
+
+  void *ptr = head;
+  taosEncodeFixedU8(&ptr, type);
+  taosEncodeFixedU8(&ptr, (uint8_t)pBlock->last);
+  taosEncodeFixedU64(&ptr, (uint64_t)pBlock->offset);
+  taosEncodeFixedU32(&ptr, (uint32_t)pBlock->len);
+  taosEncodeFixedU64(&ptr, aggrLen > 0 ? (uint64_t)pBlock->aggrOffset : 0);
+  taosEncodeFixedU32(&ptr, (uint32_t)aggrLen);
+  taosEncodeFixedU32(&ptr, ref);
+
+  if (type == TSDB_SYNC_BLOCK_REUSE) {
+    pDelta->nReused++;
+    if (taosWriteMsg(pSynch->socketFd, head, TSDB_SYNC_BLOCK_HEAD_LEN) != TSDB_SYNC_BLOCK_HEAD_LEN) {
+      terrno = TAOS_SYSTEM_ERROR(errno);
+      return -1;
+    }
+    pSynch->nsent += TSDB_SYNC_BLOCK_HEAD_LEN;
+    return 0;
+  }
+
+  pDelta->nSent++;
+  return tsdbSendFrame(pSynch, head, TSDB_SYNC_BLOCK_HEAD_LEN, SYNC_BUFFER(pSynch), pBlock->len + aggrLen);
+}
+
+static int32_t tsdbSyncSendDFileSetDelta(SSyncH *pSynch, SDFileSet *pSet) {
+  STsdbRepo * pRepo = pSynch->pRepo;
+  SSyncDeltaH delta = {0};
+  SReadH      readh;
+  int64_t     nsent = pSynch->nsent;
+  int64_t     size = 0;
+  char        end[TSDB_SYNC_BLOCK_HEAD_LEN] = {0};
+
+  if (tsdbInitReadH(&readh, pRepo) < 0) return -1;
+
+  delta.aBlocks = taosArrayInit(1024, sizeof(SSyncBlock));
+  if (delta.aBlocks == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    goto _err;
+  }
+
+  if (tsdbRecvBlockSummary(pSynch, delta.aBlocks) < 0) {
+    tsdbError("vgId:%d, failed to recv block summary of fileset:%d since %s", REPO_ID(pRepo), pSet->fid,
+              tstrerror(terrno));
+    goto _err;
+  }
+
+  delta.pBlocks = taosHashInit(taosArrayGetSize(delta.aBlocks) + 1,
+                               taosGetDefaultHashFunction(TSDB_DATA_TYPE_BINARY), false, HASH_NO_LOCK);
+  if (delta.pBlocks == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    goto _err;
+  }
+
+  for (int32_t i = 0; i < taosArrayGetSize(delta.aBlocks); i++) {
+    SSyncBlock *pSBlock = (SSyncBlock *)taosArrayGet(delta.aBlocks, i);
+    if (taosHashPut(delta.pBlocks, (void *)(&pSBlock->key), sizeof(pSBlock->key), (void *)(&i), sizeof(i)) < 0) {
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      goto _err;
+    }
+  }
+
+  if (tsdbSetAndOpenReadFSet(&readh, pSet) < 0) goto _err;
+
+  // The head file is sent as it is, so the receiving side gets the same block index and block offsets
+  SDFile *pHeadf = TSDB_READ_HEAD_FILE(&readh);
+  if (tsdbSeekDFile(pHeadf, 0, SEEK_SET) < 0) goto _err;
+  for (int64_t nread = 0; nread < pHeadf->info.size;) {
+    int32_t len = (int32_t)MIN(TSDB_SYNC_CHUNK_SIZE, pHeadf->info.size - nread);
+    if (tsdbMakeRoom((void **)(&SYNC_BUFFER(pSynch)), len) < 0) goto _err;
+    if (tsdbReadDFile(pHeadf, SYNC_BUFFER(pSynch), len) < len) {
+      if (terrno == TSDB_CODE_SUCCESS) terrno = TSDB_CODE_TDB_FILE_CORRUPTED;
+      goto _err;
+    }
+    if (tsdbSendFrame(pSynch, NULL, 0, SYNC_BUFFER(pSynch), len) < 0) goto _err;
+    nread += len;
+  }
+
+  if (tsdbLoadBlockIdx(&readh) < 0) goto _err;
+  if (tsdbForEachSyncBlock(pSynch, &readh, tsdbSendSyncBlock, (void *)(&delta)) < 0) goto _err;
+
+  // end of blocks, the type of the record is TSDB_SYNC_BLOCK_END
+  if (taosWriteMsg(pSynch->socketFd, end, TSDB_SYNC_BLOCK_HEAD_LEN) != TSDB_SYNC_BLOCK_HEAD_LEN) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    goto _err;
+  }
+  pSynch->nsent += TSDB_SYNC_BLOCK_HEAD_LEN;
+
+  for (TSDB_FILE_T ftype = 0; ftype < tsdbGetNFiles(pSet); ftype++) {
+    size += TSDB_DFILE_IN_SET(pSet, ftype)->info.size;
+  }
+  nsent = pSynch->nsent - nsent;
+  if (size > nsent) pSynch->nsaved += size - nsent;
+
+  tsdbInfo("vgId:%d, fileset:%d is sent by delta, blocks reused:%d sent:%d, %" PRId64 " of %" PRId64 " bytes sent",
+           REPO_ID(pRepo), pSet->fid, delta.nReused, delta.nSent, nsent, size);
+
+  taosHashCleanup(delta.pBlocks);
+  taosArrayDestroy(delta.aBlocks);
+  tsdbDestroyReadH(&readh);
+  return 0;
+
+_err:
+  taosHashCleanup(delta.pBlocks);
+  taosArrayDestroy(delta.aBlocks);
+  tsdbDestroyReadH(&readh);
+  return -1;
+}
+
+static int32_t tsdbWriteDFileAt(SDFile *pDFile, int64_t offset, void *buf, int32_t len) {
+  if (tsdbSeekDFile(pDFile, offset, SEEK_SET) < 0) return -1;
+  if (tsdbWriteDFile(pDFile, buf, len) < 0) return -1;
+  return 0;
+}
+
+static int32_t tsdbReadDFileAt(SDFile *pDFile, int64_t offset, void *buf, int32_t len) {
+  if (tsdbSeekDFile(pDFile, offset, SEEK_SET) < 0) return -1;
+
+  int64_t nread = tsdbReadDFile(pDFile, buf, len);
+  if (nread < 0) return -1;
+  if (nread < len) {
+    terrno = TSDB_CODE_TDB_FILE_CORRUPTED;
+    tsdbError("file %s is corrupted, offset:%" PRId64 " expected bytes:%d read bytes:%" PRId64,
+              TSDB_FILE_FULL_NAME(pDFile), offset, len, nread);
+    return -1;
+  }
+
+  return 0;
+}
+
+static int32_t tsdbSyncRecvDFileSetDelta(SSyncH *pSynch, SDFileSet *pLSet, SDFileSet *pSet) {
+  STsdbRepo *pRepo = pSynch->pRepo;
+  SDFileSet *pRSet = pSynch->pdf;
+  SReadH     readh;
+  SArray *   aBlocks = NULL;
+  int64_t    nsent = pSynch->nsent;
+  int64_t    size = 0;
+  int32_t    nReused = 0;
+  int32_t    nRecv = 0;
+  int32_t    len;
+
+  if (tsdbInitReadH(&readh, pRepo) < 0) return -1;
+
+  aBlocks = taosArrayInit(1024, sizeof(SSyncBlock));
+  if (aBlocks == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    goto _err;
+  }
+
+  if (tsdbSendBlockSummary(pSynch, &readh, pLSet, aBlocks) < 0) {
+    tsdbError("vgId:%d, failed to send block summary of fileset:%d since %s", REPO_ID(pRepo), pLSet->fid,
+              tstrerror(terrno));
+    goto _err;
+  }
+
+  SDFile *pHeadf = TSDB_DFILE_IN_SET(pSet, TSDB_FILE_HEAD);
+  int64_t hsize = TSDB_DFILE_IN_SET(pRSet, TSDB_FILE_HEAD)->info.size;
+  for (int64_t nrecv = 0; nrecv < hsize;) {
+    if (tsdbRecvFrame(pSynch, &len) < 0) goto _err;
+    if (len > hsize - nrecv) {
+      terrno = TSDB_CODE_TDB_MESSED_MSG;
+      goto _err;
+    }
+    if (tsdbWriteDFile(pHeadf, SYNC_BUFFER(pSynch), len) < 0) goto _err;
+    nrecv += len;
+  }
+
+  while (true) {
+    char     head[TSDB_SYNC_BLOCK_HEAD_LEN];
+    uint8_t  type, last;
+    uint64_t offset, aggrOffset;
+    uint32_t blen, aggrLen, ref;
+
+    if (taosReadMsg(pSynch->socketFd, head, TSDB_SYNC_BLOCK_HEAD_LEN) != TSDB_SYNC_BLOCK_HEAD_LEN) {
+      terrno = TAOS_SYSTEM_ERROR(errno);
+      goto _err;
+    }
+    pSynch->nsent += TSDB_SYNC_BLOCK_HEAD_LEN;
+
+    void *ptr = head;
+    ptr = taosDecodeFixedU8(ptr, &type);
+    ptr = taosDecodeFixedU8(ptr, &last);
+    ptr = taosDecodeFixedU64(ptr, &offset);
+    ptr = taosDecodeFixedU32(ptr, &blen);
+    ptr = taosDecodeFixedU64(ptr, &aggrOffset);
+    ptr = taosDecodeFixedU32(ptr, &aggrLen);
+    taosDecodeFixedU32(ptr, &ref);
+
+    if (type == TSDB_SYNC_BLOCK_END) break;
+
+    SDFile *pDFile = TSDB_DFILE_IN_SET(pSet, last ? TSDB_FILE_LAST : TSDB_FILE_DATA);
+    SDFile *pRDFile = TSDB_DFILE_IN_SET(pRSet, last ? TSDB_FILE_LAST : TSDB_FILE_DATA);
+    if (offset + blen > pRDFile->info.size ||
+        (aggrLen > 0 && (tsdbGetNFiles(pRSet) <= TSDB_FILE_SMAL ||
+                         aggrOffset + aggrLen > TSDB_DFILE_IN_SET(pRSet, last ? TSDB_FILE_SMAL : TSDB_FILE_SMAD)->info.size))) {
+      terrno = TSDB_CODE_TDB_MESSED_MSG;
+      goto _err;
+    }
+
+    void *pData = NULL;
+    if (type == TSDB_SYNC_BLOCK_REUSE) {
+      SSyncBlock *pSBlock = (ref < taosArrayGetSize(aBlocks)) ? (SSyncBlock *)taosArrayGet(aBlocks, ref) : NULL;
+      if (pSBlock == NULL || pSBlock->key.len != blen || pSBlock->key.aggrLen != aggrLen || pSBlock->key.last != last) {
+        terrno = TSDB_CODE_TDB_MESSED_MSG;
+        goto _err;
+      }
+
+      if (tsdbMakeRoom((void **)(&SYNC_CBUFFER(pSynch)), blen + aggrLen) < 0) goto _err;
+      pData = SYNC_CBUFFER(pSynch);
+      if (tsdbReadDFileAt(last ? TSDB_READ_LAST_FILE(&readh) : TSDB_READ_DATA_FILE(&readh), pSBlock->offset, pData,
+                          blen) < 0) {
+        goto _err;
+      }
+      if (aggrLen > 0 && tsdbReadDFileAt(last ? TSDB_READ_SMAL_FILE(&readh) : TSDB_READ_SMAD_FILE(&readh),
+                                         pSBlock->aggrOffset, POINTER_SHIFT(pData, blen), aggrLen) < 0) {
+        goto _err;
+      }
+      nReused++;
+    } else if (type == TSDB_SYNC_BLOCK_DATA) {
+      if (tsdbRecvFrame(pSynch, &len) < 0) goto _err;
+      if (len != blen + aggrLen) {
+        terrno = TSDB_CODE_TDB_MESSED_MSG;
+        goto _err;
+      }
+      pData = SYNC_BUFFER(pSynch);
+      nRecv++;
+    } else {
+      terrno = TSDB_CODE_TDB_MESSED_MSG;
+      goto _err;
+    }
+
+    // Blocks are put at the same offsets as in the remote files, which the received head file refers to
+    if (tsdbWriteDFileAt(pDFile, offset, pData, blen) < 0) goto _err;
+    if (aggrLen > 0 && tsdbWriteDFileAt(TSDB_DFILE_IN_SET(pSet, last ? TSDB_FILE_SMAL : TSDB_FILE_SMAD), aggrOffset,
+                                        POINTER_SHIFT(pData, blen), aggrLen) < 0) {
+      goto _err;
+    }
+  }
+
+  // Bytes of blocks no longer referred in the remote files are left as holes
+  for (TSDB_FILE_T ftype = 0; ftype < tsdbGetNFiles(pSet); ftype++) {
+    SDFile *pDFile = TSDB_DFILE_IN_SET(pSet, ftype);
+    SDFile *pRDFile = TSDB_DFILE_IN_SET(pRSet, ftype);
+
+    pDFile->info = pRDFile->info;
+    size += pRDFile->info.size;
+    if (ftype == TSDB_FILE_HEAD) continue;
+
+    if (taosFtruncate(TSDB_FILE_FD(pDFile), pRDFile->info.size) < 0) {
+      terrno = TAOS_SYSTEM_ERROR(errno);
+      goto _err;
+    }
+    if (tsdbUpdateDFileHeader(pDFile) < 0) goto _err;
+  }
+
+  nsent = pSynch->nsent - nsent;
+  if (size > nsent) pSynch->nsaved += size - nsent;
+
+  tsdbInfo("vgId:%d, fileset:%d is received by delta, blocks reused:%d received:%d, %" PRId64 " of %" PRId64
+           " bytes received",
+           REPO_ID(pRepo), pSet->fid, nReused, nRecv, nsent, size);
+
+  taosArrayDestroy(aBlocks);
+  tsdbDestroyReadH(&readh);
+  return 0;
+
+_err:
+  taosArrayDestroy(aBlocks);
+  tsdbDestroyReadH(&readh);
+  return -1;
+}
+
+static int32_t tsdbAddSyncBlock(SSyncH *pSynch, SReadH *pReadh, uint64_t uid, SBlock *pBlock, void *param) {
+  SArray *   aBlocks = (SArray *)param;
+  SSyncBlock sBlock;
+  int32_t    aggrLen = 0;
+
+  if (tsdbReadSyncBlock(pReadh, pBlock, &SYNC_BUFFER(pSynch), &aggrLen) < 0) return -1;
+
+  tsdbInitSyncBlockKey(&sBlock.key, uid, pBlock, aggrLen);
+  sBlock.digest = taosCalcChecksum(0, (uint8_t *)SYNC_BUFFER(pSynch), pBlock->len + aggrLen);
+  sBlock.offset = pBlock->offset;
+  sBlock.aggrOffset = aggrLen > 0 ? (int64_t)pBlock->aggrOffset : 0;
+
+  if (taosArrayPush(aBlocks, (void *)(&sBlock)) == NULL) {
+    terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+    return -1;
+  }
+
+  return 0;
+}
+
+static int32_t tsdbSendBlockSummary(SSyncH *pSynch, SReadH *pReadh, SDFileSet *pLSet, SArray *aBlocks) {
+  STsdbRepo *pRepo = pSynch->pRepo;
+
+  if (tsdbSetAndOpenReadFSet(pReadh, pLSet) < 0 || tsdbLoadBlockIdx(pReadh) < 0 ||
+      tsdbForEachSyncBlock(pSynch, pReadh, tsdbAddSyncBlock, (void *)aBlocks) < 0) {
+    // Nothing local can be trusted, let remote send all blocks
+    tsdbWarn("vgId:%d, failed to load blocks of fileset:%d since %s, all blocks will be received", REPO_ID(pRepo),
+             pLSet->fid, tstrerror(terrno));
+    taosArrayClear(aBlocks);
+  }
+
+  uint32_t nBlocks = (uint32_t)taosArrayGetSize(aBlocks);
+  uint32_t tlen = sizeof(uint32_t) + nBlocks * TSDB_SYNC_SUMMARY_LEN + sizeof(TSCKSUM);
+
+  if (tsdbMakeRoom((void **)(&SYNC_BUFFER(pSynch)), tlen + sizeof(tlen)) < 0) return -1;
+
+  void *ptr = SYNC_BUFFER(pSynch);
+  taosEncodeFixedU32(&ptr, tlen);
+  void *tptr = ptr;
+  taosEncodeFixedU32(&ptr, nBlocks);
+  for (uint32_t i = 0; i < nBlocks; i++) {
+    SSyncBlock *pSBlock = (SSyncBlock *)taosArrayGet(aBlocks, i);
+    taosEncodeFixedU64(&ptr, pSBlock->key.uid);
+    taosEncodeFixedI64(&ptr, pSBlock->key.keyFirst);
+    taosEncodeFixedI64(&ptr, pSBlock->key.keyLast);
+    taosEncodeFixedI32(&ptr, pSBlock->key.numOfRows);
+    taosEncodeFixedI32(&ptr, pSBlock->key.len);
+    taosEncodeFixedI32(&ptr, pSBlock->key.last);
+    taosEncodeFixedI32(&ptr, pSBlock->key.aggrLen);
+    taosEncodeFixedU32(&ptr, pSBlock->digest);
+  }
+  taosCalcChecksumAppend(0, (uint8_t *)tptr, tlen);
+
+  int32_t writeLen = tlen + sizeof(uint32_t);
+  int32_t ret = taosWriteMsg(pSynch->socketFd, SYNC_BUFFER(pSynch), writeLen);
+  if (ret != writeLen) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    tsdbError("vgId:%d, failed to send block summary, ret:%d writeLen:%d", REPO_ID(pRepo), ret, writeLen);
+    return -1;
+  }
+
+  tsdbInfo("vgId:%d, summary of %u blocks in fileset:%d is sent", REPO_ID(pRepo), nBlocks, pLSet->fid);
+  return 0;
+}
+
+static int32_t tsdbRecvBlockSummary(SSyncH *pSynch, SArray *aBlocks) {
+  STsdbRepo *pRepo = pSynch->pRepo;
+  uint32_t   tlen;
+  uint32_t   nBlocks;
+  char       buf[sizeof(uint32_t)];
+
+  int32_t ret = taosReadMsg(pSynch->socketFd, buf, sizeof(uint32_t));
+  if (ret != sizeof(uint32_t)) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    return -1;
+  }
+
+  taosDecodeFixedU32(buf, &tlen);
+  if (tlen < sizeof(uint32_t) + sizeof(TSCKSUM)) {
+    terrno = TSDB_CODE_TDB_MESSED_MSG;
+    return -1;
+  }
+
+  if (tsdbMakeRoom((void **)(&SYNC_BUFFER(pSynch)), tlen) < 0) return -1;
+
+  ret = taosReadMsg(pSynch->socketFd, SYNC_BUFFER(pSynch), tlen);
+  if (ret != tlen) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    tsdbError("vgId:%d, failed to recv block summary, ret:%d readLen:%d", REPO_ID(pRepo), ret, tlen);
+    return -1;
+  }
+
+  if (!taosCheckChecksumWhole((uint8_t *)SYNC_BUFFER(pSynch), tlen)) {
+    terrno = TSDB_CODE_TDB_MESSED_MSG;
+    tsdbError("vgId:%d, failed to checksum while recv block summary since %s", REPO_ID(pRepo), tstrerror(terrno));
+    return -1;
+  }
+
+  void *ptr = taosDecodeFixedU32(SYNC_BUFFER(pSynch), &nBlocks);
+  if (sizeof(uint32_t) + (uint64_t)nBlocks * TSDB_SYNC_SUMMARY_LEN + sizeof(TSCKSUM) != tlen) {
+    terrno = TSDB_CODE_TDB_MESSED_MSG;
+    return -1;
+  }
+
+  for (uint32_t i = 0; i < nBlocks; i++) {
+    SSyncBlock sBlock = {0};
+    ptr = taosDecodeFixedU64(ptr, &sBlock.key.uid);
+    ptr = taosDecodeFixedI64(ptr, &sBlock.key.keyFirst);
+    ptr = taosDecodeFixedI64(ptr, &sBlock.key.keyLast);
+    ptr = taosDecodeFixedI32(ptr, &sBlock.key.numOfRows);
+    ptr = taosDecodeFixedI32(ptr, &sBlock.key.len);
+    ptr = taosDecodeFixedI32(ptr, &sBlock.key.last);
+    ptr = taosDecodeFixedI32(ptr, &sBlock.key.aggrLen);
+    ptr = taosDecodeFixedU32(ptr, &sBlock.digest);
+
+    if (taosArrayPush(aBlocks, (void *)(&sBlock)) == NULL) {
+      terrno = TSDB_CODE_TDB_OUT_OF_MEMORY;
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+// Call fp on each block holding data, i.e. the super blocks without sub-blocks and all the sub-blocks
+static int32_t tsdbForEachSyncBlock(SSyncH *pSynch, SReadH *pReadh, __tsdb_sync_block_fn_t fp, void *param) {
+  int32_t nIdx = (pReadh->pHeadIdx == NULL) ? 0 : pReadh->pHeadIdx->numOfIdx;
+
+  for (int32_t i = 0; i < nIdx; i++) {
+    pReadh->pBlkIdx = pReadh->pHeadIdx->aBlkIdx + i;
+    if (tsdbLoadBlockInfo(pReadh, NULL, NULL) < 0) return -1;
+
+    uint64_t uid = pReadh->pBlkIdx->uid;
+    for (int j = 0; j < pReadh->pBlkIdx->numOfBlocks; j++) {
+      SBlock *pBlock = pReadh->pBlkInfo->blocks + j;
+
+      if (pBlock->numOfSubBlocks > 1) {
+        SBlock *pSubBlocks = (SBlock *)POINTER_SHIFT(pReadh->pBlkInfo, pBlock->offset);
+        for (int k = 0; k < pBlock->numOfSubBlocks; k++) {
+          if ((*fp)(pSynch, pReadh, uid, pSubBlocks + k, param) < 0) return -1;
+        }
+      } else {
+        if ((*fp)(pSynch, pReadh, uid, pBlock, param) < 0) return -1;
+      }
+    }
+  }
+
+  pReadh->pBlkIdx = NULL;
+  return 0;
+}
+
+// Read the raw block, followed by its aggregate part in .smad/.smal if any
+static int32_t tsdbReadSyncBlock(SReadH *pReadh, SBlock *pBlock, void **ppBuf, int32_t *aggrLen) {
+  SDFile *pDFile = pBlock->last ? TSDB_READ_LAST_FILE(pReadh) : TSDB_READ_DATA_FILE(pReadh);
+
+  *aggrLen = 0;
+  if (pBlock->blkVer > TSDB_SBLK_VER_0 && pBlock->aggrStat) {
+    *aggrLen = (int32_t)tsdbBlockAggrSize(pBlock->numOfCols, (uint32_t)pBlock->blkVer);
+  }
+
+  if (tsdbMakeRoom(ppBuf, pBlock->len + *aggrLen) < 0) return -1;
+
+  if (tsdbReadDFileAt(pDFile, pBlock->offset, *ppBuf, pBlock->len) < 0) return -1;
+
+  if (*aggrLen > 0) {
+    SDFile *pDFileAggr = pBlock->last ? TSDB_READ_SMAL_FILE(pReadh) : TSDB_READ_SMAD_FILE(pReadh);
+    if (tsdbReadDFileAt(pDFileAggr, pBlock->aggrOffset, POINTER_SHIFT(*ppBuf, pBlock->len), *aggrLen) < 0) return -1;
+  }
+
+  return 0;
+}
+
+// A frame is [raw length][frame length][frame], the frame is compressed by lz4 when tsdbSyncCompress is set. File
+// blocks are compressed already, while head files and uncompressed databases benefit much from it.
+static int32_t tsdbSendFrame(SSyncH *pSynch, void *head, int32_t headLen, void *data, int32_t len) {
+  STsdbRepo *pRepo = pSynch->pRepo;
+
+  if (tsdbMakeRoom((void **)(&SYNC_CBUFFER(pSynch)), headLen + TSDB_SYNC_FRAME_HEAD_LEN + len + 1) < 0) return -1;
+
+  char *buf = (char *)SYNC_CBUFFER(pSynch);
+  char *frame = buf + headLen + TSDB_SYNC_FRAME_HEAD_LEN;
+  int32_t flen;
+
+  if (tsdbSyncCompress) {
+    flen = tsCompressStringImp((const char *)data, len, frame, len + 1);
+  } else {
+    frame[0] = 0;
+    memcpy(frame + 1, data, len);
+    flen = len + 1;
+  }
+
+  if (headLen > 0) memcpy(buf, head, headLen);
+  void *ptr = buf + headLen;
+  taosEncodeFixedU32(&ptr, (uint32_t)len);
+  taosEncodeFixedU32(&ptr, (uint32_t)flen);
+
+  int32_t writeLen = headLen + TSDB_SYNC_FRAME_HEAD_LEN + flen;
+  int32_t ret = taosWriteMsg(pSynch->socketFd, buf, writeLen);
+  if (ret != writeLen) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    tsdbError("vgId:%d, failed to send frame, ret:%d writeLen:%d", REPO_ID(pRepo), ret, writeLen);
+    return -1;
+  }
+
+  pSynch->nsent += writeLen;
+  return 0;
+}
+
+// Receive a frame into SYNC_BUFFER
+static int32_t tsdbRecvFrame(SSyncH *pSynch, int32_t *len) {
+  STsdbRepo *pRepo = pSynch->pRepo;
+  char       head[TSDB_SYNC_FRAME_HEAD_LEN];
+  uint32_t   rlen, flen;
+
+  if (taosReadMsg(pSynch->socketFd, head, TSDB_SYNC_FRAME_HEAD_LEN) != TSDB_SYNC_FRAME_HEAD_LEN) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    return -1;
+  }
+
+  void *ptr = taosDecodeFixedU32(head, &rlen);
+  taosDecodeFixedU32(ptr, &flen);
+  if (flen < 1 || flen > rlen + 1 || rlen > INT32_MAX - 1) {
+    terrno = TSDB_CODE_TDB_MESSED_MSG;
+    return -1;
+  }
+
+  if (tsdbMakeRoom((void **)(&SYNC_CBUFFER(pSynch)), flen) < 0) return -1;
+  if (tsdbMakeRoom((void **)(&SYNC_BUFFER(pSynch)), rlen) < 0) return -1;
+
+  int32_t ret = taosReadMsg(pSynch->socketFd, SYNC_CBUFFER(pSynch), flen);
+  if (ret != flen) {
+    terrno = TAOS_SYSTEM_ERROR(errno);
+    tsdbError("vgId:%d, failed to recv frame, ret:%d readLen:%u", REPO_ID(pRepo), ret, flen);
+    return -1;
+  }
+
+  if (tsDecompressStringImp(SYNC_CBUFFER(pSynch), flen, SYNC_BUFFER(pSynch), rlen) != rlen) {
+    terrno = TSDB_CODE_TDB_MESSED_MSG;
+    tsdbError("vgId:%d, failed to decompress frame, raw len:%u frame len:%u", REPO_ID(pRepo), rlen, flen);
+    return -1;
+  }
+
+  pSynch->nsent += TSDB_SYNC_FRAME_HEAD_LEN + flen;
+  *len = (int32_t)rlen;
+  return 0;
+}
+
 static int tsdbReload(STsdbRepo *pRepo, bool isMfChanged) {
   // TODO: may need to stop and restart stream
   // if (isMfChanged) {
@@ -62,6 +62,16 @@ extern int tsCompressDoubleImp(const char *const input, const int nelements, cha
 extern int tsDecompressDoubleImp(const char *const input, const int nelements, char *const output);
 extern int tsCompressFloatImp(const char *const input, const int nelements, char *const output);
 extern int tsDecompressFloatImp(const char *const input, const int nelements, char *const output);
+extern int tsCompressZlibImp(const char *const input, int inputSize, char *const output, int outputSize);
+extern int tsDecompressZlibImp(const char *const input, int compressedSize, char *const output, int outputSize);
+extern int tsCompressBitPackImp(const char *const input, const int nelements, char *const output, int outputSize,
+                                const char type);
+extern int tsDecompressBitPackImp(const char *const input, int compressedSize, const int nelements, char *const output,
+                                  const char type);
+extern int tsCompressDictImp(const char *const input, int inputSize, const int nelements, char *const output,
+                             int outputSize);
+extern int tsDecompressDictImp(const char *const input, int compressedSize, const int nelements, char *const output,
+                               int outputSize);
 // lossy
 extern int tsCompressFloatLossyImp(const char * input, const int nelements, char *const output);
 extern int tsDecompressFloatLossyImp(const char * input, int compressedSize, const int nelements, char *const output);
@@ -41,6 +41,7 @@ typedef char *(*__sl_key_fn_t)(const void *);
 
 typedef void (*sl_patch_row_fn_t)(void * pDst, const void * pSrc);
 typedef void* (*iter_next_fn_t)(void *iter);
+typedef void* (*sl_node_alloc_fn_t)(void *param, int32_t size);
 
 typedef struct SSkipListNode {
   uint8_t        level;
@@ -62,6 +63,10 @@ typedef struct SSkipListNode {
  * In this case, one should use the concurrent skip list (by using michael-scott algorithm) instead of
  * this simple version in a multi-thread environment, to achieve higher performance of read/write operations.
  *
+ * Without SL_THREAD_SAFE, one writer and any number of readers may still work on the same list: a new node is
+ * fully linked before it is published to its neighbours with atomic stores, from the bottom level up, so a
+ * reader either sees the node with valid pointers or does not see it at all.
+ *
  * Note: Duplicated primary key situation.
  * In case of duplicated primary key, two ways can be employed to handle this situation:
  * 1. add as normal insertion without special process.
@@ -123,6 +128,8 @@ typedef struct SSkipList {
   tSkipListState state;  // skiplist state
 #endif
   tGenericSavedFunc* insertHandleFn;
+  sl_node_alloc_fn_t nodeAllocFn;     // if set, nodes are carved from an arena owned by the caller and never freed here
+  void *             nodeAllocParam;
 } SSkipList;
 
 typedef struct SSkipListIterator {
@@ -143,6 +150,7 @@ typedef struct SSkipListIterator {
 SSkipList *tSkipListCreate(uint8_t maxLevel, uint8_t keyType, uint16_t keyLen, __compar_fn_t comparFn, uint8_t flags,
                            __sl_key_fn_t fn);
 void       tSkipListDestroy(SSkipList *pSkipList);
+void       tSkipListSetNodeAllocator(SSkipList *pSkipList, sl_node_alloc_fn_t fn, void *param);
 SSkipListNode *    tSkipListPut(SSkipList *pSkipList, void *pData);
 void               tSkipListPutBatchByIter(SSkipList *pSkipList, void *iter, iter_next_fn_t iterate);
 SArray *           tSkipListGet(SSkipList *pSkipList, SSkipListKey pKey);
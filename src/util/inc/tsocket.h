@@ -26,6 +26,7 @@ extern "C" {
 
 int32_t taosReadn(SOCKET sock, char *buffer, int32_t len);
 int32_t taosWriteMsg(SOCKET fd, void *ptr, int32_t nbytes);
+int32_t taosWriteMsgV(SOCKET fd, struct iovec *iov, int32_t iovcnt);
 int32_t taosReadMsg(SOCKET fd, void *ptr, int32_t nbytes);
 int32_t taosNonblockwrite(SOCKET fd, char *ptr, int32_t nbytes);
 int64_t taosCopyFds(SOCKET sfd, int32_t dfd, int64_t len);
@@ -45,17 +45,33 @@
  *   of leading zeros are larger than the trailing zeros, then record the last serveral bytes
  *   of the XORed value with informations. If not, record the first corresponding bytes.
  *
+ * BIT PACKING Compression Algorithm:
+ *   Frame of reference for integers. The minimum value of the block is recorded, and each value
+ *   is stored as its distance to the minimum with just the bits needed by the largest distance.
+ *   It works better than simple 8B for values fluctuating in a narrow range without a trend.
+ *
+ * DICTIONARY Compression Algorithm:
+ *   For binary and nchar blocks with at most 256 distinct values. The distinct values are stored
+ *   once and each row is replaced by an one byte index into them.
+ *
+ * ZLIB Compression Algorithm:
+ *   The deflate method of zlib, an alternative to LZ4 as the second stage which trades CPU for a
+ *   better compression ratio.
+ *
  */
 
 #include "os.h"
 #include "lz4.h"
+#include "zlib.h"
 #ifdef TD_TSZ  
   #include "td_sz.h"
 #endif
 #include "taosdef.h"
+#include "ttype.h"
 #include "tscompression.h"
 #include "tulog.h"
 #include "tglobal.h"
+#include "hashfunc.h"
 
 
 static const int TEST_NUMBER = 1;
@@ -232,6 +248,88 @@ int tsCompressINTImp(const char *const input, const int nelements, char *const o
   return opos;
 }
 
+/*
+ * Decompress Integer (Simple8B).
+ *
+ * The zigzag encoded deltas of one simple8b word are unpacked into a buffer first, and then turned into values by a
+ * prefix sum and stored with a loop specialized for the output type. Unpacking is done with AVX2 variable shifts when
+ * the CPU supports it, and with a scalar loop otherwise; both produce exactly the same values.
+ */
+#define SIMPLE8B_MAX_ELEMS_PER_WORD 60  // words of selector 0 and 1 carry no bits and are decoded as runs
+
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(_TD_WINDOWS_64)
+#define SIMPLE8B_USE_AVX2
+#include <immintrin.h>
+
+__attribute__((target("avx2"))) static void tsUnpackSimple8bAVX2(uint64_t w, int bit, int elems, int64_t *diffs) {
+  const __m256i vw = _mm256_set1_epi64x((int64_t)w);
+  const __m256i vmask = _mm256_set1_epi64x((int64_t)INT64MASK(bit));
+  const __m256i vone = _mm256_set1_epi64x(1);
+  const __m256i vzero = _mm256_setzero_si256();
+  const __m256i vstep = _mm256_set1_epi64x(4 * bit);
+  __m256i       vshift = _mm256_setr_epi64x(4, 4 + bit, 4 + 2 * bit, 4 + 3 * bit);
+
+  for (int i = 0; i < elems; i += 4) {
+    __m256i v = _mm256_and_si256(_mm256_srlv_epi64(vw, vshift), vmask);
+    // zigzag decode: (v >> 1) ^ -(v & 1)
+    __m256i d = _mm256_xor_si256(_mm256_srli_epi64(v, 1), _mm256_sub_epi64(vzero, _mm256_and_si256(v, vone)));
+    _mm256_storeu_si256((__m256i *)(diffs + i), d);
+    vshift = _mm256_add_epi64(vshift, vstep);
+  }
+}
+
+static bool tsCpuSupportAVX2() {
+  static int8_t supported = -1;
+  if (supported < 0) {
+    __builtin_cpu_init();
+    supported = __builtin_cpu_supports("avx2") ? 1 : 0;
+  }
+  return supported == 1;
+}
+#endif
+
+#ifdef SIMPLE8B_USE_AVX2
+#define SIMPLE8B_USE_AVX2_UNPACK(elems) (useAVX2 && (elems) >= 8)
+#else
+#define SIMPLE8B_USE_AVX2_UNPACK(elems) false
+#define tsUnpackSimple8bAVX2(w, bit, elems, diffs)
+#endif
+
+// the loop is expanded for each output type, so no type switch is evaluated per word or per value
+#define SIMPLE8B_DECODE(T)                                                \
+  do {                                                                    \
+    T *ostream = (T *)output;                                             \
+    while (count < nelements) {                                           \
+      uint64_t w = 0;                                                     \
+      memcpy(&w, ip, LONG_BYTES);                                         \
+      ip += LONG_BYTES;                                                   \
+                                                                          \
+      int selector = (int)(w & INT64MASK(4));                             \
+      int bit = bit_per_integer[selector];                                \
+      int num = MIN(selector_to_elems[selector], nelements - count);      \
+      if (selector == 0 || selector == 1) {                               \
+        for (int i = 0; i < num; i++) {                                   \
+          ostream[count + i] = (T)prev_value;                             \
+        }                                                                 \
+      } else if (SIMPLE8B_USE_AVX2_UNPACK(num)) {                         \
+        tsUnpackSimple8bAVX2(w, bit, num, diffs);                         \
+        for (int i = 0; i < num; i++) {                                   \
+          prev_value = diffs[i] + prev_value;                             \
+          ostream[count + i] = (T)prev_value;                             \
+        }                                                                 \
+      } else {                                                            \
+        uint64_t mask = INT64MASK(bit);                                   \
+        for (int i = 0; i < num; i++) {                                   \
+          uint64_t zigzag_value = ((w >> (4 + bit * i)) & mask);          \
+          int64_t  diff = ZIGZAG_DECODE(int64_t, zigzag_value);           \
+          prev_value = diff + prev_value;                                 \
+          ostream[count + i] = (T)prev_value;                             \
+        }                                                                 \
+      }                                                                   \
+      count += num;                                                       \
+    }                                                                     \
+  } while (0)
+
 int tsDecompressINTImp(const char *const input, const int nelements, char *const output, const char type) {
   int word_length = 0;
   switch (type) {
@@ -260,61 +358,31 @@ int tsDecompressINTImp(const char *const input, const int nelements, char *const
 
   // Selector value:              0    1   2   3   4   5   6   7   8  9  10  11
   // 12  13  14  15
-  char bit_per_integer[] = {0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 10, 12, 15, 20, 30, 60};
-  int  selector_to_elems[] = {240, 120, 60, 30, 20, 15, 12, 10, 8, 7, 6, 5, 4, 3, 2, 1};
+  static const char bit_per_integer[] = {0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 10, 12, 15, 20, 30, 60};
+  static const int  selector_to_elems[] = {240, 120, 60, 30, 20, 15, 12, 10, 8, 7, 6, 5, 4, 3, 2, 1};
 
   const char *ip = input + 1;
   int         count = 0;
-  int         _pos = 0;
   int64_t     prev_value = 0;
+  int64_t     diffs[SIMPLE8B_MAX_ELEMS_PER_WORD + 4];  // AVX2 unpacking writes 4 values at a time
 
-  while (1) {
-    if (count == nelements) break;
-
-    uint64_t w = 0;
-    memcpy(&w, ip, LONG_BYTES);
-
-    char selector = (char)(w & INT64MASK(4));  // selector = 4
-    char bit = bit_per_integer[(int)selector];      // bit = 3
-    int  elems = selector_to_elems[(int)selector];
-
-    for (int i = 0; i < elems; i++) {
-      uint64_t zigzag_value;
-
-      if (selector == 0 || selector == 1) {
-        zigzag_value = 0;
-      } else {
-        zigzag_value = ((w >> (4 + bit * i)) & INT64MASK(bit));
-      }
-      int64_t diff = ZIGZAG_DECODE(int64_t, zigzag_value);
-      int64_t curr_value = diff + prev_value;
-      prev_value = curr_value;
+#ifdef SIMPLE8B_USE_AVX2
+  bool useAVX2 = tsCpuSupportAVX2();
+#endif
 
-      switch (type) {
-        case TSDB_DATA_TYPE_BIGINT:
-          *((int64_t *)output + _pos) = (int64_t)curr_value;
-          _pos++;
-          break;
-        case TSDB_DATA_TYPE_INT:
-          *((int32_t *)output + _pos) = (int32_t)curr_value;
-          _pos++;
-          break;
-        case TSDB_DATA_TYPE_SMALLINT:
-          *((int16_t *)output + _pos) = (int16_t)curr_value;
-          _pos++;
-          break;
-        case TSDB_DATA_TYPE_TINYINT:
-          *((int8_t *)output + _pos) = (int8_t)curr_value;
-          _pos++;
-          break;
-        default:
-          perror("Wrong integer types.\n");
-          return -1;
-      }
-      count++;
-      if (count == nelements) break;
-    }
-    ip += LONG_BYTES;
+  switch (type) {
+    case TSDB_DATA_TYPE_BIGINT:
+      SIMPLE8B_DECODE(int64_t);
+      break;
+    case TSDB_DATA_TYPE_INT:
+      SIMPLE8B_DECODE(int32_t);
+      break;
+    case TSDB_DATA_TYPE_SMALLINT:
+      SIMPLE8B_DECODE(int16_t);
+      break;
+    default:
+      SIMPLE8B_DECODE(int8_t);
+      break;
   }
 
   return nelements * word_length;
@@ -355,22 +423,23 @@ int tsCompressBoolImp(const char *const input, const int nelements, char *const
 }
 
 int tsDecompressBoolImp(const char *const input, const int nelements, char *const output) {
-  int ipos = -1, opos = 0;
+  // each byte holds 4 values of 2 bits, 0b01 for true, 0b10 for null and others for false
+  static const char bool_values[4] = {0, 1, TSDB_DATA_BOOL_NULL, 0};
   int ele_per_byte = BITS_PER_BYTE / 2;
+  int nbytes = nelements / ele_per_byte;
+
+  for (int ipos = 0; ipos < nbytes; ipos++) {
+    uint8_t byte = (uint8_t)input[ipos];
+    char   *out = output + ipos * ele_per_byte;
+    out[0] = bool_values[byte & INT8MASK(2)];
+    out[1] = bool_values[(byte >> 2) & INT8MASK(2)];
+    out[2] = bool_values[(byte >> 4) & INT8MASK(2)];
+    out[3] = bool_values[(byte >> 6) & INT8MASK(2)];
+  }
 
-  for (int i = 0; i < nelements; i++) {
-    if (i % ele_per_byte == 0) {
-      ipos++;
-    }
-
-    uint8_t ele = (input[ipos] >> (2 * (i % ele_per_byte))) & INT8MASK(2);
-    if (ele == 1) {
-      output[opos++] = 1;
-    } else if (ele == 2) {
-      output[opos++] = TSDB_DATA_BOOL_NULL;
-    } else {
-      output[opos++] = 0;
-    }
+  for (int i = nbytes * ele_per_byte; i < nelements; i++) {
+    uint8_t ele = (input[nbytes] >> (2 * (i % ele_per_byte))) & INT8MASK(2);
+    output[i] = bool_values[ele];
   }
 
   return nelements;
@@ -468,6 +537,300 @@ int tsDecompressStringImp(const char *const input, int compressedSize, char *con
   }
 }
 
+/* --------------------------------------------Zlib Compression
+ * ---------------------------------------------- */
+int tsCompressZlibImp(const char *const input, int inputSize, char *const output, int outputSize) {
+  uLongf len = (uLongf)(outputSize - 1);
+
+  // Compress failed or not smaller, just copy the data
+  if (compress2((Bytef *)(output + 1), &len, (const Bytef *)input, (uLong)inputSize, Z_DEFAULT_COMPRESSION) != Z_OK ||
+      (int)len >= inputSize) {
+    if (inputSize + 1 > outputSize) return -1;
+    output[0] = 0;
+    memcpy(output + 1, input, inputSize);
+    return inputSize + 1;
+  }
+
+  output[0] = 1;
+  return (int)len + 1;
+}
+
+int tsDecompressZlibImp(const char *const input, int compressedSize, char *const output, int outputSize) {
+  if (input[0] == 1) {
+    uLongf len = (uLongf)outputSize;
+    int    code = uncompress((Bytef *)output, &len, (const Bytef *)(input + 1), (uLong)(compressedSize - 1));
+    if (code != Z_OK) {
+      uError("Failed to decompress data with zlib algorithm, code:%d", code);
+      return -1;
+    }
+
+    return (int)len;
+  } else if (input[0] == 0) {
+    if (compressedSize - 1 > outputSize) return -1;
+    memcpy(output, input + 1, compressedSize - 1);
+    return compressedSize - 1;
+  } else {
+    uError("Invalid decompress zlib indicator:%d", input[0]);
+    return -1;
+  }
+}
+
+/* --------------------------------------------Bit Packing Compression
+ * ---------------------------------------------- */
+#define BITPACK_HEAD_SIZE (CHAR_BYTES + LONG_BYTES)  // bits per value and the minimum value
+#define BITPACK_MAX_BITS 56                           // so that the value and pending bits fit into 64 bits
+
+#define BITPACK_GET_RANGE(T, input, nelements, min, max) \
+  do {                                                  \
+    const T *in = (const T *)(input);                   \
+    T        tmin = in[0], tmax = in[0];                \
+    for (int i = 1; i < (nelements); i++) {             \
+      if (in[i] < tmin) tmin = in[i];                   \
+      if (in[i] > tmax) tmax = in[i];                   \
+    }                                                   \
+    (min) = (uint64_t)(int64_t)tmin;                    \
+    (max) = (uint64_t)(int64_t)tmax;                    \
+  } while (0)
+
+#define BITPACK_GET_URANGE(T, input, nelements, min, max) \
+  do {                                                   \
+    const T *in = (const T *)(input);                    \
+    T        tmin = in[0], tmax = in[0];                 \
+    for (int i = 1; i < (nelements); i++) {              \
+      if (in[i] < tmin) tmin = in[i];                    \
+      if (in[i] > tmax) tmax = in[i];                    \
+    }                                                    \
+    (min) = (uint64_t)tmin;                              \
+    (max) = (uint64_t)tmax;                              \
+  } while (0)
+
+static FORCE_INLINE uint64_t tsBitPackGetValue(const char *const input, int i, char type) {
+  switch (type) {
+    case TSDB_DATA_TYPE_TINYINT:
+      return (uint64_t)(int64_t)((int8_t *)input)[i];
+    case TSDB_DATA_TYPE_SMALLINT:
+      return (uint64_t)(int64_t)((int16_t *)input)[i];
+    case TSDB_DATA_TYPE_INT:
+      return (uint64_t)(int64_t)((int32_t *)input)[i];
+    case TSDB_DATA_TYPE_UTINYINT:
+      return ((uint8_t *)input)[i];
+    case TSDB_DATA_TYPE_USMALLINT:
+      return ((uint16_t *)input)[i];
+    case TSDB_DATA_TYPE_UINT:
+      return ((uint32_t *)input)[i];
+    default:
+      return ((uint64_t *)input)[i];
+  }
+}
+
+static FORCE_INLINE void tsBitPackSetValue(char *const output, int i, char type, uint64_t value) {
+  switch (type) {
+    case TSDB_DATA_TYPE_TINYINT:
+    case TSDB_DATA_TYPE_UTINYINT:
+      ((uint8_t *)output)[i] = (uint8_t)value;
+      break;
+    case TSDB_DATA_TYPE_SMALLINT:
+    case TSDB_DATA_TYPE_USMALLINT:
+      ((uint16_t *)output)[i] = (uint16_t)value;
+      break;
+    case TSDB_DATA_TYPE_INT:
+    case TSDB_DATA_TYPE_UINT:
+      ((uint32_t *)output)[i] = (uint32_t)value;
+      break;
+    default:
+      ((uint64_t *)output)[i] = value;
+      break;
+  }
+}
+
+int tsCompressBitPackImp(const char *const input, const int nelements, char *const output, int outputSize,
+                         const char type) {
+  uint64_t min = 0, max = 0;
+
+  if (nelements <= 0) return -1;
+
+  switch (type) {
+    case TSDB_DATA_TYPE_TINYINT:
+      BITPACK_GET_RANGE(int8_t, input, nelements, min, max);
+      break;
+    case TSDB_DATA_TYPE_SMALLINT:
+      BITPACK_GET_RANGE(int16_t, input, nelements, min, max);
+      break;
+    case TSDB_DATA_TYPE_INT:
+      BITPACK_GET_RANGE(int32_t, input, nelements, min, max);
+      break;
+    case TSDB_DATA_TYPE_BIGINT:
+      BITPACK_GET_RANGE(int64_t, input, nelements, min, max);
+      break;
+    case TSDB_DATA_TYPE_UTINYINT:
+      BITPACK_GET_URANGE(uint8_t, input, nelements, min, max);
+      break;
+    case TSDB_DATA_TYPE_USMALLINT:
+      BITPACK_GET_URANGE(uint16_t, input, nelements, min, max);
+      break;
+    case TSDB_DATA_TYPE_UINT:
+      BITPACK_GET_URANGE(uint32_t, input, nelements, min, max);
+      break;
+    case TSDB_DATA_TYPE_UBIGINT:
+      BITPACK_GET_URANGE(uint64_t, input, nelements, min, max);
+      break;
+    default:
+      uError("Invalid bit packing integer type:%d", type);
+      return -1;
+  }
+
+  uint64_t range = max - min;
+  int      bits = (range == 0) ? 0 : (LONG_BYTES * BITS_PER_BYTE - BUILDIN_CLZL(range));
+  int      len = BITPACK_HEAD_SIZE + (int)(((int64_t)nelements * bits + BITS_PER_BYTE - 1) / BITS_PER_BYTE);
+  if (bits > BITPACK_MAX_BITS || len > outputSize) return -1;
+
+  output[0] = (char)bits;
+  memcpy(output + CHAR_BYTES, &min, LONG_BYTES);
+
+  uint8_t *op = (uint8_t *)(output + BITPACK_HEAD_SIZE);
+  uint64_t acc = 0;
+  int      nbits = 0;
+  if (bits > 0) {
+    for (int i = 0; i < nelements; i++) {
+      acc |= (tsBitPackGetValue(input, i, type) - min) << nbits;
+      nbits += bits;
+      while (nbits >= BITS_PER_BYTE) {
+        *(op++) = (uint8_t)acc;
+        acc >>= BITS_PER_BYTE;
+        nbits -= BITS_PER_BYTE;
+      }
+    }
+    if (nbits > 0) *(op++) = (uint8_t)acc;
+  }
+
+  ASSERT((char *)op - output == len);
+  return len;
+}
+
+int tsDecompressBitPackImp(const char *const input, int compressedSize, const int nelements, char *const output,
+                           const char type) {
+  if (compressedSize < BITPACK_HEAD_SIZE) return -1;
+
+  int      bits = (uint8_t)input[0];
+  uint64_t min = 0;
+  memcpy(&min, input + CHAR_BYTES, LONG_BYTES);
+
+  if (bits > BITPACK_MAX_BITS ||
+      BITPACK_HEAD_SIZE + ((int64_t)nelements * bits + BITS_PER_BYTE - 1) / BITS_PER_BYTE > compressedSize) {
+    uError("Invalid bit packing data, bits:%d nelements:%d compressedSize:%d", bits, nelements, compressedSize);
+    return -1;
+  }
+
+  const uint8_t *ip = (const uint8_t *)(input + BITPACK_HEAD_SIZE);
+  uint64_t       mask = INT64MASK(bits);
+  uint64_t       acc = 0;
+  int            nbits = 0;
+  for (int i = 0; i < nelements; i++) {
+    while (nbits < bits) {
+      acc |= ((uint64_t)*(ip++)) << nbits;
+      nbits += BITS_PER_BYTE;
+    }
+    tsBitPackSetValue(output, i, type, min + (acc & mask));
+    acc >>= bits;
+    nbits -= bits;
+  }
+
+  switch (type) {
+    case TSDB_DATA_TYPE_TINYINT:
+    case TSDB_DATA_TYPE_UTINYINT:
+      return nelements * CHAR_BYTES;
+    case TSDB_DATA_TYPE_SMALLINT:
+    case TSDB_DATA_TYPE_USMALLINT:
+      return nelements * SHORT_BYTES;
+    case TSDB_DATA_TYPE_INT:
+    case TSDB_DATA_TYPE_UINT:
+      return nelements * INT_BYTES;
+    default:
+      return nelements * LONG_BYTES;
+  }
+}
+
+/* --------------------------------------------Dictionary Compression
+ * ---------------------------------------------- */
+#define DICT_MAX_ENTRIES 256
+#define DICT_HASH_SLOTS (DICT_MAX_ENTRIES * 2)
+
+int tsCompressDictImp(const char *const input, int inputSize, const int nelements, char *const output,
+                      int outputSize) {
+  const char *entries[DICT_MAX_ENTRIES];
+  int16_t     slots[DICT_HASH_SLOTS];
+  int         numOfEntries = 0;
+
+  // head: number of entries - 1, then the entries, then one index per row
+  int   dictLen = CHAR_BYTES;
+  char *indices = NULL;
+  if (nelements <= 0 || CHAR_BYTES + nelements > outputSize) return -1;
+
+  memset(slots, 0xff, sizeof(slots));
+
+  // put indices at the tail of the output first, they are moved behind the entries in the end
+  indices = output + outputSize - nelements;
+
+  const char *ip = input;
+  for (int i = 0; i < nelements; i++) {
+    if (ip - input + VARSTR_HEADER_SIZE > inputSize) return -1;
+    int len = varDataTLen(ip);
+    if (ip - input + len > inputSize) return -1;
+
+    uint32_t h = MurmurHash3_32(ip, len) % DICT_HASH_SLOTS;
+    while (slots[h] >= 0 && (varDataTLen(entries[slots[h]]) != len || memcmp(entries[slots[h]], ip, len) != 0)) {
+      h = (h + 1) % DICT_HASH_SLOTS;
+    }
+
+    if (slots[h] < 0) {
+      if (numOfEntries >= DICT_MAX_ENTRIES || dictLen + len > outputSize - nelements) return -1;
+      memcpy(output + dictLen, ip, len);
+      entries[numOfEntries] = output + dictLen;
+      slots[h] = (int16_t)numOfEntries++;
+      dictLen += len;
+    }
+
+    indices[i] = (char)(uint8_t)slots[h];
+    ip += len;
+  }
+
+  output[0] = (char)(uint8_t)(numOfEntries - 1);
+  memmove(output + dictLen, indices, nelements);
+  return dictLen + nelements;
+}
+
+int tsDecompressDictImp(const char *const input, int compressedSize, const int nelements, char *const output,
+                        int outputSize) {
+  const char *entries[DICT_MAX_ENTRIES];
+  int         numOfEntries = (uint8_t)input[0] + 1;
+  const char *ip = input + CHAR_BYTES;
+  const char *iend = input + compressedSize - nelements;
+
+  for (int i = 0; i < numOfEntries; i++) {
+    if (ip + VARSTR_HEADER_SIZE > iend || ip + varDataTLen(ip) > iend) {
+      uError("Invalid dictionary data, entries:%d compressedSize:%d", numOfEntries, compressedSize);
+      return -1;
+    }
+    entries[i] = ip;
+    ip += varDataTLen(ip);
+  }
+
+  const uint8_t *indices = (const uint8_t *)iend;
+  int            opos = 0;
+  for (int i = 0; i < nelements; i++) {
+    if (indices[i] >= numOfEntries) return -1;
+
+    const char *entry = entries[indices[i]];
+    int         len = varDataTLen(entry);
+    if (opos + len > outputSize) return -1;
+
+    memcpy(output + opos, entry, len);
+    opos += len;
+  }
+
+  return opos;
+}
+
 /* --------------------------------------------Timestamp Compression
  * ---------------------------------------------- */
 // TODO: Take care here, we assumes little endian encoding.
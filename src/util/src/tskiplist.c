@@ -28,7 +28,10 @@ static SSkipListIterator *doCreateSkipListIterator(SSkipList *pSkipList, int32_t
 static void tSkipListDoInsert(SSkipList *pSkipList, SSkipListNode **direction, SSkipListNode *pNode, bool isForward);
 static bool tSkipListGetPosToPut(SSkipList *pSkipList, SSkipListNode **backward, void *pData);
 static SSkipListNode *tSkipListNewNode(uint8_t level);
+static SSkipListNode *tSkipListAllocNode(SSkipList *pSkipList, uint8_t level);
 #define tSkipListFreeNode(n) tfree((n))
+#define SL_LOAD_FORWARD_POINTER(n, l) ((SSkipListNode *)atomic_load_ptr(&SL_NODE_GET_FORWARD_POINTER(n, l)))
+#define SL_LOAD_BACKWARD_POINTER(n, l) ((SSkipListNode *)atomic_load_ptr(&SL_NODE_GET_BACKWARD_POINTER(n, l)))
 static SSkipListNode *tSkipListPutImpl(SSkipList *pSkipList, void *pData, SSkipListNode **direction, bool isForward,
                                        bool hasDup);
 
@@ -38,6 +41,23 @@ static FORCE_INLINE int     tSkipListRLock(SSkipList *pSkipList);
 static FORCE_INLINE int     tSkipListUnlock(SSkipList *pSkipList);
 static FORCE_INLINE int32_t getSkipListRandLevel(SSkipList *pSkipList);
 
+/*
+ * The append run of a batch put: rows after the max key of the list, i.e. time series data arriving in order, are
+ * linked behind each other without any search and with the level they would have in a perfect skip list. They are
+ * published to the list at once when a row out of order arrives or the batch ends, so readers see either none or
+ * all of the nodes of a run.
+ */
+typedef struct {
+  SSkipListNode *first[MAX_SKIP_LIST_LEVEL];  // the first node of the run at each level, NULL if none
+  SSkipListNode *last[MAX_SKIP_LIST_LEVEL];   // the last node at each level, in the run or in the list
+  uint32_t       num;
+  uint8_t        level;
+} SSkipListAppendRun;
+
+static void tSkipListInitAppendRun(SSkipList *pSkipList, SSkipListAppendRun *pRun);
+static void tSkipListAppendToRun(SSkipList *pSkipList, SSkipListAppendRun *pRun, void *pData);
+static void tSkipListPublishAppendRun(SSkipList *pSkipList, SSkipListAppendRun *pRun);
+
 SSkipList *tSkipListCreate(uint8_t maxLevel, uint8_t keyType, uint16_t keyLen, __compar_fn_t comparFn, uint8_t flags,
                            __sl_key_fn_t fn) {
   SSkipList *pSkipList = (SSkipList *)calloc(1, sizeof(SSkipList));
@@ -92,12 +112,15 @@ void tSkipListDestroy(SSkipList *pSkipList) {
 
   tSkipListWLock(pSkipList);
 
-  SSkipListNode *pNode = SL_NODE_GET_FORWARD_POINTER(pSkipList->pHead, 0);
+  // nodes allocated from the arena are released together with the arena
+  if (pSkipList->nodeAllocFn == NULL) {
+    SSkipListNode *pNode = SL_NODE_GET_FORWARD_POINTER(pSkipList->pHead, 0);
 
-  while (pNode != pSkipList->pTail) {
-    SSkipListNode *pTemp = pNode;
-    pNode = SL_NODE_GET_FORWARD_POINTER(pNode, 0);
-    tSkipListFreeNode(pTemp);
+    while (pNode != pSkipList->pTail) {
+      SSkipListNode *pTemp = pNode;
+      pNode = SL_NODE_GET_FORWARD_POINTER(pNode, 0);
+      tSkipListFreeNode(pTemp);
+    }
   }
 
   tfree(pSkipList->insertHandleFn);
@@ -113,6 +136,14 @@ void tSkipListDestroy(SSkipList *pSkipList) {
   tfree(pSkipList);
 }
 
+void tSkipListSetNodeAllocator(SSkipList *pSkipList, sl_node_alloc_fn_t fn, void *param) {
+  // switching the allocator of a non-empty list would mix nodes with different owners
+  ASSERT(pSkipList->size == 0);
+
+  pSkipList->nodeAllocFn = fn;
+  pSkipList->nodeAllocParam = param;
+}
+
 SSkipListNode *tSkipListPut(SSkipList *pSkipList, void *pData) {
   if (pSkipList == NULL || pData == NULL) return NULL;
 
@@ -130,39 +161,55 @@ SSkipListNode *tSkipListPut(SSkipList *pSkipList, void *pData) {
 }
 
 void tSkipListPutBatchByIter(SSkipList *pSkipList, void *iter, iter_next_fn_t iterate) {
-  SSkipListNode *backward[MAX_SKIP_LIST_LEVEL] = {0};
-  SSkipListNode *forward[MAX_SKIP_LIST_LEVEL] = {0};
-  bool           hasDup = false;
-  char *         pKey = NULL;
-  char *         pDataKey = NULL;
-  int            compare = 0;
+  SSkipListNode *   backward[MAX_SKIP_LIST_LEVEL] = {0};
+  SSkipListNode *   forward[MAX_SKIP_LIST_LEVEL] = {0};
+  SSkipListAppendRun run;
+  bool              hasDup = false;
+  bool              positioned = false;
+  char *            pKey = NULL;
+  char *            pDataKey = NULL;
+  int               compare = 0;
 
   tSkipListWLock(pSkipList);
 
   void* pData = iterate(iter);
   if(pData == NULL) return;
 
-  // backward to put the first data
-  hasDup = tSkipListGetPosToPut(pSkipList, backward, pData);
-  tSkipListPutImpl(pSkipList, pData, backward, false, hasDup);
+  tSkipListInitAppendRun(pSkipList, &run);
 
-  for (int level = 0; level < pSkipList->maxLevel; level++) {
-    forward[level] = SL_NODE_GET_BACKWARD_POINTER(backward[level], level);
-  }
-
-  // forward to put the rest of data
-  while ((pData = iterate(iter)) != NULL) {
+  for (; pData != NULL; pData = iterate(iter)) {
     pDataKey = pSkipList->keyFn(pData);
-    hasDup = false;
 
-    // Compare max key
-    pKey = SL_GET_MAX_KEY(pSkipList);
-    compare = pSkipList->comparFn(pDataKey, pKey);
+    // in order rows go to the append run without any search
+    if (run.num > 0) {
+      compare = pSkipList->comparFn(pDataKey, SL_GET_NODE_KEY(pSkipList, run.last[0]));
+    } else {
+      compare = (pSkipList->size == 0) ? 1 : pSkipList->comparFn(pDataKey, SL_GET_MAX_KEY(pSkipList));
+    }
     if (compare > 0) {
-      for (int i = 0; i < pSkipList->maxLevel; i++) {
-        forward[i] = SL_NODE_GET_BACKWARD_POINTER(pSkipList->pTail, i);
+      tSkipListAppendToRun(pSkipList, &run, pData);
+      continue;
+    }
+
+    // a row out of order, the run is published first so that it is searched as part of the list
+    tSkipListPublishAppendRun(pSkipList, &run);
+
+    if (!positioned) {
+      // backward to put the first data
+      hasDup = tSkipListGetPosToPut(pSkipList, backward, pData);
+      tSkipListPutImpl(pSkipList, pData, backward, false, hasDup);
+
+      for (int level = 0; level < pSkipList->maxLevel; level++) {
+        forward[level] = SL_NODE_GET_BACKWARD_POINTER(backward[level], level);
       }
-    } else if(compare == 0) {
+      positioned = true;
+      continue;
+    }
+
+    // forward to put the rest of data
+    hasDup = false;
+
+    if(compare == 0) {
       // same need special deal
       forward[0] = SL_NODE_GET_BACKWARD_POINTER(SL_NODE_GET_BACKWARD_POINTER(pSkipList->pTail,0),0);
       hasDup = true;
@@ -210,6 +257,8 @@ void tSkipListPutBatchByIter(SSkipList *pSkipList, void *iter, iter_next_fn_t it
 
     tSkipListPutImpl(pSkipList, pData, forward, true, hasDup);
   }
+
+  tSkipListPublishAppendRun(pSkipList, &run);
   tSkipListUnlock(pSkipList);
 }
 
@@ -309,14 +358,14 @@ bool tSkipListIterNext(SSkipListIterator *iter) {
       return false;
     }
 
-    iter->cur = SL_NODE_GET_FORWARD_POINTER(iter->cur, 0);
+    iter->cur = SL_LOAD_FORWARD_POINTER(iter->cur, 0);
 
     // a new node is inserted into between iter->cur and iter->next, ignore it
     if (iter->cur != iter->next && (iter->next != NULL)) {
       iter->cur = iter->next;
     }
 
-    iter->next = SL_NODE_GET_FORWARD_POINTER(iter->cur, 0);
+    iter->next = SL_LOAD_FORWARD_POINTER(iter->cur, 0);
     iter->step++;
   } else {
     if (iter->cur == pSkipList->pHead) {
@@ -325,14 +374,14 @@ bool tSkipListIterNext(SSkipListIterator *iter) {
       return false;
     }
 
-    iter->cur = SL_NODE_GET_BACKWARD_POINTER(iter->cur, 0);
+    iter->cur = SL_LOAD_BACKWARD_POINTER(iter->cur, 0);
 
     // a new node is inserted into between iter->cur and iter->next, ignore it
     if (iter->cur != iter->next && (iter->next != NULL)) {
       iter->cur = iter->next;
     }
 
-    iter->next = SL_NODE_GET_BACKWARD_POINTER(iter->cur, 0);
+    iter->next = SL_LOAD_BACKWARD_POINTER(iter->cur, 0);
     iter->step++;
   }
 
@@ -400,25 +449,26 @@ void tSkipListPrint(SSkipList *pSkipList, int16_t nlevel) {
 }
 
 static void tSkipListDoInsert(SSkipList *pSkipList, SSkipListNode **direction, SSkipListNode *pNode, bool isForward) {
+  // link the new node completely before it becomes reachable, so that lock-free readers never follow a
+  // pointer of a half initialized node
   for (int32_t i = 0; i < pNode->level; ++i) {
     SSkipListNode *x = direction[i];
     if (isForward) {
       SL_NODE_GET_BACKWARD_POINTER(pNode, i) = x;
-
-      SSkipListNode *next = SL_NODE_GET_FORWARD_POINTER(x, i);
-      SL_NODE_GET_BACKWARD_POINTER(next, i) = pNode;
-
-      SL_NODE_GET_FORWARD_POINTER(pNode, i) = next;
-      SL_NODE_GET_FORWARD_POINTER(x, i) = pNode;
+      SL_NODE_GET_FORWARD_POINTER(pNode, i) = SL_NODE_GET_FORWARD_POINTER(x, i);
     } else {
       SL_NODE_GET_FORWARD_POINTER(pNode, i) = x;
+      SL_NODE_GET_BACKWARD_POINTER(pNode, i) = SL_NODE_GET_BACKWARD_POINTER(x, i);
+    }
+  }
 
-      SSkipListNode *prev = SL_NODE_GET_BACKWARD_POINTER(x, i);
-      SL_NODE_GET_FORWARD_POINTER(prev, i) = pNode;
+  // publish from the bottom level up
+  for (int32_t i = 0; i < pNode->level; ++i) {
+    SSkipListNode *prev = SL_NODE_GET_BACKWARD_POINTER(pNode, i);
+    SSkipListNode *next = SL_NODE_GET_FORWARD_POINTER(pNode, i);
 
-      SL_NODE_GET_BACKWARD_POINTER(pNode, i) = prev;
-      SL_NODE_GET_BACKWARD_POINTER(x, i) = pNode;
-    }
+    atomic_store_ptr(&SL_NODE_GET_FORWARD_POINTER(prev, i), pNode);
+    atomic_store_ptr(&SL_NODE_GET_BACKWARD_POINTER(next, i), pNode);
   }
 
   if (pSkipList->level < pNode->level) pSkipList->level = pNode->level;
@@ -535,7 +585,9 @@ static void tSkipListRemoveNodeImpl(SSkipList *pSkipList, SSkipListNode *pNode)
     SL_NODE_GET_BACKWARD_POINTER(next, j) = prev;
   }
 
-  tSkipListFreeNode(pNode);
+  if (pSkipList->nodeAllocFn == NULL) {
+    tSkipListFreeNode(pNode);
+  }
   pSkipList->size--;
 }
 
@@ -597,6 +649,83 @@ static FORCE_INLINE int32_t getSkipListRandLevel(SSkipList *pSkipList) {
   return level;
 }
 
+/*
+ * Every 4th appended node is raised to level 2, every 16th to level 3 and so on, the same factor as
+ * getSkipListNodeRandomHeight(), which keeps the list balanced for the searches of out of order rows and queries.
+ */
+static FORCE_INLINE int32_t getSkipListAppendLevel(SSkipList *pSkipList, SSkipListAppendRun *pRun) {
+  uint32_t n = pSkipList->size + pRun->num + 1;
+  int32_t  level = 1;
+
+  while ((n & 0x3) == 0 && level < pSkipList->maxLevel) {
+    n >>= 2;
+    level++;
+  }
+
+  if (level > pRun->level + 1) {
+    level = pRun->level + 1;
+  }
+
+  ASSERT(level <= pSkipList->maxLevel);
+  return level;
+}
+
+static void tSkipListInitAppendRun(SSkipList *pSkipList, SSkipListAppendRun *pRun) {
+  for (int32_t i = 0; i < pSkipList->maxLevel; ++i) {
+    pRun->first[i] = NULL;
+    pRun->last[i] = SL_NODE_GET_BACKWARD_POINTER(pSkipList->pTail, i);
+  }
+
+  pRun->num = 0;
+  pRun->level = pSkipList->level;
+}
+
+static void tSkipListAppendToRun(SSkipList *pSkipList, SSkipListAppendRun *pRun, void *pData) {
+  int32_t        level = getSkipListAppendLevel(pSkipList, pRun);
+  SSkipListNode *pNode = tSkipListAllocNode(pSkipList, level);
+  if (pNode == NULL) return;
+
+  if (pSkipList->insertHandleFn) {
+    pSkipList->insertHandleFn->args[0] = pData;
+    pSkipList->insertHandleFn->args[1] = NULL;
+    pData = genericInvoke(pSkipList->insertHandleFn);
+  }
+  pNode->pData = pData;
+
+  // the nodes of the run are not reachable yet, so they are linked with plain stores
+  for (int32_t i = 0; i < level; ++i) {
+    SL_NODE_GET_BACKWARD_POINTER(pNode, i) = pRun->last[i];
+    SL_NODE_GET_FORWARD_POINTER(pNode, i) = pSkipList->pTail;
+    if (pRun->first[i] == NULL) {
+      pRun->first[i] = pNode;
+    } else {
+      SL_NODE_GET_FORWARD_POINTER(pRun->last[i], i) = pNode;
+    }
+    pRun->last[i] = pNode;
+  }
+
+  pRun->num++;
+  if (pRun->level < level) pRun->level = level;
+}
+
+static void tSkipListPublishAppendRun(SSkipList *pSkipList, SSkipListAppendRun *pRun) {
+  if (pRun->num == 0) return;
+
+  // publish from the bottom level up, as tSkipListDoInsert does for a single node
+  for (int32_t i = 0; i < pRun->level; ++i) {
+    if (pRun->first[i] == NULL) continue;
+
+    SSkipListNode *prev = SL_NODE_GET_BACKWARD_POINTER(pRun->first[i], i);
+    atomic_store_ptr(&SL_NODE_GET_FORWARD_POINTER(prev, i), pRun->first[i]);
+    atomic_store_ptr(&SL_NODE_GET_BACKWARD_POINTER(pSkipList->pTail, i), pRun->last[i]);
+  }
+
+  if (pSkipList->level < pRun->level) pSkipList->level = pRun->level;
+  pSkipList->size += pRun->num;
+
+  tSkipListInitAppendRun(pSkipList, pRun);
+}
+
 // when order is TSDB_ORDER_ASC, return the last node with key less than val
 // when order is TSDB_ORDER_DESC, return the first node with key large than val
 static SSkipListNode *getPriorNode(SSkipList *pSkipList, const char *val, int32_t order, SSkipListNode **pCur) {
@@ -609,12 +738,12 @@ static SSkipListNode *getPriorNode(SSkipList *pSkipList, const char *val, int32_
   if (order == TSDB_ORDER_ASC) {
     pNode = pSkipList->pHead;
     for (int32_t i = pSkipList->level - 1; i >= 0; --i) {
-      SSkipListNode *p = SL_NODE_GET_FORWARD_POINTER(pNode, i);
+      SSkipListNode *p = SL_LOAD_FORWARD_POINTER(pNode, i);
       while (p != pSkipList->pTail) {
         char *key = SL_GET_NODE_KEY(pSkipList, p);
         if (comparFn(key, val) < 0) {
           pNode = p;
-          p = SL_NODE_GET_FORWARD_POINTER(p, i);
+          p = SL_LOAD_FORWARD_POINTER(p, i);
         } else {
           if (pCur != NULL) {
             *pCur = p;
@@ -626,12 +755,12 @@ static SSkipListNode *getPriorNode(SSkipList *pSkipList, const char *val, int32_
   } else {
     pNode = pSkipList->pTail;
     for (int32_t i = pSkipList->level - 1; i >= 0; --i) {
-      SSkipListNode *p = SL_NODE_GET_BACKWARD_POINTER(pNode, i);
+      SSkipListNode *p = SL_LOAD_BACKWARD_POINTER(pNode, i);
       while (p != pSkipList->pHead) {
         char *key = SL_GET_NODE_KEY(pSkipList, p);
         if (comparFn(key, val) > 0) {
           pNode = p;
-          p = SL_NODE_GET_BACKWARD_POINTER(p, i);
+          p = SL_LOAD_BACKWARD_POINTER(p, i);
         } else {
           if (pCur != NULL) {
             *pCur = p;
@@ -677,6 +806,20 @@ static SSkipListNode *tSkipListNewNode(uint8_t level) {
   return pNode;
 }
 
+static SSkipListNode *tSkipListAllocNode(SSkipList *pSkipList, uint8_t level) {
+  if (pSkipList->nodeAllocFn == NULL) {
+    return tSkipListNewNode(level);
+  }
+
+  int32_t        tsize = sizeof(SSkipListNode) + sizeof(SSkipListNode *) * level * 2;
+  SSkipListNode *pNode = (SSkipListNode *)(*pSkipList->nodeAllocFn)(pSkipList->nodeAllocParam, tsize);
+  if (pNode == NULL) return NULL;
+
+  memset(pNode, 0, tsize);
+  pNode->level = level;
+  return pNode;
+}
+
 static SSkipListNode *tSkipListPutImpl(SSkipList *pSkipList, void *pData, SSkipListNode **direction, bool isForward,
                                        bool hasDup) {
   uint8_t        dupMode = SL_DUP_MODE(pSkipList);
@@ -706,7 +849,7 @@ static SSkipListNode *tSkipListPutImpl(SSkipList *pSkipList, void *pData, SSkipL
       }
     }
   } else {
-    pNode = tSkipListNewNode(getSkipListRandLevel(pSkipList));
+    pNode = tSkipListAllocNode(pSkipList, getSkipListRandLevel(pSkipList));
     if (pNode != NULL) {
       // insertHandleFn will be assigned only for timeseries data,
       // in which case, pData is pointed to an memory to be freed later;
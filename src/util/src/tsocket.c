@@ -143,6 +143,43 @@ int32_t taosWriteMsg(SOCKET fd, void *buf, int32_t nbytes) {
   return (nbytes - nleft);
 }
 
+// the iovecs are changed if they are written partly
+int32_t taosWriteMsgV(SOCKET fd, struct iovec *iov, int32_t iovcnt) {
+  int32_t nbytes = 0;
+  for (int32_t i = 0; i < iovcnt; ++i) nbytes += (int32_t)iov[i].iov_len;
+
+  int32_t nleft = nbytes;
+  while (nleft > 0) {
+    int32_t nwritten = (int32_t)taosWriteSocketV(fd, iov, iovcnt);
+    if (nwritten <= 0) {
+      if (errno == EINTR)
+        continue;
+      else
+        return -1;
+    }
+
+    nleft -= nwritten;
+
+    // skip the ones written, and move forward in the one written partly
+    while (iovcnt > 0 && nwritten >= (int32_t)iov->iov_len) {
+      nwritten -= (int32_t)iov->iov_len;
+      iov++;
+      iovcnt--;
+    }
+
+    if (nwritten > 0) {
+      iov->iov_base = (char *)iov->iov_base + nwritten;
+      iov->iov_len -= nwritten;
+    }
+
+    if (errno == SIGPIPE || errno == EPIPE) {
+      return -1;
+    }
+  }
+
+  return (nbytes - nleft);
+}
+
 int32_t taosReadMsg(SOCKET fd, void *buf, int32_t nbytes) {
   int32_t nleft, nread;
   char *  ptr = (char *)buf;
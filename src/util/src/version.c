@@ -0,0 +1,7 @@
+char version[12] = "2.3.2.0";
+char compatible_version[12] = "2.0.0.0";
+char gitinfo[48] = "5de13d79e663ff09929b6da3723f8a107aeedfc1";
+char gitinfoOfInternal[48] = "5de13d79e663ff09929b6da3723f8a107aeedfc1";
+char buildinfo[64] = "Built at 2026-10-18 05:43:43";
+
+void libtaos_2_3_2_0_Linux_x32_stable() {};
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+ * Micro benchmark of the column decoders in tcompression.c, reports the decoded bytes per second of each codec on
+ * a few data patterns.
+ *
+ * usage: compressBench [-n rows] [-l loops]
+ */
+#include "os.h"
+#include "taosdef.h"
+#include "tscompression.h"
+
+typedef int (*compress_fn_t)(const char *const input, const int nelements, char *const output);
+typedef int (*decompress_fn_t)(const char *const input, const int nelements, char *const output);
+
+static int  tsRows = 4096;
+static int  tsLoops = 2000;
+static char tsType;
+
+static int compressInt(const char *const input, const int nelements, char *const output) {
+  return tsCompressINTImp(input, nelements, output, tsType);
+}
+
+static int decompressInt(const char *const input, const int nelements, char *const output) {
+  return tsDecompressINTImp(input, nelements, output, tsType);
+}
+
+static void genData(char *data, int type, int bytes, const char *pattern) {
+  int64_t v = 1625068800000;
+  for (int i = 0; i < tsRows; i++) {
+    if (strcmp(pattern, "const") == 0) {
+      // keep the value
+    } else if (strcmp(pattern, "inc") == 0) {
+      v += 1000;
+    } else if (strcmp(pattern, "jitter") == 0) {
+      v += rand() % 5 - 2;
+    } else {
+      v += rand() % 2000 - 900;
+    }
+
+    switch (type) {
+      case TSDB_DATA_TYPE_BOOL:
+        data[i] = (char)(v & 0x1);
+        break;
+      case TSDB_DATA_TYPE_TINYINT:
+        *(int8_t *)(data + i * bytes) = (int8_t)v;
+        break;
+      case TSDB_DATA_TYPE_SMALLINT:
+        *(int16_t *)(data + i * bytes) = (int16_t)v;
+        break;
+      case TSDB_DATA_TYPE_INT:
+        *(int32_t *)(data + i * bytes) = (int32_t)v;
+        break;
+      case TSDB_DATA_TYPE_FLOAT:
+        *(float *)(data + i * bytes) = (float)v / 1000;
+        break;
+      case TSDB_DATA_TYPE_DOUBLE:
+        *(double *)(data + i * bytes) = (double)v / 1000;
+        break;
+      default:
+        *(int64_t *)(data + i * bytes) = v;
+        break;
+    }
+  }
+}
+
+static void benchCodec(const char *name, int type, int bytes, compress_fn_t compressFn, decompress_fn_t decompressFn) {
+  const char *patterns[] = {"const", "inc", "jitter", "random"};
+
+  char *input = malloc((size_t)tsRows * bytes);
+  char *output = malloc((size_t)tsRows * bytes);
+  char *buf = malloc((size_t)tsRows * bytes * 2 + COMP_OVERFLOW_BYTES);
+
+  for (int p = 0; p < tListLen(patterns); p++) {
+    tsType = (char)type;
+    genData(input, type, bytes, patterns[p]);
+    int len = (*compressFn)(input, tsRows, buf);
+
+    int64_t st = taosGetTimestampUs();
+    for (int i = 0; i < tsLoops; i++) {
+      (*decompressFn)(buf, tsRows, output);
+    }
+    int64_t et = taosGetTimestampUs();
+
+    if (memcmp(input, output, (size_t)tsRows * bytes) != 0) {
+      printf("%-10s %-8s decoded data mismatch\n", name, patterns[p]);
+      continue;
+    }
+
+    double gbps = (double)tsRows * bytes * tsLoops / (double)MAX(et - st, 1) / 1000.0;
+    printf("%-10s %-8s ratio:%6.2f%%  decode:%8.3f GB/s\n", name, patterns[p], len * 100.0 / ((double)tsRows * bytes),
+           gbps);
+  }
+
+  free(input);
+  free(output);
+  free(buf);
+}
+
+int main(int argc, char *argv[]) {
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-n") == 0 && i < argc - 1) {
+      tsRows = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-l") == 0 && i < argc - 1) {
+      tsLoops = atoi(argv[++i]);
+    } else {
+      printf("usage: %s [-n rows] [-l loops]\n", argv[0]);
+      return 0;
+    }
+  }
+
+  printf("rows:%d loops:%d\n", tsRows, tsLoops);
+
+  benchCodec("bool", TSDB_DATA_TYPE_BOOL, CHAR_BYTES, tsCompressBoolImp, tsDecompressBoolImp);
+  benchCodec("tinyint", TSDB_DATA_TYPE_TINYINT, CHAR_BYTES, compressInt, decompressInt);
+  benchCodec("smallint", TSDB_DATA_TYPE_SMALLINT, SHORT_BYTES, compressInt, decompressInt);
+  benchCodec("int", TSDB_DATA_TYPE_INT, INT_BYTES, compressInt, decompressInt);
+  benchCodec("bigint", TSDB_DATA_TYPE_BIGINT, LONG_BYTES, compressInt, decompressInt);
+  benchCodec("timestamp", TSDB_DATA_TYPE_TIMESTAMP, LONG_BYTES, tsCompressTimestampImp, tsDecompressTimestampImp);
+  benchCodec("float", TSDB_DATA_TYPE_FLOAT, FLOAT_BYTES, tsCompressFloatImp, tsDecompressFloatImp);
+  benchCodec("double", TSDB_DATA_TYPE_DOUBLE, DOUBLE_BYTES, tsCompressDoubleImp, tsDecompressDoubleImp);
+
+  return 0;
+}
@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <random>
+
+#include "os.h"
+#include "tscompression.h"
+
+namespace {
+
+const int kNumOfRows = 4096;
+
+// patterns which hit the run selectors, narrow and wide bit widths and the not compressed case
+void genIntegers(int64_t* data, int pattern, std::mt19937_64& rng) {
+  for (int i = 0; i < kNumOfRows; i++) {
+    switch (pattern) {
+      case 0:
+        data[i] = 42;
+        break;
+      case 1:
+        data[i] = i;
+        break;
+      case 2:
+        data[i] = (int64_t)(rng() % 7) - 3;
+        break;
+      case 3:
+        data[i] = (i % 300 < 250) ? 10 : (int64_t)(rng() % 100000);
+        break;
+      default:
+        data[i] = (int64_t)(rng() >> 8);  // simple8b keeps at most 59 bits of the deltas
+        break;
+    }
+  }
+}
+
+template <typename T>
+void checkIntRoundTrip(const int64_t* data, char type) {
+  T* input = (T*)malloc(sizeof(T) * kNumOfRows);
+  T* output = (T*)malloc(sizeof(T) * kNumOfRows);
+  char* buf = (char*)malloc(sizeof(T) * kNumOfRows * 2 + COMP_OVERFLOW_BYTES);
+
+  for (int i = 0; i < kNumOfRows; i++) input[i] = (T)data[i];
+
+  for (int n = 1; n <= kNumOfRows; n = n * 3 + 1) {
+    tsCompressINTImp((const char*)input, n, buf, type);
+    ASSERT_EQ(tsDecompressINTImp(buf, n, (char*)output, type), n * (int)sizeof(T));
+    ASSERT_EQ(memcmp(input, output, n * sizeof(T)), 0);
+  }
+
+  free(input);
+  free(output);
+  free(buf);
+}
+
+}  // namespace
+
+TEST(compressTest, integer_round_trip) {
+  std::mt19937_64 rng(20211018);
+  int64_t         data[kNumOfRows];
+
+  for (int pattern = 0; pattern < 5; pattern++) {
+    genIntegers(data, pattern, rng);
+    checkIntRoundTrip<int64_t>(data, TSDB_DATA_TYPE_BIGINT);
+    checkIntRoundTrip<int32_t>(data, TSDB_DATA_TYPE_INT);
+    checkIntRoundTrip<int16_t>(data, TSDB_DATA_TYPE_SMALLINT);
+    checkIntRoundTrip<int8_t>(data, TSDB_DATA_TYPE_TINYINT);
+  }
+}
+
+TEST(compressTest, bool_round_trip) {
+  std::mt19937 rng(20211018);
+  char         input[kNumOfRows + 3];
+  char         output[kNumOfRows + 3];
+  char         buf[kNumOfRows];
+
+  for (int i = 0; i < kNumOfRows + 3; i++) {
+    int v = rng() % 3;
+    input[i] = (v == 2) ? TSDB_DATA_BOOL_NULL : (char)v;
+  }
+
+  for (int n = 1; n <= kNumOfRows + 3; n++) {
+    tsCompressBoolImp(input, n, buf);
+    ASSERT_EQ(tsDecompressBoolImp(buf, n, output), n);
+    ASSERT_EQ(memcmp(input, output, n), 0);
+  }
+}
+
+TEST(compressTest, bitpack_round_trip) {
+  std::mt19937_64 rng(20211018);
+  int64_t         data[kNumOfRows];
+  int64_t         output[kNumOfRows];
+  char            buf[sizeof(int64_t) * kNumOfRows + COMP_OVERFLOW_BYTES];
+
+  for (int pattern = 0; pattern < 5; pattern++) {
+    genIntegers(data, pattern, rng);
+    for (int n = 1; n <= kNumOfRows; n = n * 3 + 1) {
+      int clen = tsCompressBitPackImp((const char*)data, n, buf, sizeof(buf), TSDB_DATA_TYPE_BIGINT);
+      ASSERT_GT(clen, 0);
+      ASSERT_EQ(tsDecompressBitPackImp(buf, clen, n, (char*)output, TSDB_DATA_TYPE_BIGINT), n * (int)sizeof(int64_t));
+      ASSERT_EQ(memcmp(data, output, n * sizeof(int64_t)), 0);
+    }
+  }
+
+  // full range of the type does not fit in the bit width limit
+  data[0] = INT64_MIN;
+  data[1] = INT64_MAX;
+  ASSERT_EQ(tsCompressBitPackImp((const char*)data, 2, buf, sizeof(buf), TSDB_DATA_TYPE_BIGINT), -1);
+
+  uint16_t udata[3] = {0, 65535, 7};
+  uint16_t uoutput[3];
+  int      clen = tsCompressBitPackImp((const char*)udata, 3, buf, sizeof(buf), TSDB_DATA_TYPE_USMALLINT);
+  ASSERT_GT(clen, 0);
+  ASSERT_EQ(tsDecompressBitPackImp(buf, clen, 3, (char*)uoutput, TSDB_DATA_TYPE_USMALLINT), 3 * (int)sizeof(uint16_t));
+  ASSERT_EQ(memcmp(udata, uoutput, sizeof(udata)), 0);
+}
+
+TEST(compressTest, dict_and_zlib_round_trip) {
+  const char* words[] = {"beijing", "shanghai", "", "shenzhen", "guangzhou"};
+  std::mt19937 rng(20211018);
+  int          size = kNumOfRows * (int)(sizeof(uint16_t) + 16);
+  char*        input = (char*)malloc(size);
+  char*        output = (char*)malloc(size);
+  char*        buf = (char*)malloc(size + COMP_OVERFLOW_BYTES);
+
+  int len = 0;
+  for (int i = 0; i < kNumOfRows; i++) {
+    const char* w = words[rng() % tListLen(words)];
+    uint16_t    wlen = (uint16_t)strlen(w);
+    memcpy(input + len, &wlen, sizeof(wlen));
+    memcpy(input + len + sizeof(wlen), w, wlen);
+    len += (int)sizeof(wlen) + wlen;
+  }
+
+  int clen = tsCompressDictImp(input, len, kNumOfRows, buf, size + COMP_OVERFLOW_BYTES);
+  ASSERT_GT(clen, 0);
+  ASSERT_LT(clen, len);
+  ASSERT_EQ(tsDecompressDictImp(buf, clen, kNumOfRows, output, size), len);
+  ASSERT_EQ(memcmp(input, output, len), 0);
+
+  clen = tsCompressZlibImp(input, len, buf, size + COMP_OVERFLOW_BYTES);
+  ASSERT_GT(clen, 0);
+  ASSERT_EQ(tsDecompressZlibImp(buf, clen, output, size), len);
+  ASSERT_EQ(memcmp(input, output, len), 0);
+
+  // more distinct values than one byte indices can address
+  len = 0;
+  for (int i = 0; i < kNumOfRows; i++) {
+    uint16_t wlen = (uint16_t)sprintf(input + len + sizeof(wlen), "%d", i);
+    memcpy(input + len, &wlen, sizeof(wlen));
+    len += (int)sizeof(wlen) + wlen;
+  }
+  ASSERT_EQ(tsCompressDictImp(input, len, kNumOfRows, buf, size + COMP_OVERFLOW_BYTES), -1);
+
+  // incompressible data is stored as is
+  for (int i = 0; i < len; i++) input[i] = (char)rng();
+  clen = tsCompressZlibImp(input, len, buf, size + COMP_OVERFLOW_BYTES);
+  ASSERT_EQ(clen, len + 1);
+  ASSERT_EQ(tsDecompressZlibImp(buf, clen, output, size), len);
+  ASSERT_EQ(memcmp(input, output, len), 0);
+
+  free(input);
+  free(output);
+  free(buf);
+}
@@ -377,4 +377,146 @@ TEST(testCase, skiplist_test) {
       free(pKeys);*/
 }
 
-#endif
\ No newline at end of file
+#endif
+namespace {
+
+struct SNodeArena {
+  char*   buf;
+  int32_t size;
+  int32_t offset;
+};
+
+char* getInt64Key(const void* data) { return (char*)data; }
+
+void* arenaAllocNode(void* param, int32_t size) {
+  SNodeArena* pArena = (SNodeArena*)param;
+  int32_t     offset = ALIGN8(pArena->offset);
+  if (offset + size > pArena->size) return NULL;
+
+  pArena->offset = offset + size;
+  return pArena->buf + offset;
+}
+
+struct SKeyIter {
+  int64_t* keys;
+  int32_t  num;
+  int32_t  index;
+};
+
+void* nextKey(void* iter) {
+  SKeyIter* pIter = (SKeyIter*)iter;
+  return (pIter->index < pIter->num) ? &pIter->keys[pIter->index++] : NULL;
+}
+
+}  // namespace
+
+TEST(testCase, skiplist_arena_test) {
+  const int32_t num = 10000;
+  SNodeArena    arena = {0};
+  arena.size = num * (int32_t)(sizeof(SSkipListNode) + sizeof(void*) * MAX_SKIP_LIST_LEVEL * 2);
+  arena.buf = (char*)malloc(arena.size);
+
+  SSkipList* pSkipList = tSkipListCreate(MAX_SKIP_LIST_LEVEL, TSDB_DATA_TYPE_BIGINT, sizeof(int64_t),
+                                         getKeyComparFunc(TSDB_DATA_TYPE_BIGINT, TSDB_ORDER_ASC), SL_DISCARD_DUP_KEY,
+                                         getInt64Key);
+  tSkipListSetNodeAllocator(pSkipList, arenaAllocNode, &arena);
+
+  int64_t* keys = (int64_t*)malloc(sizeof(int64_t) * num);
+  for (int32_t i = 0; i < num; ++i) {
+    keys[i] = (i * 7919) % num;
+    tSkipListPut(pSkipList, &keys[i]);
+  }
+
+  ASSERT_EQ(SL_SIZE(pSkipList), num);
+  ASSERT_GT(arena.offset, 0);
+
+  SSkipListIterator* pIter = tSkipListCreateIter(pSkipList);
+  int64_t            expect = 0;
+  while (tSkipListIterNext(pIter)) {
+    SSkipListNode* pNode = tSkipListIterGet(pIter);
+    ASSERT_EQ(*(int64_t*)SL_GET_NODE_DATA(pNode), expect++);
+  }
+  ASSERT_EQ(expect, num);
+  tSkipListDestroyIter(pIter);
+
+  int64_t start = num / 2;
+  pIter = tSkipListCreateIterFromVal(pSkipList, (const char*)&start, TSDB_DATA_TYPE_BIGINT, TSDB_ORDER_DESC);
+  expect = start;
+  while (tSkipListIterNext(pIter)) {
+    SSkipListNode* pNode = tSkipListIterGet(pIter);
+    ASSERT_EQ(*(int64_t*)SL_GET_NODE_DATA(pNode), expect--);
+  }
+  ASSERT_EQ(expect, -1);
+  tSkipListDestroyIter(pIter);
+
+  // nodes belong to the arena, only the list itself is released here
+  tSkipListDestroy(pSkipList);
+  free(keys);
+  free(arena.buf);
+}
+
+TEST(testCase, skiplist_append_run_test) {
+  const int32_t num = 4096;
+  SSkipList*    pSkipList = tSkipListCreate(MAX_SKIP_LIST_LEVEL, TSDB_DATA_TYPE_BIGINT, sizeof(int64_t),
+                                         getKeyComparFunc(TSDB_DATA_TYPE_BIGINT, TSDB_ORDER_ASC), SL_DISCARD_DUP_KEY,
+                                         getInt64Key);
+
+  // even keys in order, broken by an odd key out of order and a duplicate of the last key every 100 keys
+  int64_t* keys = (int64_t*)malloc(sizeof(int64_t) * num * 2);
+  int32_t  total = 0;
+  int32_t  expectSize = 0;
+  for (int32_t i = 0; i < num; ++i) {
+    keys[total++] = i * 2;
+    expectSize++;
+    if (i % 100 == 99) {
+      keys[total++] = (i - 50) * 2 + 1;
+      keys[total++] = i * 2;
+      expectSize++;
+    }
+  }
+
+  // two batches, the second one starts in order after the max key of the first
+  SKeyIter iter = {keys, total / 2, 0};
+  tSkipListPutBatchByIter(pSkipList, &iter, nextKey);
+  iter.num = total;
+  tSkipListPutBatchByIter(pSkipList, &iter, nextKey);
+
+  ASSERT_EQ(SL_SIZE(pSkipList), expectSize);
+  ASSERT_GT(pSkipList->level, 1);
+
+  int64_t prev = -1;
+  int32_t count = 0;
+  for (int32_t level = 0; level < pSkipList->level; ++level) {
+    SSkipListNode* pNode = SL_NODE_GET_FORWARD_POINTER(pSkipList->pHead, level);
+    SSkipListNode* pPrev = pSkipList->pHead;
+    prev = -1;
+    while (pNode != pSkipList->pTail) {
+      int64_t key = *(int64_t*)SL_GET_NODE_DATA(pNode);
+      ASSERT_GT(key, prev);
+      ASSERT_EQ(SL_NODE_GET_BACKWARD_POINTER(pNode, level), pPrev);
+      prev = key;
+      pPrev = pNode;
+      pNode = SL_NODE_GET_FORWARD_POINTER(pNode, level);
+      if (level == 0) count++;
+    }
+    if (level == 0) ASSERT_EQ(prev, (num - 1) * 2);
+    ASSERT_EQ(SL_NODE_GET_BACKWARD_POINTER(pSkipList->pTail, level), pPrev);
+  }
+  ASSERT_EQ(count, expectSize);
+
+  int64_t start = 1001;
+  SSkipListIterator* pIter =
+      tSkipListCreateIterFromVal(pSkipList, (const char*)&start, TSDB_DATA_TYPE_BIGINT, TSDB_ORDER_ASC);
+  ASSERT_TRUE(tSkipListIterNext(pIter));
+  ASSERT_EQ(*(int64_t*)SL_GET_NODE_DATA(tSkipListIterGet(pIter)), 1002);
+  tSkipListDestroyIter(pIter);
+
+  start = (num / 2) * 2 + 1;
+  pIter = tSkipListCreateIterFromVal(pSkipList, (const char*)&start, TSDB_DATA_TYPE_BIGINT, TSDB_ORDER_DESC);
+  ASSERT_TRUE(tSkipListIterNext(pIter));
+  ASSERT_EQ(*(int64_t*)SL_GET_NODE_DATA(tSkipListIterGet(pIter)), (num / 2) * 2);
+  tSkipListDestroyIter(pIter);
+
+  tSkipListDestroy(pSkipList);
+  free(keys);
+}
@@ -21,6 +21,7 @@ extern "C" {
 #endif
 
 #include "tlog.h"
+#include "twal.h"
 
 extern int32_t wDebugFlag;
 
@@ -55,12 +56,32 @@ typedef struct {
   char     path[WAL_PATH_LEN];
   char     name[WAL_FILE_LEN];
   pthread_mutex_t mutex;
+  // group commit, all protected by mutex
+  char *   gbuf;      // records appended but not written to the file yet
+  int32_t  gbufLen;
+  int32_t  gbufSize;
+  int32_t  gbufNum;   // number of records in gbuf
+  int32_t  errCode;   // error of the records in (errFrom, errSeq] which failed to be written or fsynced
+  int64_t  errFrom;
+  int64_t  errSeq;
+  int64_t  commitSeq; // records up to this sequence are returned to the committers
+  int64_t  gseq;      // sequence of the last appended record
+  int64_t  flushSeq;  // records up to this sequence are written to the file
+  int64_t  syncSeq;   // records up to this sequence are fsynced
+  int64_t  syncReq;   // records up to this sequence are waited to be fsynced
 } SWal;
 
 int32_t walGetNextFile(SWal *pWal, int64_t *nextFileId);
 int32_t walGetOldFile(SWal *pWal, int64_t curFileId, int32_t minDiff, int64_t *oldFileId);
 int32_t walGetNewFile(SWal *pWal, int64_t *newFileId);
 
+int32_t walGroupInit(int32_t refId);
+void    walGroupCleanUp();
+bool    walGroupEnabled();
+int32_t walGroupAppend(SWal *pWal, SWalHead *pHead, int32_t contLen);
+int32_t walGroupFlush(SWal *pWal, bool fsync);
+int32_t walGroupCommit(SWal *pWal, bool forceFsync);
+
 #ifdef __cplusplus
 }
 #endif
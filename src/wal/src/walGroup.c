@@ -0,0 +1,301 @@
+/*
+ * Copyright (c) 2019 TAOS Data, Inc. <jhtao@taosdata.com>
+ *
+ * This program is free software: you can use, redistribute, and/or modify
+ * it under the terms of the GNU Affero General Public License, version 3
+ * or later ("AGPL"), as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _DEFAULT_SOURCE
+#include "os.h"
+#include "taoserror.h"
+#include "tref.h"
+#include "tfile.h"
+#include "tglobal.h"
+#include "twal.h"
+#include "walInt.h"
+
+#define WAL_GROUP_INIT_BUF (64 * 1024)
+#define WAL_GROUP_MAX_BUF  (4 * 1024 * 1024)  // records are written inline beyond it to bound the memory
+
+/*
+ * Group commit: walWrite only appends the record to the memory buffer of the wal, and a dnode-wide flusher writes
+ * the buffers of all wals with one write each and one fsync per wal, then wakes up the committers. A committer asks
+ * for a flush and waits in walCommit, so the records appended while a flush cycle is running form the next group.
+ */
+typedef struct {
+  int8_t          enabled;
+  int8_t          stop;
+  int8_t          pending;  // a committer is waiting for the next flush cycle
+  int32_t         refId;
+  pthread_t       thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t  workCond;
+  pthread_cond_t  doneCond;
+  SWalGroupStat   stat;
+} SWalGroup;
+
+static SWalGroup tsWalGroup = {0};
+static void *    walGroupThreadFunc(void *param);
+
+int32_t walGroupInit(int32_t refId) {
+  if (tsWalGroupCommit <= 0) return TSDB_CODE_SUCCESS;
+
+  tsWalGroup.refId = refId;
+  pthread_mutex_init(&tsWalGroup.mutex, NULL);
+  pthread_cond_init(&tsWalGroup.workCond, NULL);
+  pthread_cond_init(&tsWalGroup.doneCond, NULL);
+
+  pthread_attr_t thAttr;
+  pthread_attr_init(&thAttr);
+  pthread_attr_setdetachstate(&thAttr, PTHREAD_CREATE_JOINABLE);
+
+  int32_t ret = pthread_create(&tsWalGroup.thread, &thAttr, walGroupThreadFunc, NULL);
+  if (ret != 0) {
+    wError("failed to create wal group commit thread since %s", strerror(ret));
+    pthread_attr_destroy(&thAttr);
+    return TAOS_SYSTEM_ERROR(ret);
+  }
+
+  pthread_attr_destroy(&thAttr);
+  tsWalGroup.enabled = 1;
+  wInfo("wal group commit is enabled, flush period:%dms", tsWalGroupCommit);
+
+  return TSDB_CODE_SUCCESS;
+}
+
+void walGroupCleanUp() {
+  if (!tsWalGroup.enabled) return;
+
+  pthread_mutex_lock(&tsWalGroup.mutex);
+  tsWalGroup.stop = 1;
+  pthread_cond_signal(&tsWalGroup.workCond);
+  pthread_mutex_unlock(&tsWalGroup.mutex);
+
+  if (taosCheckPthreadValid(tsWalGroup.thread)) {
+    pthread_join(tsWalGroup.thread, NULL);
+  }
+
+  tsWalGroup.enabled = 0;
+  pthread_cond_destroy(&tsWalGroup.workCond);
+  pthread_cond_destroy(&tsWalGroup.doneCond);
+  pthread_mutex_destroy(&tsWalGroup.mutex);
+  wDebug("wal group commit thread is stopped");
+}
+
+bool walGroupEnabled() { return tsWalGroup.enabled != 0; }
+
+// called with pWal->mutex locked
+int32_t walGroupAppend(SWal *pWal, SWalHead *pHead, int32_t contLen) {
+  if (pWal->gbufLen > 0 && pWal->gbufLen + contLen > WAL_GROUP_MAX_BUF) {
+    walGroupFlush(pWal, false);
+  }
+
+  if (pWal->gbufLen + contLen > pWal->gbufSize) {
+    int32_t size = MAX(pWal->gbufSize, WAL_GROUP_INIT_BUF);
+    while (size < pWal->gbufLen + contLen) size *= 2;
+
+    char *buf = realloc(pWal->gbuf, size);
+    if (buf == NULL) {
+      wError("vgId:%d, failed to malloc %d bytes for wal group buffer", pWal->vgId, size);
+      return TSDB_CODE_COM_OUT_OF_MEMORY;
+    }
+    pWal->gbuf = buf;
+    pWal->gbufSize = size;
+  }
+
+  memcpy(pWal->gbuf + pWal->gbufLen, pHead, contLen);
+  pWal->gbufLen += contLen;
+  pWal->gbufNum++;
+  pWal->gseq++;
+
+  return TSDB_CODE_SUCCESS;
+}
+
+/*
+ * called with pWal->mutex locked, the records in (from, to] failed. The failed range is extended while the committers
+ * have not got the previous error yet, so that an error is neither lost nor returned for the later batches.
+ */
+static void walGroupSetError(SWal *pWal, int64_t from, int64_t to, int32_t code) {
+  if (pWal->errCode == 0 || pWal->errSeq <= pWal->commitSeq) {
+    pWal->errFrom = from;
+  } else {
+    pWal->errFrom = MIN(pWal->errFrom, from);
+  }
+  pWal->errSeq = MAX(pWal->errSeq, to);
+  pWal->errCode = code;
+}
+
+// called with pWal->mutex locked, fsync is done only if a committer waits for it
+int32_t walGroupFlush(SWal *pWal, bool fsync) {
+  int32_t code = 0;
+
+  if (pWal->gbufLen > 0) {
+    if (tfWrite(pWal->tfd, pWal->gbuf, pWal->gbufLen) != pWal->gbufLen) {
+      code = TAOS_SYSTEM_ERROR(errno);
+      wError("vgId:%d, file:%s, failed to write %d records since %s", pWal->vgId, pWal->name, pWal->gbufNum,
+             strerror(errno));
+      walGroupSetError(pWal, pWal->flushSeq, pWal->gseq, code);
+    }
+    pWal->gbufLen = 0;
+    pWal->gbufNum = 0;
+  }
+  atomic_store_64(&pWal->flushSeq, pWal->gseq);
+
+  if (fsync && pWal->syncReq > pWal->syncSeq) {
+    if (code == 0 && tfFsync(pWal->tfd) < 0) {
+      code = TAOS_SYSTEM_ERROR(errno);
+      wError("vgId:%d, file:%s, fsync failed since %s", pWal->vgId, pWal->name, strerror(errno));
+      walGroupSetError(pWal, pWal->syncSeq, pWal->flushSeq, code);
+    }
+    atomic_store_64(&pWal->syncSeq, pWal->flushSeq);
+  }
+
+  return code;
+}
+
+// called with pWal->mutex locked, returns the error of the records in (commitSeq, target]
+static int32_t walGroupGetError(SWal *pWal, int64_t target) {
+  int32_t code = 0;
+  if (pWal->errCode != 0 && pWal->errSeq > pWal->commitSeq && pWal->errFrom < target) {
+    code = pWal->errCode;
+  }
+  if (pWal->commitSeq < target) pWal->commitSeq = target;
+  return code;
+}
+
+int32_t walGroupCommit(SWal *pWal, bool forceFsync) {
+  bool needSync = forceFsync || (pWal->level == TAOS_WAL_FSYNC && pWal->fsyncPeriod == 0);
+
+  pthread_mutex_lock(&pWal->mutex);
+  int64_t target = pWal->gseq;
+  if (needSync && pWal->syncReq < target) pWal->syncReq = target;
+  bool    done = (needSync ? pWal->syncSeq : pWal->flushSeq) >= target;
+  int32_t code = done ? walGroupGetError(pWal, target) : 0;
+  pthread_mutex_unlock(&pWal->mutex);
+
+  if (done) return code;
+
+  pthread_mutex_lock(&tsWalGroup.mutex);
+  tsWalGroup.pending = 1;
+  pthread_cond_signal(&tsWalGroup.workCond);
+  while (!tsWalGroup.stop) {
+    int64_t seq = needSync ? atomic_load_64(&pWal->syncSeq) : atomic_load_64(&pWal->flushSeq);
+    if (seq >= target) break;
+    pthread_cond_wait(&tsWalGroup.doneCond, &tsWalGroup.mutex);
+  }
+  pthread_mutex_unlock(&tsWalGroup.mutex);
+
+  pthread_mutex_lock(&pWal->mutex);
+  code = walGroupGetError(pWal, target);
+  pthread_mutex_unlock(&pWal->mutex);
+
+  return code;
+}
+
+void walGetGroupStat(SWalGroupStat *pStat) {
+  if (!tsWalGroup.enabled) {
+    memset(pStat, 0, sizeof(*pStat));
+    return;
+  }
+
+  pthread_mutex_lock(&tsWalGroup.mutex);
+  *pStat = tsWalGroup.stat;
+  pthread_mutex_unlock(&tsWalGroup.mutex);
+}
+
+static int32_t walGroupStatBucket(int64_t value) {
+  int32_t bucket = 0;
+  while ((value >>= 1) > 0 && bucket < WAL_STAT_BUCKETS - 1) bucket++;
+  return bucket;
+}
+
+static void walGroupFlushOne(SWal *pWal, int64_t *records, int64_t *bytes, int64_t *fsyncs) {
+  pthread_mutex_lock(&pWal->mutex);
+  *records += pWal->gbufNum;
+  *bytes += pWal->gbufLen;
+  int32_t code = walGroupFlush(pWal, false);
+  int64_t tfd = pWal->tfd;
+  int64_t seq = pWal->flushSeq;
+  int64_t from = pWal->syncSeq;
+  bool    needSync = pWal->syncReq > pWal->syncSeq;
+  pthread_mutex_unlock(&pWal->mutex);
+
+  if (!needSync) return;
+
+  // fsync out of the lock so that writers are not blocked, a renew in between has fsynced the old file
+  if (code == 0 && tfFsync(tfd) < 0) {
+    code = TAOS_SYSTEM_ERROR(errno);
+  }
+  (*fsyncs)++;
+
+  pthread_mutex_lock(&pWal->mutex);
+  if (code != 0 && tfd == pWal->tfd) {
+    wError("vgId:%d, file:%s, fsync failed since %s", pWal->vgId, pWal->name, tstrerror(code));
+    walGroupSetError(pWal, from, seq, code);
+  }
+  if (pWal->syncSeq < seq) atomic_store_64(&pWal->syncSeq, seq);
+  pthread_mutex_unlock(&pWal->mutex);
+}
+
+static void walGroupFlushAll() {
+  int64_t start = taosGetTimestampUs();
+  int64_t records = 0;
+  int64_t bytes = 0;
+  int64_t fsyncs = 0;
+
+  SWal *pWal = taosIterateRef(tsWalGroup.refId, 0);
+  while (pWal) {
+    walGroupFlushOne(pWal, &records, &bytes, &fsyncs);
+    pWal = taosIterateRef(tsWalGroup.refId, pWal->rid);
+  }
+
+  int64_t elapsed = taosGetTimestampUs() - start;
+
+  pthread_mutex_lock(&tsWalGroup.mutex);
+  if (records > 0 || fsyncs > 0) {
+    SWalGroupStat *pStat = &tsWalGroup.stat;
+    pStat->cycles++;
+    pStat->records += records;
+    pStat->bytes += bytes;
+    pStat->fsyncs += fsyncs;
+    pStat->latency[walGroupStatBucket(elapsed)]++;
+    pStat->groups[walGroupStatBucket(records)]++;
+    wTrace("wal group is flushed, records:%" PRId64 " bytes:%" PRId64 " fsyncs:%" PRId64 " elapsed:%" PRId64 "us",
+           records, bytes, fsyncs, elapsed);
+  }
+  pthread_cond_broadcast(&tsWalGroup.doneCond);
+  pthread_mutex_unlock(&tsWalGroup.mutex);
+}
+
+static void *walGroupThreadFunc(void *param) {
+  setThreadName("walGroup");
+
+  while (1) {
+    pthread_mutex_lock(&tsWalGroup.mutex);
+    if (!tsWalGroup.pending && !tsWalGroup.stop) {
+      struct timespec ts = {0};
+      clock_gettime(CLOCK_REALTIME, &ts);
+      int64_t nsec = ts.tv_nsec + (int64_t)tsWalGroupCommit * 1000000;
+      ts.tv_sec += nsec / 1000000000;
+      ts.tv_nsec = nsec % 1000000000;
+      pthread_cond_timedwait(&tsWalGroup.workCond, &tsWalGroup.mutex, &ts);
+    }
+    tsWalGroup.pending = 0;
+    int8_t stop = tsWalGroup.stop;
+    pthread_mutex_unlock(&tsWalGroup.mutex);
+
+    // the last cycle writes out what is left before the wals are closed
+    walGroupFlushAll();
+    if (stop) break;
+  }
+
+  return NULL;
+}
@@ -51,11 +51,18 @@ int32_t walInit() {
     return code;
   }
 
+  code = walGroupInit(tsWal.refId);
+  if (code != TSDB_CODE_SUCCESS) {
+    wError("failed to init wal group commit since %s", tstrerror(code));
+    return code;
+  }
+
   wInfo("wal module is initialized, rsetId:%d", tsWal.refId);
   return code;
 }
 
 void walCleanUp() {
+  walGroupCleanUp();
   walStopThread();
   taosCloseRef(tsWal.refId);
   pthread_mutex_destroy(&tsWal.mutex);
@@ -133,6 +140,7 @@ void walClose(void *handle) {
 
   SWal *pWal = handle;
   pthread_mutex_lock(&pWal->mutex);
+  if (walGroupEnabled()) walGroupFlush(pWal, true);
   tfClose(pWal->tfd);
   pthread_mutex_unlock(&pWal->mutex);
   taosRemoveRef(tsWal.refId, pWal->rid);
@@ -154,6 +162,7 @@ static void walFreeObj(void *wal) {
 
   tfClose(pWal->tfd);
   pthread_mutex_destroy(&pWal->mutex);
+  tfree(pWal->gbuf);
   tfree(pWal);
 }
 
@@ -23,7 +23,47 @@
 #include "twal.h"
 #include "walInt.h"
 
-static int32_t walRestoreWalFile(SWal *pWal, void *pVnode, FWalWrite writeFp, char *name, int64_t fileId);
+#define WAL_RESTORE_PIPELINE_SIZE  (1024 * 1024)       // smaller files are read and applied in one thread
+#define WAL_RESTORE_QUEUE_SIZE     (16 * 1024 * 1024)  // bytes of records read ahead of the apply thread
+#define WAL_RESTORE_PROGRESS_ROWS  1024
+#define WAL_RESTORE_PROGRESS_MS    5000
+
+typedef struct SWalRecord {
+  struct SWalRecord *next;
+  int64_t            offset;  // file offset after the record
+  int32_t            len;
+  char               data[];  // SWalHead and its content
+} SWalRecord;
+
+typedef struct SWalReplay {
+  SWal *          pWal;
+  void *          pVnode;
+  FWalWrite *     writeFp;
+  char *          name;
+  int64_t         fileId;
+  int64_t         tfd;
+  int64_t         fsize;
+  int64_t         start;       // file offset the restore starts from
+  void *          buffer;
+  int64_t         records;     // records applied
+  int64_t         applied;     // file offset of the last applied record
+  int64_t         lastReport;  // ms
+  int32_t         code;        // error of the read thread
+  int8_t          done;        // the read thread is finished
+  int32_t         qbytes;
+  SWalRecord *    qhead;
+  SWalRecord *    qtail;
+  pthread_mutex_t mutex;
+  pthread_cond_t  notEmpty;
+  pthread_cond_t  notFull;
+} SWalReplay;
+
+typedef int32_t (*FWalRecord)(SWalReplay *pReplay, SWalHead *pHead, int64_t offset);
+
+static SWalRestoreStat tsWalRestoreStat = {0};
+
+static int32_t walRestoreWalFile(SWal *pWal, void *pVnode, FWalWrite writeFp, char *name, int64_t fileId,
+                                 int64_t offset);
 
 int32_t walRenew(void *handle) {
   if (handle == NULL) return 0;
@@ -39,6 +79,7 @@ int32_t walRenew(void *handle) {
   pthread_mutex_lock(&pWal->mutex);
 
   if (tfValid(pWal->tfd)) {
+    if (walGroupEnabled()) walGroupFlush(pWal, true);
     tfClose(pWal->tfd);
     wDebug("vgId:%d, file:%s, it is closed while renew", pWal->vgId, pWal->name);
   }
@@ -96,7 +137,8 @@ void walRemoveAllOldFiles(void *handle) {
   int64_t fileId = -1;
 
   pthread_mutex_lock(&pWal->mutex);
-  
+
+  if (walGroupEnabled()) walGroupFlush(pWal, false);
   tfClose(pWal->tfd);
   wDebug("vgId:%d, file:%s, it is closed before remove all wals", pWal->vgId, pWal->name);
 
@@ -157,7 +199,11 @@ int32_t walWrite(void *handle, SWalHead *pHead) {
 
   pthread_mutex_lock(&pWal->mutex);
 
-  if (tfWrite(pWal->tfd, pHead, contLen) != contLen) {
+  if (walGroupEnabled()) {
+    // written and fsynced by the group commit flusher, see walCommit
+    code = walGroupAppend(pWal, pHead, contLen);
+    if (code == 0) pWal->version = pHead->version;
+  } else if (tfWrite(pWal->tfd, pHead, contLen) != contLen) {
     code = TAOS_SYSTEM_ERROR(errno);
     wError("vgId:%d, file:%s, failed to write since %s", pWal->vgId, pWal->name, strerror(errno));
   } else {
@@ -173,19 +219,42 @@ int32_t walWrite(void *handle, SWalHead *pHead) {
   return code;
 }
 
-void walFsync(void *handle, bool forceFsync) {
+int32_t walFsync(void *handle, bool forceFsync) {
   SWal *pWal = handle;
-  if (pWal == NULL || !tfValid(pWal->tfd)) return;
+  if (pWal == NULL || !tfValid(pWal->tfd)) return TSDB_CODE_SUCCESS;
+
+  if (walGroupEnabled()) {
+    return walGroupCommit(pWal, forceFsync);
+  }
 
   if (forceFsync || (pWal->level == TAOS_WAL_FSYNC && pWal->fsyncPeriod == 0)) {
     wTrace("vgId:%d, fileId:%" PRId64 ", do fsync", pWal->vgId, pWal->fileId);
     if (tfFsync(pWal->tfd) < 0) {
+      int32_t code = TAOS_SYSTEM_ERROR(errno);
       wError("vgId:%d, fileId:%" PRId64 ", fsync failed since %s", pWal->vgId, pWal->fileId, strerror(errno));
+      return code;
     }
   }
+
+  return TSDB_CODE_SUCCESS;
 }
 
+/*
+ * Make the records written so far durable according to the wal level, and return the error of writing them. Without
+ * group commit the records are already written by walWrite and this is the same as walFsync.
+ */
+int32_t walCommit(void *handle, bool forceFsync) { return walFsync(handle, forceFsync); }
+
 int32_t walRestore(void *handle, void *pVnode, FWalWrite writeFp) {
+  return walRestoreFrom(handle, pVnode, writeFp, -1, 0);
+}
+
+/*
+ * Same as walRestore, but the files before startFileId are skipped and the file startFileId is read from startOffset,
+ * which shall be a position checked by walCheckPos. It is used when the state before that position is loaded from
+ * somewhere else, e.g. the snapshot of the mnode sdb.
+ */
+int32_t walRestoreFrom(void *handle, void *pVnode, FWalWrite writeFp, int64_t startFileId, int64_t startOffset) {
   if (handle == NULL) return -1;
 
   SWal *  pWal = handle;
@@ -199,8 +268,15 @@ int32_t walRestore(void *handle, void *pVnode, FWalWrite writeFp) {
     char walName[WAL_FILE_LEN];
     snprintf(walName, sizeof(pWal->name), "%s/%s%" PRId64, pWal->path, WAL_PREFIX, fileId);
 
-    wInfo("vgId:%d, file:%s, will be restored", pWal->vgId, walName);
-    code = walRestoreWalFile(pWal, pVnode, writeFp, walName, fileId);
+    if (fileId < startFileId) {
+      wInfo("vgId:%d, file:%s, skipped for restore starts from fileId:%" PRId64, pWal->vgId, walName, startFileId);
+      count++;
+      continue;
+    }
+
+    int64_t start = (fileId == startFileId) ? startOffset : 0;
+    wInfo("vgId:%d, file:%s, will be restored from offset:%" PRId64, pWal->vgId, walName, start);
+    code = walRestoreWalFile(pWal, pVnode, writeFp, walName, fileId, start);
     if (code != TSDB_CODE_SUCCESS) {
       wError("vgId:%d, file:%s, failed to restore since %s", pWal->vgId, walName, tstrerror(code));
       continue;
@@ -239,6 +315,9 @@ int32_t walGetWalFile(void *handle, char *fileName, int64_t *fileId) {
 
   pthread_mutex_lock(&(pWal->mutex));
 
+  // the file is read by sync, so the records waiting for group commit are written out first
+  if (walGroupEnabled()) walGroupFlush(pWal, false);
+
   int32_t code = walGetNextFile(pWal, fileId);
   if (code >= 0) {
     sprintf(fileName, "wal/%s%" PRId64, WAL_PREFIX, *fileId);
@@ -251,6 +330,62 @@ int32_t walGetWalFile(void *handle, char *fileName, int64_t *fileId) {
   return code;
 }
 
+/*
+ * Check that the file fileId ends at offset, or has a valid record there whose version is exactly the next one of
+ * version, so a restore can start from that position without missing any record.
+ */
+bool walCheckPos(void *handle, int64_t fileId, int64_t offset, uint64_t version) {
+  SWal *pWal = handle;
+  if (pWal == NULL || fileId < 0 || offset < 0) return false;
+
+  char walName[WAL_FILE_LEN];
+  snprintf(walName, sizeof(walName), "%s/%s%" PRId64, pWal->path, WAL_PREFIX, fileId);
+
+  int64_t tfd = tfOpen(walName, O_RDONLY);
+  if (!tfValid(tfd)) {
+    wWarn("vgId:%d, file:%s, failed to open for position check since %s", pWal->vgId, walName, strerror(errno));
+    return false;
+  }
+
+  bool        valid = false;
+  SWalHead *  pHead = NULL;
+  struct stat fstat;
+
+  if (tfStat(tfd, &fstat) != 0 || fstat.st_size < offset) {
+    wWarn("vgId:%d, file:%s, offset:%" PRId64 " is beyond the file", pWal->vgId, walName, offset);
+    goto _end;
+  }
+
+  if (fstat.st_size == offset) {
+    valid = true;
+    goto _end;
+  }
+
+  pHead = tmalloc(WAL_MAX_SIZE);
+  if (pHead == NULL) goto _end;
+
+  if (tfLseek(tfd, offset, SEEK_SET) < 0 || tfRead(tfd, pHead, sizeof(SWalHead)) != sizeof(SWalHead)) goto _end;
+  if (pHead->signature != WAL_SIGNATURE || pHead->len < 0 || pHead->len > WAL_MAX_SIZE - sizeof(SWalHead)) goto _end;
+
+#if defined(WAL_CHECKSUM_WHOLE)
+  if (pHead->sver >= 1 && tfRead(tfd, pHead->cont, pHead->len) != pHead->len) goto _end;
+  if (!walValidateChecksum(pHead)) goto _end;
+#else
+  if (!taosCheckChecksumWhole((uint8_t *)pHead, sizeof(SWalHead))) goto _end;
+#endif
+
+  valid = (pHead->version == version + 1);
+
+_end:
+  if (!valid) {
+    wWarn("vgId:%d, file:%s, no record after version:%" PRIu64 " at offset:%" PRId64, pWal->vgId, walName, version,
+          offset);
+  }
+  tfree(pHead);
+  tfClose(tfd);
+  return valid;
+}
+
 static void walFtruncate(SWal *pWal, int64_t tfd, int64_t offset) {
   tfFtruncate(tfd, offset);
   tfFsync(tfd);
@@ -417,27 +552,26 @@ static int walSMemRowCheck(SWalHead *pHead) {
   return 0;
 }
 
-static int32_t walRestoreWalFile(SWal *pWal, void *pVnode, FWalWrite writeFp, char *name, int64_t fileId) {
-  int32_t size = WAL_MAX_SIZE;
-  void *  buffer = tmalloc(size);
-  if (buffer == NULL) {
-    wError("vgId:%d, file:%s, failed to open for restore since %s", pWal->vgId, name, strerror(errno));
-    return TAOS_SYSTEM_ERROR(errno);
-  }
+/*
+ * Records of a wal file are read, validated and expanded by walReadWalFile, and handed to fp. For a large file it runs
+ * in a reader thread and fp queues the records, so the checksums and the reads overlap with the inserts into the
+ * memtable, which are still done in the thread opening the vnode in the order of the records.
+ */
+static int32_t walReadWalFile(SWalReplay *pReplay, FWalRecord fp) {
+  SWal *    pWal = pReplay->pWal;
+  char *    name = pReplay->name;
+  int64_t   fileId = pReplay->fileId;
+  int64_t   tfd = pReplay->tfd;
+  int32_t   size = WAL_MAX_SIZE;
+  int32_t   code = TSDB_CODE_SUCCESS;
+  int64_t   offset = pReplay->start;
+  SWalHead *pHead = pReplay->buffer;
 
-  int64_t tfd = tfOpen(name, O_RDWR);
-  if (!tfValid(tfd)) {
-    wError("vgId:%d, file:%s, failed to open for restore since %s", pWal->vgId, name, strerror(errno));
-    tfree(buffer);
+  if (offset > 0 && tfLseek(tfd, offset, SEEK_SET) < 0) {
+    wError("vgId:%d, file:%s, failed to seek to offset:%" PRId64 " since %s", pWal->vgId, name, offset, strerror(errno));
     return TAOS_SYSTEM_ERROR(errno);
-  } else {
-    wDebug("vgId:%d, file:%s, open for restore", pWal->vgId, name);
   }
 
-  int32_t   code = TSDB_CODE_SUCCESS;
-  int64_t   offset = 0;
-  SWalHead *pHead = buffer;
-
   while (1) {
     int32_t ret = (int32_t)tfRead(tfd, pHead, sizeof(SWalHead));
     if (ret == 0) break;
@@ -535,29 +669,198 @@ static int32_t walRestoreWalFile(SWal *pWal, void *pVnode, FWalWrite writeFp, ch
 #endif
     offset = offset + sizeof(SWalHead) + pHead->len;
 
-    wTrace("vgId:%d, restore wal, fileId:%" PRId64 " hver:%" PRIu64 " wver:%" PRIu64 " len:%d offset:%" PRId64,
-           pWal->vgId, fileId, pHead->version, pWal->version, pHead->len, offset);
-
-    pWal->version = pHead->version;
-
-    // wInfo("writeFp: %ld", offset);
     if (0 != walSMemRowCheck(pHead)) {
       wError("vgId:%d, restore wal, fileId:%" PRId64 " hver:%" PRIu64 " wver:%" PRIu64 " len:%d offset:%" PRId64,
              pWal->vgId, fileId, pHead->version, pWal->version, pHead->len, offset);
-      tfClose(tfd);
-      tfree(buffer);
-      return TAOS_SYSTEM_ERROR(errno);
+      code = TAOS_SYSTEM_ERROR(errno);
+      break;
     }
-    (*writeFp)(pVnode, pHead, TAOS_QTYPE_WAL, NULL);
+
+    code = (*fp)(pReplay, pHead, offset);
+    if (code != TSDB_CODE_SUCCESS) break;
   }
 
+  return code;
+}
+
+static void walApplyRecord(SWalReplay *pReplay, SWalHead *pHead, int64_t offset) {
+  SWal *pWal = pReplay->pWal;
+
+  wTrace("vgId:%d, restore wal, fileId:%" PRId64 " hver:%" PRIu64 " wver:%" PRIu64 " len:%d offset:%" PRId64,
+         pWal->vgId, pReplay->fileId, pHead->version, pWal->version, pHead->len, offset);
+
+  pWal->version = pHead->version;
+  (*pReplay->writeFp)(pReplay->pVnode, pHead, TAOS_QTYPE_WAL, NULL);
+
+  pReplay->records++;
+  pReplay->applied = offset;
+
+  if (pReplay->records % WAL_RESTORE_PROGRESS_ROWS == 0) {
+    int64_t now = taosGetTimestampMs();
+    if (now - pReplay->lastReport >= WAL_RESTORE_PROGRESS_MS) {
+      pReplay->lastReport = now;
+      wInfo("vgId:%d, file:%s, %" PRId64 " records are restored, %" PRId64 " of %" PRId64 " bytes (%d%%)", pWal->vgId,
+            pReplay->name, pReplay->records, offset, pReplay->fsize,
+            pReplay->fsize > 0 ? (int32_t)(offset * 100 / pReplay->fsize) : 100);
+    }
+  }
+}
+
+static int32_t walApplyDirectly(SWalReplay *pReplay, SWalHead *pHead, int64_t offset) {
+  walApplyRecord(pReplay, pHead, offset);
+  return 0;
+}
+
+static int32_t walQueueRecord(SWalReplay *pReplay, SWalHead *pHead, int64_t offset) {
+  int32_t     len = sizeof(SWalHead) + pHead->len;
+  SWalRecord *pRecord = malloc(sizeof(SWalRecord) + len);
+  if (pRecord == NULL) {
+    wError("vgId:%d, file:%s, failed to malloc %d bytes for restore", pReplay->pWal->vgId, pReplay->name, len);
+    return TSDB_CODE_COM_OUT_OF_MEMORY;
+  }
+
+  pRecord->next = NULL;
+  pRecord->offset = offset;
+  pRecord->len = len;
+  memcpy(pRecord->data, pHead, len);
+
+  pthread_mutex_lock(&pReplay->mutex);
+  while (pReplay->qbytes >= WAL_RESTORE_QUEUE_SIZE) {
+    pthread_cond_wait(&pReplay->notFull, &pReplay->mutex);
+  }
+  if (pReplay->qtail) {
+    pReplay->qtail->next = pRecord;
+  } else {
+    pReplay->qhead = pRecord;
+  }
+  pReplay->qtail = pRecord;
+  pReplay->qbytes += len;
+  pthread_cond_signal(&pReplay->notEmpty);
+  pthread_mutex_unlock(&pReplay->mutex);
+
+  return 0;
+}
+
+static void *walReadThreadFunc(void *param) {
+  SWalReplay *pReplay = param;
+  setThreadName("walRead");
+
+  pReplay->code = walReadWalFile(pReplay, walQueueRecord);
+
+  pthread_mutex_lock(&pReplay->mutex);
+  pReplay->done = 1;
+  pthread_cond_signal(&pReplay->notEmpty);
+  pthread_mutex_unlock(&pReplay->mutex);
+
+  return NULL;
+}
+
+static int32_t walReplayPipelined(SWalReplay *pReplay) {
+  pthread_t thread;
+
+  pthread_mutex_init(&pReplay->mutex, NULL);
+  pthread_cond_init(&pReplay->notEmpty, NULL);
+  pthread_cond_init(&pReplay->notFull, NULL);
+
+  int32_t ret = pthread_create(&thread, NULL, walReadThreadFunc, pReplay);
+  if (ret != 0) {
+    wWarn("vgId:%d, file:%s, failed to create read thread since %s, restore it serially", pReplay->pWal->vgId,
+          pReplay->name, strerror(ret));
+    pReplay->code = walReadWalFile(pReplay, walApplyDirectly);
+  } else {
+    while (1) {
+      pthread_mutex_lock(&pReplay->mutex);
+      while (pReplay->qhead == NULL && !pReplay->done) {
+        pthread_cond_wait(&pReplay->notEmpty, &pReplay->mutex);
+      }
+      SWalRecord *pRecord = pReplay->qhead;
+      if (pRecord != NULL) {
+        pReplay->qhead = pRecord->next;
+        if (pReplay->qhead == NULL) pReplay->qtail = NULL;
+        pReplay->qbytes -= pRecord->len;
+        pthread_cond_signal(&pReplay->notFull);
+      }
+      pthread_mutex_unlock(&pReplay->mutex);
+
+      if (pRecord == NULL) break;
+
+      walApplyRecord(pReplay, (SWalHead *)pRecord->data, pRecord->offset);
+      free(pRecord);
+    }
+
+    pthread_join(thread, NULL);
+  }
+
+  pthread_cond_destroy(&pReplay->notFull);
+  pthread_cond_destroy(&pReplay->notEmpty);
+  pthread_mutex_destroy(&pReplay->mutex);
+
+  return pReplay->code;
+}
+
+static int32_t walRestoreWalFile(SWal *pWal, void *pVnode, FWalWrite writeFp, char *name, int64_t fileId,
+                                 int64_t offset) {
+  int32_t size = WAL_MAX_SIZE;
+  void *  buffer = tmalloc(size);
+  if (buffer == NULL) {
+    wError("vgId:%d, file:%s, failed to open for restore since %s", pWal->vgId, name, strerror(errno));
+    return TAOS_SYSTEM_ERROR(errno);
+  }
+
+  int64_t tfd = tfOpen(name, O_RDWR);
+  if (!tfValid(tfd)) {
+    wError("vgId:%d, file:%s, failed to open for restore since %s", pWal->vgId, name, strerror(errno));
+    tfree(buffer);
+    return TAOS_SYSTEM_ERROR(errno);
+  } else {
+    wDebug("vgId:%d, file:%s, open for restore", pWal->vgId, name);
+  }
+
+  SWalReplay replay = {0};
+  replay.pWal = pWal;
+  replay.pVnode = pVnode;
+  replay.writeFp = writeFp;
+  replay.name = name;
+  replay.fileId = fileId;
+  replay.tfd = tfd;
+  replay.start = offset;
+  replay.applied = offset;
+  replay.buffer = buffer;
+  replay.lastReport = taosGetTimestampMs();
+
+  struct stat fstat;
+  if (tfStat(tfd, &fstat) == 0) replay.fsize = fstat.st_size;
+
+  int64_t start = taosGetTimestampUs();
+  int32_t code = 0;
+  if (replay.fsize - offset >= WAL_RESTORE_PIPELINE_SIZE) {
+    code = walReplayPipelined(&replay);
+  } else {
+    code = walReadWalFile(&replay, walApplyDirectly);
+  }
+  int64_t elapsed = taosGetTimestampUs() - start;
+
   tfClose(tfd);
   tfree(buffer);
 
+  atomic_add_fetch_64(&tsWalRestoreStat.files, 1);
+  atomic_add_fetch_64(&tsWalRestoreStat.records, replay.records);
+  atomic_add_fetch_64(&tsWalRestoreStat.bytes, replay.applied - offset);
+  atomic_add_fetch_64(&tsWalRestoreStat.elapsedUs, elapsed);
+
+  wInfo("vgId:%d, file:%s, %" PRId64 " records of %" PRId64 " bytes are restored in %" PRId64 "ms", pWal->vgId, name,
+        replay.records, replay.applied - offset, elapsed / 1000);
   wDebug("vgId:%d, file:%s, it is closed after restore", pWal->vgId, name);
   return code;
 }
 
+void walGetRestoreStat(SWalRestoreStat *pStat) {
+  pStat->files = atomic_load_64(&tsWalRestoreStat.files);
+  pStat->records = atomic_load_64(&tsWalRestoreStat.records);
+  pStat->bytes = atomic_load_64(&tsWalRestoreStat.bytes);
+  pStat->elapsedUs = atomic_load_64(&tsWalRestoreStat.elapsedUs);
+}
+
 uint64_t walGetVersion(twalh param) {
   SWal *pWal = param;
   if (pWal == 0) return 0;
@@ -43,6 +43,7 @@ int main(int argc, char *argv[]) {
   int  rows = 10000;
   int  size = 128;
   int  keep = 0;
+  int  group = 0;
 
   for (int i=1; i<argc; ++i) {
     if (strcmp(argv[i], "-p")==0 && i < argc-1) {
@@ -59,6 +60,8 @@ int main(int argc, char *argv[]) {
       size = atoi(argv[++i]);
     } else if (strcmp(argv[i], "-v")==0 && i < argc-1) {
       ver = atoll(argv[++i]);
+    } else if (strcmp(argv[i], "-g")==0 && i < argc-1) {
+      group = atoi(argv[++i]);
     } else if (strcmp(argv[i], "-d")==0 && i < argc-1) {
       dDebugFlag = atoi(argv[++i]);
     } else {
@@ -69,6 +72,7 @@ int main(int argc, char *argv[]) {
       printf("  [-r rows]: rows of records per wal file, default is:%d\n", rows);
       printf("  [-k keep]: keep the wal after closing, default is:%d\n", keep);
       printf("  [-v version]: initial version, default is:%" PRId64 "\n", ver);
+      printf("  [-g period]: group commit flush period in ms, 0 means disabled, default is:%d\n", group);
       printf("  [-d debugFlag]: debug flag, default:%d\n", dDebugFlag);
       printf("  [-h help]: print out this help\n\n");
       exit(0);
@@ -77,6 +81,7 @@ int main(int argc, char *argv[]) {
 
   taosInitLog("wal.log", 100000, 10);
   tfInit();
+  tsWalGroupCommit = group;
   walInit();
 
   SWalCfg walCfg = {0};
@@ -105,6 +110,7 @@ int main(int argc, char *argv[]) {
       pHead->version = ++ver;
       pHead->len = size;
       walWrite(pWal, pHead);
+      walCommit(pWal, false);
     }
        
     printf("renew a wal, i:%d\n", i);
@@ -0,0 +1,134 @@
+// import data files with insert ... file, a file with an invalid line must fail the import instead of being
+// imported partially, wherever the line is in the chunks that the file is split into
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include "taos.h"
+
+#define PRINT_ERROR printf("\033[31m");
+#define PRINT_SUCCESS printf("\033[32m");
+
+#define NUM_OF_LINES 20000
+
+static const int64_t START_TS = 1626624000000LL;
+
+void execute_simple_sql(void *taos, char *sql) {
+  TAOS_RES *result = taos_query(taos, sql);
+  if (result == NULL || taos_errno(result) != 0) {
+    PRINT_ERROR
+    printf("failed to %s, Reason: %s\n", sql, taos_errstr(result));
+    taos_free_result(result);
+    exit(EXIT_FAILURE);
+  }
+  taos_free_result(result);
+}
+
+static int64_t count_rows(TAOS *taos) {
+  TAOS_RES *result = taos_query(taos, "select count(*) from t");
+  TAOS_ROW  row = taos_fetch_row(result);
+  int64_t   count = (row == NULL || row[0] == NULL) ? 0 : *(int64_t *)row[0];
+  taos_free_result(result);
+  return count;
+}
+
+// write NUM_OF_LINES lines, the line badLine (if not negative) has a parameter placeholder instead of a value
+static void write_file(const char *fileName, int badLine) {
+  FILE *fp = fopen(fileName, "w");
+  if (fp == NULL) {
+    PRINT_ERROR
+    printf("failed to create %s\n", fileName);
+    exit(EXIT_FAILURE);
+  }
+
+  for (int i = 0; i < NUM_OF_LINES; ++i) {
+    if (i == badLine) {
+      fprintf(fp, "%lld,?,'b%d'\n", (long long)(START_TS + i), i);
+    } else {
+      fprintf(fp, "%lld,%d,'b%d'\n", (long long)(START_TS + i), i, i);
+    }
+  }
+  fclose(fp);
+}
+
+static int run_case(TAOS *taos, const char *desc, int badLine) {
+  char fileName[] = "/tmp/importFileTestXXXXXX";
+  char sql[256];
+  int  fd = mkstemp(fileName);
+  if (fd < 0) {
+    PRINT_ERROR
+    printf("%s: failed to create a temporary file\n", desc);
+    exit(EXIT_FAILURE);
+  }
+  close(fd);
+  write_file(fileName, badLine);
+
+  execute_simple_sql(taos, "drop table if exists t");
+  execute_simple_sql(taos, "create table t (ts timestamp, v int, b binary(16))");
+
+  snprintf(sql, sizeof(sql), "insert into t file '%s'", fileName);
+  TAOS_RES *result = taos_query(taos, sql);
+  int       code = taos_errno(result);
+  int       affected = taos_affected_rows(result);
+  taos_free_result(result);
+  unlink(fileName);
+
+  int failed = 0;
+  if (badLine < 0) {
+    int64_t count = count_rows(taos);
+    if (code != 0 || affected != NUM_OF_LINES || count != NUM_OF_LINES) {
+      PRINT_ERROR
+      printf("%s: expect %d rows imported, code:0x%x affected:%d count:%lld\n", desc, NUM_OF_LINES, code, affected,
+             (long long)count);
+      failed = 1;
+    }
+  } else if (code == 0) {
+    PRINT_ERROR
+    printf("%s: the import succeeded with %d rows, but the line %d is invalid\n", desc, affected, badLine);
+    failed = 1;
+  }
+
+  if (!failed) {
+    PRINT_SUCCESS
+    printf("%s: passed, code:0x%x\n", desc, code);
+  }
+  return failed;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1) {
+    taos_options(TSDB_OPTION_CONFIGDIR, argv[1]);
+  }
+
+  TAOS *taos = taos_connect(NULL, "root", "taosdata", NULL, 0);
+  if (taos == NULL) {
+    PRINT_ERROR
+    printf("TDengine error: failed to connect\n");
+    exit(EXIT_FAILURE);
+  }
+
+  execute_simple_sql(taos, "drop database if exists import_file_test");
+  execute_simple_sql(taos, "create database import_file_test");
+  execute_simple_sql(taos, "use import_file_test");
+
+  int failed = 0;
+  failed += run_case(taos, "valid file", -1);
+  failed += run_case(taos, "placeholder in the middle of the first chunk", 150);
+  failed += run_case(taos, "placeholder as the first line", 0);
+  failed += run_case(taos, "placeholder in the middle of a later chunk", NUM_OF_LINES / 2 + 7);
+  failed += run_case(taos, "placeholder as the last line", NUM_OF_LINES - 1);
+
+  execute_simple_sql(taos, "drop database if exists import_file_test");
+  taos_close(taos);
+
+  if (failed > 0) {
+    PRINT_ERROR
+    printf("%d cases failed\n", failed);
+    exit(EXIT_FAILURE);
+  }
+
+  PRINT_SUCCESS
+  printf("all cases passed\n");
+  return 0;
+}
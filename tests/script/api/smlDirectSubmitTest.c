@@ -0,0 +1,253 @@
+// insert schemaless data of the line, telnet and json protocols both with smlDirectSubmit 0 (prepared statements) and
+// 1 (submit blocks built directly with the cached super table schemas), each path runs in a child process since the
+// client configuration can only be set once
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "taos.h"
+
+#define PRINT_ERROR printf("\033[31m");
+#define PRINT_SUCCESS printf("\033[32m");
+
+static int failed = 0;
+static int directSubmit = 0;
+
+void execute_simple_sql(void *taos, char *sql) {
+  TAOS_RES *result = taos_query(taos, sql);
+  if (result == NULL || taos_errno(result) != 0) {
+    PRINT_ERROR
+    printf("failed to %s, Reason: %s\n", sql, taos_errstr(result));
+    taos_free_result(result);
+    exit(EXIT_FAILURE);
+  }
+  taos_free_result(result);
+}
+
+static int64_t query_count(TAOS *taos, const char *sql) {
+  TAOS_RES *result = taos_query(taos, sql);
+  if (taos_errno(result) != 0) {
+    PRINT_ERROR
+    printf("failed to %s, Reason: %s\n", sql, taos_errstr(result));
+    taos_free_result(result);
+    return -1;
+  }
+
+  TAOS_ROW row = taos_fetch_row(result);
+  int64_t  count = (row == NULL || row[0] == NULL) ? 0 : *(int64_t *)row[0];
+  taos_free_result(result);
+  return count;
+}
+
+static void sml_insert(TAOS *taos, const char *desc, char *lines[], int numLines, int protocol) {
+  TAOS_RES *result = taos_schemaless_insert(taos, lines, numLines, protocol, TSDB_SML_TIMESTAMP_MILLI_SECONDS);
+  if (taos_errno(result) != 0) {
+    PRINT_ERROR
+    printf("smlDirectSubmit %d, %s: insert failed, reason:%s\n", directSubmit, desc, taos_errstr(result));
+    failed++;
+  }
+  taos_free_result(result);
+}
+
+static void check_count(TAOS *taos, const char *desc, const char *sql, int64_t expected) {
+  int64_t count = query_count(taos, sql);
+  if (count != expected) {
+    PRINT_ERROR
+    printf("smlDirectSubmit %d, %s: %s returns %lld, expect %lld\n", directSubmit, desc, sql, (long long)count,
+           (long long)expected);
+    failed++;
+  } else {
+    PRINT_SUCCESS
+    printf("smlDirectSubmit %d, %s: passed\n", directSubmit, desc);
+  }
+}
+
+static void verify_line_insert(TAOS *taos) {
+  char *lines0[] = {
+      "lm,t1=a,t2=1i64 c1=1i32,c2=\"x\" 1626006833000",
+      "lm,t1=b,t2=2i64 c1=2i32,c2=\"y\" 1626006833000",
+      "lm,t1=a,t2=1i64 c1=3i32,c2=\"z\" 1626006833001",
+  };
+  sml_insert(taos, "line new child tables", lines0, 3, TSDB_SML_LINE_PROTOCOL);
+  check_count(taos, "line new child tables", "select count(*) from lm", 3);
+  check_count(taos, "line new child tables", "select count(tbname) from lm", 2);
+
+  // a new column, a new tag and a longer binary value change the super table
+  char *lines1[] = {
+      "lm,t1=c,t2=3i64,t3=\"new\" c1=4i32,c2=\"a much longer binary value\",c3=1.5 1626006833002",
+  };
+  sml_insert(taos, "line schema change", lines1, 1, TSDB_SML_LINE_PROTOCOL);
+  check_count(taos, "line schema change", "select count(c3) from lm", 1);
+  check_count(taos, "line schema change", "select count(*) from lm where c2 = 'a much longer binary value'", 1);
+
+  // the tags and columns missing in the points are null
+  char *lines2[] = {
+      "lm,t1=d c1=5i32 1626006833003",
+      "lm,t1=a,t2=1i64 c2=\"w\" 1626006833004",
+  };
+  sml_insert(taos, "line null tags and columns", lines2, 2, TSDB_SML_LINE_PROTOCOL);
+  check_count(taos, "line null tags", "select count(*) from lm where t2 is null", 1);
+  check_count(taos, "line null columns", "select count(*) from lm where c1 is null", 1);
+  check_count(taos, "line null columns", "select count(*) from lm where c2 is null", 1);
+
+  // the cached schema is out of date once the super table is altered or dropped by others
+  execute_simple_sql(taos, "alter stable lm drop column c3");
+  char *lines3[] = {
+      "lm,t1=a,t2=1i64 c1=6i32,c3=2.5 1626006833005",
+  };
+  sml_insert(taos, "line dropped column", lines3, 1, TSDB_SML_LINE_PROTOCOL);
+  check_count(taos, "line dropped column", "select count(c3) from lm", 1);
+
+  execute_simple_sql(taos, "drop stable lm");
+  char *lines4[] = {
+      "lm,t1=e,t2=5i64 c1=7i32 1626006833006",
+  };
+  sml_insert(taos, "line dropped super table", lines4, 1, TSDB_SML_LINE_PROTOCOL);
+  check_count(taos, "line dropped super table", "select count(*) from lm", 1);
+}
+
+static void verify_telnet_insert(TAOS *taos) {
+  char *lines0[] = {
+      "tm 1626006833000 1i32 host=h0 dc=d0",
+      "tm 1626006833000 2i32 host=h1 dc=d0",
+      "tm 1626006833001 3i32 host=h0 dc=d0",
+  };
+  sml_insert(taos, "telnet new child tables", lines0, 3, TSDB_SML_TELNET_PROTOCOL);
+  check_count(taos, "telnet new child tables", "select count(*) from tm", 3);
+  check_count(taos, "telnet new child tables", "select count(tbname) from tm", 2);
+
+  char *lines1[] = {
+      "tm 1626006833002 4i32 host=h2 dc=d0 rack=a_much_longer_rack_name",
+  };
+  sml_insert(taos, "telnet schema change", lines1, 1, TSDB_SML_TELNET_PROTOCOL);
+  check_count(taos, "telnet schema change", "select count(*) from tm where rack = 'a_much_longer_rack_name'", 1);
+
+  char *lines2[] = {
+      "tm 1626006833003 5i32 host=h3",
+  };
+  sml_insert(taos, "telnet null tags", lines2, 1, TSDB_SML_TELNET_PROTOCOL);
+  check_count(taos, "telnet null tags", "select count(*) from tm where dc is null", 1);
+
+  execute_simple_sql(taos, "alter stable tm drop tag rack");
+  char *lines3[] = {
+      "tm 1626006833004 6i32 host=h4 dc=d1 rack=r1",
+  };
+  sml_insert(taos, "telnet dropped tag", lines3, 1, TSDB_SML_TELNET_PROTOCOL);
+  check_count(taos, "telnet dropped tag", "select count(*) from tm where rack = 'r1'", 1);
+
+  execute_simple_sql(taos, "drop stable tm");
+  char *lines4[] = {
+      "tm 1626006833005 7i32 host=h5",
+  };
+  sml_insert(taos, "telnet dropped super table", lines4, 1, TSDB_SML_TELNET_PROTOCOL);
+  check_count(taos, "telnet dropped super table", "select count(*) from tm", 1);
+}
+
+static void verify_json_insert(TAOS *taos) {
+  char *message0[] = {
+      "[{\"metric\":\"jm\",\"timestamp\":1626006833000,\"value\":1.5,\"tags\":{\"host\":\"h0\",\"dc\":\"d0\"}},"
+      " {\"metric\":\"jm\",\"timestamp\":1626006833000,\"value\":2.5,\"tags\":{\"host\":\"h1\",\"dc\":\"d0\"}},"
+      " {\"metric\":\"jm\",\"timestamp\":1626006833001,\"value\":3.5,\"tags\":{\"host\":\"h0\",\"dc\":\"d0\"}}]"};
+  sml_insert(taos, "json new child tables", message0, 1, TSDB_SML_JSON_PROTOCOL);
+  check_count(taos, "json new child tables", "select count(*) from jm", 3);
+  check_count(taos, "json new child tables", "select count(tbname) from jm", 2);
+
+  char *message1[] = {
+      "{\"metric\":\"jm\",\"timestamp\":1626006833002,\"value\":4.5,"
+      "\"tags\":{\"host\":\"h2\",\"dc\":\"d0\",\"rack\":\"a much longer rack name\"}}"};
+  sml_insert(taos, "json schema change", message1, 1, TSDB_SML_JSON_PROTOCOL);
+  check_count(taos, "json schema change", "select count(*) from jm where rack = 'a much longer rack name'", 1);
+
+  char *message2[] = {"{\"metric\":\"jm\",\"timestamp\":1626006833003,\"value\":5.5,\"tags\":{\"host\":\"h3\"}}"};
+  sml_insert(taos, "json null tags", message2, 1, TSDB_SML_JSON_PROTOCOL);
+  check_count(taos, "json null tags", "select count(*) from jm where dc is null", 1);
+
+  execute_simple_sql(taos, "alter stable jm drop tag rack");
+  char *message3[] = {
+      "{\"metric\":\"jm\",\"timestamp\":1626006833004,\"value\":6.5,"
+      "\"tags\":{\"host\":\"h4\",\"dc\":\"d1\",\"rack\":\"r1\"}}"};
+  sml_insert(taos, "json dropped tag", message3, 1, TSDB_SML_JSON_PROTOCOL);
+  check_count(taos, "json dropped tag", "select count(*) from jm where rack = 'r1'", 1);
+
+  execute_simple_sql(taos, "drop stable jm");
+  char *message4[] = {"{\"metric\":\"jm\",\"timestamp\":1626006833005,\"value\":7.5,\"tags\":{\"host\":\"h5\"}}"};
+  sml_insert(taos, "json dropped super table", message4, 1, TSDB_SML_JSON_PROTOCOL);
+  check_count(taos, "json dropped super table", "select count(*) from jm", 1);
+}
+
+static int run_test(const char *configDir, int direct) {
+  char config[64];
+  directSubmit = direct;
+  snprintf(config, sizeof(config), "{\"smlDirectSubmit\":\"%d\"}", direct);
+  setConfRet ret = taos_set_config(config);
+  if (ret.retCode != SET_CONF_RET_SUCC) {
+    PRINT_ERROR
+    printf("failed to set %s, reason:%s\n", config, ret.retMsg);
+    return 1;
+  }
+
+  if (configDir != NULL) {
+    taos_options(TSDB_OPTION_CONFIGDIR, configDir);
+  }
+
+  TAOS *taos = taos_connect(NULL, "root", "taosdata", NULL, 0);
+  if (taos == NULL) {
+    PRINT_ERROR
+    printf("TDengine error: failed to connect\n");
+    return 1;
+  }
+
+  char sql[128];
+  snprintf(sql, sizeof(sql), "drop database if exists sml_direct_%d", direct);
+  execute_simple_sql(taos, sql);
+  snprintf(sql, sizeof(sql), "create database sml_direct_%d precision 'ms'", direct);
+  execute_simple_sql(taos, sql);
+  snprintf(sql, sizeof(sql), "use sml_direct_%d", direct);
+  execute_simple_sql(taos, sql);
+
+  verify_line_insert(taos);
+  verify_telnet_insert(taos);
+  verify_json_insert(taos);
+
+  snprintf(sql, sizeof(sql), "drop database if exists sml_direct_%d", direct);
+  execute_simple_sql(taos, sql);
+  taos_close(taos);
+
+  return failed;
+}
+
+int main(int argc, char *argv[]) {
+  const char *configDir = (argc > 1) ? argv[1] : NULL;
+  int         numOfFailed = 0;
+
+  for (int direct = 0; direct <= 1; ++direct) {
+    pid_t pid = fork();
+    if (pid < 0) {
+      PRINT_ERROR
+      printf("failed to fork\n");
+      exit(EXIT_FAILURE);
+    }
+
+    if (pid == 0) {
+      exit(run_test(configDir, direct) == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+      numOfFailed++;
+    }
+  }
+
+  if (numOfFailed > 0) {
+    PRINT_ERROR
+    printf("%d of the two paths failed\n", numOfFailed);
+    exit(EXIT_FAILURE);
+  }
+
+  PRINT_SUCCESS
+  printf("all cases passed\n");
+  return 0;
+}
@@ -0,0 +1,204 @@
+// compare the results of prepared select statements executed repeatedly with the results of the same statements
+// written as sql strings, the parameters of the later executions are bound without parsing the statement again
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "taos.h"
+
+#define PRINT_ERROR printf("\033[31m");
+#define PRINT_SUCCESS printf("\033[32m");
+
+#define MAX_PARAMS 4
+#define RESULT_LEN 65536
+
+typedef struct {
+  const char *desc;
+  const char *stmtSql;    // with "?" for each parameter
+  const char *textSql;    // printf format of the same statement with "%s" for each parameter
+  int         numParams;
+  int         types[MAX_PARAMS];
+  int64_t     values[3][MAX_PARAMS];     // each execution binds one row
+  const char *strValues[3][MAX_PARAMS];  // the values of the binary parameters
+} SQueryCase;
+
+static const int64_t START_TS = 1626624000000LL;
+
+void execute_simple_sql(void *taos, char *sql) {
+  TAOS_RES *result = taos_query(taos, sql);
+  if (result == NULL || taos_errno(result) != 0) {
+    PRINT_ERROR
+    printf("failed to %s, Reason: %s\n", sql, taos_errstr(result));
+    taos_free_result(result);
+    exit(EXIT_FAILURE);
+  }
+  taos_free_result(result);
+}
+
+static void fetch_result(TAOS_RES *result, char *buf) {
+  int        len = 0;
+  int        numOfFields = taos_num_fields(result);
+  TAOS_FIELD *fields = taos_fetch_fields(result);
+  TAOS_ROW   row;
+
+  buf[0] = 0;
+  while ((row = taos_fetch_row(result)) && len < RESULT_LEN - 1024) {
+    len += taos_print_row(buf + len, row, fields, numOfFields);
+    buf[len++] = '\n';
+    buf[len] = 0;
+  }
+}
+
+static int run_case(TAOS *taos, SQueryCase *pCase) {
+  char      sql[1024];
+  char      literals[MAX_PARAMS][64];
+  char      expected[RESULT_LEN];
+  char      actual[RESULT_LEN];
+  int       failed = 0;
+  int64_t   v64[MAX_PARAMS];
+  int32_t   v32[MAX_PARAMS];
+  uintptr_t lengths[MAX_PARAMS];
+  TAOS_BIND params[MAX_PARAMS];
+
+  TAOS_STMT *stmt = taos_stmt_init(taos);
+  if (taos_stmt_prepare(stmt, pCase->stmtSql, 0) != 0) {
+    PRINT_ERROR
+    printf("%s: failed to prepare %s, reason:%s\n", pCase->desc, pCase->stmtSql, taos_stmt_errstr(stmt));
+    exit(EXIT_FAILURE);
+  }
+
+  for (int i = 0; i < 3; ++i) {
+    memset(params, 0, sizeof(params));
+    memset(literals, 0, sizeof(literals));
+    for (int j = 0; j < pCase->numParams; ++j) {
+      params[j].buffer_type = pCase->types[j];
+      if (pCase->types[j] == TSDB_DATA_TYPE_BINARY) {
+        params[j].buffer = (void *)pCase->strValues[i][j];
+        params[j].buffer_length = strlen(pCase->strValues[i][j]);
+        snprintf(literals[j], sizeof(literals[j]), "'%s'", pCase->strValues[i][j]);
+      } else if (pCase->types[j] == TSDB_DATA_TYPE_INT) {
+        v32[j] = (int32_t)pCase->values[i][j];
+        params[j].buffer = &v32[j];
+        params[j].buffer_length = sizeof(int32_t);
+        snprintf(literals[j], sizeof(literals[j]), "%lld", (long long)pCase->values[i][j]);
+      } else {
+        v64[j] = pCase->values[i][j];
+        params[j].buffer = &v64[j];
+        params[j].buffer_length = sizeof(int64_t);
+        snprintf(literals[j], sizeof(literals[j]), "%lld", (long long)pCase->values[i][j]);
+      }
+      lengths[j] = params[j].buffer_length;
+      params[j].length = &lengths[j];
+    }
+
+    if (taos_stmt_bind_param(stmt, params) != 0 || taos_stmt_execute(stmt) != 0) {
+      PRINT_ERROR
+      printf("%s: failed to execute %s, reason:%s\n", pCase->desc, pCase->stmtSql, taos_stmt_errstr(stmt));
+      exit(EXIT_FAILURE);
+    }
+    TAOS_RES *result = taos_stmt_use_result(stmt);
+    fetch_result(result, actual);
+    taos_free_result(result);
+
+    snprintf(sql, sizeof(sql), pCase->textSql, literals[0], literals[1], literals[2], literals[3]);
+    result = taos_query(taos, sql);
+    if (taos_errno(result) != 0) {
+      PRINT_ERROR
+      printf("%s: failed to query %s, reason:%s\n", pCase->desc, sql, taos_errstr(result));
+      exit(EXIT_FAILURE);
+    }
+    fetch_result(result, expected);
+    taos_free_result(result);
+
+    if (strcmp(expected, actual) != 0) {
+      PRINT_ERROR
+      printf("%s: execution %d of %s differs from %s\nexpected:\n%sactual:\n%s", pCase->desc, i, pCase->stmtSql, sql,
+             expected, actual);
+      failed = 1;
+    }
+  }
+
+  taos_stmt_close(stmt);
+  if (!failed) {
+    PRINT_SUCCESS
+    printf("%s: the bound results are the same as the sql results\n", pCase->desc);
+  }
+  return failed;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1) {
+    taos_options(TSDB_OPTION_CONFIGDIR, argv[1]);
+  }
+
+  TAOS *taos = taos_connect(NULL, "root", "taosdata", NULL, 0);
+  if (taos == NULL) {
+    PRINT_ERROR
+    printf("TDengine error: failed to connect\n");
+    exit(EXIT_FAILURE);
+  }
+
+  execute_simple_sql(taos, "drop database if exists stmt_query_bind");
+  execute_simple_sql(taos, "create database stmt_query_bind");
+  execute_simple_sql(taos, "use stmt_query_bind");
+  execute_simple_sql(taos, "create table st (ts timestamp, c1 int) tags (t1 int)");
+
+  char *sql = calloc(1, 1024 * 1024);
+  for (int t = 0; t < 5; ++t) {
+    int len = sprintf(sql, "insert into t%d using st tags (%d) values", t, t);
+    for (int r = 0; r < 100; ++r) {
+      len += sprintf(sql + len, " (%lld, %d)", (long long)(START_TS + r * 1000LL), t * 100 + r);
+    }
+    execute_simple_sql(taos, sql);
+  }
+  free(sql);
+
+  SQueryCase cases[] = {
+    {"time window", "select count(*), sum(c1) from st where ts >= ? and ts < ?",
+     "select count(*), sum(c1) from st where ts >= %s and ts < %s", 2,
+     {TSDB_DATA_TYPE_TIMESTAMP, TSDB_DATA_TYPE_TIMESTAMP},
+     {{START_TS, START_TS + 10000}, {START_TS + 50000, START_TS + 90000}, {START_TS + 99000, START_TS + 200000}}},
+
+    {"tag condition", "select count(*), max(c1) from st where t1 = ?",
+     "select count(*), max(c1) from st where t1 = %s", 1, {TSDB_DATA_TYPE_INT}, {{1}, {3}, {4}}},
+
+    {"window and tag", "select count(*), min(c1) from st where (ts > ?) and t1 >= ? group by t1",
+     "select count(*), min(c1) from st where (ts > %s) and t1 >= %s group by t1", 2,
+     {TSDB_DATA_TYPE_TIMESTAMP, TSDB_DATA_TYPE_INT},
+     {{START_TS + 20000, 2}, {START_TS + 80000, 0}, {START_TS, 4}}},
+
+    {"window expression", "select count(*) from st where ts > ? + 1000",
+     "select count(*) from st where ts > %s + 1000", 1, {TSDB_DATA_TYPE_BIGINT},
+     {{START_TS}, {START_TS + 50000}, {START_TS + 97000}}},
+
+    {"tag expression", "select count(*), sum(c1) from st where t1 = ? * 2",
+     "select count(*), sum(c1) from st where t1 = %s * 2", 1, {TSDB_DATA_TYPE_INT}, {{0}, {1}, {2}}},
+
+    {"table name", "select count(*), sum(c1) from st where tbname = ? and ts > ?",
+     "select count(*), sum(c1) from st where tbname = %s and ts > %s", 2,
+     {TSDB_DATA_TYPE_BINARY, TSDB_DATA_TYPE_TIMESTAMP},
+     {{0, START_TS}, {0, START_TS + 50000}, {0, START_TS - 1}}, {{"t1"}, {"t3"}, {"t9"}}},
+
+    {"table name and tag", "select count(*), max(c1) from st where tbname = ? and t1 >= ?",
+     "select count(*), max(c1) from st where tbname = %s and t1 >= %s", 2,
+     {TSDB_DATA_TYPE_BINARY, TSDB_DATA_TYPE_INT}, {{0, 1}, {0, 2}, {0, 3}}, {{"t2"}, {"t4"}, {"t0"}}},
+  };
+
+  int failed = 0;
+  for (int i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+    failed += run_case(taos, &cases[i]);
+  }
+
+  execute_simple_sql(taos, "drop database if exists stmt_query_bind");
+  taos_close(taos);
+
+  if (failed > 0) {
+    PRINT_ERROR
+    printf("%d cases failed\n", failed);
+    exit(EXIT_FAILURE);
+  }
+
+  PRINT_SUCCESS
+  printf("all cases passed\n");
+  return 0;
+}